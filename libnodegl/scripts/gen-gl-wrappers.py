@@ -57,6 +57,12 @@ cmds_optional = [
     "glGetProgramResourceiv",
     "glGetProgramInterfaceiv",
     "glGetProgramResourceName",
+    # Program binary
+    "glGetProgramBinary",
+    "glProgramBinary",
+    "glProgramParameteri",
+    # Parallel shader compile
+    "glMaxShaderCompilerThreadsKHR",
     # Polygon
     "glPolygonMode",
     # Internal format
@@ -92,6 +98,7 @@ cmds_optional = [
     "glFenceSync",
     "glWaitSync",
     "glClientWaitSync",
+    "glDeleteSync",
     # Read/Draw Buffer
     "glReadBuffer",
     "glDrawBuffer",
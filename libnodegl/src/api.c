@@ -40,9 +40,13 @@
 #include "memory.h"
 #include "nodegl.h"
 #include "internal.h"
+#include "pass.h"
 #include "pgcache.h"
+#include "plan.h"
 #include "rnode.h"
 #include "pthread_compat.h"
+#include "threadpool.h"
+#include "workqueue.h"
 
 #if defined(HAVE_VAAPI)
 #include "vaapi_ctx.h"
@@ -117,10 +121,13 @@ static void reset_scene(struct ngl_ctx *s, int action)
 {
     ngli_hud_freep(&s->hud);
     if (s->scene) {
+        /* Pending live changes still land in the detached scene (errors are logged) */
+        ngli_node_apply_live_changes(s);
         ngli_node_detach_ctx(s->scene, s);
         if (action == NGLI_ACTION_UNREF_SCENE)
             ngl_node_unrefp(&s->scene);
     }
+    ngli_plan_reset(&s->plan);
     ngli_rnode_reset(&s->rnode);
 }
 
@@ -134,7 +141,10 @@ int ngli_ctx_set_scene(struct ngl_ctx *s, struct ngl_node *scene)
     ngli_rnode_init(&s->rnode);
     s->rnode_pos = &s->rnode;
     s->rnode_pos->graphicstate = NGLI_GRAPHICSTATE_DEFAULTS;
-    s->rnode_pos->rendertarget_desc = *ngli_gpu_ctx_get_default_rendertarget_desc(s->gpu_ctx);
+    if (s->capconv)
+        s->rnode_pos->rendertarget_desc = s->capconv->rt_desc;
+    else
+        s->rnode_pos->rendertarget_desc = *ngli_gpu_ctx_get_default_rendertarget_desc(s->gpu_ctx);
 
     if (scene) {
         int ret = ngli_node_attach_ctx(scene, s);
@@ -143,6 +153,18 @@ int ngli_ctx_set_scene(struct ngl_ctx *s, struct ngl_node *scene)
             return ret;
         }
         s->scene = ngl_node_ref(scene);
+
+        ngli_plan_init(&s->plan);
+        ret = ngli_plan_build(&s->plan, s, scene);
+        if (ret < 0) {
+            ngli_darray_clear(&s->pending_passes);
+            goto fail;
+        }
+
+        /* Only the pipelines not taken over by a batch of the plan remain */
+        ret = ngli_pass_create_pending_pipelines(s);
+        if (ret < 0)
+            goto fail;
     }
 
     const struct ngl_config *config = &s->config;
@@ -177,7 +199,10 @@ void ngli_ctx_reset(struct ngl_ctx *s, int action)
     ngli_android_ctx_reset(&s->android_ctx);
 #endif
     ngli_texture_freep(&s->font_atlas); // allocated by the first node text
+    ngli_capconv_freep(&s->capconv);
     ngli_pgcache_reset(&s->pgcache);
+    ngli_threadpool_freep(&s->threadpool);
+    ngli_workqueue_freep(&s->prefetch_queue);
     ngli_gpu_ctx_freep(&s->gpu_ctx);
     ngli_config_reset(&s->config);
 }
@@ -190,7 +215,21 @@ int ngli_ctx_configure(struct ngl_ctx *s, const struct ngl_config *config)
     if (ret < 0)
         return ret;
 
-    s->gpu_ctx = ngli_gpu_ctx_create(config);
+    /*
+     * With the YUV capture buffer types, the GPU context only handles the
+     * packed representation of the converted frame (see capconv.h)
+     */
+    struct ngl_config gpu_config = *config;
+    const int use_capconv = ngli_capconv_is_yuv_type(config->capture_buffer_type);
+    if (use_capconv) {
+        ret = ngli_capconv_get_gpu_config(&gpu_config, config);
+        if (ret < 0) {
+            ngli_config_reset(&s->config);
+            return ret;
+        }
+    }
+
+    s->gpu_ctx = ngli_gpu_ctx_create(&gpu_config);
     if (!s->gpu_ctx) {
         ngli_config_reset(&s->config);
         return NGL_ERROR_MEMORY;
@@ -208,6 +247,32 @@ int ngli_ctx_configure(struct ngl_ctx *s, const struct ngl_config *config)
     if (ret < 0)
         goto fail;
 
+    s->threadpool = ngli_threadpool_create();
+    if (!s->threadpool) {
+        ret = NGL_ERROR_MEMORY;
+        goto fail;
+    }
+
+    ret = ngli_threadpool_init(s->threadpool, 0);
+    if (ret < 0) {
+        /* Jobs are executed sequentially without a thread pool */
+        LOG(WARNING, "could not initialize thread pool: %s", NGLI_RET_STR(ret));
+        ngli_threadpool_freep(&s->threadpool);
+    }
+
+    s->prefetch_queue = ngli_workqueue_create();
+    if (!s->prefetch_queue) {
+        ret = NGL_ERROR_MEMORY;
+        goto fail;
+    }
+
+    ret = ngli_workqueue_init(s->prefetch_queue);
+    if (ret < 0) {
+        /* Nodes are prefetched synchronously without a work queue */
+        LOG(WARNING, "could not initialize prefetch queue: %s", NGLI_RET_STR(ret));
+        ngli_workqueue_freep(&s->prefetch_queue);
+    }
+
 #if defined(HAVE_VAAPI)
     ret = ngli_vaapi_ctx_init(s->gpu_ctx, &s->vaapi_ctx);
     if (ret < 0)
@@ -221,6 +286,18 @@ int ngli_ctx_configure(struct ngl_ctx *s, const struct ngl_config *config)
         LOG(WARNING, "could not initialize Android context");
 #endif
 
+    if (use_capconv) {
+        s->capconv = ngli_capconv_create(s);
+        if (!s->capconv) {
+            ret = NGL_ERROR_MEMORY;
+            goto fail;
+        }
+
+        ret = ngli_capconv_init(s->capconv);
+        if (ret < 0)
+            goto fail;
+    }
+
     NGLI_ALIGNED_MAT(matrix) = NGLI_MAT4_IDENTITY;
     ngli_gpu_ctx_transform_projection_matrix(s->gpu_ctx, matrix);
     ngli_darray_clear(&s->projection_matrix_stack);
@@ -265,6 +342,22 @@ int ngli_ctx_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer)
     return 0;
 }
 
+int ngli_ctx_fetch_capture(struct ngl_ctx *s, int wait, double *t)
+{
+    const struct ngl_config *config = &s->config;
+    if (!config->capture_async_depth) {
+        LOG(ERROR, "capture fetching requires an asynchronous capture context");
+        return NGL_ERROR_INVALID_USAGE;
+    }
+
+    if (!config->capture_buffer) {
+        LOG(ERROR, "a capture buffer must be set to fetch a capture");
+        return NGL_ERROR_INVALID_USAGE;
+    }
+
+    return ngli_gpu_ctx_fetch_capture(s->gpu_ctx, wait, t);
+}
+
 int ngli_ctx_prepare_draw(struct ngl_ctx *s, double t)
 {
     const int64_t start_time = s->hud ? ngli_gettime_relative() : 0;
@@ -280,11 +373,14 @@ int ngli_ctx_prepare_draw(struct ngl_ctx *s, double t)
 
     LOG(DEBUG, "prepare scene %s @ t=%f", scene->label, t);
 
+    /* A failed live change must not prevent the frame from being drawn */
+    ngli_ctx_defer_error(s, ngli_node_apply_live_changes(s));
+
     ret = ngli_node_honor_release_prefetch(scene, t);
     if (ret < 0)
         return ret;
 
-    ret = ngli_node_update(scene, t);
+    ret = ngli_plan_update(&s->plan, t);
     if (ret < 0)
         return ret;
 
@@ -311,6 +407,11 @@ int ngli_ctx_draw(struct ngl_ctx *s, double t)
 
     struct rendertarget *rt = ngli_gpu_ctx_get_default_rendertarget(s->gpu_ctx, NGLI_LOAD_OP_CLEAR);
     struct rendertarget *rt_resume = ngli_gpu_ctx_get_default_rendertarget(s->gpu_ctx, NGLI_LOAD_OP_LOAD);
+    if (s->capconv) {
+        rt = s->capconv->rt;
+        rt_resume = s->capconv->rt_resume;
+        ngli_capconv_begin_draw(s->capconv);
+    }
     s->available_rendertargets[0] = rt;
     s->available_rendertargets[1] = rt_resume;
     s->current_rendertarget = rt;
@@ -319,7 +420,7 @@ int ngli_ctx_draw(struct ngl_ctx *s, double t)
     struct ngl_node *scene = s->scene;
     if (scene) {
         LOG(DEBUG, "draw scene %s @ t=%f", scene->label, t);
-        ngli_node_draw(scene);
+        ngli_plan_draw(&s->plan);
     }
 
     if (!s->render_pass_started) {
@@ -345,20 +446,81 @@ int ngli_ctx_draw(struct ngl_ctx *s, double t)
         s->render_pass_started = 0;
     }
 
-    return ngli_gpu_ctx_end_draw(s->gpu_ctx, t);
+    if (s->capconv)
+        ngli_capconv_end_draw(s->capconv);
+
+    ret = ngli_gpu_ctx_end_draw(s->gpu_ctx, t);
+    if (ret < 0)
+        return ret;
+
+    ret = s->deferred_ret;
+    s->deferred_ret = 0;
+    return ret;
+}
+
+void ngli_ctx_defer_error(struct ngl_ctx *s, int ret)
+{
+    if (ret < 0 && s->deferred_ret >= 0)
+        s->deferred_ret = ret;
+}
+
+/* Must be called with the lock held */
+static void wait_async_cmd(struct ngl_ctx *s)
+{
+    while (s->cmd_func)
+        pthread_cond_wait(&s->cond_ctl, &s->lock);
+    if (s->async_cmd_pending) {
+        /* Keep the first error until it is reported to the user */
+        if (s->async_cmd_ret >= 0)
+            s->async_cmd_ret = s->cmd_ret;
+        s->async_cmd_pending = 0;
+    }
 }
 
 int ngli_ctx_dispatch_cmd(struct ngl_ctx *s, cmd_func_type cmd_func, void *arg)
 {
     pthread_mutex_lock(&s->lock);
+    wait_async_cmd(s);
     s->cmd_func = cmd_func;
     s->cmd_arg = arg;
     pthread_cond_signal(&s->cond_wkr);
     while (s->cmd_func)
         pthread_cond_wait(&s->cond_ctl, &s->lock);
+    const int ret = s->cmd_ret;
     pthread_mutex_unlock(&s->lock);
 
-    return s->cmd_ret;
+    return ret;
+}
+
+int ngli_ctx_dispatch_cmd_async(struct ngl_ctx *s, cmd_func_type cmd_func, void *arg)
+{
+    pthread_mutex_lock(&s->lock);
+    wait_async_cmd(s);
+    s->cmd_func = cmd_func;
+    s->cmd_arg = arg;
+    s->async_cmd_pending = 1;
+    pthread_cond_signal(&s->cond_wkr);
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+void ngli_ctx_wait_async_cmd(struct ngl_ctx *s)
+{
+    pthread_mutex_lock(&s->lock);
+    wait_async_cmd(s);
+    pthread_mutex_unlock(&s->lock);
+}
+
+static int get_async_cmd_ret(struct ngl_ctx *s)
+{
+    pthread_mutex_lock(&s->lock);
+    wait_async_cmd(s);
+    const int ret = s->async_cmd_ret;
+    s->async_cmd_ret = 0;
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
 }
 
 static void *worker_thread(void *arg)
@@ -580,6 +742,13 @@ struct ngl_ctx *ngl_create(void)
     if (!s)
         return NULL;
 
+    s->live_changes = ngli_cmdqueue_create();
+    if (!s->live_changes || ngli_cmdqueue_init(s->live_changes, sizeof(struct live_change), NGLI_MAX_LIVE_CHANGES) < 0) {
+        ngli_cmdqueue_freep(&s->live_changes);
+        ngli_free(s);
+        return NULL;
+    }
+
     if (pthread_mutex_init(&s->lock, NULL) ||
         pthread_cond_init(&s->cond_ctl, NULL) ||
         pthread_cond_init(&s->cond_wkr, NULL) ||
@@ -587,6 +756,7 @@ struct ngl_ctx *ngl_create(void)
         pthread_cond_destroy(&s->cond_ctl);
         pthread_cond_destroy(&s->cond_wkr);
         pthread_mutex_destroy(&s->lock);
+        ngli_cmdqueue_freep(&s->live_changes);
         ngli_free(s);
         return NULL;
     }
@@ -594,6 +764,7 @@ struct ngl_ctx *ngl_create(void)
     ngli_darray_init(&s->modelview_matrix_stack, 4 * 4 * sizeof(float), 1);
     ngli_darray_init(&s->projection_matrix_stack, 4 * 4 * sizeof(float), 1);
     ngli_darray_init(&s->activitycheck_nodes, sizeof(struct ngl_node *), 0);
+    ngli_darray_init(&s->pending_passes, sizeof(struct pass *), 0);
 
     static const NGLI_ALIGNED_MAT(id_matrix) = NGLI_MAT4_IDENTITY;
     if (!ngli_darray_push(&s->modelview_matrix_stack, id_matrix) ||
@@ -612,6 +783,8 @@ fail:
 
 int ngl_configure(struct ngl_ctx *s, struct ngl_config *config)
 {
+    ngli_ctx_wait_async_cmd(s);
+
     if (s->configured) {
         s->api_impl->reset(s, NGLI_ACTION_KEEP_SCENE);
         s->configured = 0;
@@ -665,6 +838,8 @@ int ngl_resize(struct ngl_ctx *s, int width, int height, const int *viewport)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     return s->api_impl->resize(s, width, height, viewport);
 }
 
@@ -675,6 +850,8 @@ int ngl_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     int ret = s->api_impl->set_capture_buffer(s, capture_buffer);
     if (ret < 0) {
         s->configured = 0;
@@ -683,6 +860,18 @@ int ngl_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer)
     return ret;
 }
 
+int ngl_fetch_capture(struct ngl_ctx *s, int wait, double *t)
+{
+    if (!s->configured) {
+        LOG(ERROR, "context must be configured before fetching a capture");
+        return NGL_ERROR_INVALID_USAGE;
+    }
+
+    ngli_ctx_wait_async_cmd(s);
+
+    return s->api_impl->fetch_capture(s, wait, t);
+}
+
 int ngl_set_scene(struct ngl_ctx *s, struct ngl_node *scene)
 {
     if (!s->configured) {
@@ -690,6 +879,8 @@ int ngl_set_scene(struct ngl_ctx *s, struct ngl_node *scene)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     return s->api_impl->set_scene(s, scene);
 }
 
@@ -700,6 +891,8 @@ int ngli_prepare_draw(struct ngl_ctx *s, double t)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     return s->api_impl->prepare_draw(s, t);
 }
 
@@ -710,9 +903,36 @@ int ngl_draw(struct ngl_ctx *s, double t)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     return s->api_impl->draw(s, t);
 }
 
+int ngl_draw_async(struct ngl_ctx *s, double t)
+{
+    if (!s->configured) {
+        LOG(ERROR, "context must be configured before drawing");
+        return NGL_ERROR_INVALID_USAGE;
+    }
+
+    if (!s->api_impl->draw_async) {
+        LOG(ERROR, "asynchronous draw is not supported by context");
+        return NGL_ERROR_UNSUPPORTED;
+    }
+
+    /* Report the failure of the previous asynchronous draw */
+    int ret = get_async_cmd_ret(s);
+    if (ret < 0)
+        return ret;
+
+    return s->api_impl->draw_async(s, t);
+}
+
+int ngl_wait(struct ngl_ctx *s)
+{
+    return get_async_cmd_ret(s);
+}
+
 int ngl_gl_wrap_framebuffer(struct ngl_ctx *s, uint32_t framebuffer)
 {
     if (!s->configured) {
@@ -720,6 +940,8 @@ int ngl_gl_wrap_framebuffer(struct ngl_ctx *s, uint32_t framebuffer)
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    ngli_ctx_wait_async_cmd(s);
+
     if (!s->api_impl->gl_wrap_framebuffer) {
         LOG(ERROR, "wrapping external OpenGL framebuffer is not supported by context");
         return NGL_ERROR_UNSUPPORTED;
@@ -743,6 +965,11 @@ void ngl_livectls_freep(struct ngl_livectl **livectlsp)
     ngli_node_livectls_freep(livectlsp);
 }
 
+int ngl_livectls_apply(int nb_livectls, const struct ngl_livectl *livectls)
+{
+    return ngli_node_livectls_apply(nb_livectls, livectls);
+}
+
 void ngl_freep(struct ngl_ctx **ss)
 {
     struct ngl_ctx *s = *ss;
@@ -750,6 +977,8 @@ void ngl_freep(struct ngl_ctx **ss)
     if (!s)
         return;
 
+    ngli_ctx_wait_async_cmd(s);
+
     if (s->configured) {
         s->api_impl->reset(s, NGLI_ACTION_UNREF_SCENE);
         s->configured = 0;
@@ -763,6 +992,8 @@ void ngl_freep(struct ngl_ctx **ss)
     ngli_darray_reset(&s->modelview_matrix_stack);
     ngli_darray_reset(&s->projection_matrix_stack);
     ngli_darray_reset(&s->activitycheck_nodes);
+    ngli_darray_reset(&s->pending_passes);
+    ngli_cmdqueue_freep(&s->live_changes);
     ngli_freep(ss);
 }
 
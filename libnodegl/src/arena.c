@@ -0,0 +1,123 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "arena.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "utils.h"
+
+struct arena_block {
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+};
+
+#define BLOCK_HEADER_SIZE NGLI_ALIGN(sizeof(struct arena_block), NGLI_ALIGN_VAL)
+
+struct arena {
+    int refcount;
+    size_t block_size;
+    struct arena_block *blocks; /* the first block is the one being carved */
+};
+
+struct arena *ngli_arena_create(void)
+{
+    struct arena *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->refcount = 1;
+    return s;
+}
+
+int ngli_arena_init(struct arena *s, size_t block_size)
+{
+    if (!block_size)
+        return NGL_ERROR_INVALID_ARG;
+    s->block_size = NGLI_ALIGN(block_size, NGLI_ALIGN_VAL);
+    return 0;
+}
+
+static struct arena_block *create_block(size_t size)
+{
+    struct arena_block *block = ngli_malloc_aligned(BLOCK_HEADER_SIZE + size);
+    if (!block)
+        return NULL;
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+void *ngli_arena_alloc(struct arena *s, size_t size)
+{
+    size = NGLI_ALIGN(size, NGLI_ALIGN_VAL);
+
+    struct arena_block *block = s->blocks;
+    if (!block || block->size - block->used < size) {
+        /*
+         * Large chunks get a dedicated block, inserted behind the current one
+         * so that its remaining space is not wasted.
+         */
+        const int dedicated = size > s->block_size / 4;
+        block = create_block(dedicated ? size : s->block_size);
+        if (!block)
+            return NULL;
+        if (dedicated && s->blocks) {
+            block->next = s->blocks->next;
+            s->blocks->next = block;
+        } else {
+            block->next = s->blocks;
+            s->blocks = block;
+        }
+    }
+
+    uint8_t *ptr = (uint8_t *)block + BLOCK_HEADER_SIZE + block->used;
+    block->used += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+struct arena *ngli_arena_ref(struct arena *s)
+{
+    s->refcount++;
+    return s;
+}
+
+void ngli_arena_unrefp(struct arena **sp)
+{
+    struct arena *s = *sp;
+    if (!s)
+        return;
+
+    if (--s->refcount == 0) {
+        struct arena_block *block = s->blocks;
+        while (block) {
+            struct arena_block *next = block->next;
+            ngli_free_aligned(block);
+            block = next;
+        }
+        ngli_free(s);
+    }
+    *sp = NULL;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Bump allocator carving zero-initialized chunks, aligned on NGLI_ALIGN_VAL,
+ * out of large memory blocks. The chunks can not be freed individually: all
+ * the blocks are released at once when the last reference to the arena is
+ * dropped. The arena is not thread-safe.
+ */
+
+struct arena;
+
+struct arena *ngli_arena_create(void);
+int ngli_arena_init(struct arena *s, size_t block_size);
+void *ngli_arena_alloc(struct arena *s, size_t size);
+struct arena *ngli_arena_ref(struct arena *s);
+void ngli_arena_unrefp(struct arena **sp);
+
+#endif
@@ -59,6 +59,11 @@ static int gl_configure(struct ngl_ctx *s, const struct ngl_config *config)
 
 static int glw_configure(struct ngl_ctx *s, const struct ngl_config *config)
 {
+    if (ngli_capconv_is_yuv_type(config->capture_buffer_type)) {
+        LOG(ERROR, "YUV capture buffer types are not supported with external OpenGL contexts");
+        return NGL_ERROR_UNSUPPORTED;
+    }
+
     int ret = ngli_ctx_configure(s, config);
     if (ret < 0)
         return ret;
@@ -127,6 +132,32 @@ static int glw_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer)
     return NGL_ERROR_UNSUPPORTED;
 }
 
+struct fetch_capture_params {
+    int wait;
+    double *t;
+};
+
+static int cmd_fetch_capture(struct ngl_ctx *s, void *arg)
+{
+    const struct fetch_capture_params *params = arg;
+    return ngli_ctx_fetch_capture(s, params->wait, params->t);
+}
+
+static int gl_fetch_capture(struct ngl_ctx *s, int wait, double *t)
+{
+    struct fetch_capture_params params = {
+        .wait = wait,
+        .t = t,
+    };
+    return ngli_ctx_dispatch_cmd(s, cmd_fetch_capture, &params);
+}
+
+static int glw_fetch_capture(struct ngl_ctx *s, int wait, double *t)
+{
+    LOG(ERROR, "capture is not supported by external OpenGL context");
+    return NGL_ERROR_UNSUPPORTED;
+}
+
 static int cmd_set_scene(struct ngl_ctx *s, void *arg)
 {
     struct ngl_node *node = arg;
@@ -176,6 +207,12 @@ static int gl_draw(struct ngl_ctx *s, double t)
     return ngli_ctx_dispatch_cmd(s, cmd_draw, &t);
 }
 
+static int gl_draw_async(struct ngl_ctx *s, double t)
+{
+    s->draw_async_time = t;
+    return ngli_ctx_dispatch_cmd_async(s, cmd_draw, &s->draw_async_time);
+}
+
 static int glw_draw(struct ngl_ctx *s, double t)
 {
     ngli_gpu_ctx_gl_reset_state(s->gpu_ctx);
@@ -184,6 +221,12 @@ static int glw_draw(struct ngl_ctx *s, double t)
     return ret;
 }
 
+static int glw_draw_async(struct ngl_ctx *s, double t)
+{
+    LOG(ERROR, "asynchronous draw is not supported by external OpenGL context");
+    return NGL_ERROR_UNSUPPORTED;
+}
+
 static int cmd_reset(struct ngl_ctx *s, void *arg)
 {
     const int action = *(int *)arg;
@@ -243,6 +286,11 @@ static int glv_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer)
     return is_glw(&s->config) ? glw_set_capture_buffer(s, capture_buffer) : gl_set_capture_buffer(s, capture_buffer);
 }
 
+static int glv_fetch_capture(struct ngl_ctx *s, int wait, double *t)
+{
+    return is_glw(&s->config) ? glw_fetch_capture(s, wait, t) : gl_fetch_capture(s, wait, t);
+}
+
 static int glv_set_scene(struct ngl_ctx *s, struct ngl_node *node)
 {
     return is_glw(&s->config) ? glw_set_scene(s, node) : gl_set_scene(s, node);
@@ -258,6 +306,11 @@ static int glv_draw(struct ngl_ctx *s, double t)
     return is_glw(&s->config) ? glw_draw(s, t) : gl_draw(s, t);
 }
 
+static int glv_draw_async(struct ngl_ctx *s, double t)
+{
+    return is_glw(&s->config) ? glw_draw_async(s, t) : gl_draw_async(s, t);
+}
+
 static void glv_reset(struct ngl_ctx *s, int action)
 {
     is_glw(&s->config) ? glw_reset(s, action) : gl_reset(s, action);
@@ -272,9 +325,11 @@ const struct api_impl api_gl = {
     .configure           = glv_configure,
     .resize              = glv_resize,
     .set_capture_buffer  = glv_set_capture_buffer,
+    .fetch_capture       = glv_fetch_capture,
     .set_scene           = glv_set_scene,
     .prepare_draw        = glv_prepare_draw,
     .draw                = glv_draw,
+    .draw_async          = glv_draw_async,
     .reset               = glv_reset,
     .gl_wrap_framebuffer = glv_wrap_framebuffer,
 };
@@ -63,6 +63,8 @@
 #define NGLI_FEATURE_GL_MAP_BUFFER_RANGE                           (1ULL << 38)
 #define NGLI_FEATURE_GL_BUFFER_STORAGE                             (1ULL << 39)
 #define NGLI_FEATURE_GL_OES_STANDARD_DERIVATIVES                   (1ULL << 40)
+#define NGLI_FEATURE_GL_GET_PROGRAM_BINARY                         (1ULL << 41)
+#define NGLI_FEATURE_GL_KHR_PARALLEL_SHADER_COMPILE                (1ULL << 42)
 
 #define NGLI_FEATURE_GL_COMPUTE_SHADER_ALL (NGLI_FEATURE_GL_COMPUTE_SHADER           | \
                                             NGLI_FEATURE_GL_PROGRAM_INTERFACE_QUERY  | \
@@ -121,6 +121,13 @@ typedef void (NGLI_GL_APIENTRY *GLDEBUGPROC)(GLenum source, GLenum type, GLuint
 # define GL_MAX_COLOR_ATTACHMENTS              0x8CDF
 # define GL_SYNC_GPU_COMMANDS_COMPLETE         0x9117
 # define GL_TIMEOUT_IGNORED                    0xFFFFFFFFFFFFFFFFull
+# define GL_SYNC_FLUSH_COMMANDS_BIT            0x00000001
+# define GL_ALREADY_SIGNALED                   0x911A
+# define GL_TIMEOUT_EXPIRED                    0x911B
+# define GL_CONDITION_SATISFIED                0x911C
+# define GL_WAIT_FAILED                        0x911D
+# define GL_PIXEL_PACK_BUFFER                  0x88EB
+# define GL_MAP_READ_BIT                       0x0001
 # define GL_TEXTURE_RECTANGLE                  0x84F5
 # define GL_STENCIL_INDEX                      0x1901
 # define GL_STENCIL_INDEX8                     0x8D48
@@ -250,6 +257,9 @@ typedef void (NGLI_GL_APIENTRY *GLDEBUGPROC)(GLenum source, GLenum type, GLuint
 # define GL_FRAMEBUFFER_ATTACHMENT_ALPHA_SIZE  0x8215
 # define GL_FRAMEBUFFER_ATTACHMENT_DEPTH_SIZE  0x8216
 # define GL_FRAMEBUFFER_ATTACHMENT_STENCIL_SIZE 0x8217
+# define GL_PROGRAM_BINARY_RETRIEVABLE_HINT    0x8257
+# define GL_PROGRAM_BINARY_LENGTH              0x8741
+# define GL_NUM_PROGRAM_BINARY_FORMATS         0x87FE
 #endif
 
 #if NGL_CS_COMPAT_INCLUDES
@@ -260,6 +260,12 @@ static inline void ngli_glDeleteShader(const struct glcontext *gl, GLuint shader
     check_error_code(gl, "glDeleteShader");
 }
 
+static inline void ngli_glDeleteSync(const struct glcontext *gl, GLsync sync)
+{
+    gl->funcs.DeleteSync(sync);
+    check_error_code(gl, "glDeleteSync");
+}
+
 static inline void ngli_glDeleteTextures(const struct glcontext *gl, GLsizei n, const GLuint * textures)
 {
     gl->funcs.DeleteTextures(n, textures);
@@ -525,6 +531,12 @@ static inline void ngli_glGetInternalformativ(const struct glcontext *gl, GLenum
     check_error_code(gl, "glGetInternalformativ");
 }
 
+static inline void ngli_glGetProgramBinary(const struct glcontext *gl, GLuint program, GLsizei bufSize, GLsizei * length, GLenum * binaryFormat, void * binary)
+{
+    gl->funcs.GetProgramBinary(program, bufSize, length, binaryFormat, binary);
+    check_error_code(gl, "glGetProgramBinary");
+}
+
 static inline void ngli_glGetProgramInfoLog(const struct glcontext *gl, GLuint program, GLsizei bufSize, GLsizei * length, GLchar * infoLog)
 {
     gl->funcs.GetProgramInfoLog(program, bufSize, length, infoLog);
@@ -658,6 +670,12 @@ static inline void * ngli_glMapBufferRange(const struct glcontext *gl, GLenum ta
     return ret;
 }
 
+static inline void ngli_glMaxShaderCompilerThreadsKHR(const struct glcontext *gl, GLuint count)
+{
+    gl->funcs.MaxShaderCompilerThreadsKHR(count);
+    check_error_code(gl, "glMaxShaderCompilerThreadsKHR");
+}
+
 static inline void ngli_glMemoryBarrier(const struct glcontext *gl, GLbitfield barriers)
 {
     gl->funcs.MemoryBarrier(barriers);
@@ -676,6 +694,18 @@ static inline void ngli_glPolygonMode(const struct glcontext *gl, GLenum face, G
     check_error_code(gl, "glPolygonMode");
 }
 
+static inline void ngli_glProgramBinary(const struct glcontext *gl, GLuint program, GLenum binaryFormat, const void * binary, GLsizei length)
+{
+    gl->funcs.ProgramBinary(program, binaryFormat, binary, length);
+    check_error_code(gl, "glProgramBinary");
+}
+
+static inline void ngli_glProgramParameteri(const struct glcontext *gl, GLuint program, GLenum pname, GLint value)
+{
+    gl->funcs.ProgramParameteri(program, pname, value);
+    check_error_code(gl, "glProgramParameteri");
+}
+
 static inline void ngli_glQueryCounter(const struct glcontext *gl, GLuint id, GLenum target)
 {
     gl->funcs.QueryCounter(id, target);
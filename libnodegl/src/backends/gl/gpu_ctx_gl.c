@@ -43,7 +43,7 @@
 #include "gpu_capture.h"
 #endif
 
-static void capture_cpu(struct gpu_ctx *s)
+static void capture_cpu(struct gpu_ctx *s, double t)
 {
     struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
     struct glcontext *gl = s_priv->glcontext;
@@ -56,7 +56,38 @@ static void capture_cpu(struct gpu_ctx *s)
     ngli_glReadPixels(gl, 0, 0, rt->width, rt->height, GL_RGBA, GL_UNSIGNED_BYTE, config->capture_buffer);
 }
 
-static void capture_corevideo(struct gpu_ctx *s)
+static void capture_cpu_async(struct gpu_ctx *s, double t)
+{
+    struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
+    struct glcontext *gl = s_priv->glcontext;
+    struct rendertarget *rt = s_priv->default_rt;
+    struct rendertarget_gl *rt_gl = (struct rendertarget_gl *)rt;
+
+    const int index = (s_priv->capture_head + s_priv->nb_pending_captures) % s_priv->nb_capture_slots;
+    struct capture_slot_gl *slot = &s_priv->capture_slots[index];
+
+    const GLuint fbo_id = rt_gl->resolve_id ? rt_gl->resolve_id : rt_gl->id;
+    ngli_glBindFramebuffer(gl, GL_FRAMEBUFFER, fbo_id);
+    if (slot->pbo) {
+        /*
+         * The readback targets a pixel pack buffer so glReadPixels() returns
+         * immediately, the fence tells us later when the data is available.
+         * The flush ensures the fence is submitted even if the user only
+         * polls for the capture.
+         */
+        ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, slot->pbo);
+        ngli_glReadPixels(gl, 0, 0, rt->width, rt->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, 0);
+        slot->fence = ngli_glFenceSync(gl, GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ngli_glFlush(gl);
+    } else {
+        ngli_glReadPixels(gl, 0, 0, rt->width, rt->height, GL_RGBA, GL_UNSIGNED_BYTE, slot->data);
+    }
+    slot->t = t;
+    s_priv->nb_pending_captures++;
+}
+
+static void capture_corevideo(struct gpu_ctx *s, double t)
 {
     struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
     struct glcontext *gl = s_priv->glcontext;
@@ -311,6 +342,59 @@ static int create_rendertarget(struct gpu_ctx *s,
     return 0;
 }
 
+static int capture_async_init(struct gpu_ctx *s)
+{
+    struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
+    struct glcontext *gl = s_priv->glcontext;
+    const struct ngl_config *config = &s->config;
+
+    s_priv->capture_slots = ngli_calloc(config->capture_async_depth, sizeof(*s_priv->capture_slots));
+    if (!s_priv->capture_slots)
+        return NGL_ERROR_MEMORY;
+    s_priv->nb_capture_slots = config->capture_async_depth;
+
+    const uint64_t features = NGLI_FEATURE_GL_SYNC | NGLI_FEATURE_GL_MAP_BUFFER_RANGE;
+    const int use_pbo = (gl->features & features) == features;
+    if (!use_pbo)
+        LOG(WARNING, "context does not support pixel pack buffers and fence syncs, "
+            "captures will be read back synchronously");
+
+    const int size = config->width * config->height * 4;
+    for (int i = 0; i < s_priv->nb_capture_slots; i++) {
+        struct capture_slot_gl *slot = &s_priv->capture_slots[i];
+        if (use_pbo) {
+            ngli_glGenBuffers(gl, 1, &slot->pbo);
+            ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, slot->pbo);
+            ngli_glBufferData(gl, GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+            ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, 0);
+        } else {
+            slot->data = ngli_malloc(size);
+            if (!slot->data)
+                return NGL_ERROR_MEMORY;
+        }
+    }
+
+    return 0;
+}
+
+static void capture_async_reset(struct gpu_ctx *s)
+{
+    struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
+    struct glcontext *gl = s_priv->glcontext;
+
+    for (int i = 0; i < s_priv->nb_capture_slots; i++) {
+        struct capture_slot_gl *slot = &s_priv->capture_slots[i];
+        if (slot->fence)
+            ngli_glDeleteSync(gl, slot->fence);
+        ngli_glDeleteBuffers(gl, 1, &slot->pbo);
+        ngli_freep(&slot->data);
+    }
+    ngli_freep(&s_priv->capture_slots);
+    s_priv->nb_capture_slots = 0;
+    s_priv->capture_head = 0;
+    s_priv->nb_pending_captures = 0;
+}
+
 static int offscreen_rendertarget_init(struct gpu_ctx *s)
 {
     struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
@@ -349,6 +433,16 @@ static int offscreen_rendertarget_init(struct gpu_ctx *s)
         return NGL_ERROR_UNSUPPORTED;
     }
 
+    if (config->capture_async_depth < 0) {
+        LOG(ERROR, "invalid capture async depth: %d", config->capture_async_depth);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    if (config->capture_async_depth && config->capture_buffer_type != NGL_CAPTURE_BUFFER_TYPE_CPU) {
+        LOG(ERROR, "asynchronous capture is only supported with CPU capture buffers");
+        return NGL_ERROR_UNSUPPORTED;
+    }
+
     if (config->samples) {
         int ret = create_texture(s, NGLI_FORMAT_R8G8B8A8_UNORM, config->samples, &s_priv->ms_color);
         if (ret < 0)
@@ -375,6 +469,13 @@ static int offscreen_rendertarget_init(struct gpu_ctx *s)
     };
     s_priv->capture_func = capture_func_map[config->capture_buffer_type];
 
+    if (config->capture_async_depth) {
+        ret = capture_async_init(s);
+        if (ret < 0)
+            return ret;
+        s_priv->capture_func = capture_cpu_async;
+    }
+
     return 0;
 }
 
@@ -403,6 +504,7 @@ static void rendertarget_reset(struct gpu_ctx *s)
 #if defined(TARGET_IPHONE) || defined(TARGET_DARWIN)
     reset_capture_cvpixelbuffer(s);
 #endif
+    capture_async_reset(s);
     s_priv->capture_func = NULL;
 }
 
@@ -526,8 +628,8 @@ static int gl_init(struct gpu_ctx *s)
                 config->width, config->height);
             return NGL_ERROR_INVALID_ARG;
         }
-        if (config->capture_buffer) {
-            LOG(ERROR, "capture_buffer is not supported by external context");
+        if (config->capture_buffer || config->capture_async_depth) {
+            LOG(ERROR, "capture is not supported by external context");
             return NGL_ERROR_INVALID_ARG;
         }
     } else if (config->offscreen) {
@@ -537,8 +639,8 @@ static int gl_init(struct gpu_ctx *s)
             return NGL_ERROR_INVALID_ARG;
         }
     } else {
-        if (config->capture_buffer) {
-            LOG(ERROR, "capture_buffer is not supported by onscreen context");
+        if (config->capture_buffer || config->capture_async_depth) {
+            LOG(ERROR, "capture is not supported by onscreen context");
             return NGL_ERROR_INVALID_ARG;
         }
     }
@@ -592,6 +694,10 @@ static int gl_init(struct gpu_ctx *s)
         ngli_gpu_capture_begin(s->gpu_capture_ctx);
 #endif
 
+    /* Let the driver use as many threads as it wants to compile the shaders */
+    if (gl->features & NGLI_FEATURE_GL_KHR_PARALLEL_SHADER_COMPILE)
+        ngli_glMaxShaderCompilerThreadsKHR(gl, 0xFFFFFFFF);
+
     if (external) {
         ret = ngli_gpu_ctx_gl_wrap_framebuffer(s, config_gl->external_framebuffer);
     } else if (gl->offscreen) {
@@ -753,6 +859,69 @@ static int gl_set_capture_buffer(struct gpu_ctx *s, void *capture_buffer)
     return 0;
 }
 
+static int wait_capture_fence(struct gpu_ctx *s, struct capture_slot_gl *slot, int wait)
+{
+    struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
+    struct glcontext *gl = s_priv->glcontext;
+
+    const GLbitfield flags = wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0;
+    const GLuint64 timeout = wait ? 1000000000 : 0;
+    for (;;) {
+        const GLenum status = ngli_glClientWaitSync(gl, slot->fence, flags, timeout);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+            break;
+        if (status == GL_WAIT_FAILED) {
+            LOG(ERROR, "could not wait for capture completion");
+            return NGL_ERROR_GRAPHICS_GENERIC;
+        }
+        if (!wait)
+            return 0;
+    }
+
+    ngli_glDeleteSync(gl, slot->fence);
+    slot->fence = NULL;
+
+    return 1;
+}
+
+static int gl_fetch_capture(struct gpu_ctx *s, int wait, double *t)
+{
+    struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
+    struct glcontext *gl = s_priv->glcontext;
+    const struct ngl_config *config = &s->config;
+
+    if (!s_priv->nb_pending_captures)
+        return 0;
+
+    struct capture_slot_gl *slot = &s_priv->capture_slots[s_priv->capture_head];
+    const int size = config->width * config->height * 4;
+    if (slot->pbo) {
+        int ret = wait_capture_fence(s, slot, wait);
+        if (ret <= 0)
+            return ret;
+
+        ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, slot->pbo);
+        const void *data = ngli_glMapBufferRange(gl, GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (!data) {
+            ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, 0);
+            LOG(ERROR, "could not map capture pixel pack buffer");
+            return NGL_ERROR_GRAPHICS_GENERIC;
+        }
+        memcpy(config->capture_buffer, data, size);
+        ngli_glUnmapBuffer(gl, GL_PIXEL_PACK_BUFFER);
+        ngli_glBindBuffer(gl, GL_PIXEL_PACK_BUFFER, 0);
+    } else {
+        memcpy(config->capture_buffer, slot->data, size);
+    }
+
+    if (t)
+        *t = slot->t;
+    s_priv->capture_head = (s_priv->capture_head + 1) % s_priv->nb_capture_slots;
+    s_priv->nb_pending_captures--;
+
+    return 1;
+}
+
 int ngli_gpu_ctx_gl_make_current(struct gpu_ctx *s)
 {
     struct gpu_ctx_gl *s_priv = (struct gpu_ctx_gl *)s;
@@ -873,6 +1042,13 @@ static int gl_begin_draw(struct gpu_ctx *s, double t)
     struct glcontext *gl = s_priv->glcontext;
     const struct ngl_config *config = &s->config;
 
+    if (s_priv->capture_slots && config->capture_buffer &&
+        s_priv->nb_pending_captures == s_priv->nb_capture_slots) {
+        LOG(ERROR, "asynchronous capture queue is full (%d pending captures), "
+            "ngl_fetch_capture() must be called before drawing", s_priv->nb_pending_captures);
+        return NGL_ERROR_LIMIT_EXCEEDED;
+    }
+
     if (config->hud)
 #if defined(TARGET_DARWIN)
         s_priv->glBeginQuery(gl, GL_TIME_ELAPSED, s_priv->queries[0]);
@@ -891,7 +1067,7 @@ static int gl_end_draw(struct gpu_ctx *s, double t)
     const struct ngl_config_gl *config_gl = config->backend_config;
 
     if (s_priv->capture_func && config->capture_buffer)
-        s_priv->capture_func(s);
+        s_priv->capture_func(s, t);
 
     int ret = ngli_glcontext_check_gl_error(gl, __func__);
 
@@ -1050,6 +1226,7 @@ const struct gpu_ctx_class ngli_gpu_ctx_##cls_suffix = {
     .init                               = gl_init,                               \
     .resize                             = gl_resize,                             \
     .set_capture_buffer                 = gl_set_capture_buffer,                 \
+    .fetch_capture                      = gl_fetch_capture,                      \
     .begin_update                       = gl_begin_update,                       \
     .end_update                         = gl_end_update,                         \
     .begin_draw                         = gl_begin_draw,                         \
@@ -1096,6 +1273,7 @@ const struct gpu_ctx_class ngli_gpu_ctx_##cls_suffix = {
                                                                                  \
     .program_create                     = ngli_program_gl_create,                \
     .program_init                       = ngli_program_gl_init,                  \
+    .program_init_batch                 = ngli_program_gl_init_batch,            \
     .program_freep                      = ngli_program_gl_freep,                 \
                                                                                  \
     .rendertarget_create                = ngli_rendertarget_gl_create,           \
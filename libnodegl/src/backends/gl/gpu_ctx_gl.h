@@ -39,7 +39,14 @@
 struct ngl_ctx;
 struct rendertarget;
 
-typedef void (*capture_func_type)(struct gpu_ctx *s);
+typedef void (*capture_func_type)(struct gpu_ctx *s, double t);
+
+struct capture_slot_gl {
+    GLuint pbo;     /* pixel pack buffer, 0 if the readback is synchronous */
+    GLsync fence;   /* signaled once the readback into the pbo is complete */
+    uint8_t *data;  /* host memory used when pixel pack buffers are unavailable */
+    double t;
+};
 
 #define NGLI_CFRELEASE(ref) do { \
     if (ref) {                   \
@@ -75,6 +82,11 @@ struct gpu_ctx_gl {
 #elif defined(TARGET_DARWIN)
     CVOpenGLTextureRef capture_cvtexture;
 #endif
+    /* Asynchronous capture ring */
+    struct capture_slot_gl *capture_slots;
+    int nb_capture_slots;
+    int capture_head;
+    int nb_pending_captures;
     /* Timer */
     GLuint queries[2];
     void (*glGenQueries)(const struct glcontext *gl, GLsizei n, GLuint * ids);
@@ -40,7 +40,10 @@ struct uniform_binding {
     GLuint location;
     set_uniform_func set;
     struct pipeline_uniform_desc desc;
-    const void *data;
+    uint8_t *data;  /* copy of the last value set, valid if has_data is set */
+    int data_size;
+    int has_data;
+    int dirty;      /* data not uploaded to the program yet */
 };
 
 struct texture_binding {
@@ -147,6 +150,24 @@ static const set_uniform_func set_uniform_func_map[NGLI_TYPE_NB] = {
     [NGLI_TYPE_MAT4]   = set_uniform_mat4fv,
 };
 
+static const int uniform_size_map[NGLI_TYPE_NB] = {
+    [NGLI_TYPE_BOOL]   = 1 * sizeof(int),
+    [NGLI_TYPE_INT]    = 1 * sizeof(int),
+    [NGLI_TYPE_IVEC2]  = 2 * sizeof(int),
+    [NGLI_TYPE_IVEC3]  = 3 * sizeof(int),
+    [NGLI_TYPE_IVEC4]  = 4 * sizeof(int),
+    [NGLI_TYPE_UINT]   = 1 * sizeof(unsigned int),
+    [NGLI_TYPE_UIVEC2] = 2 * sizeof(unsigned int),
+    [NGLI_TYPE_UIVEC3] = 3 * sizeof(unsigned int),
+    [NGLI_TYPE_UIVEC4] = 4 * sizeof(unsigned int),
+    [NGLI_TYPE_FLOAT]  = 1 * sizeof(float),
+    [NGLI_TYPE_VEC2]   = 2 * sizeof(float),
+    [NGLI_TYPE_VEC3]   = 3 * sizeof(float),
+    [NGLI_TYPE_VEC4]   = 4 * sizeof(float),
+    [NGLI_TYPE_MAT3]   = 9 * sizeof(float),
+    [NGLI_TYPE_MAT4]   = 16 * sizeof(float),
+};
+
 static int build_uniform_bindings(struct pipeline *s, const struct pipeline_params *params)
 {
     struct pipeline_gl *s_priv = (struct pipeline_gl *)s;
@@ -180,23 +201,42 @@ static int build_uniform_bindings(struct pipeline *s, const struct pipeline_para
             .location = info->location,
             .set = set_func,
             .desc = *uniform_desc,
+            .data_size = uniform_size_map[uniform_desc->type] * uniform_desc->count,
         };
-        if (!ngli_darray_push(&s_priv->uniform_bindings, &binding))
+        binding.data = ngli_calloc(1, binding.data_size);
+        if (!binding.data)
             return NGL_ERROR_MEMORY;
+        if (!ngli_darray_push(&s_priv->uniform_bindings, &binding)) {
+            ngli_free(binding.data);
+            return NGL_ERROR_MEMORY;
+        }
     }
 
     return 0;
 }
 
+/*
+ * The uniform values are part of the program state, which is shared with the
+ * other pipelines using the same program: only the values changed since the
+ * previous draw are uploaded, unless another pipeline set the uniforms of the
+ * program in the meantime. The owner is only compared by address: a pipeline
+ * later allocated at the address of a destroyed one has all its values dirty.
+ */
 static void set_uniforms(struct pipeline *s, struct glcontext *gl)
 {
     struct pipeline_gl *s_priv = (struct pipeline_gl *)s;
+    struct program_gl *program_gl = (struct program_gl *)s->program;
+
+    const int upload_all = program_gl->uniforms_owner != s;
+    program_gl->uniforms_owner = s;
 
-    const struct uniform_binding *bindings = ngli_darray_data(&s_priv->uniform_bindings);
+    struct uniform_binding *bindings = ngli_darray_data(&s_priv->uniform_bindings);
     for (int i = 0; i < ngli_darray_count(&s_priv->uniform_bindings); i++) {
-        const struct uniform_binding *uniform_binding = &bindings[i];
-        if (uniform_binding->data)
-            uniform_binding->set(gl, uniform_binding->location, uniform_binding->desc.count, uniform_binding->data);
+        struct uniform_binding *uniform_binding = &bindings[i];
+        if (!uniform_binding->has_data || (!uniform_binding->dirty && !upload_all))
+            continue;
+        uniform_binding->set(gl, uniform_binding->location, uniform_binding->desc.count, uniform_binding->data);
+        uniform_binding->dirty = 0;
     }
 }
 
@@ -336,7 +376,8 @@ static int build_buffer_bindings(struct pipeline *s, const struct pipeline_param
     for (int i = 0; i < layout->nb_buffers; i++) {
         const struct pipeline_buffer_desc *pipeline_buffer_desc = &layout->buffers_desc[i];
 
-        if (pipeline_buffer_desc->type == NGLI_TYPE_UNIFORM_BUFFER &&
+        if ((pipeline_buffer_desc->type == NGLI_TYPE_UNIFORM_BUFFER ||
+             pipeline_buffer_desc->type == NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC) &&
             !(gl->features & NGLI_FEATURE_GL_UNIFORM_BUFFER_OBJECT)) {
             LOG(ERROR, "context does not support uniform buffer objects");
             return NGL_ERROR_GRAPHICS_UNSUPPORTED;
@@ -585,9 +626,9 @@ int ngli_pipeline_gl_set_resources(struct pipeline *s, const struct pipeline_res
 
     ngli_assert(ngli_darray_count(&s_priv->uniform_bindings) == resources->nb_uniforms);
     for (int i = 0; i < resources->nb_uniforms; i++) {
-        struct uniform_binding *uniform_binding = ngli_darray_get(&s_priv->uniform_bindings, i);
-        const void *uniform_data = resources->uniforms[i];
-        uniform_binding->data = uniform_data;
+        int ret = ngli_pipeline_gl_update_uniform(s, i, resources->uniforms[i]);
+        if (ret < 0)
+            return ret;
     }
 
     return 0;
@@ -638,17 +679,17 @@ int ngli_pipeline_gl_update_uniform(struct pipeline *s, int index, const void *d
         return NGL_ERROR_NOT_FOUND;
 
     struct uniform_binding *uniform_binding = ngli_darray_get(&s_priv->uniform_bindings, index);
+    if (!data)
+        return 0;
 
-    if (data) {
-        struct gpu_ctx *gpu_ctx = s->gpu_ctx;
-        struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)gpu_ctx;
-        struct glcontext *gl = gpu_ctx_gl->glcontext;
-        struct glstate *glstate = &gpu_ctx_gl->glstate;
-        struct program_gl *program_gl = (struct program_gl *)s->program;
-        ngli_glstate_use_program(gl, glstate, program_gl->id);
-        uniform_binding->set(gl, uniform_binding->location, uniform_binding->desc.count, data);
+    if (uniform_binding->has_data && !memcmp(uniform_binding->data, data, uniform_binding->data_size)) {
+        s->gpu_ctx->nb_elided_uniform_uploads++;
+        return 0;
     }
-    uniform_binding->data = NULL;
+
+    memcpy(uniform_binding->data, data, uniform_binding->data_size);
+    uniform_binding->has_data = 1;
+    uniform_binding->dirty = 1;
 
     return 0;
 }
@@ -679,11 +720,13 @@ int ngli_pipeline_gl_update_buffer(struct pipeline *s, int index, const struct b
         struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
         struct glcontext *gl = gpu_ctx_gl->glcontext;
         const struct gpu_limits *limits = &gl->limits;
-        if (buffer_binding->desc.type == NGLI_TYPE_UNIFORM_BUFFER) {
+        if (buffer_binding->desc.type == NGLI_TYPE_UNIFORM_BUFFER ||
+            buffer_binding->desc.type == NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC) {
             ngli_assert(buffer->usage & NGLI_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
-            if (buffer->size > limits->max_uniform_block_size) {
+            const int range = size ? size : buffer->size;
+            if (range > limits->max_uniform_block_size) {
                 LOG(ERROR, "buffer %s size (%d) exceeds max uniform block size (%d)",
-                    buffer_binding->desc.name, buffer->size, limits->max_uniform_block_size);
+                    buffer_binding->desc.name, range, limits->max_uniform_block_size);
                 return NGL_ERROR_GRAPHICS_LIMIT_EXCEEDED;
             }
         } else if (buffer_binding->desc.type == NGLI_TYPE_STORAGE_BUFFER) {
@@ -828,6 +871,9 @@ void ngli_pipeline_gl_freep(struct pipeline **sp)
 
     struct pipeline *s = *sp;
     struct pipeline_gl *s_priv = (struct pipeline_gl *)s;
+    struct uniform_binding *uniform_bindings = ngli_darray_data(&s_priv->uniform_bindings);
+    for (int i = 0; i < ngli_darray_count(&s_priv->uniform_bindings); i++)
+        ngli_freep(&uniform_bindings[i].data);
     ngli_darray_reset(&s_priv->uniform_bindings);
     ngli_darray_reset(&s_priv->texture_bindings);
     ngli_darray_reset(&s_priv->buffer_bindings);
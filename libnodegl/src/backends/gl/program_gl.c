@@ -19,9 +19,11 @@
  * under the License.
  */
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "diskcache.h"
 #include "gpu_ctx_gl.h"
 #include "glincludes.h"
 #include "log.h"
@@ -253,22 +255,124 @@ struct program *ngli_program_gl_create(struct gpu_ctx *gpu_ctx)
     return (struct program *)s;
 }
 
-int ngli_program_gl_init(struct program *s, const struct program_params *params)
+static int program_get_cache_key(struct program *s, const struct program_params *params,
+                                 struct diskcache_key *key)
+{
+    struct gpu_ctx *gpu_ctx = s->gpu_ctx;
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
+
+    if (!gpu_ctx->diskcache || !(gl->features & NGLI_FEATURE_GL_GET_PROGRAM_BINARY))
+        return 0;
+
+    GLint nb_formats = 0;
+    ngli_glGetIntegerv(gl, GL_NUM_PROGRAM_BINARY_FORMATS, &nb_formats);
+    if (!nb_formats)
+        return 0;
+
+    /*
+     * Program binaries are only guaranteed to be accepted by the exact same
+     * driver, so the renderer and version strings are part of the key.
+     */
+    static const GLenum strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    ngli_diskcache_key_init(key, "glprogram");
+    for (int i = 0; i < NGLI_ARRAY_NB(strings); i++) {
+        const char *str = (const char *)ngli_glGetString(gl, strings[i]);
+        ngli_diskcache_key_update_str(key, str ? str : "");
+    }
+    const char *srcs[] = {params->vertex, params->fragment, params->compute};
+    for (int i = 0; i < NGLI_ARRAY_NB(srcs); i++)
+        ngli_diskcache_key_update_str(key, srcs[i] ? srcs[i] : "");
+    return 1;
+}
+
+static int program_load_binary(struct program *s, const struct diskcache_key *key)
 {
     struct program_gl *s_priv = (struct program_gl *)s;
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
 
-    int ret = 0;
-    struct {
-        const char *name;
-        GLenum type;
-        const char *src;
-        GLuint id;
-    } shaders[] = {
-        [NGLI_PROGRAM_SHADER_VERT] = {"vertex",   GL_VERTEX_SHADER,   params->vertex,   0},
-        [NGLI_PROGRAM_SHADER_FRAG] = {"fragment", GL_FRAGMENT_SHADER, params->fragment, 0},
-        [NGLI_PROGRAM_SHADER_COMP] = {"compute",  GL_COMPUTE_SHADER,  params->compute,  0},
-    };
+    void *data;
+    size_t size;
+    if (ngli_diskcache_get(s->gpu_ctx->diskcache, key, &data, &size) < 0)
+        return 0;
 
+    /* Cached entries are the binary format followed by the program binary */
+    uint32_t format;
+    if (size <= sizeof(format) || size - sizeof(format) > INT_MAX) {
+        ngli_free(data);
+        return 0;
+    }
+    memcpy(&format, data, sizeof(format));
+
+    ngli_glProgramBinary(gl, s_priv->id, format, (const uint8_t *)data + sizeof(format),
+                         (GLsizei)(size - sizeof(format)));
+    ngli_free(data);
+
+    /* The driver is allowed to reject any binary (after an update for instance) */
+    GLint status = GL_FALSE;
+    ngli_glGetProgramiv(gl, s_priv->id, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        LOG(DEBUG, "cached program binary rejected by the driver");
+        return 0;
+    }
+    return 1;
+}
+
+static void program_store_binary(struct program *s, const struct diskcache_key *key)
+{
+    struct program_gl *s_priv = (struct program_gl *)s;
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
+
+    GLint length = 0;
+    ngli_glGetProgramiv(gl, s_priv->id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    uint32_t format;
+    uint8_t *data = ngli_malloc(sizeof(format) + length);
+    if (!data)
+        return;
+
+    GLenum binary_format = 0;
+    GLsizei binary_length = 0;
+    ngli_glGetProgramBinary(gl, s_priv->id, length, &binary_length, &binary_format, data + sizeof(format));
+    if (binary_length > 0) {
+        format = binary_format;
+        memcpy(data, &format, sizeof(format));
+        ngli_diskcache_put(s->gpu_ctx->diskcache, key, data, sizeof(format) + binary_length);
+    }
+    ngli_free(data);
+}
+
+static const struct {
+    const char *name;
+    GLenum type;
+} shader_types[] = {
+    [NGLI_PROGRAM_SHADER_VERT] = {"vertex",   GL_VERTEX_SHADER},
+    [NGLI_PROGRAM_SHADER_FRAG] = {"fragment", GL_FRAGMENT_SHADER},
+    [NGLI_PROGRAM_SHADER_COMP] = {"compute",  GL_COMPUTE_SHADER},
+};
+
+static void get_shader_sources(const struct program_params *params, const char **srcs)
+{
+    srcs[NGLI_PROGRAM_SHADER_VERT] = params->vertex;
+    srcs[NGLI_PROGRAM_SHADER_FRAG] = params->fragment;
+    srcs[NGLI_PROGRAM_SHADER_COMP] = params->compute;
+}
+
+/* State of a program between its submission and its completion */
+struct program_build {
+    GLuint shaders[NGLI_PROGRAM_SHADER_NB];
+    int from_cache;
+    int use_cache;
+    struct diskcache_key cache_key;
+};
+
+static int program_submit(struct program *s, const struct program_params *params, struct program_build *build)
+{
+    struct program_gl *s_priv = (struct program_gl *)s;
     struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
     struct glcontext *gl = gpu_ctx_gl->glcontext;
 
@@ -280,64 +384,142 @@ int ngli_program_gl_init(struct program *s, const struct program_params *params)
 
     s_priv->id = ngli_glCreateProgram(gl);
 
-    for (int i = 0; i < NGLI_ARRAY_NB(shaders); i++) {
-        if (!shaders[i].src)
+    build->use_cache = program_get_cache_key(s, params, &build->cache_key);
+    if (build->use_cache) {
+        if (program_load_binary(s, &build->cache_key)) {
+            build->from_cache = 1;
+            return 0;
+        }
+
+        /* Start over with a fresh program in case a cached binary was rejected */
+        ngli_glDeleteProgram(gl, s_priv->id);
+        s_priv->id = ngli_glCreateProgram(gl);
+        ngli_glProgramParameteri(gl, s_priv->id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    const char *srcs[NGLI_PROGRAM_SHADER_NB];
+    get_shader_sources(params, srcs);
+    for (int i = 0; i < NGLI_ARRAY_NB(srcs); i++) {
+        if (!srcs[i])
             continue;
-        GLuint shader = ngli_glCreateShader(gl, shaders[i].type);
-        shaders[i].id = shader;
-        ngli_glShaderSource(gl, shader, 1, &shaders[i].src, NULL);
+        GLuint shader = ngli_glCreateShader(gl, shader_types[i].type);
+        build->shaders[i] = shader;
+        ngli_glShaderSource(gl, shader, 1, &srcs[i], NULL);
         ngli_glCompileShader(gl, shader);
-        ret = program_check_status(gl, shader, GL_COMPILE_STATUS);
-        if (ret < 0) {
-            char *s_with_numbers = ngli_numbered_lines(shaders[i].src);
-            if (s_with_numbers) {
-                LOG(ERROR, "failed to compile shader \"%s\":\n%s",
-                    params->label ? params->label : "", s_with_numbers);
-                ngli_free(s_with_numbers);
-            }
-            goto fail;
-        }
         ngli_glAttachShader(gl, s_priv->id, shader);
     }
 
     ngli_glLinkProgram(gl, s_priv->id);
-    ret = program_check_status(gl, s_priv->id, GL_LINK_STATUS);
-    if (ret < 0) {
-        struct bstr *bstr = ngli_bstr_create();
-        if (bstr) {
-            ngli_bstr_printf(bstr, "failed to link shaders \"%s\":",
-                             params->label ? params->label : "");
-            for (int i = 0; i < NGLI_ARRAY_NB(shaders); i++) {
-                if (!shaders[i].src)
-                    continue;
-                char *s_with_numbers = ngli_numbered_lines(shaders[i].src);
+    return 0;
+}
+
+/*
+ * The compilation and link statuses are only queried at completion so that
+ * the driver can process the previously submitted programs in the background
+ * (see KHR_parallel_shader_compile).
+ */
+static int program_complete(struct program *s, const struct program_params *params, struct program_build *build)
+{
+    struct program_gl *s_priv = (struct program_gl *)s;
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
+
+    if (!build->from_cache) {
+        const char *srcs[NGLI_PROGRAM_SHADER_NB];
+        get_shader_sources(params, srcs);
+        for (int i = 0; i < NGLI_ARRAY_NB(srcs); i++) {
+            if (!srcs[i])
+                continue;
+            int ret = program_check_status(gl, build->shaders[i], GL_COMPILE_STATUS);
+            if (ret < 0) {
+                char *s_with_numbers = ngli_numbered_lines(srcs[i]);
                 if (s_with_numbers) {
-                    ngli_bstr_printf(bstr, "\n\n%s shader:\n%s", shaders[i].name, s_with_numbers);
+                    LOG(ERROR, "failed to compile shader \"%s\":\n%s",
+                        params->label ? params->label : "", s_with_numbers);
                     ngli_free(s_with_numbers);
                 }
+                return ret;
             }
-            LOG(ERROR, "%s", ngli_bstr_strptr(bstr));
-            ngli_bstr_freep(&bstr);
         }
-        goto fail;
-    }
 
-    for (int i = 0; i < NGLI_ARRAY_NB(shaders); i++)
-        ngli_glDeleteShader(gl, shaders[i].id);
+        int ret = program_check_status(gl, s_priv->id, GL_LINK_STATUS);
+        if (ret < 0) {
+            struct bstr *bstr = ngli_bstr_create();
+            if (bstr) {
+                ngli_bstr_printf(bstr, "failed to link shaders \"%s\":",
+                                 params->label ? params->label : "");
+                for (int i = 0; i < NGLI_ARRAY_NB(srcs); i++) {
+                    if (!srcs[i])
+                        continue;
+                    char *s_with_numbers = ngli_numbered_lines(srcs[i]);
+                    if (s_with_numbers) {
+                        ngli_bstr_printf(bstr, "\n\n%s shader:\n%s", shader_types[i].name, s_with_numbers);
+                        ngli_free(s_with_numbers);
+                    }
+                }
+                LOG(ERROR, "%s", ngli_bstr_strptr(bstr));
+                ngli_bstr_freep(&bstr);
+            }
+            return ret;
+        }
+
+        if (build->use_cache)
+            program_store_binary(s, &build->cache_key);
+    }
 
     s->uniforms = program_probe_uniforms(gl, s_priv->id);
     s->attributes = program_probe_attributes(gl, s_priv->id);
     s->buffer_blocks = program_probe_buffer_blocks(gl, s_priv->id);
-    if (!s->uniforms || !s->attributes || !s->buffer_blocks) {
-        ret = NGL_ERROR_MEMORY;
-        goto fail;
-    }
+    if (!s->uniforms || !s->attributes || !s->buffer_blocks)
+        return NGL_ERROR_MEMORY;
 
     return 0;
+}
+
+static void program_build_reset(struct glcontext *gl, struct program_build *build)
+{
+    for (int i = 0; i < NGLI_ARRAY_NB(build->shaders); i++)
+        ngli_glDeleteShader(gl, build->shaders[i]);
+    memset(build, 0, sizeof(*build));
+}
+
+int ngli_program_gl_init(struct program *s, const struct program_params *params)
+{
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)s->gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
+
+    struct program_build build = {0};
+    int ret = program_submit(s, params, &build);
+    if (ret >= 0)
+        ret = program_complete(s, params, &build);
+    program_build_reset(gl, &build);
+    return ret;
+}
 
-fail:
-    for (int i = 0; i < NGLI_ARRAY_NB(shaders); i++)
-        ngli_glDeleteShader(gl, shaders[i].id);
+int ngli_program_gl_init_batch(struct program **programs, const struct program_params *params,
+                               int nb_programs, struct threadpool *threadpool)
+{
+    struct gpu_ctx_gl *gpu_ctx_gl = (struct gpu_ctx_gl *)programs[0]->gpu_ctx;
+    struct glcontext *gl = gpu_ctx_gl->glcontext;
+
+    /*
+     * The GL context is only current on this thread, so the thread pool is
+     * not used: the parallelism is left to the driver by submitting all the
+     * programs before checking any of them.
+     */
+    struct program_build *builds = ngli_calloc(nb_programs, sizeof(*builds));
+    if (!builds)
+        return NGL_ERROR_MEMORY;
+
+    int ret = 0;
+    for (int i = 0; i < nb_programs && ret >= 0; i++)
+        ret = program_submit(programs[i], &params[i], &builds[i]);
+    for (int i = 0; i < nb_programs && ret >= 0; i++)
+        ret = program_complete(programs[i], &params[i], &builds[i]);
+
+    for (int i = 0; i < nb_programs; i++)
+        program_build_reset(gl, &builds[i]);
+    ngli_free(builds);
 
     return ret;
 }
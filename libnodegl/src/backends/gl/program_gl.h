@@ -26,14 +26,18 @@
 #include "program.h"
 
 struct gpu_ctx;
+struct threadpool;
 
 struct program_gl {
     struct program parent;
     GLuint id;
+    const struct pipeline *uniforms_owner; /* last pipeline which set the uniforms, see pipeline_gl.c */
 };
 
 struct program *ngli_program_gl_create(struct gpu_ctx *gpu_ctx);
 int ngli_program_gl_init(struct program *s, const struct program_params *params);
+int ngli_program_gl_init_batch(struct program **programs, const struct program_params *params,
+                               int nb_programs, struct threadpool *threadpool);
 void ngli_program_gl_freep(struct program **sp);
 
 #endif
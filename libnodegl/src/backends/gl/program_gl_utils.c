@@ -55,7 +55,8 @@ int ngli_program_gl_set_locations_and_bindings(struct program *s,
 
     for (int i = 0; i < layout.nb_buffers; i++) {
         const struct pipeline_buffer_desc *buffer_desc = &layout.buffers_desc[i];
-        if (buffer_desc->type != NGLI_TYPE_UNIFORM_BUFFER)
+        if (buffer_desc->type != NGLI_TYPE_UNIFORM_BUFFER &&
+            buffer_desc->type != NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC)
             continue;
         const GLuint block_index = ngli_glGetUniformBlockIndex(gl, s_priv->id, buffer_desc->name);
         ngli_glUniformBlockBinding(gl, s_priv->id, block_index, buffer_desc->binding);
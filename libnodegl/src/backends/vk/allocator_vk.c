@@ -0,0 +1,159 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <string.h>
+
+#include "allocator_vk.h"
+#include "memory.h"
+#include "utils.h"
+#include "vkcontext.h"
+#include "vkutils.h"
+
+#define MAX_BLOCK_SIZE (64 * 1024 * 1024)
+#define MIN_BLOCK_SIZE (1 * 1024 * 1024)
+
+/* VkDeviceMemory is not a pointer on 32-bit platforms */
+struct device_memory_vk {
+    VkDeviceMemory memory;
+};
+
+static void block_destroy(void *user_arg, void *memory, uint8_t *mapped_data)
+{
+    struct allocator_vk *s = user_arg;
+    struct vkcontext *vk = s->vk;
+    struct device_memory_vk *device_memory = memory;
+
+    if (mapped_data)
+        vkUnmapMemory(vk->device, device_memory->memory);
+    vkFreeMemory(vk->device, device_memory->memory, NULL);
+    ngli_free(device_memory);
+}
+
+static int block_create(void *user_arg, int pool, uint64_t size, void **memoryp, uint8_t **mapped_datap)
+{
+    struct allocator_vk *s = user_arg;
+    struct vkcontext *vk = s->vk;
+    const int mem_type_index = pool / 2;
+
+    struct device_memory_vk *device_memory = ngli_calloc(1, sizeof(*device_memory));
+    if (!device_memory)
+        return NGL_ERROR_MEMORY;
+
+    const VkMemoryAllocateInfo alloc_info = {
+        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+        .allocationSize  = size,
+        .memoryTypeIndex = mem_type_index,
+    };
+    VkResult res = vkAllocateMemory(vk->device, &alloc_info, NULL, &device_memory->memory);
+    if (res != VK_SUCCESS) {
+        ngli_free(device_memory);
+        s->block_res = res;
+        return ngli_vk_res2ret(res);
+    }
+
+    uint8_t *mapped_data = NULL;
+    const VkMemoryPropertyFlags mem_props = vk->phydev_mem_props.memoryTypes[mem_type_index].propertyFlags;
+    if ((mem_props & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && size) {
+        res = vkMapMemory(vk->device, device_memory->memory, 0, VK_WHOLE_SIZE, 0, (void **)&mapped_data);
+        if (res != VK_SUCCESS) {
+            block_destroy(s, device_memory, NULL);
+            s->block_res = res;
+            return ngli_vk_res2ret(res);
+        }
+    }
+
+    *memoryp = device_memory;
+    *mapped_datap = mapped_data;
+    return 0;
+}
+
+VkResult ngli_allocator_vk_init(struct allocator_vk *s, struct vkcontext *vk)
+{
+    memset(s, 0, sizeof(*s));
+    s->vk = vk;
+
+    /*
+     * Blocks are never larger than 1/8 of the smallest heap so a single block
+     * cannot starve small heaps (such as the host visible device local heap
+     * found on some discrete GPUs).
+     */
+    VkDeviceSize block_size = MAX_BLOCK_SIZE;
+    const VkPhysicalDeviceMemoryProperties *props = &vk->phydev_mem_props;
+    for (uint32_t i = 0; i < props->memoryHeapCount; i++)
+        block_size = NGLI_MIN(block_size, props->memoryHeaps[i].size / 8);
+    block_size = NGLI_MAX(block_size, MIN_BLOCK_SIZE);
+
+    const struct block_alloc_params params = {
+        .nb_pools      = VK_MAX_MEMORY_TYPES * 2,
+        .block_size    = block_size,
+        .user_arg      = s,
+        .block_create  = block_create,
+        .block_destroy = block_destroy,
+    };
+    if (ngli_block_alloc_init(&s->blocks, &params) < 0)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    return VK_SUCCESS;
+}
+
+VkResult ngli_allocator_vk_alloc(struct allocator_vk *s, const VkMemoryRequirements *reqs,
+                                 int mem_type_index, int flags, struct allocation_vk *alloc)
+{
+    ngli_assert(mem_type_index >= 0 && mem_type_index < VK_MAX_MEMORY_TYPES);
+
+    memset(alloc, 0, sizeof(*alloc));
+
+    const int pool = mem_type_index * 2 + !!(flags & NGLI_ALLOCATION_VK_OPTIMAL);
+    const int dedicated = !!(flags & NGLI_ALLOCATION_VK_DEDICATED);
+
+    s->block_res = VK_SUCCESS;
+    int ret = ngli_block_alloc_alloc(&s->blocks, pool, reqs->size, reqs->alignment, dedicated, &alloc->alloc);
+    if (ret < 0)
+        return s->block_res != VK_SUCCESS ? s->block_res : VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    const struct device_memory_vk *device_memory = alloc->alloc.memory;
+    alloc->memory      = device_memory->memory;
+    alloc->offset      = alloc->alloc.offset;
+    alloc->mapped_data = alloc->alloc.mapped_data;
+
+    return VK_SUCCESS;
+}
+
+void ngli_allocator_vk_free(struct allocator_vk *s, struct allocation_vk *alloc)
+{
+    ngli_block_alloc_free(&s->blocks, &alloc->alloc);
+    memset(alloc, 0, sizeof(*alloc));
+}
+
+void ngli_allocator_vk_get_stats(const struct allocator_vk *s, struct block_alloc_stats *stats)
+{
+    *stats = s->blocks.stats;
+}
+
+void ngli_allocator_vk_reset(struct allocator_vk *s)
+{
+    if (!s->vk)
+        return;
+
+    ngli_block_alloc_reset(&s->blocks);
+    memset(s, 0, sizeof(*s));
+}
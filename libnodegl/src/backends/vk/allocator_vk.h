@@ -0,0 +1,63 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef ALLOCATOR_VK_H
+#define ALLOCATOR_VK_H
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+#include "block_alloc.h"
+
+struct vkcontext;
+
+#define NGLI_ALLOCATION_VK_DEDICATED (1 << 0) /* always use a dedicated VkDeviceMemory */
+#define NGLI_ALLOCATION_VK_OPTIMAL   (1 << 1) /* resource is an optimally tiled image */
+
+struct allocation_vk {
+    VkDeviceMemory memory;
+    VkDeviceSize offset;
+    uint8_t *mapped_data; /* host visible memory is persistently mapped */
+    struct block_alloc_allocation alloc;
+};
+
+/*
+ * Device memory sub-allocator. Small resources are packed into large
+ * per-memory-type blocks, while large ones get their own dedicated
+ * VkDeviceMemory (see block_alloc.h). Linear resources (buffers) and
+ * optimally tiled images never share a block, which frees us from having to
+ * honor bufferImageGranularity.
+ */
+struct allocator_vk {
+    struct vkcontext *vk;
+    struct block_alloc blocks; /* one pool per memory type and tiling */
+    VkResult block_res;        /* result of the last failed block creation */
+};
+
+VkResult ngli_allocator_vk_init(struct allocator_vk *s, struct vkcontext *vk);
+VkResult ngli_allocator_vk_alloc(struct allocator_vk *s, const VkMemoryRequirements *reqs,
+                                 int mem_type_index, int flags, struct allocation_vk *alloc);
+void ngli_allocator_vk_free(struct allocator_vk *s, struct allocation_vk *alloc);
+void ngli_allocator_vk_get_stats(const struct allocator_vk *s, struct block_alloc_stats *stats);
+void ngli_allocator_vk_reset(struct allocator_vk *s);
+
+#endif
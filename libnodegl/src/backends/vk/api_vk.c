@@ -21,12 +21,31 @@
 
 #include "internal.h"
 
+/*
+ * The Vulkan context is not bound to any thread, so the synchronous commands
+ * are executed directly by the caller while the asynchronous draws are
+ * dispatched to the worker thread.
+ */
+static int cmd_draw(struct ngl_ctx *s, void *arg)
+{
+    const double t = *(double *)arg;
+    return ngli_ctx_draw(s, t);
+}
+
+static int vk_draw_async(struct ngl_ctx *s, double t)
+{
+    s->draw_async_time = t;
+    return ngli_ctx_dispatch_cmd_async(s, cmd_draw, &s->draw_async_time);
+}
+
 const struct api_impl api_vk = {
     .configure          = ngli_ctx_configure,
     .resize             = ngli_ctx_resize,
     .set_capture_buffer = ngli_ctx_set_capture_buffer,
+    .fetch_capture      = ngli_ctx_fetch_capture,
     .set_scene          = ngli_ctx_set_scene,
     .prepare_draw       = ngli_ctx_prepare_draw,
     .draw               = ngli_ctx_draw,
+    .draw_async         = vk_draw_async,
     .reset              = ngli_ctx_reset,
 };
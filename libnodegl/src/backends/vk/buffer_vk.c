@@ -28,15 +28,16 @@
 #include "memory.h"
 #include "vkcontext.h"
 
-static VkResult create_vk_buffer(struct vkcontext *vk,
+static VkResult create_vk_buffer(struct gpu_ctx_vk *gpu_ctx_vk,
                                  VkDeviceSize size,
                                  VkBufferUsageFlags usage,
                                  VkMemoryPropertyFlags mem_props,
                                  VkBuffer *bufferp,
-                                 VkDeviceMemory *memoryp)
+                                 struct allocation_vk *allocp)
 {
+    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     VkBuffer buffer = VK_NULL_HANDLE;
-    VkDeviceMemory memory = VK_NULL_HANDLE;
+    struct allocation_vk alloc = {0};
 
     const VkBufferCreateInfo buffer_create_info = {
         .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
@@ -62,27 +63,22 @@ static VkResult create_vk_buffer(struct vkcontext *vk,
         }
     }
 
-    const VkMemoryAllocateInfo memory_allocate_info = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = mem_reqs.size,
-        .memoryTypeIndex = mem_type_index,
-    };
-    res = vkAllocateMemory(vk->device, &memory_allocate_info, NULL, &memory);
+    res = ngli_allocator_vk_alloc(&gpu_ctx_vk->allocator, &mem_reqs, mem_type_index, 0, &alloc);
     if (res != VK_SUCCESS)
         goto fail;
 
-    res = vkBindBufferMemory(vk->device, buffer, memory, 0);
+    res = vkBindBufferMemory(vk->device, buffer, alloc.memory, alloc.offset);
     if (res != VK_SUCCESS)
         goto fail;
 
     *bufferp = buffer;
-    *memoryp = memory;
+    *allocp = alloc;
 
     return VK_SUCCESS;
 
 fail:
     vkDestroyBuffer(vk->device, buffer, NULL);
-    vkFreeMemory(vk->device, memory, NULL);
+    ngli_allocator_vk_free(&gpu_ctx_vk->allocator, &alloc);
     return res;
 }
 
@@ -108,7 +104,6 @@ struct buffer *ngli_buffer_vk_create(struct gpu_ctx *gpu_ctx)
 VkResult ngli_buffer_vk_init(struct buffer *s, int size, int usage)
 {
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
-    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct buffer_vk *s_priv = (struct buffer_vk *)s;
 
     s->size = size;
@@ -128,7 +123,7 @@ VkResult ngli_buffer_vk_init(struct buffer *s, int size, int usage)
     }
 
     const VkBufferUsageFlags flags = get_vk_buffer_usage_flags(usage);
-    return create_vk_buffer(vk, size, flags, mem_props, &s_priv->buffer, &s_priv->memory);
+    return create_vk_buffer(gpu_ctx_vk, size, flags, mem_props, &s_priv->buffer, &s_priv->alloc);
 }
 
 VkResult ngli_buffer_vk_upload(struct buffer *s, const void *data, int size, int offset)
@@ -136,8 +131,13 @@ VkResult ngli_buffer_vk_upload(struct buffer *s, const void *data, int size, int
     if (s->usage & NGLI_BUFFER_USAGE_MAP_READ ||
         s->usage & NGLI_BUFFER_USAGE_MAP_WRITE ||
         s->usage & NGLI_BUFFER_USAGE_DYNAMIC_BIT) {
+        /* The mapped memory is shared by all the frames in flight */
+        VkResult res = ngli_cmd_vk_wait_pending(s->gpu_ctx);
+        if (res != VK_SUCCESS)
+            return res;
+
         void *mapped_data;
-        VkResult res = ngli_buffer_vk_map(s, size, offset, &mapped_data);
+        res = ngli_buffer_vk_map(s, size, offset, &mapped_data);
         if (res != VK_SUCCESS)
             return res;
         memcpy(mapped_data, data, size);
@@ -149,20 +149,24 @@ VkResult ngli_buffer_vk_upload(struct buffer *s, const void *data, int size, int
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct buffer_vk *s_priv = (struct buffer_vk *)s;
 
+    /*
+     * During the update phase of a frame, the copy is recorded into the
+     * update command buffer using the per-frame staging ring. Copies are not
+     * allowed inside a render pass, which is why we fall back on the
+     * transient command path in that case (and outside of any frame).
+     */
+    if (ngli_staging_ring_vk_is_recording(&gpu_ctx_vk->staging_ring) && !gpu_ctx_vk->current_rt)
+        return ngli_staging_ring_vk_upload(&gpu_ctx_vk->staging_ring, s, data, size, offset);
+
     const VkBufferUsageFlags usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     const VkMemoryPropertyFlags mem_props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    VkResult res = create_vk_buffer(vk, s->size, usage, mem_props,
-                                    &s_priv->staging_buffer, &s_priv->staging_memory);
+    VkResult res = create_vk_buffer(gpu_ctx_vk, s->size, usage, mem_props,
+                                    &s_priv->staging_buffer, &s_priv->staging_alloc);
     if (res != VK_SUCCESS)
         return res;
 
-    uint8_t *mapped_data;
-    res = vkMapMemory(vk->device, s_priv->staging_memory, 0, s->size, 0, (void *)&mapped_data);
-    if (res != VK_SUCCESS)
-        return res;
-    memcpy(mapped_data + offset, data, size);
-    vkUnmapMemory(vk->device, s_priv->staging_memory);
+    memcpy(s_priv->staging_alloc.mapped_data + offset, data, size);
 
     struct cmd_vk *cmd_vk;
     res = ngli_cmd_vk_begin_transient(s->gpu_ctx, 0, &cmd_vk);
@@ -182,28 +186,38 @@ VkResult ngli_buffer_vk_upload(struct buffer *s, const void *data, int size, int
 
     vkDestroyBuffer(vk->device, s_priv->staging_buffer, NULL);
     s_priv->staging_buffer = VK_NULL_HANDLE;
-    vkFreeMemory(vk->device, s_priv->staging_memory, NULL);
-    s_priv->staging_memory = VK_NULL_HANDLE;
+    ngli_allocator_vk_free(&gpu_ctx_vk->allocator, &s_priv->staging_alloc);
 
     return VK_SUCCESS;
 }
 
 VkResult ngli_buffer_vk_map(struct buffer *s, int size, int offset, void **data)
 {
-    struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
-    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct buffer_vk *s_priv = (struct buffer_vk *)s;
 
-    return vkMapMemory(vk->device, s_priv->memory, offset, size, 0, data);
+    /* Host visible memory is persistently mapped by the allocator */
+    if (!s_priv->alloc.mapped_data)
+        return VK_ERROR_MEMORY_MAP_FAILED;
+    *data = s_priv->alloc.mapped_data + offset;
+    return VK_SUCCESS;
 }
 
 void ngli_buffer_vk_unmap(struct buffer *s)
+{
+}
+
+void ngli_buffer_vk_release(struct buffer *s)
 {
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct buffer_vk *s_priv = (struct buffer_vk *)s;
 
-    vkUnmapMemory(vk->device, s_priv->memory);
+    vkDestroyBuffer(vk->device, s_priv->buffer, NULL);
+    s_priv->buffer = VK_NULL_HANDLE;
+    ngli_allocator_vk_free(&gpu_ctx_vk->allocator, &s_priv->alloc);
+    vkDestroyBuffer(vk->device, s_priv->staging_buffer, NULL);
+    s_priv->staging_buffer = VK_NULL_HANDLE;
+    ngli_allocator_vk_free(&gpu_ctx_vk->allocator, &s_priv->staging_alloc);
 }
 
 void ngli_buffer_vk_freep(struct buffer **sp)
@@ -211,14 +225,6 @@ void ngli_buffer_vk_freep(struct buffer **sp)
     if (!*sp)
         return;
 
-    struct buffer *s = *sp;
-    struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
-    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
-    struct buffer_vk *s_priv = (struct buffer_vk *)s;
-
-    vkDestroyBuffer(vk->device, s_priv->buffer, NULL);
-    vkFreeMemory(vk->device, s_priv->memory, NULL);
-    vkDestroyBuffer(vk->device, s_priv->staging_buffer, NULL);
-    vkFreeMemory(vk->device, s_priv->staging_memory, NULL);
+    ngli_buffer_vk_release(*sp);
     ngli_freep(sp);
 }
@@ -22,16 +22,19 @@
 #ifndef BUFFER_VK_H
 #define BUFFER_VK_H
 
+#include <stdint.h>
 #include <vulkan/vulkan.h>
 
+#include "allocator_vk.h"
 #include "buffer.h"
 
 struct buffer_vk {
     struct buffer parent;
     VkBuffer buffer;
-    VkDeviceMemory memory;
+    struct allocation_vk alloc;
     VkBuffer staging_buffer;
-    VkDeviceMemory staging_memory;
+    struct allocation_vk staging_alloc;
+    uint64_t staging_frame_id; /* last update in which a copy to this buffer was recorded */
 };
 
 struct buffer *ngli_buffer_vk_create(struct gpu_ctx *gpu_ctx);
@@ -39,6 +42,12 @@ VkResult ngli_buffer_vk_init(struct buffer *s, int size, int usage);
 VkResult ngli_buffer_vk_upload(struct buffer *s, const void *data, int size, int offset);
 VkResult ngli_buffer_vk_map(struct buffer *s, int size, int offset, void **data);
 void ngli_buffer_vk_unmap(struct buffer *s);
+
+/*
+ * Release the Vulkan buffer and its memory but keep the buffer itself, so its
+ * address is not reused by another allocation until ngli_buffer_vk_freep()
+ */
+void ngli_buffer_vk_release(struct buffer *s);
 void ngli_buffer_vk_freep(struct buffer **sp);
 
 #endif
@@ -174,6 +174,25 @@ VkResult ngli_cmd_vk_wait(struct cmd_vk *s)
     return VK_SUCCESS;
 }
 
+/*
+ * Wait for all the submitted commands, including the ones of the other frames
+ * in flight. This must be called before the host writes into memory which is
+ * not multi-buffered and may still be read by the GPU.
+ */
+VkResult ngli_cmd_vk_wait_pending(struct gpu_ctx *gpu_ctx)
+{
+    struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)gpu_ctx;
+
+    while (ngli_darray_count(&gpu_ctx_vk->pending_cmds)) {
+        struct cmd_vk **cmds = ngli_darray_data(&gpu_ctx_vk->pending_cmds);
+        VkResult res = ngli_cmd_vk_wait(cmds[0]);
+        if (res != VK_SUCCESS)
+            return res;
+    }
+
+    return VK_SUCCESS;
+}
+
 VkResult ngli_cmd_vk_begin_transient(struct gpu_ctx *gpu_ctx, int type, struct cmd_vk **sp)
 {
     struct cmd_vk *s = ngli_cmd_vk_create(gpu_ctx);
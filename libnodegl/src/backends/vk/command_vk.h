@@ -45,6 +45,7 @@ VkResult ngli_cmd_vk_add_signal_sem(struct cmd_vk *s, VkSemaphore *sem);
 VkResult ngli_cmd_vk_begin(struct cmd_vk *s);
 VkResult ngli_cmd_vk_submit(struct cmd_vk *s);
 VkResult ngli_cmd_vk_wait(struct cmd_vk *s);
+VkResult ngli_cmd_vk_wait_pending(struct gpu_ctx *gpu_ctx);
 
 VkResult ngli_cmd_vk_begin_transient(struct gpu_ctx *gpu_ctx, int type, struct cmd_vk **sp);
 VkResult ngli_cmd_vk_execute_transient(struct cmd_vk **sp);
@@ -82,6 +82,7 @@ int ngli_glslang_compile(int stage, const char *src, void **datap, size_t *sizep
         .resource                          = glslang_default_resource(),
     };
 
+    /* Any change in this input must be reflected in ngli_glslang_get_cache_key() */
     glslang_shader_t *shader = glslang_shader_create(&glslc_input);
     if (!shader)
         return NGL_ERROR_MEMORY;
@@ -141,6 +142,19 @@ int ngli_glslang_compile(int stage, const char *src, void **datap, size_t *sizep
     return 0;
 }
 
+void ngli_glslang_get_cache_key(struct diskcache_key *key, int stage, const char *src)
+{
+    ngli_diskcache_key_init(key, "spirv");
+    ngli_diskcache_key_update_int(key, GLSLANG_VERSION_MAJOR);
+    ngli_diskcache_key_update_int(key, GLSLANG_VERSION_MINOR);
+    ngli_diskcache_key_update_int(key, GLSLANG_VERSION_PATCH);
+    ngli_diskcache_key_update_str(key, GLSLANG_VERSION_FLAVOR);
+    ngli_diskcache_key_update_int(key, GLSLANG_TARGET_VULKAN_1_1);
+    ngli_diskcache_key_update_int(key, GLSLANG_TARGET_SPV_1_3);
+    ngli_diskcache_key_update_int(key, stage);
+    ngli_diskcache_key_update_str(key, src);
+}
+
 void ngli_glslang_uninit(void)
 {
     pthread_mutex_lock(&lock);
@@ -27,8 +27,11 @@
 #include <glslang/build_info.h>
 #include <glslang/Include/glslang_c_interface.h>
 
+#include "diskcache.h"
+
 int ngli_glslang_init(void);
 int ngli_glslang_compile(int stage, const char *src, void **datap, size_t *sizep);
+void ngli_glslang_get_cache_key(struct diskcache_key *key, int stage, const char *src);
 void ngli_glslang_uninit(void);
 
 #endif
@@ -27,6 +27,7 @@
 #include <vulkan/vulkan.h>
 
 #include "glslang_utils.h"
+#include "hmap.h"
 #include "internal.h"
 #include "log.h"
 #include "math_utils.h"
@@ -252,21 +253,28 @@ static VkResult create_render_resources(struct gpu_ctx *s)
     }
 
     if (config->offscreen) {
-        s_priv->capture_buffer = ngli_buffer_vk_create(s);
-        if (!s_priv->capture_buffer)
+        s_priv->capture_slots = ngli_calloc(s_priv->nb_in_flight_frames, sizeof(*s_priv->capture_slots));
+        if (!s_priv->capture_slots)
             return VK_ERROR_OUT_OF_HOST_MEMORY;
 
         s_priv->capture_buffer_size = s_priv->width * s_priv->height * ngli_format_get_bytes_per_pixel(color_format);
-        VkResult res = ngli_buffer_vk_init(s_priv->capture_buffer,
-                                           s_priv->capture_buffer_size,
-                                           NGLI_BUFFER_USAGE_MAP_READ |
-                                           NGLI_BUFFER_USAGE_TRANSFER_DST_BIT);
-        if (res != VK_SUCCESS)
-            return res;
+        for (int i = 0; i < s_priv->nb_in_flight_frames; i++) {
+            struct capture_slot_vk *slot = &s_priv->capture_slots[i];
+            slot->buffer = ngli_buffer_vk_create(s);
+            if (!slot->buffer)
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
 
-        res = ngli_buffer_vk_map(s_priv->capture_buffer, s_priv->capture_buffer_size, 0, &s_priv->mapped_data);
-        if (res != VK_SUCCESS)
-            return res;
+            VkResult res = ngli_buffer_vk_init(slot->buffer,
+                                               s_priv->capture_buffer_size,
+                                               NGLI_BUFFER_USAGE_MAP_READ |
+                                               NGLI_BUFFER_USAGE_TRANSFER_DST_BIT);
+            if (res != VK_SUCCESS)
+                return res;
+
+            res = ngli_buffer_vk_map(slot->buffer, s_priv->capture_buffer_size, 0, &slot->mapped_data);
+            if (res != VK_SUCCESS)
+                return res;
+        }
     }
 
     return VK_SUCCESS;
@@ -301,11 +309,16 @@ static void destroy_render_resources(struct gpu_ctx *s)
         ngli_rendertarget_vk_freep(&rts_load[i]);
     ngli_darray_reset(&s_priv->rts_load);
 
-    if (s_priv->mapped_data) {
-        ngli_buffer_unmap(s_priv->capture_buffer);
-        s_priv->mapped_data = NULL;
+    if (s_priv->capture_slots) {
+        for (int i = 0; i < s_priv->nb_in_flight_frames; i++) {
+            struct capture_slot_vk *slot = &s_priv->capture_slots[i];
+            if (slot->mapped_data)
+                ngli_buffer_unmap(slot->buffer);
+            ngli_buffer_vk_freep(&slot->buffer);
+        }
+        ngli_freep(&s_priv->capture_slots);
     }
-    ngli_buffer_vk_freep(&s_priv->capture_buffer);
+    ngli_darray_clear(&s_priv->pending_captures);
 }
 
 static VkResult create_query_pool(struct gpu_ctx *s)
@@ -330,6 +343,97 @@ static void destroy_query_pool(struct gpu_ctx *s)
     vkDestroyQueryPool(vk->device, s_priv->query_pool, NULL);
 }
 
+static void get_pipeline_cache_key(struct gpu_ctx *s, struct diskcache_key *key)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    struct vkcontext *vk = s_priv->vkcontext;
+    const VkPhysicalDeviceProperties *props = &vk->phy_device_props;
+
+    ngli_diskcache_key_init(key, "vkpipelinecache");
+    ngli_diskcache_key_update_int(key, props->vendorID);
+    ngli_diskcache_key_update_int(key, props->deviceID);
+    ngli_diskcache_key_update_int(key, props->driverVersion);
+    ngli_diskcache_key_update(key, props->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+/*
+ * Some drivers do not survive invalid initial data, so we check the header
+ * (VkPipelineCacheHeaderVersionOne) ourselves before handing it over.
+ */
+static int is_pipeline_cache_data_valid(struct gpu_ctx *s, const uint8_t *data, size_t size)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    struct vkcontext *vk = s_priv->vkcontext;
+    const VkPhysicalDeviceProperties *props = &vk->phy_device_props;
+
+    uint32_t header[4];
+    if (size < sizeof(header) + VK_UUID_SIZE)
+        return 0;
+    memcpy(header, data, sizeof(header));
+    return header[0] >= sizeof(header) + VK_UUID_SIZE &&
+           header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header[2] == props->vendorID &&
+           header[3] == props->deviceID &&
+           !memcmp(data + sizeof(header), props->pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+static VkResult create_pipeline_cache(struct gpu_ctx *s)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    struct vkcontext *vk = s_priv->vkcontext;
+
+    void *data = NULL;
+    size_t size = 0;
+    if (s->diskcache) {
+        struct diskcache_key key;
+        get_pipeline_cache_key(s, &key);
+        int ret = ngli_diskcache_get(s->diskcache, &key, &data, &size);
+        if (ret == 0 && !is_pipeline_cache_data_valid(s, data, size)) {
+            LOG(WARNING, "ignoring incompatible pipeline cache data");
+            ngli_freep(&data);
+            size = 0;
+        }
+    }
+
+    const VkPipelineCacheCreateInfo create_info = {
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = size,
+        .pInitialData    = data,
+    };
+    VkResult res = vkCreatePipelineCache(vk->device, &create_info, NULL, &s_priv->pipeline_cache);
+    ngli_freep(&data);
+    s_priv->pipeline_cache_size = size;
+    return res;
+}
+
+static void destroy_pipeline_cache(struct gpu_ctx *s)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    struct vkcontext *vk = s_priv->vkcontext;
+
+    if (!s_priv->pipeline_cache)
+        return;
+
+    /* Write back the cache only if new pipelines have been added to it */
+    size_t size = 0;
+    VkResult res = vkGetPipelineCacheData(vk->device, s_priv->pipeline_cache, &size, NULL);
+    if (s->diskcache && res == VK_SUCCESS && size && size != s_priv->pipeline_cache_size) {
+        void *data = ngli_malloc(size);
+        if (data) {
+            res = vkGetPipelineCacheData(vk->device, s_priv->pipeline_cache, &size, data);
+            if (res == VK_SUCCESS) {
+                struct diskcache_key key;
+                get_pipeline_cache_key(s, &key);
+                ngli_diskcache_put(s->diskcache, &key, data, size);
+            }
+            ngli_free(data);
+        }
+    }
+
+    vkDestroyPipelineCache(vk->device, s_priv->pipeline_cache, NULL);
+    s_priv->pipeline_cache = VK_NULL_HANDLE;
+}
+
 static VkResult create_command_pool_and_buffers(struct gpu_ctx *s)
 {
     struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
@@ -366,7 +470,7 @@ static VkResult create_command_pool_and_buffers(struct gpu_ctx *s)
             return res;
     }
 
-    ngli_darray_init(&s_priv->pending_cmds, sizeof(struct vmd_vk *), 0);
+    ngli_darray_init(&s_priv->pending_cmds, sizeof(struct cmd_vk *), 0);
 
     return VK_SUCCESS;
 }
@@ -825,6 +929,17 @@ static int vk_init(struct gpu_ctx *s)
         }
     }
 
+    if (config->capture_async_depth < 0 || config->capture_async_depth > NGLI_VK_MAX_IN_FLIGHT_FRAMES) {
+        LOG(ERROR, "invalid capture async depth: %d (max: %d)",
+            config->capture_async_depth, NGLI_VK_MAX_IN_FLIGHT_FRAMES);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    if (config->capture_async_depth && !config->offscreen) {
+        LOG(ERROR, "asynchronous capture is not supported by onscreen context");
+        return NGL_ERROR_INVALID_ARG;
+    }
+
 #if DEBUG_GPU_CAPTURE
     const char *var = getenv("NGL_GPU_CAPTURE");
     s->gpu_capture = var && !strcmp(var, "yes");
@@ -848,6 +963,7 @@ static int vk_init(struct gpu_ctx *s)
     ngli_darray_init(&s_priv->depth_stencils, sizeof(struct texture *), 0);
     ngli_darray_init(&s_priv->rts, sizeof(struct rendertarget *), 0);
     ngli_darray_init(&s_priv->rts_load, sizeof(struct rendertarget *), 0);
+    ngli_darray_init(&s_priv->pending_captures, sizeof(int), 0);
 
     s_priv->vkcontext = ngli_vkcontext_create();
     if (!s_priv->vkcontext)
@@ -865,6 +981,10 @@ static int vk_init(struct gpu_ctx *s)
         return ngli_vk_res2ret(res);
     }
 
+    res = ngli_allocator_vk_init(&s_priv->allocator, s_priv->vkcontext);
+    if (res != VK_SUCCESS)
+        return ngli_vk_res2ret(res);
+
 #if DEBUG_GPU_CAPTURE
     if (s->gpu_capture)
         ngli_gpu_capture_begin(s->gpu_capture_ctx);
@@ -903,6 +1023,8 @@ static int vk_init(struct gpu_ctx *s)
      * direct Vulkan equivalent so use a sane default value */
     s->limits.max_texture_image_units            = 32;
     s->limits.max_uniform_block_size             = limits->maxUniformBufferRange;
+    s->limits.min_uniform_block_offset_alignment = limits->minUniformBufferOffsetAlignment;
+    s->limits.max_push_constants_size            = limits->maxPushConstantsSize;
 
     if (config->set_surface_pts &&
         !ngli_vkcontext_has_extension(vk, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME, 1)) {
@@ -913,7 +1035,12 @@ static int vk_init(struct gpu_ctx *s)
 
     s_priv->width = config->width;
     s_priv->height = config->height;
-    s_priv->nb_in_flight_frames = 1;
+    /*
+     * Asynchronous offscreen captures get one frame in flight (and thus one
+     * capture buffer) per pending capture.
+     */
+    s_priv->nb_in_flight_frames = config->offscreen && config->capture_async_depth > 0
+                                ? config->capture_async_depth : 1;
 
     int ret = ngli_glslang_init();
     if (ret < 0)
@@ -923,6 +1050,14 @@ static int vk_init(struct gpu_ctx *s)
     if (res != VK_SUCCESS)
         return ngli_vk_res2ret(res);
 
+    res = create_pipeline_cache(s);
+    if (res != VK_SUCCESS)
+        return ngli_vk_res2ret(res);
+
+    s_priv->pipeline_states = ngli_hmap_create();
+    if (!s_priv->pipeline_states)
+        return NGL_ERROR_MEMORY;
+
     res = create_semaphores(s);
     if (res != VK_SUCCESS)
         return ngli_vk_res2ret(res);
@@ -931,6 +1066,14 @@ static int vk_init(struct gpu_ctx *s)
     if (res != VK_SUCCESS)
         return ngli_vk_res2ret(res);
 
+    res = ngli_staging_ring_vk_init(&s_priv->staging_ring, s, s_priv->nb_in_flight_frames);
+    if (res != VK_SUCCESS)
+        return ngli_vk_res2ret(res);
+
+    res = ngli_uniform_ring_vk_init(&s_priv->uniform_ring, s, s_priv->nb_in_flight_frames);
+    if (res != VK_SUCCESS)
+        return ngli_vk_res2ret(res);
+
     res = create_dummy_texture(s);
     if (res != VK_SUCCESS)
         return ngli_vk_res2ret(res);
@@ -1002,33 +1145,90 @@ static int vk_set_capture_buffer(struct gpu_ctx *s, void *capture_buffer)
     return 0;
 }
 
-static int vk_begin_update(struct gpu_ctx *s, double t)
+static int vk_fetch_capture(struct gpu_ctx *s, int wait, double *t)
 {
     struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    struct vkcontext *vk = s_priv->vkcontext;
+    const struct ngl_config *config = &s->config;
+
+    if (!ngli_darray_count(&s_priv->pending_captures))
+        return 0;
 
-    struct cmd_vk **cmds = ngli_darray_data(&s_priv->pending_cmds);
-    for (int i = 0; i < ngli_darray_count(&s_priv->pending_cmds); i++) {
-        VkResult res = ngli_cmd_vk_wait(cmds[i]);
+    const int *indices = ngli_darray_data(&s_priv->pending_captures);
+    const int index = indices[0];
+    struct cmd_vk *cmd_vk = s_priv->cmds[index];
+
+    if (!wait) {
+        VkResult res = vkGetFenceStatus(vk->device, cmd_vk->fence);
+        if (res == VK_NOT_READY)
+            return 0;
         if (res != VK_SUCCESS)
-            return res;
+            return ngli_vk_res2ret(res);
     }
-    ngli_darray_clear(&s_priv->pending_cmds);
 
-    struct cmd_vk *cmd_vk = s_priv->cmds[s_priv->cur_frame_index];
     VkResult res = ngli_cmd_vk_wait(cmd_vk);
+    if (res != VK_SUCCESS)
+        return ngli_vk_res2ret(res);
+
+    struct capture_slot_vk *slot = &s_priv->capture_slots[index];
+    memcpy(config->capture_buffer, slot->mapped_data, s_priv->capture_buffer_size);
+    if (t)
+        *t = slot->t;
+    slot->pending = 0;
+    ngli_darray_remove(&s_priv->pending_captures, 0);
+
+    return 1;
+}
+
+static int vk_begin_update(struct gpu_ctx *s, double t)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    const struct ngl_config *config = &s->config;
+
+    const int next_frame_index = (s_priv->cur_frame_index + 1) % s_priv->nb_in_flight_frames;
+    if (s_priv->capture_slots && config->capture_buffer &&
+        s_priv->capture_slots[next_frame_index].pending) {
+        LOG(ERROR, "asynchronous capture queue is full (%d pending captures), "
+            "ngl_fetch_capture() must be called before drawing",
+            ngli_darray_count(&s_priv->pending_captures));
+        return NGL_ERROR_LIMIT_EXCEEDED;
+    }
+
+    /*
+     * Only the commands of the frame slot about to be reused are waited for:
+     * the render targets, capture buffers, descriptor sets and the staging
+     * and uniform rings are all per frame. The host writes into the remaining
+     * shared memory (dynamic buffers and texture staging buffers) wait for
+     * the other frames in flight themselves with ngli_cmd_vk_wait_pending().
+     */
+    VkResult res = ngli_cmd_vk_wait(s_priv->update_cmds[next_frame_index]);
     if (res != VK_SUCCESS)
         return res;
 
-    s_priv->cur_frame_index = (s_priv->cur_frame_index + 1) % s_priv->nb_in_flight_frames;
+    res = ngli_cmd_vk_wait(s_priv->cmds[next_frame_index]);
+    if (res != VK_SUCCESS)
+        return res;
+
+    s_priv->cur_frame_index = next_frame_index;
+    s_priv->frame_id++;
 
     s_priv->cur_cmd = s_priv->update_cmds[s_priv->cur_frame_index];
-    return ngli_cmd_vk_begin(s_priv->cur_cmd);
+    res = ngli_cmd_vk_begin(s_priv->cur_cmd);
+    if (res != VK_SUCCESS)
+        return res;
+
+    ngli_staging_ring_vk_begin(&s_priv->staging_ring, s_priv->cur_frame_index, s_priv->cur_cmd);
+    ngli_uniform_ring_vk_begin(&s_priv->uniform_ring, s_priv->cur_frame_index);
+
+    return 0;
 }
 
 static int vk_end_update(struct gpu_ctx *s, double t)
 {
     struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
 
+    ngli_staging_ring_vk_end(&s_priv->staging_ring);
+
     VkSemaphore update_finished_sem = s_priv->update_finished_sems[s_priv->cur_frame_index];
     VkResult res = ngli_cmd_vk_add_signal_sem(s_priv->cur_cmd, &update_finished_sem);
     if (res != VK_SUCCESS)
@@ -1144,17 +1344,25 @@ static int vk_end_draw(struct gpu_ctx *s, double t)
         if (config->capture_buffer) {
             struct texture **colors = ngli_darray_data(&s_priv->colors);
             struct texture *color = colors[s_priv->cur_frame_index];
-            ngli_texture_vk_copy_to_buffer(color, s_priv->capture_buffer);
+            struct capture_slot_vk *slot = &s_priv->capture_slots[s_priv->cur_frame_index];
+            ngli_texture_vk_copy_to_buffer(color, slot->buffer);
 
             VkResult res = ngli_cmd_vk_submit(s_priv->cur_cmd);
             if (res != VK_SUCCESS)
                 return ngli_vk_res2ret(res);
 
-            res = ngli_cmd_vk_wait(s_priv->cur_cmd);
-            if (res != VK_SUCCESS)
-                return ngli_vk_res2ret(res);
-
-            memcpy(config->capture_buffer, s_priv->mapped_data, s_priv->capture_buffer_size);
+            if (config->capture_async_depth) {
+                slot->pending = 1;
+                slot->t = t;
+                if (!ngli_darray_push(&s_priv->pending_captures, &s_priv->cur_frame_index))
+                    return NGL_ERROR_MEMORY;
+            } else {
+                res = ngli_cmd_vk_wait(s_priv->cur_cmd);
+                if (res != VK_SUCCESS)
+                    return ngli_vk_res2ret(res);
+
+                memcpy(config->capture_buffer, slot->mapped_data, s_priv->capture_buffer_size);
+            }
         } else {
             VkResult res = ngli_cmd_vk_submit(s_priv->cur_cmd);
             if (res != VK_SUCCESS)
@@ -1193,18 +1401,43 @@ static void vk_destroy(struct gpu_ctx *s)
     ngli_gpu_capture_freep(&s->gpu_capture_ctx);
 #endif
 
+    ngli_staging_ring_vk_reset(&s_priv->staging_ring);
+    ngli_uniform_ring_vk_reset(&s_priv->uniform_ring);
     destroy_command_pool_and_buffers(s);
     destroy_semaphores(s);
     destroy_dummy_texture(s);
     destroy_render_resources(s);
+    ngli_darray_reset(&s_priv->pending_captures);
     destroy_swapchain(s);
     destroy_query_pool(s);
+    destroy_pipeline_cache(s);
+
+    /* Every pipeline, and thus every shared state, must be released by now */
+    ngli_assert(!s_priv->pipeline_states || !ngli_hmap_count(s_priv->pipeline_states));
+    ngli_hmap_freep(&s_priv->pipeline_states);
 
     ngli_glslang_uninit();
 
+    ngli_allocator_vk_reset(&s_priv->allocator);
     ngli_vkcontext_freep(&s_priv->vkcontext);
 }
 
+static int vk_get_memory_stats(struct gpu_ctx *s, struct gpu_memory_stats *stats)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+
+    struct block_alloc_stats allocator_stats;
+    ngli_allocator_vk_get_stats(&s_priv->allocator, &allocator_stats);
+
+    *stats = (struct gpu_memory_stats){
+        .used                  = allocator_stats.used,
+        .reserved              = allocator_stats.reserved,
+        .nb_allocations        = allocator_stats.nb_allocations,
+        .nb_device_allocations = allocator_stats.nb_device_allocations,
+    };
+    return 0;
+}
+
 static void vk_wait_idle(struct gpu_ctx *s)
 {
     struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
@@ -1412,6 +1645,15 @@ static void vk_buffer_unmap(struct buffer *s)
     ngli_buffer_vk_unmap(s);
 }
 
+static int vk_get_uniform_memory(struct gpu_ctx *s, int size, struct buffer **bufferp, int *offsetp, void **datap)
+{
+    struct gpu_ctx_vk *s_priv = (struct gpu_ctx_vk *)s;
+    VkResult res = ngli_uniform_ring_vk_alloc(&s_priv->uniform_ring, size, bufferp, offsetp, datap);
+    if (res != VK_SUCCESS)
+        LOG(ERROR, "unable to allocate uniform memory: %s", ngli_vk_res2str(res));
+    return ngli_vk_res2ret(res);
+}
+
 static int vk_texture_init(struct texture *s, const struct texture_params *params)
 {
     VkResult res = ngli_texture_vk_init(s, params);
@@ -1458,10 +1700,12 @@ const struct gpu_ctx_class ngli_gpu_ctx_vk = {
     .init                               = vk_init,
     .resize                             = vk_resize,
     .set_capture_buffer                 = vk_set_capture_buffer,
+    .fetch_capture                      = vk_fetch_capture,
     .begin_update                       = vk_begin_update,
     .end_update                         = vk_end_update,
     .begin_draw                         = vk_begin_draw,
     .query_draw_time                    = vk_query_draw_time,
+    .get_memory_stats                   = vk_get_memory_stats,
     .end_draw                           = vk_end_draw,
     .wait_idle                          = vk_wait_idle,
     .destroy                            = vk_destroy,
@@ -1490,6 +1734,7 @@ const struct gpu_ctx_class ngli_gpu_ctx_vk = {
     .buffer_map                         = vk_buffer_map,
     .buffer_unmap                       = vk_buffer_unmap,
     .buffer_freep                       = ngli_buffer_vk_freep,
+    .get_uniform_memory                 = vk_get_uniform_memory,
 
     .pipeline_create                    = ngli_pipeline_vk_create,
     .pipeline_init                      = vk_pipeline_init,
@@ -1505,6 +1750,7 @@ const struct gpu_ctx_class ngli_gpu_ctx_vk = {
 
     .program_create                     = ngli_program_vk_create,
     .program_init                       = ngli_program_vk_init,
+    .program_init_batch                 = ngli_program_vk_init_batch,
     .program_freep                      = ngli_program_vk_freep,
 
     .rendertarget_create                = ngli_rendertarget_vk_create,
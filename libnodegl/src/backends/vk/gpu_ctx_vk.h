@@ -22,13 +22,27 @@
 #ifndef GPU_CTX_VK_H
 #define GPU_CTX_VK_H
 
+#include "allocator_vk.h"
 #include "gpu_ctx.h"
 #include "vkcontext.h"
 #include "command_vk.h"
+#include "staging_ring_vk.h"
+#include "uniform_ring_vk.h"
+
+struct capture_slot_vk {
+    struct buffer *buffer;
+    void *mapped_data;
+    int pending;
+    double t;
+};
+
+/* Limited by the descriptor set update flags of the pipelines (2 sets per frame) */
+#define NGLI_VK_MAX_IN_FLIGHT_FRAMES 16
 
 struct gpu_ctx_vk {
     struct gpu_ctx parent;
     struct vkcontext *vkcontext;
+    struct allocator_vk allocator;
 
     VkSemaphore *image_avail_sems;
     VkSemaphore *update_finished_sems;
@@ -43,8 +57,15 @@ struct gpu_ctx_vk {
     struct cmd_vk *cur_cmd;
     int cur_cmd_is_transient;
 
+    struct staging_ring_vk staging_ring;
+    struct uniform_ring_vk uniform_ring;
+
     VkQueryPool query_pool;
 
+    VkPipelineCache pipeline_cache; /* shared by all the pipelines of the context */
+    size_t pipeline_cache_size;     /* size of the data the cache was created with */
+    struct hmap *pipeline_states;   /* pipeline_state_vk shared between identical pipelines */
+
     VkSurfaceCapabilitiesKHR surface_caps;
     VkSurfaceFormatKHR surface_format;
     VkPresentModeKHR present_mode;
@@ -60,15 +81,17 @@ struct gpu_ctx_vk {
 
     int nb_in_flight_frames;
     int cur_frame_index;
+    uint64_t frame_id; /* incremented at each frame, 0 before the first one */
 
     struct darray colors;
     struct darray ms_colors;
     struct darray depth_stencils;
     struct darray rts;
     struct darray rts_load;
-    struct buffer *capture_buffer;
+    /* Offscreen capture resources, one slot per in-flight frame */
+    struct capture_slot_vk *capture_slots;
     int capture_buffer_size;
-    void *mapped_data;
+    struct darray pending_captures;
 
     struct rendertarget *default_rt;
     struct rendertarget *default_rt_load;
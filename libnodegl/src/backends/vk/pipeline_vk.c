@@ -19,12 +19,14 @@
  * under the License.
  */
 
+#include <inttypes.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <limits.h>
 
 #include "darray.h"
+#include "diskcache.h"
 #include "format.h"
 #include "gpu_ctx_vk.h"
 #include "hmap.h"
@@ -53,10 +55,19 @@ struct attribute_binding {
     const struct buffer *buffer;
 };
 
+/*
+ * Each frame in flight owns 2 descriptor sets: updating a set already bound
+ * in the commands of the current frame would invalidate them, so such an
+ * update (typically the uniform ring growing in the middle of a frame) is
+ * written to the other set of the frame instead.
+ */
+#define NB_DESC_SETS_PER_FRAME 2
+
 struct buffer_binding {
     struct pipeline_buffer_desc desc;
     const struct buffer *buffer;
     uint32_t update_desc_flags;
+    int dynamic_offset_index; /* -1 if the binding is not dynamic */
 };
 
 struct texture_binding {
@@ -212,7 +223,7 @@ static VkResult create_attribute_descs(struct pipeline *s, const struct pipeline
     return VK_SUCCESS;
 }
 
-static VkResult pipeline_graphics_init(struct pipeline *s)
+static VkResult pipeline_graphics_init(struct pipeline *s, struct pipeline_state_vk *state)
 {
     const struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     const struct vkcontext *vk = gpu_ctx_vk->vkcontext;
@@ -351,22 +362,21 @@ static VkResult pipeline_graphics_init(struct pipeline *s)
         .pDepthStencilState  = &depthstencil_state_create_info,
         .pColorBlendState    = &colorblend_state_create_info,
         .pDynamicState       = &dynamic_state_create_info,
-        .layout              = s_priv->pipeline_layout,
+        .layout              = state->pipeline_layout,
         .renderPass          = render_pass,
         .subpass             = 0,
     };
-    res = vkCreateGraphicsPipelines(vk->device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &s_priv->pipeline);
+    res = vkCreateGraphicsPipelines(vk->device, gpu_ctx_vk->pipeline_cache, 1, &pipeline_create_info, NULL, &state->pipeline);
 
     vkDestroyRenderPass(vk->device, render_pass, NULL);
 
     return res;
 }
 
-static VkResult pipeline_compute_init(struct pipeline *s)
+static VkResult pipeline_compute_init(struct pipeline *s, struct pipeline_state_vk *state)
 {
     const struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     const struct vkcontext *vk = gpu_ctx_vk->vkcontext;
-    struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
     const struct program_vk *program_vk = (struct program_vk *)s->program;
     const VkPipelineShaderStageCreateInfo shader_stage_create_info = {
@@ -379,10 +389,10 @@ static VkResult pipeline_compute_init(struct pipeline *s)
     const VkComputePipelineCreateInfo pipeline_create_info = {
         .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
         .stage  = shader_stage_create_info,
-        .layout = s_priv->pipeline_layout,
+        .layout = state->pipeline_layout,
     };
 
-    return vkCreateComputePipelines(vk->device, VK_NULL_HANDLE, 1, &pipeline_create_info, NULL, &s_priv->pipeline);
+    return vkCreateComputePipelines(vk->device, gpu_ctx_vk->pipeline_cache, 1, &pipeline_create_info, NULL, &state->pipeline);
 }
 
 static const VkShaderStageFlags stage_flag_map[NGLI_PROGRAM_SHADER_NB] = {
@@ -397,14 +407,15 @@ static VkShaderStageFlags get_vk_stage_flags(int stage)
 }
 
 static const VkDescriptorType descriptor_type_map[NGLI_TYPE_NB] = {
-    [NGLI_TYPE_UNIFORM_BUFFER] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-    [NGLI_TYPE_STORAGE_BUFFER] = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-    [NGLI_TYPE_SAMPLER_2D]     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-    [NGLI_TYPE_SAMPLER_3D]     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-    [NGLI_TYPE_SAMPLER_CUBE]   = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-    [NGLI_TYPE_IMAGE_2D]       = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-    [NGLI_TYPE_IMAGE_3D]       = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-    [NGLI_TYPE_IMAGE_2D_ARRAY] = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    [NGLI_TYPE_UNIFORM_BUFFER]         = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+    [NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC] = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+    [NGLI_TYPE_STORAGE_BUFFER]         = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    [NGLI_TYPE_SAMPLER_2D]             = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    [NGLI_TYPE_SAMPLER_3D]             = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    [NGLI_TYPE_SAMPLER_CUBE]           = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+    [NGLI_TYPE_IMAGE_2D]               = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    [NGLI_TYPE_IMAGE_3D]               = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+    [NGLI_TYPE_IMAGE_2D_ARRAY]         = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
 };
 
 static VkDescriptorType get_vk_descriptor_type(int type)
@@ -423,14 +434,15 @@ static VkResult create_desc_set_layout_bindings(struct pipeline *s, const struct
     ngli_darray_init(&s_priv->desc_set_layout_bindings, sizeof(VkDescriptorSetLayoutBinding), 0);
 
     VkDescriptorPoolSize desc_pool_size_map[NGLI_TYPE_NB] = {
-        [NGLI_TYPE_UNIFORM_BUFFER] = {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER},
-        [NGLI_TYPE_STORAGE_BUFFER] = {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
-        [NGLI_TYPE_SAMPLER_2D]     = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
-        [NGLI_TYPE_SAMPLER_3D]     = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
-        [NGLI_TYPE_SAMPLER_CUBE]   = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
-        [NGLI_TYPE_IMAGE_2D]       = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
-        [NGLI_TYPE_IMAGE_3D]       = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
-        [NGLI_TYPE_IMAGE_2D_ARRAY] = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
+        [NGLI_TYPE_UNIFORM_BUFFER]         = {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER},
+        [NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC] = {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC},
+        [NGLI_TYPE_STORAGE_BUFFER]         = {.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER},
+        [NGLI_TYPE_SAMPLER_2D]             = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        [NGLI_TYPE_SAMPLER_3D]             = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        [NGLI_TYPE_SAMPLER_CUBE]           = {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER},
+        [NGLI_TYPE_IMAGE_2D]               = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
+        [NGLI_TYPE_IMAGE_3D]               = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
+        [NGLI_TYPE_IMAGE_2D_ARRAY]         = {.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE},
     };
 
     const struct pipeline_layout *layout = &params->layout;
@@ -447,14 +459,29 @@ static VkResult create_desc_set_layout_bindings(struct pipeline *s, const struct
         if (!ngli_darray_push(&s_priv->desc_set_layout_bindings, &binding))
             return VK_ERROR_OUT_OF_HOST_MEMORY;
 
+        /* The dynamic offsets are consumed in the increasing order of the bindings */
+        int dynamic_offset_index = -1;
+        if (desc->type == NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            dynamic_offset_index = 0;
+            for (int j = 0; j < layout->nb_buffers; j++) {
+                const struct pipeline_buffer_desc *other = &layout->buffers_desc[j];
+                if (other->type == NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC && other->binding < desc->binding)
+                    dynamic_offset_index++;
+            }
+            const uint32_t dynamic_offset = 0;
+            if (!ngli_darray_push(&s_priv->dynamic_offsets, &dynamic_offset))
+                return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+
         const struct buffer_binding buffer_binding = {
             .desc = *desc,
+            .dynamic_offset_index = dynamic_offset_index,
         };
         if (!ngli_darray_push(&s_priv->buffer_bindings, &buffer_binding))
             return VK_ERROR_OUT_OF_HOST_MEMORY;
 
         ngli_assert(desc_pool_size_map[desc->type].type);
-        desc_pool_size_map[desc->type].descriptorCount += gpu_ctx_vk->nb_in_flight_frames;
+        desc_pool_size_map[desc->type].descriptorCount += gpu_ctx_vk->nb_in_flight_frames * NB_DESC_SETS_PER_FRAME;
     }
 
     for (int i = 0; i < layout->nb_textures; i++) {
@@ -478,7 +505,7 @@ static VkResult create_desc_set_layout_bindings(struct pipeline *s, const struct
             return VK_ERROR_OUT_OF_HOST_MEMORY;
 
         ngli_assert(desc_pool_size_map[desc->type].type);
-        desc_pool_size_map[desc->type].descriptorCount += gpu_ctx_vk->nb_in_flight_frames;
+        desc_pool_size_map[desc->type].descriptorCount += gpu_ctx_vk->nb_in_flight_frames * NB_DESC_SETS_PER_FRAME;
     }
 
     uint32_t nb_desc_pool_sizes = 0;
@@ -494,7 +521,7 @@ static VkResult create_desc_set_layout_bindings(struct pipeline *s, const struct
         .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
         .poolSizeCount = nb_desc_pool_sizes,
         .pPoolSizes    = desc_pool_sizes,
-        .maxSets       = gpu_ctx_vk->nb_in_flight_frames,
+        .maxSets       = gpu_ctx_vk->nb_in_flight_frames * NB_DESC_SETS_PER_FRAME,
     };
 
     VkResult res = vkCreateDescriptorPool(vk->device, &descriptor_pool_create_info, NULL, &s_priv->desc_pool);
@@ -504,7 +531,38 @@ static VkResult create_desc_set_layout_bindings(struct pipeline *s, const struct
     return VK_SUCCESS;
 }
 
-static VkResult create_desc_layout(struct pipeline *s)
+/*
+ * The uniforms of the pipeline are push constants, shared by all the stages
+ * and laid out in the order of their declaration.
+ */
+static VkResult create_push_constants(struct pipeline *s, const struct pipeline_params *params)
+{
+    struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
+    const struct pipeline_layout *layout = &params->layout;
+
+    ngli_block_init(&s_priv->push_constants, NGLI_BLOCK_LAYOUT_STD430);
+    for (int i = 0; i < layout->nb_uniforms; i++) {
+        const struct pipeline_uniform_desc *desc = &layout->uniforms_desc[i];
+        const int count = desc->count > 1 ? desc->count : 0;
+        if (ngli_block_add_field(&s_priv->push_constants, desc->name, desc->type, count) < 0)
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    if (!s_priv->push_constants.size)
+        return VK_SUCCESS;
+
+    s_priv->push_constants_data = ngli_calloc(1, s_priv->push_constants.size);
+    if (!s_priv->push_constants_data)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    s_priv->push_constants_stages = s->type == NGLI_PIPELINE_TYPE_COMPUTE
+                                  ? VK_SHADER_STAGE_COMPUTE_BIT
+                                  : VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    return VK_SUCCESS;
+}
+
+static VkResult create_desc_layout(struct pipeline *s, struct pipeline_state_vk *state)
 {
     const struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     const struct vkcontext *vk = gpu_ctx_vk->vkcontext;
@@ -516,7 +574,7 @@ static VkResult create_desc_layout(struct pipeline *s)
         .pBindings    = ngli_darray_data(&s_priv->desc_set_layout_bindings),
     };
 
-    VkResult res = vkCreateDescriptorSetLayout(vk->device, &descriptor_set_layout_create_info, NULL, &s_priv->desc_set_layout);
+    VkResult res = vkCreateDescriptorSetLayout(vk->device, &descriptor_set_layout_create_info, NULL, &state->desc_set_layout);
     if (res != VK_SUCCESS)
         return res;
 
@@ -529,25 +587,32 @@ static VkResult create_desc_sets(struct pipeline *s)
     const struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
-    VkDescriptorSetLayout *desc_set_layouts = ngli_calloc(gpu_ctx_vk->nb_in_flight_frames, sizeof(*desc_set_layouts));
+    const int nb_desc_sets = gpu_ctx_vk->nb_in_flight_frames * NB_DESC_SETS_PER_FRAME;
+    ngli_assert(nb_desc_sets <= 32); /* update_desc_flags bits */
+
+    VkDescriptorSetLayout *desc_set_layouts = ngli_calloc(nb_desc_sets, sizeof(*desc_set_layouts));
     if (!desc_set_layouts)
         return VK_ERROR_OUT_OF_HOST_MEMORY;
 
-    for (int i = 0; i < gpu_ctx_vk->nb_in_flight_frames; i++)
-        desc_set_layouts[i] = s_priv->desc_set_layout;
+    for (int i = 0; i < nb_desc_sets; i++)
+        desc_set_layouts[i] = s_priv->state->desc_set_layout;
 
     const VkDescriptorSetAllocateInfo descriptor_set_allocate_info = {
         .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
         .descriptorPool     = s_priv->desc_pool,
-        .descriptorSetCount = gpu_ctx_vk->nb_in_flight_frames,
+        .descriptorSetCount = nb_desc_sets,
         .pSetLayouts        = desc_set_layouts
     };
 
-    s_priv->desc_sets = ngli_calloc(gpu_ctx_vk->nb_in_flight_frames, sizeof(*s_priv->desc_sets));
-    if (!s_priv->desc_sets) {
+    s_priv->desc_sets = ngli_calloc(nb_desc_sets, sizeof(*s_priv->desc_sets));
+    s_priv->desc_sets_bind_ids = ngli_calloc(nb_desc_sets, sizeof(*s_priv->desc_sets_bind_ids));
+    s_priv->cur_desc_sets = ngli_calloc(gpu_ctx_vk->nb_in_flight_frames, sizeof(*s_priv->cur_desc_sets));
+    if (!s_priv->desc_sets || !s_priv->desc_sets_bind_ids || !s_priv->cur_desc_sets) {
         ngli_free(desc_set_layouts);
         return VK_ERROR_OUT_OF_HOST_MEMORY;
     }
+    for (int i = 0; i < gpu_ctx_vk->nb_in_flight_frames; i++)
+        s_priv->cur_desc_sets[i] = i * NB_DESC_SETS_PER_FRAME;
 
     VkResult res = vkAllocateDescriptorSets(vk->device, &descriptor_set_allocate_info, s_priv->desc_sets);
     if (res != VK_SUCCESS) {
@@ -559,59 +624,245 @@ static VkResult create_desc_sets(struct pipeline *s)
     return VK_SUCCESS;
 }
 
-static VkResult create_pipeline_layout(struct pipeline *s)
+static VkResult create_pipeline_layout(struct pipeline *s, struct pipeline_state_vk *state)
 {
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
+    const VkPushConstantRange push_constant_range = {
+        .stageFlags = s_priv->push_constants_stages,
+        .offset     = 0,
+        .size       = s_priv->push_constants.size,
+    };
+
     const VkPipelineLayoutCreateInfo pipeline_layout_create_info = {
-        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = s_priv->desc_set_layout ? 1 : 0,
-        .pSetLayouts    = &s_priv->desc_set_layout,
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = state->desc_set_layout ? 1 : 0,
+        .pSetLayouts            = &state->desc_set_layout,
+        .pushConstantRangeCount = push_constant_range.size ? 1 : 0,
+        .pPushConstantRanges    = &push_constant_range,
     };
 
-    return vkCreatePipelineLayout(vk->device, &pipeline_layout_create_info, NULL, &s_priv->pipeline_layout);
+    return vkCreatePipelineLayout(vk->device, &pipeline_layout_create_info, NULL, &state->pipeline_layout);
 }
 
-static VkResult create_pipeline(struct pipeline *s)
+/*
+ * The key covers everything the VkPipeline, VkPipelineLayout and
+ * VkDescriptorSetLayout objects are created from. Programs are deduplicated by
+ * the program cache so their address is enough to identify them. The hash is
+ * only used to index the shared states: the serialized key material is kept
+ * along with each state and compared on lookup to rule out collisions.
+ */
+struct state_key {
+    struct diskcache_key hash;
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+    int oom;
+};
+
+static void state_key_update(struct state_key *key, const void *data, size_t size)
 {
-    VkResult res = create_desc_layout(s);
-    if (res != VK_SUCCESS)
-        return res;
+    ngli_diskcache_key_update(&key->hash, data, size);
+
+    if (key->oom || !size)
+        return;
+
+    if (key->size + size > key->capacity) {
+        const size_t capacity = NGLI_MAX(key->capacity * 2, key->size + size);
+        uint8_t *new_data = ngli_realloc(key->data, capacity);
+        if (!new_data) {
+            key->oom = 1;
+            return;
+        }
+        key->data = new_data;
+        key->capacity = capacity;
+    }
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+}
+
+static void state_key_update_int(struct state_key *key, int64_t value)
+{
+    state_key_update(key, &value, sizeof(value));
+}
+
+static VkResult get_state_key(struct pipeline *s, struct state_key *key)
+{
+    struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
-    res = create_desc_sets(s);
+    memset(key, 0, sizeof(*key));
+    ngli_diskcache_key_init(&key->hash, "vkpipelinestate");
+    state_key_update_int(key, s->type);
+    state_key_update_int(key, (int64_t)(uintptr_t)s->program);
+
+    if (s->type == NGLI_PIPELINE_TYPE_GRAPHICS) {
+        const struct pipeline_graphics *graphics = &s->graphics;
+        state_key_update_int(key, graphics->topology);
+        state_key_update(key, &graphics->state, sizeof(graphics->state));
+
+        const struct rendertarget_desc *rt_desc = &graphics->rt_desc;
+        state_key_update_int(key, rt_desc->samples);
+        state_key_update_int(key, rt_desc->nb_colors);
+        for (int i = 0; i < rt_desc->nb_colors; i++) {
+            state_key_update_int(key, rt_desc->colors[i].format);
+            state_key_update_int(key, rt_desc->colors[i].resolve);
+        }
+        state_key_update_int(key, rt_desc->depth_stencil.format);
+        state_key_update_int(key, rt_desc->depth_stencil.resolve);
+
+        state_key_update(key, ngli_darray_data(&s_priv->vertex_binding_descs),
+                         ngli_darray_count(&s_priv->vertex_binding_descs) * sizeof(VkVertexInputBindingDescription));
+        state_key_update(key, ngli_darray_data(&s_priv->vertex_attribute_descs),
+                         ngli_darray_count(&s_priv->vertex_attribute_descs) * sizeof(VkVertexInputAttributeDescription));
+    }
+
+    const VkDescriptorSetLayoutBinding *bindings = ngli_darray_data(&s_priv->desc_set_layout_bindings);
+    for (int i = 0; i < ngli_darray_count(&s_priv->desc_set_layout_bindings); i++) {
+        const VkDescriptorSetLayoutBinding *binding = &bindings[i];
+        state_key_update_int(key, binding->binding);
+        state_key_update_int(key, binding->descriptorType);
+        state_key_update_int(key, binding->descriptorCount);
+        state_key_update_int(key, binding->stageFlags);
+        /* The immutable samplers are kept alive by the pipelines using them */
+        const VkSampler sampler = binding->pImmutableSamplers ? binding->pImmutableSamplers[0] : VK_NULL_HANDLE;
+        state_key_update(key, &sampler, sizeof(sampler));
+    }
+
+    state_key_update_int(key, s_priv->push_constants.size);
+    state_key_update_int(key, s_priv->push_constants_stages);
+
+    if (key->oom) {
+        ngli_freep(&key->data);
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    }
+
+    return VK_SUCCESS;
+}
+
+static void destroy_state(struct gpu_ctx *gpu_ctx, struct pipeline_state_vk *state)
+{
+    struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)gpu_ctx;
+    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
+
+    vkDestroyPipeline(vk->device, state->pipeline, NULL);
+    vkDestroyPipelineLayout(vk->device, state->pipeline_layout, NULL);
+    vkDestroyDescriptorSetLayout(vk->device, state->desc_set_layout, NULL);
+    ngli_freep(&state->key_data);
+    ngli_free(state);
+}
+
+/* On success, the state takes ownership of the key material */
+static VkResult create_state(struct pipeline *s, struct state_key *key, struct pipeline_state_vk **statep)
+{
+    struct pipeline_state_vk *state = ngli_calloc(1, sizeof(*state));
+    if (!state)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    state->refcount = 1;
+    snprintf(state->key, sizeof(state->key), "%016" PRIx64 "%016" PRIx64, key->hash.h[0], key->hash.h[1]);
+
+    VkResult res = create_desc_layout(s, state);
     if (res != VK_SUCCESS)
-        return res;
+        goto fail;
 
-    res = create_pipeline_layout(s);
+    res = create_pipeline_layout(s, state);
     if (res != VK_SUCCESS)
-        return res;
+        goto fail;
 
     if (s->type == NGLI_PIPELINE_TYPE_GRAPHICS) {
-        res = pipeline_graphics_init(s);
+        res = pipeline_graphics_init(s, state);
     } else if (s->type == NGLI_PIPELINE_TYPE_COMPUTE) {
-        res = pipeline_compute_init(s);
+        res = pipeline_compute_init(s, state);
     } else {
         ngli_assert(0);
     }
+    if (res != VK_SUCCESS)
+        goto fail;
+
+    state->key_data = key->data;
+    state->key_size = key->size;
+    key->data = NULL;
+
+    *statep = state;
     return VK_SUCCESS;
+
+fail:
+    destroy_state(s->gpu_ctx, state);
+    return res;
 }
 
-static void destroy_pipeline_keep_pool(struct pipeline *s)
+static VkResult acquire_state(struct pipeline *s)
 {
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
-    struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
-    vkDestroyPipeline(vk->device, s_priv->pipeline, NULL);
-    s_priv->pipeline = VK_NULL_HANDLE;
+    struct state_key key;
+    VkResult res = get_state_key(s, &key);
+    if (res != VK_SUCCESS)
+        return res;
+
+    char hash_str[sizeof(s_priv->state->key)];
+    snprintf(hash_str, sizeof(hash_str), "%016" PRIx64 "%016" PRIx64, key.hash.h[0], key.hash.h[1]);
+
+    struct pipeline_state_vk *state = ngli_hmap_get(gpu_ctx_vk->pipeline_states, hash_str);
+    if (state && state->key_size == key.size && !memcmp(state->key_data, key.data, key.size)) {
+        ngli_freep(&key.data);
+        state->refcount++;
+        s_priv->state = state;
+        return VK_SUCCESS;
+    }
+
+    /*
+     * On a hash collision, the new state is kept private to the pipeline
+     * and the one already indexed remains shared.
+     */
+    const int shared = !state;
+
+    res = create_state(s, &key, &state);
+    ngli_freep(&key.data);
+    if (res != VK_SUCCESS)
+        return res;
 
-    vkDestroyPipelineLayout(vk->device, s_priv->pipeline_layout, NULL);
-    s_priv->pipeline_layout = VK_NULL_HANDLE;
+    if (shared) {
+        if (ngli_hmap_set(gpu_ctx_vk->pipeline_states, hash_str, state) < 0) {
+            destroy_state(s->gpu_ctx, state);
+            return VK_ERROR_OUT_OF_HOST_MEMORY;
+        }
+        state->shared = 1;
+    } else {
+        LOG(DEBUG, "pipeline state hash collision on %s", hash_str);
+    }
 
-    vkDestroyDescriptorSetLayout(vk->device, s_priv->desc_set_layout, NULL);
-    s_priv->desc_set_layout = VK_NULL_HANDLE;
+    s_priv->state = state;
+    return VK_SUCCESS;
+}
+
+static void release_state(struct pipeline *s)
+{
+    struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
+    struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
+    struct pipeline_state_vk *state = s_priv->state;
+
+    if (!state)
+        return;
+
+    if (state->refcount-- == 1) {
+        if (state->shared)
+            ngli_hmap_set(gpu_ctx_vk->pipeline_states, state->key, NULL);
+        destroy_state(s->gpu_ctx, state);
+    }
+
+    s_priv->state = NULL;
+}
+
+static VkResult create_pipeline(struct pipeline *s)
+{
+    VkResult res = acquire_state(s);
+    if (res != VK_SUCCESS)
+        return res;
+
+    return create_desc_sets(s);
 }
 
 static void destroy_pipeline(struct pipeline *s)
@@ -620,11 +871,13 @@ static void destroy_pipeline(struct pipeline *s)
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
     struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
 
-    destroy_pipeline_keep_pool(s);
+    release_state(s);
 
     vkDestroyDescriptorPool(vk->device, s_priv->desc_pool, NULL);
     s_priv->desc_pool = VK_NULL_HANDLE;
     ngli_freep(&s_priv->desc_sets);
+    ngli_freep(&s_priv->desc_sets_bind_ids);
+    ngli_freep(&s_priv->cur_desc_sets);
 }
 
 static void request_desc_sets_update(struct pipeline *s)
@@ -651,15 +904,17 @@ static VkResult recreate_pipeline(struct pipeline *s)
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
 
     /*
-     * Destroy the current pipeline but keep the descriptor pool to avoid
-     * re-allocating the descriptor sets.
+     * Release the current pipeline state but keep the descriptor pool to
+     * avoid re-allocating the descriptor sets.
      */
-    destroy_pipeline_keep_pool(s);
+    release_state(s);
 
     VkResult res = vkResetDescriptorPool(vk->device, s_priv->desc_pool, 0);
     if (res != VK_SUCCESS)
         return res;
     ngli_freep(&s_priv->desc_sets);
+    ngli_freep(&s_priv->desc_sets_bind_ids);
+    ngli_freep(&s_priv->cur_desc_sets);
 
     res = create_pipeline(s);
     if (res != VK_SUCCESS)
@@ -695,6 +950,7 @@ VkResult ngli_pipeline_vk_init(struct pipeline *s, const struct pipeline_params
     ngli_darray_init(&s_priv->texture_bindings, sizeof(struct texture_binding), 0);
     ngli_darray_init(&s_priv->buffer_bindings,  sizeof(struct buffer_binding), 0);
     ngli_darray_init(&s_priv->attribute_bindings, sizeof(struct attribute_binding), 0);
+    ngli_darray_init(&s_priv->dynamic_offsets, sizeof(uint32_t), 0);
 
     if (params->type == NGLI_PIPELINE_TYPE_GRAPHICS) {
         VkResult res = create_attribute_descs(s, params);
@@ -706,6 +962,10 @@ VkResult ngli_pipeline_vk_init(struct pipeline *s, const struct pipeline_params
     if (res != VK_SUCCESS)
         return res;
 
+    res = create_push_constants(s, params);
+    if (res != VK_SUCCESS)
+        return res;
+
     return create_pipeline(s);
 }
 
@@ -736,6 +996,13 @@ int ngli_pipeline_vk_set_resources(struct pipeline *s, const struct pipeline_res
             return ret;
     }
 
+    ngli_assert(ngli_darray_count(&s_priv->push_constants.fields) == resources->nb_uniforms);
+    for (int i = 0; i < resources->nb_uniforms; i++) {
+        int ret = ngli_pipeline_vk_update_uniform(s, i, resources->uniforms[i]);
+        if (ret < 0)
+            return ret;
+    }
+
     return 0;
 }
 
@@ -765,7 +1032,16 @@ int ngli_pipeline_vk_update_attribute(struct pipeline *s, int index, const struc
 
 int ngli_pipeline_vk_update_uniform(struct pipeline *s, int index, const void *value)
 {
-    return NGL_ERROR_GRAPHICS_UNSUPPORTED;
+    struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
+
+    if (index == -1)
+        return NGL_ERROR_NOT_FOUND;
+
+    const struct block_field *field = ngli_darray_get(&s_priv->push_constants.fields, index);
+    if (value)
+        ngli_block_field_copy(field, s_priv->push_constants_data + field->offset, value);
+
+    return 0;
 }
 
 static int need_desc_set_layout_update(const struct texture_binding *binding,
@@ -848,6 +1124,22 @@ int ngli_pipeline_vk_update_buffer(struct pipeline *s, int index, const struct b
     struct buffer_binding *buffer_binding = ngli_darray_get(&s_priv->buffer_bindings, index);
     ngli_assert(buffer_binding);
 
+    /*
+     * The offset of a dynamic buffer is given when binding the descriptor
+     * set, so only a change of buffer or size requires a descriptor update.
+     */
+    if (buffer_binding->dynamic_offset_index >= 0) {
+        uint32_t *dynamic_offsets = ngli_darray_data(&s_priv->dynamic_offsets);
+        dynamic_offsets[buffer_binding->dynamic_offset_index] = offset;
+        if (buffer_binding->buffer == buffer && buffer_binding->desc.size == size)
+            return 0;
+        buffer_binding->buffer = buffer;
+        buffer_binding->desc.offset = 0;
+        buffer_binding->desc.size = size;
+        buffer_binding->update_desc_flags = ~0;
+        return 0;
+    }
+
     buffer_binding->buffer = buffer;
     buffer_binding->desc.offset = offset;
     buffer_binding->desc.size = size;
@@ -866,12 +1158,55 @@ static VkIndexType get_vk_indices_type(int indices_format)
     return vk_indices_type_map[indices_format];
 }
 
+static int need_desc_set_update(const struct pipeline *s, uint32_t update_desc_flags)
+{
+    const struct pipeline_vk *s_priv = (const struct pipeline_vk *)s;
+
+    const struct texture_binding *texture_bindings = ngli_darray_data(&s_priv->texture_bindings);
+    for (int i = 0; i < ngli_darray_count(&s_priv->texture_bindings); i++) {
+        if (texture_bindings[i].update_desc_flags & update_desc_flags)
+            return 1;
+    }
+
+    const struct buffer_binding *buffer_bindings = ngli_darray_data(&s_priv->buffer_bindings);
+    for (int i = 0; i < ngli_darray_count(&s_priv->buffer_bindings); i++) {
+        if (buffer_bindings[i].update_desc_flags & update_desc_flags)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int is_desc_set_bound(const struct pipeline *s, int set_index)
+{
+    const struct pipeline_vk *s_priv = (const struct pipeline_vk *)s;
+    const struct gpu_ctx_vk *gpu_ctx_vk = (const struct gpu_ctx_vk *)s->gpu_ctx;
+    return gpu_ctx_vk->frame_id && s_priv->desc_sets_bind_ids[set_index] == gpu_ctx_vk->frame_id;
+}
+
 static int update_descriptor_set(struct pipeline *s)
 {
     struct pipeline_vk *s_priv = (struct pipeline_vk *)s;
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
     struct vkcontext *vk = gpu_ctx_vk->vkcontext;
-    const uint32_t update_desc_flags = (1 << gpu_ctx_vk->cur_frame_index);
+
+    if (!s_priv->desc_sets)
+        return 0;
+
+    const int frame_index = gpu_ctx_vk->cur_frame_index;
+    int set_index = s_priv->cur_desc_sets[frame_index];
+    if (need_desc_set_update(s, 1U << set_index) && is_desc_set_bound(s, set_index)) {
+        const int first_set_index = frame_index * NB_DESC_SETS_PER_FRAME;
+        set_index = first_set_index + (set_index - first_set_index + 1) % NB_DESC_SETS_PER_FRAME;
+        if (is_desc_set_bound(s, set_index)) {
+            LOG(ERROR, "all the descriptor sets of the frame are in use, "
+                "the pipeline resources cannot change more within the frame");
+            return NGL_ERROR_LIMIT_EXCEEDED;
+        }
+        s_priv->cur_desc_sets[frame_index] = set_index;
+    }
+
+    const uint32_t update_desc_flags = 1U << set_index;
     const uint32_t update_desc_mask = ~update_desc_flags;
 
     struct texture_binding *texture_bindings = ngli_darray_data(&s_priv->texture_bindings);
@@ -887,7 +1222,7 @@ static int update_descriptor_set(struct pipeline *s)
             const struct pipeline_texture_desc *desc = &binding->desc;
             const VkWriteDescriptorSet write_descriptor_set = {
                 .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                .dstSet           = s_priv->desc_sets[gpu_ctx_vk->cur_frame_index],
+                .dstSet           = s_priv->desc_sets[set_index],
                 .dstBinding       = desc->binding,
                 .dstArrayElement  = 0,
                 .descriptorType   = get_vk_descriptor_type(desc->type),
@@ -912,7 +1247,7 @@ static int update_descriptor_set(struct pipeline *s)
             };
             const VkWriteDescriptorSet write_descriptor_set = {
                 .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                .dstSet           = s_priv->desc_sets[gpu_ctx_vk->cur_frame_index],
+                .dstSet           = s_priv->desc_sets[set_index],
                 .dstBinding       = desc->binding,
                 .dstArrayElement  = 0,
                 .descriptorType   = get_vk_descriptor_type(desc->type),
@@ -938,7 +1273,7 @@ static int prepare_pipeline(struct pipeline *s, VkCommandBuffer cmd_buf)
     if (ret < 0)
         return ret;
 
-    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, s_priv->pipeline);
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, s_priv->state->pipeline);
 
     const VkViewport viewport = {
         .x        = gpu_ctx_vk->viewport[0],
@@ -967,9 +1302,18 @@ static int prepare_pipeline(struct pipeline *s, VkCommandBuffer cmd_buf)
     }
     vkCmdSetScissor(cmd_buf, 0, 1, &scissor);
 
-    if (s_priv->desc_sets)
-        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, s_priv->pipeline_layout,
-                                0, 1, &s_priv->desc_sets[gpu_ctx_vk->cur_frame_index], 0, NULL);
+    if (s_priv->desc_sets) {
+        const int set_index = s_priv->cur_desc_sets[gpu_ctx_vk->cur_frame_index];
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_GRAPHICS, s_priv->state->pipeline_layout,
+                                0, 1, &s_priv->desc_sets[set_index],
+                                ngli_darray_count(&s_priv->dynamic_offsets),
+                                ngli_darray_data(&s_priv->dynamic_offsets));
+        s_priv->desc_sets_bind_ids[set_index] = gpu_ctx_vk->frame_id;
+    }
+
+    if (s_priv->push_constants.size)
+        vkCmdPushConstants(cmd_buf, s_priv->state->pipeline_layout, s_priv->push_constants_stages,
+                           0, s_priv->push_constants.size, s_priv->push_constants_data);
 
     const int nb_vertex_buffers = ngli_darray_count(&s_priv->vertex_buffers);
     const VkBuffer *vertex_buffers = ngli_darray_data(&s_priv->vertex_buffers);
@@ -1024,11 +1368,20 @@ void ngli_pipeline_vk_dispatch(struct pipeline *s, int nb_group_x, int nb_group_
     }
     VkCommandBuffer cmd_buf = cmd_vk->cmd_buf;
 
-    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, s_priv->pipeline);
+    vkCmdBindPipeline(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, s_priv->state->pipeline);
+
+    if (s_priv->desc_sets) {
+        const int set_index = s_priv->cur_desc_sets[gpu_ctx_vk->cur_frame_index];
+        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, s_priv->state->pipeline_layout,
+                                0, 1, &s_priv->desc_sets[set_index],
+                                ngli_darray_count(&s_priv->dynamic_offsets),
+                                ngli_darray_data(&s_priv->dynamic_offsets));
+        s_priv->desc_sets_bind_ids[set_index] = gpu_ctx_vk->frame_id;
+    }
 
-    if (s_priv->desc_sets)
-        vkCmdBindDescriptorSets(cmd_buf, VK_PIPELINE_BIND_POINT_COMPUTE, s_priv->pipeline_layout,
-                                0, 1, &s_priv->desc_sets[gpu_ctx_vk->cur_frame_index], 0, NULL);
+    if (s_priv->push_constants.size)
+        vkCmdPushConstants(cmd_buf, s_priv->state->pipeline_layout, s_priv->push_constants_stages,
+                           0, s_priv->push_constants.size, s_priv->push_constants_data);
 
     vkCmdDispatch(cmd_buf, nb_group_x, nb_group_y, nb_group_z);
 
@@ -1073,6 +1426,7 @@ void ngli_pipeline_vk_freep(struct pipeline **sp)
     ngli_darray_reset(&s_priv->texture_bindings);
     ngli_darray_reset(&s_priv->buffer_bindings);
     ngli_darray_reset(&s_priv->attribute_bindings);
+    ngli_darray_reset(&s_priv->dynamic_offsets);
 
     ngli_darray_reset(&s_priv->vertex_attribute_descs);
     ngli_darray_reset(&s_priv->vertex_binding_descs);
@@ -1080,5 +1434,8 @@ void ngli_pipeline_vk_freep(struct pipeline **sp)
     ngli_darray_reset(&s_priv->vertex_offsets);
     ngli_darray_reset(&s_priv->desc_set_layout_bindings);
 
+    ngli_block_reset(&s_priv->push_constants);
+    ngli_freep(&s_priv->push_constants_data);
+
     ngli_freep(sp);
 }
@@ -24,11 +24,29 @@
 
 #include <vulkan/vulkan.h>
 
+#include "block.h"
 #include "pipeline.h"
 #include "darray.h"
 
 struct gpu_ctx;
 
+/*
+ * Immutable part of a pipeline, shared between all the pipelines created with
+ * the same program, graphics state, render target layout and resource layout.
+ * The resource bindings (descriptor sets, vertex buffers) remain owned by each
+ * pipeline.
+ */
+struct pipeline_state_vk {
+    int refcount;
+    int shared;         /* indexed in the context pipeline states map */
+    char key[33];       /* hash of the key material, used as map key */
+    uint8_t *key_data;  /* serialized key material, compared on lookup */
+    size_t key_size;
+    VkDescriptorSetLayout desc_set_layout;
+    VkPipelineLayout pipeline_layout;
+    VkPipeline pipeline;
+};
+
 struct pipeline_vk {
     struct pipeline parent;
 
@@ -43,10 +61,15 @@ struct pipeline_vk {
 
     VkDescriptorPool desc_pool;
     struct darray desc_set_layout_bindings; // array of VkDescriptorSetLayoutBinding
-    VkDescriptorSetLayout desc_set_layout;
-    VkDescriptorSet *desc_sets;
-    VkPipelineLayout pipeline_layout;
-    VkPipeline pipeline;
+    VkDescriptorSet *desc_sets;             // NB_DESC_SETS_PER_FRAME sets per frame in flight
+    uint64_t *desc_sets_bind_ids;           // id of the last frame each set was bound in
+    int *cur_desc_sets;                     // index in desc_sets of the set used by each frame in flight
+    struct darray dynamic_offsets;          // array of uint32_t, in the binding order of the dynamic buffers
+    struct pipeline_state_vk *state;
+
+    struct block push_constants;            // layout of the uniforms, recorded with each draw
+    uint8_t *push_constants_data;
+    VkShaderStageFlags push_constants_stages;
 };
 
 struct pipeline *ngli_pipeline_vk_create(struct gpu_ctx *gpu_ctx);
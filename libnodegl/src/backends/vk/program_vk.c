@@ -28,6 +28,7 @@
 #include "log.h"
 #include "memory.h"
 #include "program_vk.h"
+#include "threadpool.h"
 #include "utils.h"
 #include "vkutils.h"
 
@@ -40,6 +41,40 @@ struct program *ngli_program_vk_create(struct gpu_ctx *gpu_ctx)
     return (struct program *)s;
 }
 
+#define SPIRV_MAGIC 0x07230203
+
+static int compile_shader(struct gpu_ctx *gpu_ctx, int stage, const char *src, void **datap, size_t *sizep)
+{
+    struct diskcache *diskcache = gpu_ctx->diskcache;
+    if (!diskcache)
+        return ngli_glslang_compile(stage, src, datap, sizep);
+
+    struct diskcache_key key;
+    ngli_glslang_get_cache_key(&key, stage, src);
+
+    void *data = NULL;
+    size_t size = 0;
+    int ret = ngli_diskcache_get(diskcache, &key, &data, &size);
+    if (ret == 0) {
+        if (size >= 4 && !(size % 4) && *(const uint32_t *)data == SPIRV_MAGIC) {
+            *datap = data;
+            *sizep = size;
+            return 0;
+        }
+        ngli_freep(&data);
+    }
+
+    ret = ngli_glslang_compile(stage, src, &data, &size);
+    if (ret < 0)
+        return ret;
+
+    ngli_diskcache_put(diskcache, &key, data, size);
+
+    *datap = data;
+    *sizep = size;
+    return 0;
+}
+
 int ngli_program_vk_init(struct program *s, const struct program_params *params)
 {
     struct gpu_ctx_vk *gpu_ctx_vk = (struct gpu_ctx_vk *)s->gpu_ctx;
@@ -61,7 +96,7 @@ int ngli_program_vk_init(struct program *s, const struct program_params *params)
 
         void *data = NULL;
         size_t size = 0;
-        int ret = ngli_glslang_compile(shaders[i].stage, shaders[i].src, &data, &size);
+        int ret = compile_shader(s->gpu_ctx, shaders[i].stage, shaders[i].src, &data, &size);
         if (ret < 0) {
             char *s_with_numbers = ngli_numbered_lines(shaders[i].src);
             if (s_with_numbers) {
@@ -93,6 +128,25 @@ int ngli_program_vk_init(struct program *s, const struct program_params *params)
     return 0;
 }
 
+struct init_batch {
+    struct program **programs;
+    const struct program_params *params;
+};
+
+static int init_job(void *user_arg, int index)
+{
+    const struct init_batch *batch = user_arg;
+    return ngli_program_vk_init(batch->programs[index], &batch->params[index]);
+}
+
+int ngli_program_vk_init_batch(struct program **programs, const struct program_params *params,
+                               int nb_programs, struct threadpool *threadpool)
+{
+    /* glslang compilation and shader module creation are thread-safe */
+    struct init_batch batch = {.programs = programs, .params = params};
+    return ngli_threadpool_execute(threadpool, init_job, &batch, nb_programs);
+}
+
 void ngli_program_vk_freep(struct program **sp)
 {
     struct program *s = *sp;
@@ -27,6 +27,7 @@
 #include "program.h"
 
 struct gpu_ctx;
+struct threadpool;
 
 struct program_vk {
     struct program parent;
@@ -35,6 +36,8 @@ struct program_vk {
 
 struct program *ngli_program_vk_create(struct gpu_ctx *gpu_ctx);
 int ngli_program_vk_init(struct program *s, const struct program_params *params);
+int ngli_program_vk_init_batch(struct program **programs, const struct program_params *params,
+                               int nb_programs, struct threadpool *threadpool);
 void ngli_program_vk_freep(struct program **sp);
 
 #endif
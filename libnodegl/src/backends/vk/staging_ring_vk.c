@@ -0,0 +1,195 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "buffer_vk.h"
+#include "command_vk.h"
+#include "memory.h"
+#include "staging_ring_vk.h"
+#include "utils.h"
+#include "vkutils.h"
+
+#define STAGING_CHUNK_SIZE (1 << 20)
+#define STAGING_ALIGNMENT  16
+#define STAGING_TRIM_DELAY 60 /* frames */
+
+static int alloc_chunk(void *user_arg, struct linear_alloc_chunk *chunk)
+{
+    struct staging_ring_vk *s = user_arg;
+
+    struct buffer *buffer = ngli_buffer_vk_create(s->gpu_ctx);
+    if (!buffer)
+        return NGL_ERROR_MEMORY;
+
+    VkResult res = ngli_buffer_vk_init(buffer, chunk->size, NGLI_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                                            NGLI_BUFFER_USAGE_MAP_WRITE);
+    if (res != VK_SUCCESS)
+        goto fail;
+
+    res = ngli_buffer_vk_map(buffer, chunk->size, 0, (void **)&chunk->data);
+    if (res != VK_SUCCESS)
+        goto fail;
+
+    chunk->priv = buffer;
+    return 0;
+
+fail:
+    ngli_buffer_vk_freep(&buffer);
+    s->chunk_res = res;
+    return ngli_vk_res2ret(res);
+}
+
+static void free_chunk(void *user_arg, struct linear_alloc_chunk *chunk)
+{
+    struct buffer *buffer = chunk->priv;
+    if (chunk->data)
+        ngli_buffer_vk_unmap(buffer);
+    ngli_buffer_vk_freep(&buffer);
+}
+
+VkResult ngli_staging_ring_vk_init(struct staging_ring_vk *s, struct gpu_ctx *gpu_ctx, int nb_frames)
+{
+    s->gpu_ctx = gpu_ctx;
+    s->frames = ngli_calloc(nb_frames, sizeof(*s->frames));
+    if (!s->frames)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+    s->nb_frames = nb_frames;
+
+    const struct linear_alloc_params params = {
+        .chunk_size  = STAGING_CHUNK_SIZE,
+        .alignment   = STAGING_ALIGNMENT,
+        .trim_delay  = STAGING_TRIM_DELAY,
+        .user_arg    = s,
+        .chunk_alloc = alloc_chunk,
+        .chunk_free  = free_chunk,
+    };
+    for (int i = 0; i < s->nb_frames; i++)
+        ngli_linear_alloc_init(&s->frames[i], &params);
+
+    return VK_SUCCESS;
+}
+
+void ngli_staging_ring_vk_begin(struct staging_ring_vk *s, int frame_index, struct cmd_vk *cmd)
+{
+    ngli_assert(frame_index >= 0 && frame_index < s->nb_frames);
+
+    struct linear_alloc *frame = &s->frames[frame_index];
+    ngli_linear_alloc_begin(frame);
+
+    s->cur_frame = frame;
+    s->cmd = cmd;
+    s->frame_id++;
+    s->nb_copies = 0;
+}
+
+int ngli_staging_ring_vk_is_recording(const struct staging_ring_vk *s)
+{
+    return s->cmd != NULL;
+}
+
+VkResult ngli_staging_ring_vk_upload(struct staging_ring_vk *s, struct buffer *dst,
+                                     const void *data, int size, int offset)
+{
+    ngli_assert(s->cmd);
+
+    struct buffer_vk *dst_vk = (struct buffer_vk *)dst;
+
+    struct linear_alloc_chunk *chunk;
+    int src_offset;
+    s->chunk_res = VK_SUCCESS;
+    int ret = ngli_linear_alloc_get(s->cur_frame, size, &chunk, &src_offset);
+    if (ret < 0)
+        return s->chunk_res != VK_SUCCESS ? s->chunk_res : VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    memcpy(chunk->data + src_offset, data, size);
+
+    VkCommandBuffer cmd_buf = s->cmd->cmd_buf;
+
+    /*
+     * Copies recorded in the same command buffer are not ordered: if the
+     * destination buffer has already been written during this update, the
+     * new copy must wait for the previous one.
+     */
+    if (dst_vk->staging_frame_id == s->frame_id) {
+        const VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        };
+        vkCmdPipelineBarrier(cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 1, &barrier, 0, NULL, 0, NULL);
+    }
+    dst_vk->staging_frame_id = s->frame_id;
+
+    struct buffer_vk *chunk_vk = (struct buffer_vk *)chunk->priv;
+    const VkBufferCopy region = {
+        .srcOffset = src_offset,
+        .dstOffset = offset,
+        .size      = size,
+    };
+    vkCmdCopyBuffer(cmd_buf, chunk_vk->buffer, dst_vk->buffer, 1, &region);
+    s->nb_copies++;
+
+    return VK_SUCCESS;
+}
+
+void ngli_staging_ring_vk_end(struct staging_ring_vk *s)
+{
+    if (!s->cmd)
+        return;
+
+    /* Make the uploaded data visible to the commands of the draw phase */
+    if (s->nb_copies) {
+        const VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_INDEX_READ_BIT            |
+                             VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+                             VK_ACCESS_UNIFORM_READ_BIT          |
+                             VK_ACCESS_SHADER_READ_BIT           |
+                             VK_ACCESS_SHADER_WRITE_BIT          |
+                             VK_ACCESS_TRANSFER_READ_BIT         |
+                             VK_ACCESS_TRANSFER_WRITE_BIT,
+        };
+        const VkPipelineStageFlags dst_stages = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT   |
+                                                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT  |
+                                                VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                                                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                                VK_PIPELINE_STAGE_TRANSFER_BIT;
+        vkCmdPipelineBarrier(s->cmd->cmd_buf, VK_PIPELINE_STAGE_TRANSFER_BIT, dst_stages,
+                             0, 1, &barrier, 0, NULL, 0, NULL);
+    }
+
+    s->cur_frame = NULL;
+    s->cmd = NULL;
+}
+
+void ngli_staging_ring_vk_reset(struct staging_ring_vk *s)
+{
+    if (!s->frames)
+        return;
+
+    for (int i = 0; i < s->nb_frames; i++)
+        ngli_linear_alloc_reset(&s->frames[i]);
+    ngli_freep(&s->frames);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef STAGING_RING_VK_H
+#define STAGING_RING_VK_H
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "linear_alloc.h"
+
+struct gpu_ctx;
+struct cmd_vk;
+
+/*
+ * Per-frame staging memory used to upload device local buffers during the
+ * update phase of a frame. Each frame in flight owns a list of persistently
+ * mapped host visible chunks which are recycled once the frame has been
+ * waited for, and trimmed back to the steady-state usage after a few frames
+ * requiring less memory. The copies are recorded into the update command
+ * buffer of the frame instead of being executed (and waited for) immediately.
+ */
+struct staging_ring_vk {
+    struct gpu_ctx *gpu_ctx;
+    struct linear_alloc *frames;
+    int nb_frames;
+    struct linear_alloc *cur_frame;
+    VkResult chunk_res; /* result of the last failed chunk allocation */
+    struct cmd_vk *cmd;
+    uint64_t frame_id;
+    int nb_copies;
+};
+
+VkResult ngli_staging_ring_vk_init(struct staging_ring_vk *s, struct gpu_ctx *gpu_ctx, int nb_frames);
+void ngli_staging_ring_vk_begin(struct staging_ring_vk *s, int frame_index, struct cmd_vk *cmd);
+int ngli_staging_ring_vk_is_recording(const struct staging_ring_vk *s);
+VkResult ngli_staging_ring_vk_upload(struct staging_ring_vk *s, struct buffer *dst,
+                                     const void *data, int size, int offset);
+void ngli_staging_ring_vk_end(struct staging_ring_vk *s);
+void ngli_staging_ring_vk_reset(struct staging_ring_vk *s);
+
+#endif
@@ -394,16 +394,19 @@ VkResult ngli_texture_vk_init(struct texture *s, const struct texture_params *pa
             return VK_ERROR_FORMAT_NOT_SUPPORTED;
     }
 
-    const VkMemoryAllocateInfo alloc_info = {
-        .sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-        .allocationSize  = lazy_allocated ? 0 : mem_reqs.size,
-        .memoryTypeIndex = mem_type_index,
+    /* Lazily allocated attachments are never sub-allocated */
+    const VkMemoryRequirements alloc_reqs = {
+        .size           = lazy_allocated ? 0 : mem_reqs.size,
+        .alignment      = mem_reqs.alignment,
+        .memoryTypeBits = mem_reqs.memoryTypeBits,
     };
-    res = vkAllocateMemory(vk->device, &alloc_info, NULL, &s_priv->image_memory);
+    const int alloc_flags = (lazy_allocated ? NGLI_ALLOCATION_VK_DEDICATED : 0) |
+                            (tiling == VK_IMAGE_TILING_OPTIMAL ? NGLI_ALLOCATION_VK_OPTIMAL : 0);
+    res = ngli_allocator_vk_alloc(&gpu_ctx_vk->allocator, &alloc_reqs, mem_type_index, alloc_flags, &s_priv->image_alloc);
     if (res != VK_SUCCESS)
         return res;
 
-    res = vkBindImageMemory(vk->device, s_priv->image, s_priv->image_memory, 0);
+    res = vkBindImageMemory(vk->device, s_priv->image, s_priv->image_alloc.memory, s_priv->image_alloc.offset);
     if (res != VK_SUCCESS)
         return res;
 
@@ -543,6 +546,11 @@ VkResult ngli_texture_vk_upload(struct texture *s, const uint8_t *data, int line
     if (!data)
         return VK_SUCCESS;
 
+    /* The staging buffer may still be read by the copy of a frame in flight */
+    VkResult res = ngli_cmd_vk_wait_pending(s->gpu_ctx);
+    if (res != VK_SUCCESS)
+        return res;
+
     if (!s_priv->staging_buffer || s_priv->staging_buffer_row_length != linesize) {
         const int32_t width = linesize ? linesize : s->params.width;
         const int32_t staging_buffer_size = width * s->params.height * s->params.depth * s_priv->bytes_per_pixel * s_priv->array_layers;
@@ -560,7 +568,7 @@ VkResult ngli_texture_vk_upload(struct texture *s, const uint8_t *data, int line
         const int usage = NGLI_BUFFER_USAGE_DYNAMIC_BIT |
                           NGLI_BUFFER_USAGE_TRANSFER_SRC_BIT |
                           NGLI_BUFFER_USAGE_MAP_WRITE;
-        VkResult res = ngli_buffer_vk_init(s_priv->staging_buffer, staging_buffer_size, usage);
+        res = ngli_buffer_vk_init(s_priv->staging_buffer, staging_buffer_size, usage);
         if (res != VK_SUCCESS)
             return res;
 
@@ -575,7 +583,7 @@ VkResult ngli_texture_vk_upload(struct texture *s, const uint8_t *data, int line
 
     struct cmd_vk *cmd_vk = gpu_ctx_vk->cur_cmd;
     if (!cmd_vk) {
-        VkResult res = ngli_cmd_vk_begin_transient(s->gpu_ctx, 0, &cmd_vk);
+        res = ngli_cmd_vk_begin_transient(s->gpu_ctx, 0, &cmd_vk);
         if (res != VK_SUCCESS)
             return res;
     }
@@ -643,7 +651,7 @@ VkResult ngli_texture_vk_upload(struct texture *s, const uint8_t *data, int line
                             &subres_range);
 
     if (!gpu_ctx_vk->cur_cmd) {
-        VkResult res = ngli_cmd_vk_execute_transient(&cmd_vk);
+        res = ngli_cmd_vk_execute_transient(&cmd_vk);
         if (res != VK_SUCCESS)
             return res;
     }
@@ -800,7 +808,7 @@ void ngli_texture_vk_freep(struct texture **sp)
         vkDestroyImageView(vk->device, s_priv->image_view, NULL);
     if (!s_priv->wrapped_image)
         vkDestroyImage(vk->device, s_priv->image, NULL);
-    vkFreeMemory(vk->device, s_priv->image_memory, NULL);
+    ngli_allocator_vk_free(&gpu_ctx_vk->allocator, &s_priv->image_alloc);
 
     if (s_priv->staging_buffer_ptr)
         ngli_buffer_vk_unmap(s_priv->staging_buffer);
@@ -24,6 +24,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include "allocator_vk.h"
 #include "buffer.h"
 #include "texture.h"
 #include "vkcontext.h"
@@ -48,7 +49,7 @@ struct texture_vk {
     int wrapped_image;
     VkImageLayout default_image_layout;
     VkImageLayout image_layout;
-    VkDeviceMemory image_memory;
+    struct allocation_vk image_alloc;
     VkImageView image_view;
     int wrapped_image_view;
     VkSampler sampler;
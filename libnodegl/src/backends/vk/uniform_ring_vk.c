@@ -0,0 +1,141 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+
+
+#include <string.h>
+
+#include "buffer_vk.h"
+#include "gpu_ctx.h"
+#include "uniform_ring_vk.h"
+#include "utils.h"
+
+#define UNIFORM_FRAME_SIZE (1 << 16)
+
+VkResult ngli_uniform_ring_vk_init(struct uniform_ring_vk *s, struct gpu_ctx *gpu_ctx, int nb_frames)
+{
+    s->gpu_ctx = gpu_ctx;
+    s->nb_frames = nb_frames;
+    s->alignment = NGLI_MAX(gpu_ctx->limits.min_uniform_block_offset_alignment, 16);
+    ngli_darray_init(&s->chunks, sizeof(struct uniform_chunk_vk), 0);
+    return VK_SUCCESS;
+}
+
+void ngli_uniform_ring_vk_begin(struct uniform_ring_vk *s, int frame_index)
+{
+    ngli_assert(frame_index >= 0 && frame_index < s->nb_frames);
+    s->frame_index = frame_index;
+    s->frame_id++;
+    s->offset = 0;
+
+    /*
+     * The frame slot has just been waited for, and so have all the frames
+     * submitted before it: the retired chunks they were the last to use can
+     * be released.
+     */
+    struct uniform_chunk_vk *chunks = ngli_darray_data(&s->chunks);
+    for (int i = 0; i < ngli_darray_count(&s->chunks); i++) {
+        struct uniform_chunk_vk *chunk = &chunks[i];
+        if (chunk->mapped_data && chunk->retired_frame_id &&
+            chunk->retired_frame_id + s->nb_frames <= s->frame_id) {
+            ngli_buffer_vk_release(chunk->buffer);
+            chunk->mapped_data = NULL;
+        }
+    }
+}
+
+static void free_chunk(struct uniform_chunk_vk *chunk)
+{
+    if (chunk->mapped_data)
+        ngli_buffer_vk_unmap(chunk->buffer);
+    ngli_buffer_vk_freep(&chunk->buffer);
+}
+
+static VkResult alloc_chunk(struct uniform_ring_vk *s, int size)
+{
+    struct uniform_chunk_vk *last = ngli_darray_tail(&s->chunks);
+    const int frame_size = NGLI_MAX(last ? last->frame_size * 2 : UNIFORM_FRAME_SIZE, size);
+
+    struct uniform_chunk_vk chunk = {
+        .buffer     = ngli_buffer_vk_create(s->gpu_ctx),
+        .frame_size = NGLI_ALIGN(frame_size, s->alignment),
+    };
+    if (!chunk.buffer)
+        return VK_ERROR_OUT_OF_HOST_MEMORY;
+
+    const int chunk_size = chunk.frame_size * s->nb_frames;
+    VkResult res = ngli_buffer_vk_init(chunk.buffer, chunk_size, NGLI_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
+                                                                 NGLI_BUFFER_USAGE_MAP_WRITE);
+    if (res != VK_SUCCESS)
+        goto fail;
+
+    res = ngli_buffer_vk_map(chunk.buffer, chunk_size, 0, (void **)&chunk.mapped_data);
+    if (res != VK_SUCCESS)
+        goto fail;
+
+    /* The previous chunk may still be used by the current and pending frames */
+    if (last)
+        last->retired_frame_id = s->frame_id;
+
+    if (!ngli_darray_push(&s->chunks, &chunk)) {
+        if (last)
+            last->retired_frame_id = 0;
+        res = VK_ERROR_OUT_OF_HOST_MEMORY;
+        goto fail;
+    }
+
+    s->offset = 0;
+    return VK_SUCCESS;
+
+fail:
+    free_chunk(&chunk);
+    return res;
+}
+
+VkResult ngli_uniform_ring_vk_alloc(struct uniform_ring_vk *s, int size,
+                                    struct buffer **bufferp, int *offsetp, void **datap)
+{
+    const struct uniform_chunk_vk *chunk = ngli_darray_tail(&s->chunks);
+    if (!chunk || s->offset + size > chunk->frame_size) {
+        VkResult res = alloc_chunk(s, size);
+        if (res != VK_SUCCESS)
+            return res;
+        chunk = ngli_darray_tail(&s->chunks);
+    }
+
+    const int offset = chunk->frame_size * s->frame_index + s->offset;
+    s->offset = NGLI_ALIGN(s->offset + size, s->alignment);
+
+    *bufferp = chunk->buffer;
+    *offsetp = offset;
+    *datap = chunk->mapped_data + offset;
+    return VK_SUCCESS;
+}
+
+void ngli_uniform_ring_vk_reset(struct uniform_ring_vk *s)
+{
+    struct uniform_chunk_vk *chunks = ngli_darray_data(&s->chunks);
+    for (int i = 0; i < ngli_darray_count(&s->chunks); i++)
+        free_chunk(&chunks[i]);
+    ngli_darray_reset(&s->chunks);
+    memset(s, 0, sizeof(*s));
+}
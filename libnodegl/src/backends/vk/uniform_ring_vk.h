@@ -0,0 +1,77 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+
+
+#ifndef UNIFORM_RING_VK_H
+#define UNIFORM_RING_VK_H
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+#include "buffer.h"
+#include "darray.h"
+
+struct gpu_ctx;
+
+struct uniform_chunk_vk {
+    struct buffer *buffer;
+    uint8_t *mapped_data;
+    int frame_size;            /* size of the region owned by each frame in flight */
+    uint64_t retired_frame_id; /* last frame which used the chunk, 0 while it is the current one */
+};
+
+/*
+ * Context wide ring of persistently mapped uniform buffers, from which the
+ * uniform blocks of the pipelines are sub-allocated at each draw and bound
+ * with dynamic offsets.
+ *
+ * Each chunk is split into one region per frame in flight, and a region is
+ * recycled once its frame has been waited for. The allocations are always
+ * made from the last chunk: when its region is full, a larger chunk is
+ * appended and used from then on, including by the rest of the current frame.
+ * The pipelines switching to the new chunk update their descriptor sets
+ * before their next draw (see update_descriptor_set() in pipeline_vk.c).
+ *
+ * The memory of a replaced chunk is released once the last frame using it has
+ * been waited for. Its buffer object is only freed with the ring, so a buffer
+ * pointer remains a stable identifier for the descriptors referencing it, and
+ * a scene ends up using a single buffer (and thus never updating its uniform
+ * descriptors) once the ring has grown enough.
+ */
+struct uniform_ring_vk {
+    struct gpu_ctx *gpu_ctx;
+    struct darray chunks; /* array of uniform_chunk_vk */
+    int nb_frames;
+    int alignment;
+    int frame_index;
+    uint64_t frame_id;
+    int offset; /* in the region of the current frame of the last chunk */
+};
+
+VkResult ngli_uniform_ring_vk_init(struct uniform_ring_vk *s, struct gpu_ctx *gpu_ctx, int nb_frames);
+void ngli_uniform_ring_vk_begin(struct uniform_ring_vk *s, int frame_index);
+VkResult ngli_uniform_ring_vk_alloc(struct uniform_ring_vk *s, int size,
+                                    struct buffer **bufferp, int *offsetp, void **datap);
+void ngli_uniform_ring_vk_reset(struct uniform_ring_vk *s);
+
+#endif
@@ -0,0 +1,681 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "batch.h"
+#include "blending.h"
+#include "buffer.h"
+#include "darray.h"
+#include "format.h"
+#include "gpu_ctx.h"
+#include "log.h"
+#include "math_utils.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "internal.h"
+#include "pass.h"
+#include "pgcraft.h"
+#include "pipeline_compat.h"
+#include "rnode.h"
+#include "type.h"
+#include "utils.h"
+
+/* Minimum number of locations guaranteed by OpenGLES 3.0 and Vulkan */
+#define MAX_ATTRIBUTE_LOCATIONS 16
+#define MAX_VARYING_LOCATIONS   15
+
+enum {
+    BUILTIN_NONE,
+    BUILTIN_MODELVIEW_MATRIX,
+    BUILTIN_NORMAL_MATRIX,
+};
+
+/* Per instance value of a batched uniform */
+struct batch_field {
+    int index; /* index of the uniform in the crafter uniforms of the passes */
+    int builtin;
+    int offset;
+    int size;
+};
+
+struct uniform_map {
+    int index;
+    const void *data;
+};
+
+struct batch {
+    struct ngl_ctx *ctx;
+    struct pass *pass; /* pass of the first item, holding the shared resources */
+    struct darray items;   /* batch_item */
+    struct darray renders; /* ngl_node pointer, Render node of each item */
+    struct darray fields;  /* batch_field */
+    struct darray crafter_uniforms;
+    struct darray crafter_attributes;
+    int stride;
+    uint8_t *instances_data;
+    struct buffer *instances;
+    int nb_instances; /* number of items active during the last update */
+    struct pgcraft *crafter;
+    struct pipeline_compat *pipeline_compat;
+    struct graphicstate graphicstate;
+    int projection_matrix_index;
+    int resolution_index;
+    struct darray uniforms_map;
+};
+
+static int get_location_count(int type)
+{
+    switch (type) {
+    case NGLI_TYPE_MAT3: return 3;
+    case NGLI_TYPE_MAT4: return 4;
+    default:             return 1;
+    }
+}
+
+static int get_attribute_format(int type)
+{
+    switch (type) {
+    case NGLI_TYPE_FLOAT: return NGLI_FORMAT_R32_SFLOAT;
+    case NGLI_TYPE_VEC2:  return NGLI_FORMAT_R32G32_SFLOAT;
+    case NGLI_TYPE_VEC3:  return NGLI_FORMAT_R32G32B32_SFLOAT;
+    case NGLI_TYPE_MAT3:  return NGLI_FORMAT_R32G32B32_SFLOAT;
+    case NGLI_TYPE_VEC4:  return NGLI_FORMAT_R32G32B32A32_SFLOAT;
+    case NGLI_TYPE_MAT4:  return NGLI_FORMAT_R32G32B32A32_SFLOAT;
+    default:              return NGLI_FORMAT_UNDEFINED;
+    }
+}
+
+static int is_batchable_uniform(const struct pgcraft_uniform *uniform)
+{
+    return !uniform->count && get_attribute_format(uniform->type) != NGLI_FORMAT_UNDEFINED;
+}
+
+struct ngl_node *ngli_batch_get_render(struct ngl_node *node)
+{
+    while (node) {
+        switch (node->cls->id) {
+        case NGL_NODE_ROTATE:
+        case NGL_NODE_ROTATEQUAT:
+        case NGL_NODE_SCALE:
+        case NGL_NODE_SKEW:
+        case NGL_NODE_TRANSFORM:
+        case NGL_NODE_TRANSLATE: {
+            const struct transform *trf = node->priv_data;
+            node = trf->child;
+            break;
+        }
+        case NGL_NODE_RENDER: {
+            /* The instances of a batch are its items */
+            const struct pass *pass = ngli_node_render_get_pass(node);
+            if (pass->params.nb_instances != 1)
+                return NULL;
+            const struct pgcraft_attribute *attributes = ngli_darray_data(&pass->crafter_attributes);
+            for (int i = 0; i < ngli_darray_count(&pass->crafter_attributes); i++)
+                if (attributes[i].rate)
+                    return NULL;
+            return node;
+        }
+        default:
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static int check_iovars(const struct pass_params *a, const struct pass_params *b)
+{
+    if (a->nb_vert_out_vars != b->nb_vert_out_vars)
+        return 0;
+    for (int i = 0; i < a->nb_vert_out_vars; i++) {
+        const struct pgcraft_iovar *va = &a->vert_out_vars[i];
+        const struct pgcraft_iovar *vb = &b->vert_out_vars[i];
+        if (strcmp(va->name, vb->name) ||
+            va->type != vb->type ||
+            va->precision_out != vb->precision_out ||
+            va->precision_in != vb->precision_in)
+            return 0;
+    }
+    return 1;
+}
+
+/*
+ * Distinct Program nodes with the same shaders are compatible, but the
+ * resources must be the same nodes, except for the batchable uniforms.
+ */
+static int check_params(const struct pass_params *a, const struct pass_params *b)
+{
+    return !strcmp(a->vert_base, b->vert_base) &&
+           !strcmp(a->frag_base, b->frag_base) &&
+           a->properties == b->properties &&
+           a->geometry == b->geometry &&
+           a->nb_frag_output == b->nb_frag_output &&
+           a->blending == b->blending &&
+           check_iovars(a, b);
+}
+
+static int check_uniforms(const struct pass *a, const struct pass *b)
+{
+    if (ngli_darray_count(&a->crafter_uniforms) != ngli_darray_count(&b->crafter_uniforms))
+        return 0;
+    const struct pgcraft_uniform *uniforms_a = ngli_darray_data(&a->crafter_uniforms);
+    const struct pgcraft_uniform *uniforms_b = ngli_darray_data(&b->crafter_uniforms);
+    for (int i = 0; i < ngli_darray_count(&a->crafter_uniforms); i++) {
+        const struct pgcraft_uniform *ua = &uniforms_a[i];
+        const struct pgcraft_uniform *ub = &uniforms_b[i];
+        if (strcmp(ua->name, ub->name) ||
+            ua->type != ub->type ||
+            ua->stage != ub->stage ||
+            ua->count != ub->count ||
+            ua->precision != ub->precision)
+            return 0;
+        if (ua->data != ub->data && !is_batchable_uniform(ua))
+            return 0;
+    }
+    return 1;
+}
+
+static int check_textures(const struct pass *a, const struct pass *b)
+{
+    if (ngli_darray_count(&a->crafter_textures) != ngli_darray_count(&b->crafter_textures))
+        return 0;
+    const struct pgcraft_texture *textures_a = ngli_darray_data(&a->crafter_textures);
+    const struct pgcraft_texture *textures_b = ngli_darray_data(&b->crafter_textures);
+    for (int i = 0; i < ngli_darray_count(&a->crafter_textures); i++) {
+        const struct pgcraft_texture *ta = &textures_a[i];
+        const struct pgcraft_texture *tb = &textures_b[i];
+        if (strcmp(ta->name, tb->name) ||
+            ta->type != tb->type ||
+            ta->stage != tb->stage ||
+            ta->precision != tb->precision ||
+            ta->writable != tb->writable ||
+            ta->format != tb->format ||
+            ta->clamp_video != tb->clamp_video ||
+            ta->image != tb->image)
+            return 0;
+    }
+    return 1;
+}
+
+static int check_blocks(const struct pass *a, const struct pass *b)
+{
+    if (ngli_darray_count(&a->crafter_blocks) != ngli_darray_count(&b->crafter_blocks))
+        return 0;
+    const struct pgcraft_block *blocks_a = ngli_darray_data(&a->crafter_blocks);
+    const struct pgcraft_block *blocks_b = ngli_darray_data(&b->crafter_blocks);
+    for (int i = 0; i < ngli_darray_count(&a->crafter_blocks); i++) {
+        const struct pgcraft_block *ba = &blocks_a[i];
+        const struct pgcraft_block *bb = &blocks_b[i];
+        if (strcmp(ba->name, bb->name) ||
+            ba->type != bb->type ||
+            ba->stage != bb->stage ||
+            ba->writable != bb->writable ||
+            ba->block != bb->block ||
+            ba->buffer != bb->buffer)
+            return 0;
+    }
+    return 1;
+}
+
+static int check_attributes(const struct pass *a, const struct pass *b)
+{
+    if (ngli_darray_count(&a->crafter_attributes) != ngli_darray_count(&b->crafter_attributes))
+        return 0;
+    const struct pgcraft_attribute *attributes_a = ngli_darray_data(&a->crafter_attributes);
+    const struct pgcraft_attribute *attributes_b = ngli_darray_data(&b->crafter_attributes);
+    for (int i = 0; i < ngli_darray_count(&a->crafter_attributes); i++) {
+        const struct pgcraft_attribute *aa = &attributes_a[i];
+        const struct pgcraft_attribute *ab = &attributes_b[i];
+        if (strcmp(aa->name, ab->name) ||
+            aa->type != ab->type ||
+            aa->precision != ab->precision ||
+            aa->format != ab->format ||
+            aa->stride != ab->stride ||
+            aa->offset != ab->offset ||
+            aa->buffer != ab->buffer)
+            return 0;
+    }
+    return 1;
+}
+
+int ngli_batch_check_items(const struct batch_item *a, const struct batch_item *b)
+{
+    struct ngl_node *render_a = ngli_batch_get_render(a->node);
+    struct ngl_node *render_b = ngli_batch_get_render(b->node);
+    if (!render_a || !render_b)
+        return 0;
+
+    if (memcmp(&a->rnode->graphicstate, &b->rnode->graphicstate, sizeof(a->rnode->graphicstate)) ||
+        memcmp(&a->rnode->rendertarget_desc, &b->rnode->rendertarget_desc, sizeof(a->rnode->rendertarget_desc)))
+        return 0;
+
+    const struct pass *pass_a = ngli_node_render_get_pass(render_a);
+    const struct pass *pass_b = ngli_node_render_get_pass(render_b);
+    return check_params(&pass_a->params, &pass_b->params) &&
+           check_uniforms(pass_a, pass_b) &&
+           check_textures(pass_a, pass_b) &&
+           check_blocks(pass_a, pass_b) &&
+           check_attributes(pass_a, pass_b);
+}
+
+struct batch *ngli_batch_create(struct ngl_ctx *ctx)
+{
+    struct batch *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->ctx = ctx;
+    ngli_darray_init(&s->items, sizeof(struct batch_item), 0);
+    ngli_darray_init(&s->renders, sizeof(struct ngl_node *), 0);
+    ngli_darray_init(&s->fields, sizeof(struct batch_field), 0);
+    ngli_darray_init(&s->crafter_uniforms, sizeof(struct pgcraft_uniform), 0);
+    ngli_darray_init(&s->crafter_attributes, sizeof(struct pgcraft_attribute), 0);
+    ngli_darray_init(&s->uniforms_map, sizeof(struct uniform_map), 0);
+    return s;
+}
+
+static int uniform_differs(const struct batch *s, int index)
+{
+    struct ngl_node **renders = ngli_darray_data(&s->renders);
+    const struct pgcraft_uniform *ref = ngli_darray_get(&s->pass->crafter_uniforms, index);
+    for (int i = 1; i < ngli_darray_count(&s->renders); i++) {
+        const struct pass *pass = ngli_node_render_get_pass(renders[i]);
+        const struct pgcraft_uniform *uniform = ngli_darray_get(&pass->crafter_uniforms, index);
+        if (uniform->data != ref->data)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * The modelview and normal matrices, and the uniforms which are not the same
+ * nodes for all the items, are batched.
+ */
+static int build_fields(struct batch *s)
+{
+    const struct pass *pass = s->pass;
+    const struct pgcraft_uniform *uniforms = ngli_darray_data(&pass->crafter_uniforms);
+    for (int i = 0; i < ngli_darray_count(&pass->crafter_uniforms); i++) {
+        struct pgcraft_uniform *uniform = ngli_darray_push(&s->crafter_uniforms, &uniforms[i]);
+        if (!uniform)
+            return NGL_ERROR_MEMORY;
+
+        int builtin = BUILTIN_NONE;
+        if (!strcmp(uniform->name, "ngl_modelview_matrix"))
+            builtin = BUILTIN_MODELVIEW_MATRIX;
+        else if (!strcmp(uniform->name, "ngl_normal_matrix"))
+            builtin = BUILTIN_NORMAL_MATRIX;
+        else if (!uniform->data || !uniform_differs(s, i))
+            continue;
+
+        const int format = get_attribute_format(uniform->type);
+        ngli_assert(format != NGLI_FORMAT_UNDEFINED);
+        uniform->batched = 1;
+
+        const struct batch_field field = {
+            .index   = i,
+            .builtin = builtin,
+            .offset  = s->stride,
+            .size    = ngli_format_get_bytes_per_pixel(format) * get_location_count(uniform->type),
+        };
+        if (!ngli_darray_push(&s->fields, &field))
+            return NGL_ERROR_MEMORY;
+        s->stride += field.size;
+    }
+    return 0;
+}
+
+static int check_locations(const struct batch *s)
+{
+    const struct pass *pass = s->pass;
+
+    int nb_attribute_locations = 0;
+    const struct pgcraft_attribute *attributes = ngli_darray_data(&pass->crafter_attributes);
+    for (int i = 0; i < ngli_darray_count(&pass->crafter_attributes); i++)
+        nb_attribute_locations += get_location_count(attributes[i].type);
+
+    int nb_varying_locations = 0;
+    for (int i = 0; i < pass->params.nb_vert_out_vars; i++)
+        nb_varying_locations += get_location_count(pass->params.vert_out_vars[i].type);
+
+    const struct pgcraft_uniform *uniforms = ngli_darray_data(&s->crafter_uniforms);
+    const struct batch_field *fields = ngli_darray_data(&s->fields);
+    for (int i = 0; i < ngli_darray_count(&s->fields); i++) {
+        const struct pgcraft_uniform *uniform = &uniforms[fields[i].index];
+        const int nb_locations = get_location_count(uniform->type);
+        nb_attribute_locations += nb_locations;
+        if (uniform->stage == NGLI_PROGRAM_SHADER_FRAG)
+            nb_varying_locations += nb_locations;
+    }
+
+    if (nb_attribute_locations > MAX_ATTRIBUTE_LOCATIONS ||
+        nb_varying_locations > MAX_VARYING_LOCATIONS) {
+        LOG(DEBUG, "batch of %s requires too many locations (%d attributes, %d varyings)",
+            pass->params.label, nb_attribute_locations, nb_varying_locations);
+        return NGL_ERROR_LIMIT_EXCEEDED;
+    }
+
+    return 0;
+}
+
+static int build_attributes(struct batch *s)
+{
+    const struct pass *pass = s->pass;
+    const struct pgcraft_attribute *attributes = ngli_darray_data(&pass->crafter_attributes);
+    for (int i = 0; i < ngli_darray_count(&pass->crafter_attributes); i++)
+        if (!ngli_darray_push(&s->crafter_attributes, &attributes[i]))
+            return NGL_ERROR_MEMORY;
+
+    const struct pgcraft_uniform *uniforms = ngli_darray_data(&s->crafter_uniforms);
+    const struct batch_field *fields = ngli_darray_data(&s->fields);
+    for (int i = 0; i < ngli_darray_count(&s->fields); i++) {
+        const struct batch_field *field = &fields[i];
+        const struct pgcraft_uniform *uniform = &uniforms[field->index];
+        struct pgcraft_attribute attribute = {
+            .type      = uniform->type,
+            .precision = uniform->precision,
+            .format    = get_attribute_format(uniform->type),
+            .stride    = s->stride,
+            .offset    = field->offset,
+            .rate      = 1,
+            .buffer    = s->instances,
+        };
+        int ret = ngli_pgcraft_get_batch_attribute_name(attribute.name, sizeof(attribute.name), uniform);
+        if (ret < 0)
+            return ret;
+        if (!ngli_darray_push(&s->crafter_attributes, &attribute))
+            return NGL_ERROR_MEMORY;
+    }
+    return 0;
+}
+
+static int build_uniforms_map(struct batch *s)
+{
+    const struct pgcraft_uniform *uniforms = ngli_darray_data(&s->crafter_uniforms);
+    for (int i = 0; i < ngli_darray_count(&s->crafter_uniforms); i++) {
+        const struct pgcraft_uniform *uniform = &uniforms[i];
+        if (uniform->batched || !uniform->data)
+            continue;
+
+        const int index = ngli_pgcraft_get_uniform_index(s->crafter, uniform->name, uniform->stage);
+        if (index < 0)
+            continue;
+
+        const struct uniform_map map = {.index=index, .data=uniform->data};
+        if (!ngli_darray_push(&s->uniforms_map, &map))
+            return NGL_ERROR_MEMORY;
+    }
+    return 0;
+}
+
+static int create_pipeline(struct batch *s, const struct rnode *rnode)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
+    const struct pass *pass = s->pass;
+
+    s->crafter = ngli_pgcraft_create(ctx);
+    if (!s->crafter)
+        return NGL_ERROR_MEMORY;
+
+    if (!ngli_pgcraft_supports_batching(s->crafter))
+        return NGL_ERROR_UNSUPPORTED;
+
+    const struct pgcraft_params crafter_params = {
+        .program_label     = pass->params.program_label,
+        .vert_base         = pass->params.vert_base,
+        .frag_base         = pass->params.frag_base,
+        .uniforms          = ngli_darray_data(&s->crafter_uniforms),
+        .nb_uniforms       = ngli_darray_count(&s->crafter_uniforms),
+        .textures          = ngli_darray_data(&pass->crafter_textures),
+        .nb_textures       = ngli_darray_count(&pass->crafter_textures),
+        .attributes        = ngli_darray_data(&s->crafter_attributes),
+        .nb_attributes     = ngli_darray_count(&s->crafter_attributes),
+        .blocks            = ngli_darray_data(&pass->crafter_blocks),
+        .nb_blocks         = ngli_darray_count(&pass->crafter_blocks),
+        .vert_out_vars     = pass->params.vert_out_vars,
+        .nb_vert_out_vars  = pass->params.nb_vert_out_vars,
+        .nb_frag_output    = pass->params.nb_frag_output,
+    };
+
+    int ret = ngli_pgcraft_craft(s->crafter, &crafter_params);
+    if (ret < 0)
+        return ret;
+
+    struct pipeline_graphics pipeline_graphics = pass->pipeline_graphics;
+    pipeline_graphics.state = rnode->graphicstate;
+    pipeline_graphics.rt_desc = rnode->rendertarget_desc;
+
+    ret = ngli_blending_apply_preset(&pipeline_graphics.state, pass->params.blending);
+    if (ret < 0)
+        return ret;
+    s->graphicstate = pipeline_graphics.state;
+
+    s->pipeline_compat = ngli_pipeline_compat_create(gpu_ctx);
+    if (!s->pipeline_compat)
+        return NGL_ERROR_MEMORY;
+
+    const struct pipeline_params pipeline_params = {
+        .type     = NGLI_PIPELINE_TYPE_GRAPHICS,
+        .graphics = pipeline_graphics,
+        .program  = ngli_pgcraft_get_program(s->crafter),
+        .layout   = ngli_pgcraft_get_pipeline_layout(s->crafter),
+    };
+
+    const struct pipeline_resources pipeline_resources = ngli_pgcraft_get_pipeline_resources(s->crafter);
+    const struct pgcraft_compat_info *compat_info = ngli_pgcraft_get_compat_info(s->crafter);
+
+    const struct pipeline_compat_params params = {
+        .params = &pipeline_params,
+        .resources = &pipeline_resources,
+        .compat_info = compat_info,
+    };
+    ret = ngli_pipeline_compat_init(s->pipeline_compat, &params);
+    if (ret < 0)
+        return ret;
+
+    ret = build_uniforms_map(s);
+    if (ret < 0)
+        return ret;
+
+    s->projection_matrix_index = ngli_pgcraft_get_uniform_index(s->crafter, "ngl_projection_matrix", NGLI_PROGRAM_SHADER_VERT);
+    s->resolution_index = ngli_pgcraft_get_uniform_index(s->crafter, "ngl_resolution", NGLI_PROGRAM_SHADER_FRAG);
+
+    return 0;
+}
+
+int ngli_batch_init(struct batch *s, const struct batch_item *items, int nb_items)
+{
+    struct ngl_ctx *ctx = s->ctx;
+
+    ngli_assert(nb_items > 0);
+    for (int i = 0; i < nb_items; i++) {
+        struct ngl_node *render = ngli_batch_get_render(items[i].node);
+        ngli_assert(render);
+        if (!ngli_darray_push(&s->items, &items[i]) ||
+            !ngli_darray_push(&s->renders, &render))
+            return NGL_ERROR_MEMORY;
+    }
+
+    struct ngl_node **renders = ngli_darray_data(&s->renders);
+    s->pass = ngli_node_render_get_pass(renders[0]);
+
+    int ret;
+    if ((ret = build_fields(s)) < 0 ||
+        (ret = check_locations(s)) < 0)
+        return ret;
+
+    s->instances_data = ngli_calloc(nb_items, s->stride);
+    if (!s->instances_data)
+        return NGL_ERROR_MEMORY;
+
+    s->instances = ngli_buffer_create(ctx->gpu_ctx);
+    if (!s->instances)
+        return NGL_ERROR_MEMORY;
+
+    ret = ngli_buffer_init(s->instances, nb_items * s->stride,
+                           NGLI_BUFFER_USAGE_DYNAMIC_BIT |
+                           NGLI_BUFFER_USAGE_TRANSFER_DST_BIT |
+                           NGLI_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    if (ret < 0)
+        return ret;
+
+    if ((ret = build_attributes(s)) < 0 ||
+        (ret = create_pipeline(s, items[0].rnode)) < 0)
+        return ret;
+
+    /* The items are only drawn through the batch pipeline from now on */
+    for (int i = 0; i < nb_items; i++)
+        ngli_pass_cancel_pending_pipeline(ngli_node_render_get_pass(renders[i]), items[i].rnode->id);
+
+    return 0;
+}
+
+int ngli_batch_update(struct batch *s)
+{
+    struct ngl_ctx *ctx = s->ctx;
+
+    /* The batches are drawn by the plan with the initial modelview matrix */
+    const float *base_matrix = ngli_darray_tail(&ctx->modelview_matrix_stack);
+
+    const struct batch_item *items = ngli_darray_data(&s->items);
+    struct ngl_node **renders = ngli_darray_data(&s->renders);
+    const struct batch_field *fields = ngli_darray_data(&s->fields);
+    const int nb_fields = ngli_darray_count(&s->fields);
+
+    uint8_t *dst = s->instances_data;
+    s->nb_instances = 0;
+    for (int i = 0; i < ngli_darray_count(&s->items); i++) {
+        struct ngl_node *render = renders[i];
+        if (!items[i].node->is_active || !render->is_active)
+            continue;
+
+        /* Same product order as the nested ngli_transform_draw() */
+        NGLI_ALIGNED_MAT(modelview_matrix);
+        memcpy(modelview_matrix, base_matrix, sizeof(modelview_matrix));
+        const struct ngl_node *node = items[i].node;
+        while (node != render) {
+            const struct transform *trf = node->priv_data;
+            ngli_mat4_mul(modelview_matrix, modelview_matrix, trf->matrix);
+            node = trf->child;
+        }
+
+        const struct pass *pass = ngli_node_render_get_pass(render);
+        const struct pgcraft_uniform *uniforms = ngli_darray_data(&pass->crafter_uniforms);
+        for (int j = 0; j < nb_fields; j++) {
+            const struct batch_field *field = &fields[j];
+            if (field->builtin == BUILTIN_MODELVIEW_MATRIX) {
+                memcpy(dst + field->offset, modelview_matrix, field->size);
+            } else if (field->builtin == BUILTIN_NORMAL_MATRIX) {
+                float normal_matrix[3*3];
+                ngli_mat3_from_mat4(normal_matrix, modelview_matrix);
+                ngli_mat3_inverse(normal_matrix, normal_matrix);
+                ngli_mat3_transpose(normal_matrix, normal_matrix);
+                memcpy(dst + field->offset, normal_matrix, field->size);
+            } else {
+                memcpy(dst + field->offset, uniforms[field->index].data, field->size);
+            }
+        }
+
+        dst += s->stride;
+        s->nb_instances++;
+    }
+
+    if (!s->nb_instances)
+        return 0;
+
+    return ngli_buffer_upload(s->instances, s->instances_data, s->nb_instances * s->stride, 0);
+}
+
+int ngli_batch_draw(struct batch *s)
+{
+    if (!s->nb_instances)
+        return 0;
+
+    struct ngl_ctx *ctx = s->ctx;
+    struct pipeline_compat *pipeline_compat = s->pipeline_compat;
+
+    const float *projection_matrix = ngli_darray_tail(&ctx->projection_matrix_stack);
+    ngli_pipeline_compat_update_uniform(pipeline_compat, s->projection_matrix_index, projection_matrix);
+
+    int viewport[4] = {0};
+    ngli_gpu_ctx_get_viewport(ctx->gpu_ctx, viewport);
+
+    const float resolution[2] = {viewport[2], viewport[3]};
+    ngli_pipeline_compat_update_uniform(pipeline_compat, s->resolution_index, resolution);
+
+    const struct uniform_map *map = ngli_darray_data(&s->uniforms_map);
+    for (int i = 0; i < ngli_darray_count(&s->uniforms_map); i++)
+        ngli_pipeline_compat_update_uniform(pipeline_compat, map[i].index, map[i].data);
+
+    const struct darray *texture_infos_array = ngli_pgcraft_get_texture_infos(s->crafter);
+    const struct pgcraft_texture_info *texture_infos = ngli_darray_data(texture_infos_array);
+    for (int i = 0; i < ngli_darray_count(texture_infos_array); i++)
+        ngli_pipeline_compat_update_texture_info(pipeline_compat, &texture_infos[i]);
+
+    if (!ctx->render_pass_started) {
+        struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
+        ngli_gpu_ctx_begin_render_pass(gpu_ctx, ctx->current_rendertarget);
+        ctx->render_pass_started = 1;
+    }
+
+    if (ctx->hud)
+        ngli_hud_register_draw(ctx->hud, ngli_pgcraft_get_program(s->crafter), &s->graphicstate);
+
+    const struct pass *pass = s->pass;
+    int ret;
+    if (pass->indices)
+        ret = ngli_pipeline_compat_draw_indexed(pipeline_compat, pass->indices, pass->indices_layout->format,
+                                                pass->indices_layout->count, s->nb_instances);
+    else
+        ret = ngli_pipeline_compat_draw(pipeline_compat, pass->nb_vertices, s->nb_instances);
+    if (ret < 0)
+        return ret;
+
+    /* Account for every node drawn by the instanced call */
+    const struct batch_item *items = ngli_darray_data(&s->items);
+    struct ngl_node **renders = ngli_darray_data(&s->renders);
+    for (int i = 0; i < ngli_darray_count(&s->items); i++) {
+        if (items[i].node->is_active && renders[i]->is_active)
+            renders[i]->draw_count++;
+    }
+
+    return 0;
+}
+
+void ngli_batch_freep(struct batch **sp)
+{
+    struct batch *s = *sp;
+    if (!s)
+        return;
+
+    ngli_pipeline_compat_freep(&s->pipeline_compat);
+    ngli_pgcraft_freep(&s->crafter);
+    ngli_buffer_freep(&s->instances);
+    ngli_freep(&s->instances_data);
+    ngli_darray_reset(&s->items);
+    ngli_darray_reset(&s->renders);
+    ngli_darray_reset(&s->fields);
+    ngli_darray_reset(&s->crafter_uniforms);
+    ngli_darray_reset(&s->crafter_attributes);
+    ngli_darray_reset(&s->uniforms_map);
+    ngli_freep(sp);
+}
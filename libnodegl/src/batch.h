@@ -0,0 +1,71 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+struct ngl_ctx;
+struct ngl_node;
+struct rnode;
+
+/*
+ * Instanced draw merging consecutive draws of compatible Render nodes.
+ *
+ * Each item of a batch is a Render node, optionally drawn through a chain of
+ * transforms. The Render nodes of a batch must share the same shaders,
+ * geometry, graphic state, blending and resources, except for the variable
+ * uniforms (UniformFloat, UniformVec*, UniformMat4, ...) which may differ
+ * between them. These uniforms and the modelview matrix of every item are
+ * packed into a per instance vertex buffer, and the whole batch is drawn with
+ * a single instanced draw call, in the order of the items.
+ */
+
+struct batch_item {
+    struct ngl_node *node; /* Render node, or top of its transform chain */
+    struct rnode *rnode;
+};
+
+/*
+ * Return the Render node drawn by an item node if it can be part of a batch,
+ * NULL otherwise.
+ */
+struct ngl_node *ngli_batch_get_render(struct ngl_node *node);
+
+/* Return whether the 2 items can be drawn in the same batch */
+int ngli_batch_check_items(const struct batch_item *a, const struct batch_item *b);
+
+struct batch *ngli_batch_create(struct ngl_ctx *ctx);
+
+/*
+ * Must be called before the pending pipelines are created: on success, the
+ * per-node pipelines of the items are cancelled since the batch draws them.
+ */
+int ngli_batch_init(struct batch *s, const struct batch_item *items, int nb_items);
+
+/*
+ * Pack the per instance data of the active items; must be called once all the
+ * items are updated.
+ */
+int ngli_batch_update(struct batch *s);
+int ngli_batch_draw(struct batch *s);
+void ngli_batch_freep(struct batch **sp);
+
+#endif
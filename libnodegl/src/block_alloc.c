@@ -0,0 +1,306 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "block_alloc.h"
+#include "log.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "utils.h"
+
+struct free_range {
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct block_alloc_block {
+    void *memory;
+    uint8_t *mapped_data;
+    uint64_t size;
+    int pool;
+    int dedicated;
+    struct darray free_ranges; /* array of free_range sorted by offset */
+    int nb_allocations;
+};
+
+int ngli_block_alloc_init(struct block_alloc *s, const struct block_alloc_params *params)
+{
+    ngli_assert(params->nb_pools > 0 && params->block_size > 0);
+
+    memset(s, 0, sizeof(*s));
+    s->pools = ngli_calloc(params->nb_pools, sizeof(*s->pools));
+    if (!s->pools)
+        return NGL_ERROR_MEMORY;
+    s->params = *params;
+
+    for (int i = 0; i < params->nb_pools; i++)
+        ngli_darray_init(&s->pools[i], sizeof(struct block_alloc_block *), 0);
+
+    return 0;
+}
+
+static void block_freep(struct block_alloc *s, struct block_alloc_block **blockp)
+{
+    struct block_alloc_block *block = *blockp;
+    if (!block)
+        return;
+
+    s->params.block_destroy(s->params.user_arg, block->memory, block->mapped_data);
+    ngli_darray_reset(&block->free_ranges);
+
+    s->stats.reserved -= block->size;
+    s->stats.nb_device_allocations--;
+
+    ngli_freep(blockp);
+}
+
+static int block_create(struct block_alloc *s, uint64_t size, int pool, int dedicated,
+                        struct block_alloc_block **blockp)
+{
+    struct block_alloc_block *block = ngli_calloc(1, sizeof(*block));
+    if (!block)
+        return NGL_ERROR_MEMORY;
+
+    block->size = size;
+    block->pool = pool;
+    block->dedicated = dedicated;
+    ngli_darray_init(&block->free_ranges, sizeof(struct free_range), 0);
+
+    int ret = s->params.block_create(s->params.user_arg, pool, size, &block->memory, &block->mapped_data);
+    if (ret < 0) {
+        ngli_darray_reset(&block->free_ranges);
+        ngli_freep(&block);
+        return ret;
+    }
+
+    s->stats.reserved += size;
+    s->stats.nb_device_allocations++;
+
+    if (!dedicated) {
+        const struct free_range range = {.offset = 0, .size = size};
+        if (!ngli_darray_push(&block->free_ranges, &range)) {
+            block_freep(s, &block);
+            return NGL_ERROR_MEMORY;
+        }
+    }
+
+    *blockp = block;
+    return 0;
+}
+
+static int block_alloc(struct block_alloc_block *block, uint64_t size, uint64_t alignment,
+                       uint64_t *offsetp)
+{
+    struct darray *ranges_array = &block->free_ranges;
+    struct free_range *ranges = ngli_darray_data(ranges_array);
+    for (int i = 0; i < ngli_darray_count(ranges_array); i++) {
+        struct free_range *range = &ranges[i];
+        const uint64_t offset = (range->offset + alignment - 1) / alignment * alignment;
+        const uint64_t range_end = range->offset + range->size;
+        if (offset + size > range_end)
+            continue;
+
+        /*
+         * The padding introduced by the alignment stays in the free list as
+         * the (shrunk) current range, the remainder is inserted after it.
+         */
+        const uint64_t pad = offset - range->offset;
+        const uint64_t remainder = range_end - (offset + size);
+        if (!pad && !remainder) {
+            ngli_darray_remove(ranges_array, i);
+        } else if (!pad) {
+            range->offset = offset + size;
+            range->size = remainder;
+        } else if (!remainder) {
+            range->size = pad;
+        } else {
+            if (!ngli_darray_push(ranges_array, NULL))
+                return NGL_ERROR_MEMORY;
+            ranges = ngli_darray_data(ranges_array);
+            memmove(&ranges[i + 2], &ranges[i + 1],
+                    (ngli_darray_count(ranges_array) - i - 2) * sizeof(*ranges));
+            ranges[i].size = pad;
+            ranges[i + 1].offset = offset + size;
+            ranges[i + 1].size = remainder;
+        }
+
+        block->nb_allocations++;
+        *offsetp = offset;
+        return 1;
+    }
+    return 0;
+}
+
+static int block_release(struct block_alloc_block *block, uint64_t offset, uint64_t size)
+{
+    struct darray *ranges_array = &block->free_ranges;
+    struct free_range *ranges = ngli_darray_data(ranges_array);
+    const int nb_ranges = ngli_darray_count(ranges_array);
+
+    int pos = 0;
+    while (pos < nb_ranges && ranges[pos].offset < offset)
+        pos++;
+
+    const int merge_prev = pos > 0 && ranges[pos - 1].offset + ranges[pos - 1].size == offset;
+    const int merge_next = pos < nb_ranges && offset + size == ranges[pos].offset;
+
+    if (merge_prev && merge_next) {
+        ranges[pos - 1].size += size + ranges[pos].size;
+        ngli_darray_remove(ranges_array, pos);
+    } else if (merge_prev) {
+        ranges[pos - 1].size += size;
+    } else if (merge_next) {
+        ranges[pos].offset = offset;
+        ranges[pos].size += size;
+    } else {
+        if (!ngli_darray_push(ranges_array, NULL))
+            return NGL_ERROR_MEMORY;
+        ranges = ngli_darray_data(ranges_array);
+        memmove(&ranges[pos + 1], &ranges[pos], (nb_ranges - pos) * sizeof(*ranges));
+        ranges[pos].offset = offset;
+        ranges[pos].size = size;
+    }
+
+    block->nb_allocations--;
+    return 0;
+}
+
+int ngli_block_alloc_alloc(struct block_alloc *s, int pool, uint64_t size, uint64_t alignment,
+                           int dedicated, struct block_alloc_allocation *alloc)
+{
+    ngli_assert(pool >= 0 && pool < s->params.nb_pools);
+
+    memset(alloc, 0, sizeof(*alloc));
+
+    dedicated = dedicated || size > s->params.block_size / 2;
+
+    struct block_alloc_block *block = NULL;
+    uint64_t offset = 0;
+
+    if (dedicated) {
+        int ret = block_create(s, size, pool, 1, &block);
+        if (ret < 0)
+            return ret;
+        block->nb_allocations = 1;
+    } else {
+        alignment = NGLI_MAX(alignment, 1);
+        struct darray *blocks_array = &s->pools[pool];
+        struct block_alloc_block **blocks = ngli_darray_data(blocks_array);
+        for (int i = 0; i < ngli_darray_count(blocks_array); i++) {
+            int ret = block_alloc(blocks[i], size, alignment, &offset);
+            if (ret < 0)
+                return ret;
+            if (ret) {
+                block = blocks[i];
+                break;
+            }
+        }
+
+        if (!block) {
+            int ret = block_create(s, s->params.block_size, pool, 0, &block);
+            if (ret < 0)
+                return ret;
+            if (!ngli_darray_push(blocks_array, &block)) {
+                block_freep(s, &block);
+                return NGL_ERROR_MEMORY;
+            }
+            ret = block_alloc(block, size, alignment, &offset);
+            if (ret <= 0)
+                return ret < 0 ? ret : NGL_ERROR_MEMORY;
+        }
+    }
+
+    alloc->block       = block;
+    alloc->memory      = block->memory;
+    alloc->offset      = offset;
+    alloc->size        = size;
+    alloc->mapped_data = block->mapped_data ? block->mapped_data + offset : NULL;
+
+    s->stats.used += size;
+    s->stats.nb_allocations++;
+
+    return 0;
+}
+
+static int has_other_empty_block(const struct darray *blocks_array, const struct block_alloc_block *block)
+{
+    const struct block_alloc_block **blocks = ngli_darray_data(blocks_array);
+    for (int i = 0; i < ngli_darray_count(blocks_array); i++)
+        if (blocks[i] != block && !blocks[i]->nb_allocations)
+            return 1;
+    return 0;
+}
+
+void ngli_block_alloc_free(struct block_alloc *s, struct block_alloc_allocation *alloc)
+{
+    struct block_alloc_block *block = alloc->block;
+    if (!block)
+        return;
+
+    s->stats.used -= alloc->size;
+    s->stats.nb_allocations--;
+
+    if (block->dedicated) {
+        block_freep(s, &block);
+        memset(alloc, 0, sizeof(*alloc));
+        return;
+    }
+
+    if (block_release(block, alloc->offset, alloc->size) < 0)
+        LOG(ERROR, "could not release memory range, %" PRIu64 " bytes are lost", alloc->size);
+
+    /* Only one empty block is kept per pool, the others are released */
+    struct darray *blocks_array = &s->pools[block->pool];
+    if (!block->nb_allocations && has_other_empty_block(blocks_array, block)) {
+        struct block_alloc_block **blocks = ngli_darray_data(blocks_array);
+        for (int i = 0; i < ngli_darray_count(blocks_array); i++) {
+            if (blocks[i] == block) {
+                ngli_darray_remove(blocks_array, i);
+                break;
+            }
+        }
+        block_freep(s, &block);
+    }
+
+    memset(alloc, 0, sizeof(*alloc));
+}
+
+void ngli_block_alloc_reset(struct block_alloc *s)
+{
+    if (!s->pools)
+        return;
+
+    for (int i = 0; i < s->params.nb_pools; i++) {
+        struct darray *blocks_array = &s->pools[i];
+        struct block_alloc_block **blocks = ngli_darray_data(blocks_array);
+        for (int j = 0; j < ngli_darray_count(blocks_array); j++) {
+            if (blocks[j]->nb_allocations)
+                LOG(WARNING, "memory block still has %d live allocations", blocks[j]->nb_allocations);
+            block_freep(s, &blocks[j]);
+        }
+        ngli_darray_reset(blocks_array);
+    }
+    ngli_freep(&s->pools);
+    memset(s, 0, sizeof(*s));
+}
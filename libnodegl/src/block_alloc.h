@@ -0,0 +1,76 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef BLOCK_ALLOC_H
+#define BLOCK_ALLOC_H
+
+#include <stdint.h>
+
+#include "darray.h"
+
+/*
+ * Sub-allocator of large memory blocks. Small allocations are packed into
+ * per-pool blocks (with a first-fit free list), while dedicated ones get
+ * their own block. One empty block is kept per pool so that a resource
+ * recreated at the same pace as it is destroyed does not allocate and free a
+ * whole block every time. The memory of the blocks is provided by the user
+ * callbacks.
+ */
+
+struct block_alloc_block;
+
+struct block_alloc_allocation {
+    struct block_alloc_block *block;
+    void *memory;         /* memory of the block, as created by the user */
+    uint64_t offset;
+    uint64_t size;
+    uint8_t *mapped_data; /* host pointer to the allocation, if the block is mapped */
+};
+
+struct block_alloc_stats {
+    uint64_t used;      /* bytes handed out to resources */
+    uint64_t reserved;  /* bytes allocated in blocks */
+    int nb_allocations;
+    int nb_device_allocations;
+};
+
+struct block_alloc_params {
+    int nb_pools;
+    uint64_t block_size;
+    void *user_arg;
+    int (*block_create)(void *user_arg, int pool, uint64_t size, void **memoryp, uint8_t **mapped_datap);
+    void (*block_destroy)(void *user_arg, void *memory, uint8_t *mapped_data);
+};
+
+struct block_alloc {
+    struct block_alloc_params params;
+    struct darray *pools; /* arrays of block_alloc_block pointers */
+    struct block_alloc_stats stats;
+};
+
+int ngli_block_alloc_init(struct block_alloc *s, const struct block_alloc_params *params);
+int ngli_block_alloc_alloc(struct block_alloc *s, int pool, uint64_t size, uint64_t alignment,
+                           int dedicated, struct block_alloc_allocation *alloc);
+void ngli_block_alloc_free(struct block_alloc *s, struct block_alloc_allocation *alloc);
+void ngli_block_alloc_reset(struct block_alloc *s);
+
+#endif
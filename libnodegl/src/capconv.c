@@ -0,0 +1,467 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include "buffer.h"
+#include "capconv.h"
+#include "colorconv.h"
+#include "format.h"
+#include "gpu_ctx.h"
+#include "image.h"
+#include "internal.h"
+#include "log.h"
+#include "memory.h"
+#include "pgcraft.h"
+#include "pipeline_compat.h"
+#include "rendertarget.h"
+#include "texture.h"
+#include "topology.h"
+#include "type.h"
+#include "utils.h"
+
+/* GLSL fragments as string */
+#include "capture_i420_frag.h"
+#include "capture_nv12_frag.h"
+#include "capture_p010_frag.h"
+
+static const char *vert_base =
+    "void main()"                                                               "\n"
+    "{"                                                                         "\n"
+    "    ngl_out_pos = vec4(position.xy, 0.0, 1.0);"                            "\n"
+    "    var_tex_coord = position.zw;"                                          "\n"
+    "}";
+
+static const struct pgcraft_iovar vert_out_vars[] = {
+    {.name = "var_tex_coord", .type = NGLI_TYPE_VEC2},
+};
+
+static const struct capconv_info {
+    const char *name;
+    const char *frag_base;
+    int depth;
+    int default_space;
+    int width_align;
+    int height_align;
+    int samples_per_texel;
+} capconv_infos[] = {
+    [NGL_CAPTURE_BUFFER_TYPE_CPU_NV12] = {
+        .name              = "NV12",
+        .frag_base         = capture_nv12_frag,
+        .depth             = 8,
+        .default_space     = SXPLAYER_COL_SPC_BT709,
+        .width_align       = 4,
+        .height_align      = 2,
+        .samples_per_texel = 4,
+    },
+    [NGL_CAPTURE_BUFFER_TYPE_CPU_I420] = {
+        .name              = "I420",
+        .frag_base         = capture_i420_frag,
+        .depth             = 8,
+        .default_space     = SXPLAYER_COL_SPC_BT709,
+        .width_align       = 8,
+        .height_align      = 4,
+        .samples_per_texel = 4,
+    },
+    [NGL_CAPTURE_BUFFER_TYPE_CPU_P010] = {
+        .name              = "P010",
+        .frag_base         = capture_p010_frag,
+        .depth             = 10,
+        .default_space     = SXPLAYER_COL_SPC_BT2020_NCL,
+        .width_align       = 2,
+        .height_align      = 2,
+        .samples_per_texel = 2,
+    },
+};
+
+static const int colorspace_map[] = {
+    [NGL_CAPTURE_COLORSPACE_AUTO]   = SXPLAYER_COL_SPC_UNSPECIFIED,
+    [NGL_CAPTURE_COLORSPACE_BT601]  = SXPLAYER_COL_SPC_BT470BG,
+    [NGL_CAPTURE_COLORSPACE_BT709]  = SXPLAYER_COL_SPC_BT709,
+    [NGL_CAPTURE_COLORSPACE_BT2020] = SXPLAYER_COL_SPC_BT2020_NCL,
+};
+
+static const int color_range_map[] = {
+    [NGL_CAPTURE_COLOR_RANGE_LIMITED] = SXPLAYER_COL_RNG_LIMITED,
+    [NGL_CAPTURE_COLOR_RANGE_FULL]    = SXPLAYER_COL_RNG_FULL,
+};
+
+int ngli_capconv_is_yuv_type(int capture_buffer_type)
+{
+    return capture_buffer_type >= 0 &&
+           capture_buffer_type < NGLI_ARRAY_NB(capconv_infos) &&
+           capconv_infos[capture_buffer_type].frag_base;
+}
+
+int ngli_capconv_get_gpu_config(struct ngl_config *dst, const struct ngl_config *config)
+{
+    ngli_assert(ngli_capconv_is_yuv_type(config->capture_buffer_type));
+    const struct capconv_info *info = &capconv_infos[config->capture_buffer_type];
+
+    if (!config->offscreen) {
+        LOG(ERROR, "%s capture is only supported with offscreen rendering", info->name);
+        return NGL_ERROR_UNSUPPORTED;
+    }
+
+    if (config->width % info->width_align || config->height % info->height_align) {
+        LOG(ERROR, "%s capture requires the width to be a multiple of %d and the height "
+            "a multiple of %d, got %dx%d", info->name, info->width_align, info->height_align,
+            config->width, config->height);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    if (config->capture_colorspace < 0 ||
+        config->capture_colorspace >= NGLI_ARRAY_NB(colorspace_map)) {
+        LOG(ERROR, "invalid capture colorspace %d", config->capture_colorspace);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    if (config->capture_color_range < 0 ||
+        config->capture_color_range >= NGLI_ARRAY_NB(color_range_map)) {
+        LOG(ERROR, "invalid capture color range %d", config->capture_color_range);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    /*
+     * The GPU context only sees the packed RGBA8 representation of the YUV
+     * planes: multisampling and the viewport are honored by the scene
+     * rendertarget instead.
+     */
+    *dst = *config;
+    dst->width = config->width / info->samples_per_texel;
+    dst->height = config->height * 3 / 2;
+    dst->samples = 0;
+    memset(dst->viewport, 0, sizeof(dst->viewport));
+    dst->capture_buffer_type = NGL_CAPTURE_BUFFER_TYPE_CPU;
+
+    return 0;
+}
+
+struct capconv *ngli_capconv_create(struct ngl_ctx *ctx)
+{
+    struct capconv *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->ctx = ctx;
+    return s;
+}
+
+static int create_texture(struct gpu_ctx *gpu_ctx, struct texture **texturep,
+                          const struct texture_params *params)
+{
+    struct texture *texture = ngli_texture_create(gpu_ctx);
+    if (!texture)
+        return NGL_ERROR_MEMORY;
+    *texturep = texture;
+    return ngli_texture_init(texture, params);
+}
+
+static int create_rendertarget(struct gpu_ctx *gpu_ctx, struct rendertarget **rtp,
+                               const struct rendertarget_params *params)
+{
+    struct rendertarget *rt = ngli_rendertarget_create(gpu_ctx);
+    if (!rt)
+        return NGL_ERROR_MEMORY;
+    *rtp = rt;
+    return ngli_rendertarget_init(rt, params);
+}
+
+static int init_scene_rendertargets(struct capconv *s)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
+    const struct ngl_config *config = &ctx->config;
+
+    int samples = config->samples;
+    if (samples > 0 && !(gpu_ctx->features & NGLI_FEATURE_COLOR_RESOLVE)) {
+        LOG(WARNING, "context does not support resolving color attachments, "
+            "multisample anti-aliasing will be disabled");
+        samples = 0;
+    }
+
+    const int depth_format = ngli_gpu_ctx_get_preferred_depth_stencil_format(gpu_ctx);
+    const struct rendertarget_desc rt_desc = {
+        .samples                = samples,
+        .nb_colors              = 1,
+        .colors[0].format       = NGLI_FORMAT_R8G8B8A8_UNORM,
+        .colors[0].resolve      = samples > 0,
+        .depth_stencil.format   = depth_format,
+    };
+    s->rt_desc = rt_desc;
+
+    const struct texture_params color_params = {
+        .type       = NGLI_TEXTURE_TYPE_2D,
+        .format     = NGLI_FORMAT_R8G8B8A8_UNORM,
+        .width      = s->width,
+        .height     = s->height,
+        .min_filter = NGLI_FILTER_LINEAR,
+        .mag_filter = NGLI_FILTER_LINEAR,
+        .usage      = NGLI_TEXTURE_USAGE_COLOR_ATTACHMENT_BIT | NGLI_TEXTURE_USAGE_SAMPLED_BIT,
+    };
+    int ret = create_texture(gpu_ctx, &s->color, &color_params);
+    if (ret < 0)
+        return ret;
+
+    struct rendertarget_params rt_params = {
+        .width     = s->width,
+        .height    = s->height,
+        .nb_colors = 1,
+        .colors[0] = {
+            .attachment = s->color,
+            .load_op    = NGLI_LOAD_OP_CLEAR,
+            .store_op   = NGLI_STORE_OP_STORE,
+        },
+    };
+    memcpy(rt_params.colors[0].clear_value, config->clear_color, sizeof(config->clear_color));
+
+    if (samples) {
+        const struct texture_params ms_color_params = {
+            .type    = NGLI_TEXTURE_TYPE_2D,
+            .format  = NGLI_FORMAT_R8G8B8A8_UNORM,
+            .width   = s->width,
+            .height  = s->height,
+            .samples = samples,
+            .usage   = NGLI_TEXTURE_USAGE_COLOR_ATTACHMENT_BIT,
+        };
+        ret = create_texture(gpu_ctx, &s->ms_color, &ms_color_params);
+        if (ret < 0)
+            return ret;
+        rt_params.colors[0].attachment = s->ms_color;
+        rt_params.colors[0].resolve_target = s->color;
+    }
+
+    const struct texture_params depth_params = {
+        .type    = NGLI_TEXTURE_TYPE_2D,
+        .format  = depth_format,
+        .width   = s->width,
+        .height  = s->height,
+        .samples = samples,
+        .usage   = NGLI_TEXTURE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+    };
+    ret = create_texture(gpu_ctx, &s->depth, &depth_params);
+    if (ret < 0)
+        return ret;
+    rt_params.depth_stencil.attachment = s->depth;
+    rt_params.depth_stencil.load_op = NGLI_LOAD_OP_CLEAR;
+    rt_params.depth_stencil.store_op = NGLI_STORE_OP_STORE;
+
+    ret = create_rendertarget(gpu_ctx, &s->rt, &rt_params);
+    if (ret < 0)
+        return ret;
+
+    rt_params.colors[0].load_op = NGLI_LOAD_OP_LOAD;
+    rt_params.depth_stencil.load_op = NGLI_LOAD_OP_LOAD;
+    return create_rendertarget(gpu_ctx, &s->rt_resume, &rt_params);
+}
+
+static int init_conversion_pipeline(struct capconv *s)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
+    const struct ngl_config *config = &ctx->config;
+    const struct capconv_info *info = &capconv_infos[config->capture_buffer_type];
+
+    static const float vertices[] = {
+        -1.0f, -1.0f, 0.0f, 0.0f,
+         1.0f, -1.0f, 1.0f, 0.0f,
+        -1.0f,  1.0f, 0.0f, 1.0f,
+         1.0f,  1.0f, 1.0f, 1.0f,
+    };
+    s->vertices = ngli_buffer_create(gpu_ctx);
+    if (!s->vertices)
+        return NGL_ERROR_MEMORY;
+    int ret = ngli_buffer_init(s->vertices, sizeof(vertices), NGLI_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                                              NGLI_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    if (ret < 0)
+        return ret;
+
+    ret = ngli_buffer_upload(s->vertices, vertices, sizeof(vertices), 0);
+    if (ret < 0)
+        return ret;
+
+    const struct color_info color_info = {
+        .space = config->capture_colorspace == NGL_CAPTURE_COLORSPACE_AUTO
+               ? info->default_space : colorspace_map[config->capture_colorspace],
+        .range = color_range_map[config->capture_color_range],
+    };
+    ret = ngli_colorconv_get_rgb_to_ycbcr_color_matrix(s->color_matrix, &color_info, info->depth);
+    if (ret < 0)
+        return ret;
+
+    const struct pgcraft_uniform uniforms[] = {
+        {.name = "color_matrix", .type = NGLI_TYPE_MAT4, .stage = NGLI_PROGRAM_SHADER_FRAG, .data = NULL},
+    };
+
+    struct pgcraft_texture textures[] = {
+        {
+            .name     = "tex",
+            .type     = NGLI_PGCRAFT_SHADER_TEX_TYPE_2D,
+            .stage    = NGLI_PROGRAM_SHADER_FRAG,
+            .texture  = s->color,
+        },
+    };
+
+    const struct pgcraft_attribute attributes[] = {
+        {
+            .name     = "position",
+            .type     = NGLI_TYPE_VEC4,
+            .format   = NGLI_FORMAT_R32G32B32A32_SFLOAT,
+            .stride   = 4 * 4,
+            .buffer   = s->vertices,
+        },
+    };
+
+    const struct pgcraft_params crafter_params = {
+        .program_label    = "nodegl/capconv",
+        .vert_base        = vert_base,
+        .frag_base        = info->frag_base,
+        .uniforms         = uniforms,
+        .nb_uniforms      = NGLI_ARRAY_NB(uniforms),
+        .textures         = textures,
+        .nb_textures      = NGLI_ARRAY_NB(textures),
+        .attributes       = attributes,
+        .nb_attributes    = NGLI_ARRAY_NB(attributes),
+        .vert_out_vars    = vert_out_vars,
+        .nb_vert_out_vars = NGLI_ARRAY_NB(vert_out_vars),
+    };
+
+    s->crafter = ngli_pgcraft_create(ctx);
+    if (!s->crafter)
+        return NGL_ERROR_MEMORY;
+
+    ret = ngli_pgcraft_craft(s->crafter, &crafter_params);
+    if (ret < 0)
+        return ret;
+
+    s->pipeline_compat = ngli_pipeline_compat_create(gpu_ctx);
+    if (!s->pipeline_compat)
+        return NGL_ERROR_MEMORY;
+
+    const struct pipeline_params pipeline_params = {
+        .type         = NGLI_PIPELINE_TYPE_GRAPHICS,
+        .graphics     = {
+            .topology = NGLI_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP,
+            .state    = NGLI_GRAPHICSTATE_DEFAULTS,
+            .rt_desc  = *ngli_gpu_ctx_get_default_rendertarget_desc(gpu_ctx),
+        },
+        .program      = ngli_pgcraft_get_program(s->crafter),
+        .layout       = ngli_pgcraft_get_pipeline_layout(s->crafter),
+    };
+
+    const struct pipeline_resources pipeline_resources = ngli_pgcraft_get_pipeline_resources(s->crafter);
+    const struct pgcraft_compat_info *compat_info = ngli_pgcraft_get_compat_info(s->crafter);
+
+    const struct pipeline_compat_params params = {
+        .params = &pipeline_params,
+        .resources = &pipeline_resources,
+        .compat_info = compat_info,
+    };
+
+    ret = ngli_pipeline_compat_init(s->pipeline_compat, &params);
+    if (ret < 0)
+        return ret;
+
+    s->color_matrix_index = ngli_pgcraft_get_uniform_index(s->crafter, "color_matrix", NGLI_PROGRAM_SHADER_FRAG);
+
+    return 0;
+}
+
+int ngli_capconv_init(struct capconv *s)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    const struct ngl_config *config = &ctx->config;
+
+    s->width = config->width;
+    s->height = config->height;
+
+    const int *viewport = config->viewport;
+    if (viewport[2] > 0 && viewport[3] > 0) {
+        memcpy(s->viewport, viewport, sizeof(s->viewport));
+    } else {
+        const int default_viewport[] = {0, 0, s->width, s->height};
+        memcpy(s->viewport, default_viewport, sizeof(s->viewport));
+    }
+
+    int ret = init_scene_rendertargets(s);
+    if (ret < 0)
+        return ret;
+
+    return init_conversion_pipeline(s);
+}
+
+void ngli_capconv_begin_draw(struct capconv *s)
+{
+    struct gpu_ctx *gpu_ctx = s->ctx->gpu_ctx;
+
+    ngli_gpu_ctx_get_viewport(gpu_ctx, s->prev_viewport);
+    ngli_gpu_ctx_get_scissor(gpu_ctx, s->prev_scissor);
+
+    const int scissor[] = {0, 0, s->width, s->height};
+    ngli_gpu_ctx_set_viewport(gpu_ctx, s->viewport);
+    ngli_gpu_ctx_set_scissor(gpu_ctx, scissor);
+}
+
+void ngli_capconv_end_draw(struct capconv *s)
+{
+    struct gpu_ctx *gpu_ctx = s->ctx->gpu_ctx;
+
+    ngli_gpu_ctx_set_scissor(gpu_ctx, s->prev_scissor);
+
+    struct rendertarget *rt = ngli_gpu_ctx_get_default_rendertarget(gpu_ctx, NGLI_LOAD_OP_DONT_CARE);
+    ngli_gpu_ctx_begin_render_pass(gpu_ctx, rt);
+
+    const int vp[4] = {0, 0, rt->width, rt->height};
+    ngli_gpu_ctx_set_viewport(gpu_ctx, vp);
+
+    struct pipeline_compat *pipeline = s->pipeline_compat;
+
+    const struct darray *texture_infos_array = ngli_pgcraft_get_texture_infos(s->crafter);
+    const struct pgcraft_texture_info *info = ngli_darray_data(texture_infos_array);
+    ngli_assert(ngli_darray_count(texture_infos_array) == 1);
+
+    const struct pgcraft_texture_info_field *fields = info->fields;
+    const float dimensions[] = {s->width, s->height};
+    ngli_pipeline_compat_update_uniform(pipeline, fields[NGLI_INFO_FIELD_DIMENSIONS].index, dimensions);
+    ngli_pipeline_compat_update_uniform(pipeline, s->color_matrix_index, s->color_matrix);
+
+    ngli_ctx_defer_error(s->ctx, ngli_pipeline_compat_draw(pipeline, 4, 1));
+
+    ngli_gpu_ctx_end_render_pass(gpu_ctx);
+    ngli_gpu_ctx_set_viewport(gpu_ctx, s->prev_viewport);
+}
+
+void ngli_capconv_freep(struct capconv **sp)
+{
+    struct capconv *s = *sp;
+    if (!s)
+        return;
+
+    ngli_pipeline_compat_freep(&s->pipeline_compat);
+    ngli_pgcraft_freep(&s->crafter);
+    ngli_buffer_freep(&s->vertices);
+    ngli_rendertarget_freep(&s->rt_resume);
+    ngli_rendertarget_freep(&s->rt);
+    ngli_texture_freep(&s->depth);
+    ngli_texture_freep(&s->ms_color);
+    ngli_texture_freep(&s->color);
+
+    ngli_freep(sp);
+}
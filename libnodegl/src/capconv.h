@@ -0,0 +1,75 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef CAPCONV_H
+#define CAPCONV_H
+
+#include "buffer.h"
+#include "nodegl.h"
+#include "pgcraft.h"
+#include "pipeline_compat.h"
+#include "rendertarget.h"
+#include "texture.h"
+#include "utils.h"
+
+struct ngl_ctx;
+
+/*
+ * GPU conversion of the rendered frame into one of the YUV capture buffer
+ * types. The scene is rendered into a private RGBA rendertarget, and a final
+ * pass writes the YUV planes into the default rendertarget of the GPU
+ * context, whose RGBA8 texels are laid out exactly like the user capture
+ * buffer. This way, the backends read back the converted frame with their
+ * regular CPU capture path.
+ */
+struct capconv {
+    struct ngl_ctx *ctx;
+
+    int width;
+    int height;
+    int viewport[4];
+    int prev_viewport[4];
+    int prev_scissor[4];
+
+    struct rendertarget_desc rt_desc;
+    struct texture *color;
+    struct texture *ms_color;
+    struct texture *depth;
+    struct rendertarget *rt;
+    struct rendertarget *rt_resume;
+
+    struct buffer *vertices;
+    struct pgcraft *crafter;
+    struct pipeline_compat *pipeline_compat;
+    int color_matrix_index;
+    NGLI_ALIGNED_MAT(color_matrix);
+};
+
+int ngli_capconv_is_yuv_type(int capture_buffer_type);
+int ngli_capconv_get_gpu_config(struct ngl_config *dst, const struct ngl_config *config);
+
+struct capconv *ngli_capconv_create(struct ngl_ctx *ctx);
+int ngli_capconv_init(struct capconv *s);
+void ngli_capconv_begin_draw(struct capconv *s);
+void ngli_capconv_end_draw(struct capconv *s);
+void ngli_capconv_freep(struct capconv **sp);
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cmdqueue.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "pthread_compat.h"
+
+/*
+ * The critical sections are limited to a copy of the command and an update of
+ * the ring indexes, so the lock is never held for long.
+ */
+struct cmdqueue {
+    pthread_mutex_t lock;
+    int initialized;
+    uint8_t *cmds;
+    int cmd_size;
+    int capacity;
+    int head; /* index of the oldest command */
+    int count;
+};
+
+struct cmdqueue *ngli_cmdqueue_create(void)
+{
+    struct cmdqueue *s = ngli_calloc(1, sizeof(*s));
+    return s;
+}
+
+int ngli_cmdqueue_init(struct cmdqueue *s, int cmd_size, int capacity)
+{
+    s->cmds = ngli_calloc(capacity, cmd_size);
+    if (!s->cmds)
+        return NGL_ERROR_MEMORY;
+    s->cmd_size = cmd_size;
+    s->capacity = capacity;
+
+    if (pthread_mutex_init(&s->lock, NULL))
+        return NGL_ERROR_EXTERNAL;
+    s->initialized = 1;
+
+    return 0;
+}
+
+int ngli_cmdqueue_push(struct cmdqueue *s, const void *cmd)
+{
+    pthread_mutex_lock(&s->lock);
+    if (s->count == s->capacity) {
+        pthread_mutex_unlock(&s->lock);
+        return NGL_ERROR_LIMIT_EXCEEDED;
+    }
+    const int index = (s->head + s->count) % s->capacity;
+    memcpy(s->cmds + index * s->cmd_size, cmd, s->cmd_size);
+    s->count++;
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+int ngli_cmdqueue_replace_or_push(struct cmdqueue *s, const void *cmd,
+                                  int (*is_same)(const void *queued_cmd, const void *cmd),
+                                  void *old_cmd)
+{
+    pthread_mutex_lock(&s->lock);
+    /* Recent commands are the most likely to be replaced */
+    for (int i = s->count - 1; i >= 0; i--) {
+        uint8_t *queued_cmd = s->cmds + (s->head + i) % s->capacity * s->cmd_size;
+        if (is_same(queued_cmd, cmd)) {
+            memcpy(old_cmd, queued_cmd, s->cmd_size);
+            memcpy(queued_cmd, cmd, s->cmd_size);
+            pthread_mutex_unlock(&s->lock);
+            return 1;
+        }
+    }
+    if (s->count == s->capacity) {
+        pthread_mutex_unlock(&s->lock);
+        return NGL_ERROR_LIMIT_EXCEEDED;
+    }
+    const int index = (s->head + s->count) % s->capacity;
+    memcpy(s->cmds + index * s->cmd_size, cmd, s->cmd_size);
+    s->count++;
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+int ngli_cmdqueue_pop(struct cmdqueue *s, void *cmd)
+{
+    pthread_mutex_lock(&s->lock);
+    if (!s->count) {
+        pthread_mutex_unlock(&s->lock);
+        return 0;
+    }
+    memcpy(cmd, s->cmds + s->head * s->cmd_size, s->cmd_size);
+    s->head = (s->head + 1) % s->capacity;
+    s->count--;
+    pthread_mutex_unlock(&s->lock);
+
+    return 1;
+}
+
+void ngli_cmdqueue_freep(struct cmdqueue **sp)
+{
+    struct cmdqueue *s = *sp;
+    if (!s)
+        return;
+
+    if (s->initialized)
+        pthread_mutex_destroy(&s->lock);
+    ngli_freep(&s->cmds);
+    ngli_freep(sp);
+}
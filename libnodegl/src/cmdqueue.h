@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef CMDQUEUE_H
+#define CMDQUEUE_H
+
+/*
+ * Bounded FIFO of fixed size commands, which can be pushed from any number of
+ * threads and are popped by a single consumer. Neither side ever waits for the
+ * other: pushing to a full queue fails with NGL_ERROR_LIMIT_EXCEEDED, and
+ * popping from an empty one returns 0.
+ */
+
+struct cmdqueue;
+
+struct cmdqueue *ngli_cmdqueue_create(void);
+int ngli_cmdqueue_init(struct cmdqueue *s, int cmd_size, int capacity);
+int ngli_cmdqueue_push(struct cmdqueue *s, const void *cmd);
+
+/*
+ * Same as ngli_cmdqueue_push(), except that a queued command for which
+ * is_same(queued_cmd, cmd) is true is overwritten in place by cmd. The
+ * overwritten command is then copied into old_cmd and 1 is returned. Returns
+ * 0 if cmd has been pushed at the end of the queue.
+ */
+int ngli_cmdqueue_replace_or_push(struct cmdqueue *s, const void *cmd,
+                                  int (*is_same)(const void *queued_cmd, const void *cmd),
+                                  void *old_cmd);
+
+/*
+ * Copy the oldest command into cmd and remove it from the queue. Returns 1 if
+ * a command has been popped, 0 if the queue is empty.
+ */
+int ngli_cmdqueue_pop(struct cmdqueue *s, void *cmd);
+
+void ngli_cmdqueue_freep(struct cmdqueue **sp);
+
+#endif
@@ -155,6 +155,56 @@ int ngli_colorconv_get_ycbcr_to_rgb_color_matrix(float *dst, const struct color_
     return 0;
 }
 
+int ngli_colorconv_get_rgb_to_ycbcr_color_matrix(float *dst, const struct color_info *info, int depth)
+{
+    const int colormatrix = get_colormatrix_from_sxplayer(info->space);
+    const int video_range = info->range != SXPLAYER_COL_RNG_FULL;
+    const struct range_info range = range_infos[video_range];
+    const struct k_constants k = k_constants_infos[colormatrix];
+
+    /*
+     * The range constants are expressed for 8-bit samples: limited range
+     * values are scaled with the bit depth while full range values span the
+     * whole code space. The output is normalized to the maximum code value.
+     */
+    const float max_val  = (1 << depth) - 1;
+    const float depth_scale = 1 << (depth - 8);
+    const float y_range  = video_range ? range.y  * depth_scale : max_val;
+    const float uv_range = video_range ? range.uv * depth_scale : max_val;
+    const float y_off    = range.y_off * depth_scale;
+    const float uv_off   = 1 << (depth - 1);
+
+    const float y_scale  = y_range / max_val;
+    const float cb_scale = uv_range / (2 * (1. - k.b) * max_val);
+    const float cr_scale = uv_range / (2 * (1. - k.r) * max_val);
+
+    /* R factor */
+    dst[ 0 /* Y  */] = y_scale * k.r;
+    dst[ 1 /* Cb */] = -cb_scale * k.r;
+    dst[ 2 /* Cr */] = cr_scale * (1 - k.r);
+    dst[ 3 /* A  */] = 0;
+
+    /* G factor */
+    dst[ 4 /* Y  */] = y_scale * k.g;
+    dst[ 5 /* Cb */] = -cb_scale * k.g;
+    dst[ 6 /* Cr */] = -cr_scale * k.g;
+    dst[ 7 /* A  */] = 0;
+
+    /* B factor */
+    dst[ 8 /* Y  */] = y_scale * k.b;
+    dst[ 9 /* Cb */] = cb_scale * (1 - k.b);
+    dst[10 /* Cr */] = -cr_scale * k.b;
+    dst[11 /* A  */] = 0;
+
+    /* Offset */
+    dst[12 /* Y  */] = y_off / max_val;
+    dst[13 /* Cb */] = uv_off / max_val;
+    dst[14 /* Cr */] = uv_off / max_val;
+    dst[15 /* A  */] = 1;
+
+    return 0;
+}
+
 const struct param_choices ngli_colorconv_colorspace_choices = {
     .name = "colorspace",
     .consts = {
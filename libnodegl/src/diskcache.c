@@ -0,0 +1,524 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "darray.h"
+#include "diskcache.h"
+#include "log.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "pthread_compat.h"
+#include "utils.h"
+
+#define ENTRY_EXT       ".bin"
+#define ENTRY_MAGIC     NGLI_FOURCC('N','G','L','C')
+#define ENTRY_VERSION   1
+
+#define FNV_PRIME       0x100000001b3ULL
+#define FNV_BASIS_0     0xcbf29ce484222325ULL
+#define FNV_BASIS_1     0x84222325cbf29ce4ULL
+
+#define NS_PER_SEC      1000000000LL
+#ifdef _WIN32
+#define FILETIME_EPOCH  116444736000000000LL /* 1970-01-01 in 100ns units since 1601 */
+#endif
+
+struct entry_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+struct entry_info {
+    char *filename;
+    int64_t size;
+    int64_t mtime; /* in nanoseconds */
+};
+
+struct diskcache {
+    char *path;
+    int64_t max_size;
+    pthread_mutex_t lock;
+    int lock_initialized;
+    int64_t total_size;
+    int64_t last_stamp;
+};
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+    return h;
+}
+
+void ngli_diskcache_key_init(struct diskcache_key *key, const char *domain)
+{
+    key->h[0] = FNV_BASIS_0;
+    key->h[1] = FNV_BASIS_1;
+    ngli_diskcache_key_update_str(key, domain);
+}
+
+void ngli_diskcache_key_update(struct diskcache_key *key, const void *data, size_t size)
+{
+    /* The second hash also covers the size so that collisions between the
+     * two halves are unlikely to be correlated */
+    key->h[0] = fnv1a(key->h[0], data, size);
+    key->h[1] = fnv1a(key->h[1], &size, sizeof(size));
+    key->h[1] = fnv1a(key->h[1], data, size);
+}
+
+void ngli_diskcache_key_update_str(struct diskcache_key *key, const char *str)
+{
+    ngli_diskcache_key_update(key, str, strlen(str) + 1);
+}
+
+void ngli_diskcache_key_update_int(struct diskcache_key *key, int64_t value)
+{
+    ngli_diskcache_key_update(key, &value, sizeof(value));
+}
+
+static int make_dir(const char *path)
+{
+#ifdef _WIN32
+    if (!CreateDirectoryA(path, NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+        return NGL_ERROR_IO;
+#else
+    if (mkdir(path, 0755) < 0 && errno != EEXIST)
+        return NGL_ERROR_IO;
+#endif
+    return 0;
+}
+
+#ifdef _WIN32
+static int64_t filetime_to_ns(const FILETIME *ft)
+{
+    const int64_t t = (int64_t)ft->dwHighDateTime << 32 | ft->dwLowDateTime;
+    return (t - FILETIME_EPOCH) * 100;
+}
+#endif
+
+static int64_t get_realtime_ns(void)
+{
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    return filetime_to_ns(&ft);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+#endif
+}
+
+static void set_file_mtime(const char *filename, int64_t mtime)
+{
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(filename, FILE_WRITE_ATTRIBUTES,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    const int64_t t = mtime / 100 + FILETIME_EPOCH;
+    const FILETIME ft = {.dwLowDateTime = (DWORD)t, .dwHighDateTime = (DWORD)(t >> 32)};
+    SetFileTime(handle, NULL, &ft, &ft);
+    CloseHandle(handle);
+#else
+    const struct timespec ts = {.tv_sec = mtime / NS_PER_SEC, .tv_nsec = mtime % NS_PER_SEC};
+    const struct timespec times[2] = {ts, ts};
+    utimensat(AT_FDCWD, filename, times, 0);
+#endif
+}
+
+/*
+ * The LRU eviction orders the entries by modification time. Since the clock
+ * of the file system is usually much coarser than its timestamps, the
+ * modification time of an entry is explicitly set on every access with a
+ * nanosecond stamp that strictly increases within the process.
+ */
+static void touch_entry(struct diskcache *s, const char *filename)
+{
+    pthread_mutex_lock(&s->lock);
+    s->last_stamp = NGLI_MAX(get_realtime_ns(), s->last_stamp + 1);
+    const int64_t stamp = s->last_stamp;
+    pthread_mutex_unlock(&s->lock);
+
+    set_file_mtime(filename, stamp);
+}
+
+static int rename_file(const char *src, const char *dst)
+{
+#ifdef _WIN32
+    if (!MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING))
+        return NGL_ERROR_IO;
+#else
+    if (rename(src, dst) < 0)
+        return NGL_ERROR_IO;
+#endif
+    return 0;
+}
+
+static int get_pid(void)
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+
+static int is_entry_filename(const char *name)
+{
+    const size_t len = strlen(name);
+    const size_t ext_len = strlen(ENTRY_EXT);
+    return len > ext_len && !strcmp(name + len - ext_len, ENTRY_EXT);
+}
+
+static void reset_entries(struct darray *entries)
+{
+    struct entry_info *infos = ngli_darray_data(entries);
+    for (int i = 0; i < ngli_darray_count(entries); i++)
+        ngli_freep(&infos[i].filename);
+    ngli_darray_reset(entries);
+}
+
+static int push_entry(struct diskcache *s, struct darray *entries, const char *name,
+                      int64_t size, int64_t mtime)
+{
+    struct entry_info info = {
+        .filename = ngli_asprintf("%s/%s", s->path, name),
+        .size     = size,
+        .mtime    = mtime,
+    };
+    if (!info.filename)
+        return NGL_ERROR_MEMORY;
+    if (!ngli_darray_push(entries, &info)) {
+        ngli_freep(&info.filename);
+        return NGL_ERROR_MEMORY;
+    }
+    return 0;
+}
+
+static int list_entries(struct diskcache *s, struct darray *entries)
+{
+    ngli_darray_init(entries, sizeof(struct entry_info), 0);
+
+#ifdef _WIN32
+    char *pattern = ngli_asprintf("%s/*" ENTRY_EXT, s->path);
+    if (!pattern)
+        return NGL_ERROR_MEMORY;
+
+    WIN32_FIND_DATAA data;
+    HANDLE handle = FindFirstFileA(pattern, &data);
+    ngli_freep(&pattern);
+    if (handle == INVALID_HANDLE_VALUE)
+        return 0;
+
+    int ret = 0;
+    do {
+        const int64_t size = (int64_t)data.nFileSizeHigh << 32 | data.nFileSizeLow;
+        const int64_t mtime = filetime_to_ns(&data.ftLastWriteTime);
+        ret = push_entry(s, entries, data.cFileName, size, mtime);
+    } while (ret >= 0 && FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    DIR *dir = opendir(s->path);
+    if (!dir)
+        return NGL_ERROR_IO;
+
+    int ret = 0;
+    struct dirent *dirent;
+    while (ret >= 0 && (dirent = readdir(dir))) {
+        if (!is_entry_filename(dirent->d_name))
+            continue;
+
+        char *filename = ngli_asprintf("%s/%s", s->path, dirent->d_name);
+        if (!filename) {
+            ret = NGL_ERROR_MEMORY;
+            break;
+        }
+        struct stat st;
+        const int stat_ret = stat(filename, &st);
+        ngli_freep(&filename);
+        if (stat_ret < 0)
+            continue;
+
+#if defined(__APPLE__)
+        const int64_t mtime = st.st_mtimespec.tv_sec * NS_PER_SEC + st.st_mtimespec.tv_nsec;
+#else
+        const int64_t mtime = st.st_mtim.tv_sec * NS_PER_SEC + st.st_mtim.tv_nsec;
+#endif
+        ret = push_entry(s, entries, dirent->d_name, st.st_size, mtime);
+    }
+    closedir(dir);
+#endif
+
+    if (ret < 0)
+        reset_entries(entries);
+    return ret;
+}
+
+static int cmp_entry_mtime(const void *a, const void *b)
+{
+    const struct entry_info *e0 = a;
+    const struct entry_info *e1 = b;
+    return (e0->mtime > e1->mtime) - (e0->mtime < e1->mtime);
+}
+
+static void evict_entries(struct diskcache *s, const char *keep_filename)
+{
+    struct darray entries;
+    int ret = list_entries(s, &entries);
+    if (ret < 0)
+        return;
+
+    /* Other processes may share the same directory, so recompute the size */
+    s->total_size = 0;
+    struct entry_info *infos = ngli_darray_data(&entries);
+    for (int i = 0; i < ngli_darray_count(&entries); i++)
+        s->total_size += infos[i].size;
+
+    /* Evict down to 3/4 of the maximum so we do not scan again on next put */
+    const int64_t target_size = s->max_size / 4 * 3;
+    qsort(infos, ngli_darray_count(&entries), sizeof(*infos), cmp_entry_mtime);
+    for (int i = 0; i < ngli_darray_count(&entries) && s->total_size > target_size; i++) {
+        /* Another process may have touched older entries with a later stamp */
+        if (keep_filename && !strcmp(infos[i].filename, keep_filename))
+            continue;
+        if (remove(infos[i].filename) < 0)
+            continue;
+        LOG(DEBUG, "evicted cache entry %s", infos[i].filename);
+        s->total_size -= infos[i].size;
+    }
+
+    reset_entries(&entries);
+}
+
+struct diskcache *ngli_diskcache_create(void)
+{
+    struct diskcache *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    if (pthread_mutex_init(&s->lock, NULL)) {
+        ngli_free(s);
+        return NULL;
+    }
+    s->lock_initialized = 1;
+    return s;
+}
+
+int ngli_diskcache_init(struct diskcache *s, const char *path, int64_t max_size)
+{
+    s->path = ngli_strdup(path);
+    if (!s->path)
+        return NGL_ERROR_MEMORY;
+    s->max_size = max_size;
+
+    int ret = make_dir(s->path);
+    if (ret < 0) {
+        LOG(ERROR, "could not create cache directory %s", s->path);
+        return ret;
+    }
+
+    struct darray entries;
+    ret = list_entries(s, &entries);
+    if (ret < 0) {
+        LOG(ERROR, "could not list cache directory %s", s->path);
+        return ret;
+    }
+
+    const struct entry_info *infos = ngli_darray_data(&entries);
+    for (int i = 0; i < ngli_darray_count(&entries); i++)
+        s->total_size += infos[i].size;
+    reset_entries(&entries);
+
+    if (s->total_size > s->max_size)
+        evict_entries(s, NULL);
+
+    return 0;
+}
+
+static char *get_entry_filename(const struct diskcache *s, const struct diskcache_key *key)
+{
+    return ngli_asprintf("%s/%016" PRIx64 "%016" PRIx64 ENTRY_EXT, s->path, key->h[0], key->h[1]);
+}
+
+static int64_t get_file_size(FILE *fp)
+{
+    if (fseek(fp, 0, SEEK_END) < 0)
+        return -1;
+    const int64_t size = ftell(fp);
+    if (fseek(fp, 0, SEEK_SET) < 0)
+        return -1;
+    return size;
+}
+
+int ngli_diskcache_get(struct diskcache *s, const struct diskcache_key *key, void **datap, size_t *sizep)
+{
+    char *filename = get_entry_filename(s, key);
+    if (!filename)
+        return NGL_ERROR_NOT_FOUND;
+
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        ngli_freep(&filename);
+        return NGL_ERROR_NOT_FOUND;
+    }
+
+    /*
+     * The size of the payload is checked against the size of the file
+     * before allocating anything so a corrupted header cannot trigger an
+     * arbitrarily large allocation.
+     */
+    int ret = NGL_ERROR_INVALID_DATA;
+    void *data = NULL;
+    struct entry_header header;
+    const int64_t file_size = get_file_size(fp);
+    if (file_size < (int64_t)sizeof(header) ||
+        fread(&header, sizeof(header), 1, fp) != 1 ||
+        header.magic != ENTRY_MAGIC ||
+        header.version != ENTRY_VERSION ||
+        header.size != (uint64_t)(file_size - sizeof(header)) ||
+        header.size > SIZE_MAX)
+        goto end;
+
+    data = ngli_malloc(header.size ? header.size : 1);
+    if (!data) {
+        ret = NGL_ERROR_MEMORY;
+        goto end;
+    }
+
+    if (fread(data, 1, header.size, fp) != header.size ||
+        fnv1a(FNV_BASIS_0, data, header.size) != header.checksum)
+        goto end;
+
+    *datap = data;
+    *sizep = header.size;
+    data = NULL;
+    ret = 0;
+
+end:
+    fclose(fp);
+    ngli_freep(&data);
+
+    if (ret == NGL_ERROR_INVALID_DATA) {
+        LOG(WARNING, "removing corrupted cache entry %s", filename);
+        remove(filename);
+    } else if (ret == NGL_ERROR_MEMORY) {
+        LOG(WARNING, "could not allocate cache entry %s", filename);
+    } else if (ret == 0) {
+        touch_entry(s, filename);
+    }
+
+    ngli_freep(&filename);
+    return ret < 0 ? NGL_ERROR_NOT_FOUND : 0;
+}
+
+int ngli_diskcache_put(struct diskcache *s, const struct diskcache_key *key, const void *data, size_t size)
+{
+    char *filename = get_entry_filename(s, key);
+    char *tmp_filename = ngli_asprintf("%s.%d.tmp", filename ? filename : "", get_pid());
+    if (!filename || !tmp_filename) {
+        ngli_freep(&filename);
+        ngli_freep(&tmp_filename);
+        return NGL_ERROR_MEMORY;
+    }
+
+    /*
+     * The entry is written to a temporary file which is then atomically
+     * renamed so that concurrent readers never see a partial entry. Writers
+     * of the same process are serialized since they share the temporary
+     * file name and the size accounting.
+     */
+    pthread_mutex_lock(&s->lock);
+    int ret = NGL_ERROR_IO;
+    FILE *fp = fopen(tmp_filename, "wb");
+    if (!fp)
+        goto end;
+
+    const struct entry_header header = {
+        .magic    = ENTRY_MAGIC,
+        .version  = ENTRY_VERSION,
+        .size     = size,
+        .checksum = fnv1a(FNV_BASIS_0, data, size),
+    };
+    const int write_ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+                         fwrite(data, 1, size, fp) == size;
+    if (fclose(fp) != 0 || !write_ok) {
+        remove(tmp_filename);
+        goto end;
+    }
+
+    ret = rename_file(tmp_filename, filename);
+    if (ret < 0) {
+        remove(tmp_filename);
+        goto end;
+    }
+
+    s->last_stamp = NGLI_MAX(get_realtime_ns(), s->last_stamp + 1);
+    set_file_mtime(filename, s->last_stamp);
+
+    s->total_size += sizeof(header) + size;
+    if (s->total_size > s->max_size)
+        evict_entries(s, filename);
+
+end:
+    pthread_mutex_unlock(&s->lock);
+    if (ret < 0)
+        LOG(WARNING, "could not write cache entry %s", filename);
+    ngli_freep(&tmp_filename);
+    ngli_freep(&filename);
+    return ret;
+}
+
+void ngli_diskcache_freep(struct diskcache **sp)
+{
+    struct diskcache *s = *sp;
+    if (!s)
+        return;
+    ngli_freep(&s->path);
+    if (s->lock_initialized)
+        pthread_mutex_destroy(&s->lock);
+    ngli_freep(sp);
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DISKCACHE_H
+#define DISKCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Content addressed on-disk cache: entries are identified by a 128-bit hash
+ * of everything that may affect them (source code, compiler version, ...),
+ * and stored as one file per entry in the cache directory. When the total
+ * size of the directory exceeds the configured maximum, the least recently
+ * used entries are evicted.
+ *
+ * The cache is best-effort: any I/O error, corrupted entry (which is then
+ * removed) or allocation failure is reported by ngli_diskcache_get() as a
+ * cache miss (NGL_ERROR_NOT_FOUND). Lookups and insertions can be made
+ * concurrently from multiple threads.
+ */
+
+struct diskcache_key {
+    uint64_t h[2];
+};
+
+void ngli_diskcache_key_init(struct diskcache_key *key, const char *domain);
+void ngli_diskcache_key_update(struct diskcache_key *key, const void *data, size_t size);
+void ngli_diskcache_key_update_str(struct diskcache_key *key, const char *str);
+void ngli_diskcache_key_update_int(struct diskcache_key *key, int64_t value);
+
+struct diskcache;
+
+struct diskcache *ngli_diskcache_create(void);
+int ngli_diskcache_init(struct diskcache *s, const char *path, int64_t max_size);
+int ngli_diskcache_get(struct diskcache *s, const struct diskcache_key *key, void **datap, size_t *sizep);
+int ngli_diskcache_put(struct diskcache *s, const struct diskcache_key *key, const void *data, size_t size);
+void ngli_diskcache_freep(struct diskcache **sp);
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include capture_yuv.glsl
+
+float get_chroma_component(vec2 pos, bool cr)
+{
+    vec2 c = get_chroma(pos);
+    return cr ? c.y : c.x;
+}
+
+/*
+ * The output texture is 1/4 of the source width and 3/2 of its height: every
+ * RGBA8 texel holds 4 samples, and every row of the Cb and Cr planes holds 2
+ * consecutive chroma rows.
+ */
+void main()
+{
+    vec2 pos = floor(var_tex_coord * vec2(tex_dimensions.x / 4.0, tex_dimensions.y * 1.5));
+    float x = pos.x * 4.0;
+    if (pos.y < tex_dimensions.y) {
+        ngl_out_color = vec4(get_luma(vec2(x,       pos.y)),
+                             get_luma(vec2(x + 1.0, pos.y)),
+                             get_luma(vec2(x + 2.0, pos.y)),
+                             get_luma(vec2(x + 3.0, pos.y)));
+    } else {
+        float plane_height = tex_dimensions.y / 4.0;
+        float chroma_width = tex_dimensions.x / 2.0;
+        float row = pos.y - tex_dimensions.y;
+        bool cr = row >= plane_height;
+        row = cr ? row - plane_height : row;
+        bool odd = x >= chroma_width;
+        vec2 c = vec2(odd ? x - chroma_width : x, row * 2.0 + (odd ? 1.0 : 0.0));
+        ngl_out_color = vec4(get_chroma_component(c,                  cr),
+                             get_chroma_component(c + vec2(1.0, 0.0), cr),
+                             get_chroma_component(c + vec2(2.0, 0.0), cr),
+                             get_chroma_component(c + vec2(3.0, 0.0), cr));
+    }
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include capture_yuv.glsl
+
+/*
+ * The output texture is 1/4 of the source width and 3/2 of its height: every
+ * RGBA8 texel holds 4 luma samples in the luma plane and 2 Cb/Cr pairs in the
+ * interleaved chroma plane.
+ */
+void main()
+{
+    vec2 pos = floor(var_tex_coord * vec2(tex_dimensions.x / 4.0, tex_dimensions.y * 1.5));
+    if (pos.y < tex_dimensions.y) {
+        float x = pos.x * 4.0;
+        ngl_out_color = vec4(get_luma(vec2(x,       pos.y)),
+                             get_luma(vec2(x + 1.0, pos.y)),
+                             get_luma(vec2(x + 2.0, pos.y)),
+                             get_luma(vec2(x + 3.0, pos.y)));
+    } else {
+        vec2 c = vec2(pos.x * 2.0, pos.y - tex_dimensions.y);
+        ngl_out_color = vec4(get_chroma(c), get_chroma(c + vec2(1.0, 0.0)));
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Helpers shared by the YUV capture conversion passes. The source texture
+ * (tex) is sampled with a bilinear filter: fetching at the center of a 2x2
+ * block averages the block, which is used for the 4:2:0 chroma subsampling.
+ */
+
+vec3 get_ycbcr(vec2 pos)
+{
+    vec3 rgb = ngl_tex2d(tex, pos / tex_dimensions).rgb;
+    return clamp((color_matrix * vec4(rgb, 1.0)).xyz, 0.0, 1.0);
+}
+
+float get_luma(vec2 pos)
+{
+    return get_ycbcr(pos + 0.5).x;
+}
+
+vec2 get_chroma(vec2 pos)
+{
+    return get_ycbcr(pos * 2.0 + 1.0).yz;
+}
+
+/* Encode a normalized 10-bit sample as a little-endian 16-bit word (MSB aligned) */
+vec2 encode_p010(float x)
+{
+    float word = floor(x * 1023.0 + 0.5) * 64.0;
+    float hi = floor(word / 256.0);
+    return vec2(word - hi * 256.0, hi) / 255.0;
+}
@@ -85,8 +85,33 @@ struct gpu_ctx *ngli_gpu_ctx_create(const struct ngl_config *config)
     return s;
 }
 
+#define DEFAULT_CACHE_MAX_SIZE 256 /* MiB */
+
+static int init_diskcache(struct gpu_ctx *s)
+{
+    const struct ngl_config *config = &s->config;
+    if (!config->cache_dir)
+        return 0;
+
+    s->diskcache = ngli_diskcache_create();
+    if (!s->diskcache)
+        return NGL_ERROR_MEMORY;
+
+    const int max_size = config->cache_max_size > 0 ? config->cache_max_size : DEFAULT_CACHE_MAX_SIZE;
+    int ret = ngli_diskcache_init(s->diskcache, config->cache_dir, (int64_t)max_size << 20);
+    if (ret < 0) {
+        /* The disk cache is an optimization, its failure is not fatal */
+        LOG(WARNING, "disk cache is disabled");
+        ngli_diskcache_freep(&s->diskcache);
+    }
+    return 0;
+}
+
 int ngli_gpu_ctx_init(struct gpu_ctx *s)
 {
+    int ret = init_diskcache(s);
+    if (ret < 0)
+        return ret;
     return s->cls->init(s);
 }
 
@@ -102,6 +127,16 @@ int ngli_gpu_ctx_set_capture_buffer(struct gpu_ctx *s, void *capture_buffer)
     return cls->set_capture_buffer(s, capture_buffer);
 }
 
+int ngli_gpu_ctx_fetch_capture(struct gpu_ctx *s, int wait, double *t)
+{
+    const struct gpu_ctx_class *cls = s->cls;
+    if (!cls->fetch_capture) {
+        LOG(ERROR, "asynchronous capture is not supported by this backend");
+        return NGL_ERROR_UNSUPPORTED;
+    }
+    return cls->fetch_capture(s, wait, t);
+}
+
 int ngli_gpu_ctx_begin_update(struct gpu_ctx *s, double t)
 {
     return s->cls->begin_update(s, t);
@@ -114,6 +149,7 @@ int ngli_gpu_ctx_end_update(struct gpu_ctx *s, double t)
 
 int ngli_gpu_ctx_begin_draw(struct gpu_ctx *s, double t)
 {
+    s->nb_elided_uniform_uploads = 0;
     return s->cls->begin_draw(s, t);
 }
 
@@ -127,6 +163,16 @@ int ngli_gpu_ctx_query_draw_time(struct gpu_ctx *s, int64_t *time)
     return s->cls->query_draw_time(s, time);
 }
 
+int ngli_gpu_ctx_get_memory_stats(struct gpu_ctx *s, struct gpu_memory_stats *stats)
+{
+    const struct gpu_ctx_class *cls = s->cls;
+    if (!cls->get_memory_stats) {
+        memset(stats, 0, sizeof(*stats));
+        return NGL_ERROR_UNSUPPORTED;
+    }
+    return cls->get_memory_stats(s, stats);
+}
+
 void ngli_gpu_ctx_wait_idle(struct gpu_ctx *s)
 {
     s->cls->wait_idle(s);
@@ -142,6 +188,7 @@ void ngli_gpu_ctx_freep(struct gpu_ctx **sp)
     if (cls)
         cls->destroy(s);
 
+    ngli_diskcache_freep(&s->diskcache);
     ngli_config_reset(&s->config);
     ngli_freep(sp);
 }
@@ -210,3 +257,11 @@ int ngli_gpu_ctx_get_preferred_depth_stencil_format(struct gpu_ctx *s)
 {
     return s->cls->get_preferred_depth_stencil_format(s);
 }
+
+int ngli_gpu_ctx_get_uniform_memory(struct gpu_ctx *s, int size, struct buffer **bufferp, int *offsetp, void **datap)
+{
+    const struct gpu_ctx_class *cls = s->cls;
+    if (!cls->get_uniform_memory)
+        return NGL_ERROR_GRAPHICS_UNSUPPORTED;
+    return cls->get_uniform_memory(s, size, bufferp, offsetp, datap);
+}
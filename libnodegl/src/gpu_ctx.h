@@ -25,6 +25,7 @@
 #include <stdint.h>
 
 #include "buffer.h"
+#include "diskcache.h"
 #include "gpu_limits.h"
 #include "nodegl.h"
 #include "pipeline.h"
@@ -47,6 +48,13 @@
 #define NGLI_FEATURE_TEXTURE_HALF_FLOAT_RENDERABLE     (1 << 13)
 #define NGLI_FEATURE_BUFFER_MAP                        (1 << 14)
 
+struct gpu_memory_stats {
+    uint64_t used;      /* bytes used by the resources */
+    uint64_t reserved;  /* bytes allocated from the GPU heaps */
+    int nb_allocations;
+    int nb_device_allocations;
+};
+
 struct gpu_ctx_class {
     const char *name;
 
@@ -54,11 +62,13 @@ struct gpu_ctx_class {
     int (*init)(struct gpu_ctx *s);
     int (*resize)(struct gpu_ctx *s, int width, int height, const int *viewport);
     int (*set_capture_buffer)(struct gpu_ctx *s, void *capture_buffer);
+    int (*fetch_capture)(struct gpu_ctx *s, int wait, double *t);
     int (*begin_update)(struct gpu_ctx *s, double t);
     int (*end_update)(struct gpu_ctx *s, double t);
     int (*begin_draw)(struct gpu_ctx *s, double t);
     int (*end_draw)(struct gpu_ctx *s, double t);
     int (*query_draw_time)(struct gpu_ctx *s, int64_t *time);
+    int (*get_memory_stats)(struct gpu_ctx *s, struct gpu_memory_stats *stats);
     void (*wait_idle)(struct gpu_ctx *s);
     void (*destroy)(struct gpu_ctx *s);
 
@@ -85,6 +95,7 @@ struct gpu_ctx_class {
     int (*buffer_map)(struct buffer *s, int size, int offset, void **datap);
     void (*buffer_unmap)(struct buffer *s);
     void (*buffer_freep)(struct buffer **sp);
+    int (*get_uniform_memory)(struct gpu_ctx *s, int size, struct buffer **bufferp, int *offsetp, void **datap);
 
     struct pipeline *(*pipeline_create)(struct gpu_ctx *ctx);
     int (*pipeline_init)(struct pipeline *s, const struct pipeline_params *params);
@@ -100,6 +111,8 @@ struct gpu_ctx_class {
 
     struct program *(*program_create)(struct gpu_ctx *ctx);
     int (*program_init)(struct program *s, const struct program_params *params);
+    int (*program_init_batch)(struct program **programs, const struct program_params *params,
+                              int nb_programs, struct threadpool *threadpool);
     void (*program_freep)(struct program **sp);
 
     struct rendertarget *(*rendertarget_create)(struct gpu_ctx *ctx);
@@ -121,6 +134,8 @@ struct gpu_ctx {
     int language_version;
     uint64_t features;
     struct gpu_limits limits;
+    struct diskcache *diskcache; /* NULL if disk caching is disabled */
+    int nb_elided_uniform_uploads; /* unchanged uniforms not uploaded during the current draw */
 #if DEBUG_GPU_CAPTURE
     struct gpu_capture_ctx *gpu_capture_ctx;
     int gpu_capture;
@@ -131,11 +146,13 @@ struct gpu_ctx *ngli_gpu_ctx_create(const struct ngl_config *config);
 int ngli_gpu_ctx_init(struct gpu_ctx *s);
 int ngli_gpu_ctx_resize(struct gpu_ctx *s, int width, int height, const int *viewport);
 int ngli_gpu_ctx_set_capture_buffer(struct gpu_ctx *s, void *capture_buffer);
+int ngli_gpu_ctx_fetch_capture(struct gpu_ctx *s, int wait, double *t);
 int ngli_gpu_ctx_begin_update(struct gpu_ctx *s, double t);
 int ngli_gpu_ctx_end_update(struct gpu_ctx *s, double t);
 int ngli_gpu_ctx_begin_draw(struct gpu_ctx *s, double t);
 int ngli_gpu_ctx_query_draw_time(struct gpu_ctx *s, int64_t *time);
 int ngli_gpu_ctx_end_draw(struct gpu_ctx *s, double t);
+int ngli_gpu_ctx_get_memory_stats(struct gpu_ctx *s, struct gpu_memory_stats *stats);
 void ngli_gpu_ctx_wait_idle(struct gpu_ctx *s);
 void ngli_gpu_ctx_freep(struct gpu_ctx **sp);
 
@@ -157,4 +174,13 @@ void ngli_gpu_ctx_get_scissor(struct gpu_ctx *s, int *scissor);
 int ngli_gpu_ctx_get_preferred_depth_format(struct gpu_ctx *s);
 int ngli_gpu_ctx_get_preferred_depth_stencil_format(struct gpu_ctx *s);
 
+/*
+ * Sub-allocate size bytes of mapped uniform buffer memory from the per-frame
+ * ring of the context. The memory can be written until the draw using it is
+ * recorded, and must be bound as a dynamic uniform buffer at the returned
+ * offset. Only the backends using uniform blocks for the pipeline uniforms
+ * implement it.
+ */
+int ngli_gpu_ctx_get_uniform_memory(struct gpu_ctx *s, int size, struct buffer **bufferp, int *offsetp, void **datap);
+
 #endif
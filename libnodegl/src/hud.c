@@ -65,6 +65,10 @@ struct hud {
 
     int modelview_matrix_index;
     int projection_matrix_index;
+
+    const struct program *last_program;
+    struct graphicstate last_graphicstate;
+    int nb_pipeline_switches;
 };
 
 #define WIDGET_PADDING 4
@@ -89,6 +93,8 @@ enum {
     MEMORY_BLOCKS_CPU,
     MEMORY_BLOCKS_GPU,
     MEMORY_TEXTURES,
+    MEMORY_HEAP_USED,
+    MEMORY_HEAP_RESERVED,
     NB_MEMORY
 };
 
@@ -105,6 +111,8 @@ enum {
     DRAWCALL_GRAPHICCONFIGS,
     DRAWCALL_RENDERS,
     DRAWCALL_RTTS,
+    DRAWCALL_PIPELINE_SWITCHES,
+    DRAWCALL_ELIDED_UNIFORMS,
     NB_DRAWCALL
 };
 
@@ -184,6 +192,16 @@ static const struct {
         .node_types=(const int[]){NGL_NODE_TEXTURE2D, NGL_NODE_TEXTURE3D, -1},
         .color=0xFF3232FF,
     },
+    [MEMORY_HEAP_USED] = {
+        .label="Heap used",
+        .node_types=(const int[]){-1},
+        .color=0x32FFFFFF,
+    },
+    [MEMORY_HEAP_RESERVED] = {
+        .label="Heap reserved",
+        .node_types=(const int[]){-1},
+        .color=0xFF9632FF,
+    },
 };
 
 static const struct activity_spec {
@@ -208,9 +226,20 @@ static const struct activity_spec {
     },
 };
 
+static int get_nb_pipeline_switches(const struct hud *s)
+{
+    return s->nb_pipeline_switches;
+}
+
+static int get_nb_elided_uniform_uploads(const struct hud *s)
+{
+    return s->ctx->gpu_ctx->nb_elided_uniform_uploads;
+}
+
 static const struct drawcall_spec {
     const char *label;
     const int *node_types;
+    int (*get_count)(const struct hud *s); /* used instead of the node draw counts */
 } drawcall_specs[] = {
     [DRAWCALL_COMPUTES] = {
         .label="Computes",
@@ -235,6 +264,14 @@ static const struct drawcall_spec {
         .label="RTTs",
         .node_types=(const int[]){NGL_NODE_RENDERTOTEXTURE, -1},
     },
+    [DRAWCALL_PIPELINE_SWITCHES] = {
+        .label="PipeSwitch",
+        .get_count=get_nb_pipeline_switches, /* counted by ngli_hud_register_draw() */
+    },
+    [DRAWCALL_ELIDED_UNIFORMS] = {
+        .label="UniSkip",
+        .get_count=get_nb_elided_uniform_uploads,
+    },
 };
 
 NGLI_STATIC_ASSERT(hud_nb_latency,  NGLI_ARRAY_NB(latency_specs)  == NB_LATENCY);
@@ -414,6 +451,10 @@ static int widget_drawcall_init(struct hud *s, struct widget *widget)
     const struct drawcall_spec *spec = widget->user_data;
     struct widget_drawcall *priv = widget->priv_data;
     const int *node_types = spec->node_types;
+    if (spec->get_count) {
+        ngli_darray_init(&priv->nodes, sizeof(struct ngl_node *), 0);
+        return 0;
+    }
     return make_nodes_set(scene, &priv->nodes, node_types);
 }
 
@@ -477,6 +518,12 @@ static void widget_memory_make_stats(struct hud *s, struct widget *widget)
         priv->sizes[MEMORY_TEXTURES] += ngli_image_get_memory_size(&texture->image)
                                       * tex_node->is_active;
     }
+
+    /* Real GPU heap usage, only reported by backends with their own allocator */
+    struct gpu_memory_stats stats;
+    ngli_gpu_ctx_get_memory_stats(s->ctx->gpu_ctx, &stats);
+    priv->sizes[MEMORY_HEAP_USED] = stats.used;
+    priv->sizes[MEMORY_HEAP_RESERVED] = stats.reserved;
 }
 
 static void widget_activity_make_stats(struct hud *s, struct widget *widget)
@@ -491,7 +538,12 @@ static void widget_activity_make_stats(struct hud *s, struct widget *widget)
 
 static void widget_drawcall_make_stats(struct hud *s, struct widget *widget)
 {
+    const struct drawcall_spec *spec = widget->user_data;
     struct widget_drawcall *priv = widget->priv_data;
+    if (spec->get_count) {
+        priv->nb_draws = spec->get_count(s);
+        return;
+    }
     struct darray *nodes_array = &priv->nodes;
     struct ngl_node **nodes = ngli_darray_data(nodes_array);
     priv->nb_draws = 0;
@@ -1029,6 +1081,20 @@ static void widgets_make_stats(struct hud *s)
         if (w->type == WIDGET_DRAWCALL)
             widget_drawcall_reset_draws(w);
     }
+    s->last_program = NULL;
+    s->nb_pipeline_switches = 0;
+}
+
+void ngli_hud_register_draw(struct hud *s, const struct program *program,
+                            const struct graphicstate *graphicstate)
+{
+    if (s->last_program &&
+        s->last_program == program &&
+        !memcmp(&s->last_graphicstate, graphicstate, sizeof(*graphicstate)))
+        return;
+    s->last_program = program;
+    s->last_graphicstate = *graphicstate;
+    s->nb_pipeline_switches++;
 }
 
 static void widgets_draw(struct hud *s)
@@ -1357,7 +1423,7 @@ void ngli_hud_draw(struct hud *s)
     const float *projection_matrix = ngli_darray_tail(&ctx->projection_matrix_stack);
     ngli_pipeline_compat_update_uniform(s->pipeline_compat, s->modelview_matrix_index, modelview_matrix);
     ngli_pipeline_compat_update_uniform(s->pipeline_compat, s->projection_matrix_index, projection_matrix);
-    ngli_pipeline_compat_draw(s->pipeline_compat, 4, 1);
+    ngli_ctx_defer_error(ctx, ngli_pipeline_compat_draw(s->pipeline_compat, 4, 1));
 }
 
 void ngli_hud_freep(struct hud **sp)
@@ -26,9 +26,15 @@
 
 struct ngl_ctx;
 struct hud;
+struct program;
+struct graphicstate;
 
 struct hud *ngli_hud_create(struct ngl_ctx *ctx);
 int ngli_hud_init(struct hud *s);
+
+/* Track the pipeline switches between the graphics draws of the scene */
+void ngli_hud_register_draw(struct hud *s, const struct program *program,
+                            const struct graphicstate *graphicstate);
 void ngli_hud_draw(struct hud *s);
 void ngli_hud_freep(struct hud **sp);
 
@@ -254,12 +254,12 @@ int ngli_hwconv_convert_image(struct hwconv *hwconv, const struct image *image)
     ngli_pipeline_compat_update_uniform(pipeline, fields[NGLI_INFO_FIELD_COORDINATE_MATRIX].index, image->coordinates_matrix);
     ngli_pipeline_compat_update_uniform(pipeline, fields[NGLI_INFO_FIELD_COLOR_MATRIX].index, image->color_matrix);
 
-    ngli_pipeline_compat_draw(pipeline, 4, 1);
+    ret = ngli_pipeline_compat_draw(pipeline, 4, 1);
 
     ngli_gpu_ctx_end_render_pass(gpu_ctx);
     ngli_gpu_ctx_set_viewport(gpu_ctx, prev_vp);
 
-    return 0;
+    return ret;
 }
 
 void ngli_hwconv_reset(struct hwconv *hwconv)
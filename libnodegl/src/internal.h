@@ -39,7 +39,10 @@
 #endif
 
 #include "animation.h"
+#include "arena.h"
 #include "block.h"
+#include "capconv.h"
+#include "cmdqueue.h"
 #include "drawutils.h"
 #include "graphicstate.h"
 #include "hmap.h"
@@ -50,6 +53,7 @@
 #include "nodegl.h"
 #include "params.h"
 #include "pgcache.h"
+#include "plan.h"
 #include "program.h"
 #include "pthread_compat.h"
 #include "darray.h"
@@ -58,18 +62,40 @@
 #include "rendertarget.h"
 #include "rnode.h"
 #include "texture.h"
+#include "workqueue.h"
 
 struct node_class;
 
 typedef int (*cmd_func_type)(struct ngl_ctx *s, void *arg);
 
+/*
+ * Live change of a parameter of a node attached to a context, queued by
+ * ngl_node_param_set_*() and applied by ngli_node_apply_live_changes()
+ */
+struct live_change {
+    struct ngl_node *node;
+    const struct node_param *par;
+    uint8_t *dst;
+    union {
+        int i[4];
+        unsigned u[4];
+        float f[16];
+        double d;
+        char *s;
+    } value;
+};
+
+#define NGLI_MAX_LIVE_CHANGES 1024
+
 struct api_impl {
     int (*configure)(struct ngl_ctx *s, const struct ngl_config *config);
     int (*resize)(struct ngl_ctx *s, int width, int height, const int *viewport);
     int (*set_capture_buffer)(struct ngl_ctx *s, void *capture_buffer);
+    int (*fetch_capture)(struct ngl_ctx *s, int wait, double *t);
     int (*set_scene)(struct ngl_ctx *s, struct ngl_node *scene);
     int (*prepare_draw)(struct ngl_ctx *s, double t);
     int (*draw)(struct ngl_ctx *s, double t);
+    int (*draw_async)(struct ngl_ctx *s, double t);
     void (*reset)(struct ngl_ctx *s, int action);
 
     /* OpenGL */
@@ -103,6 +129,14 @@ struct ngl_ctx {
 
     struct texture *font_atlas;
     struct pgcache pgcache;
+    struct threadpool *threadpool;
+    struct workqueue *prefetch_queue;
+
+    /* Passes with pipelines waiting to be crafted, see ngli_pass_prepare() */
+    struct darray pending_passes;
+
+    /* Flattened update and draw traversals of the scene, see plan.h */
+    struct plan plan;
 #if defined(HAVE_VAAPI)
     struct vaapi_ctx vaapi_ctx;
 #endif
@@ -110,6 +144,7 @@ struct ngl_ctx {
     struct android_ctx android_ctx;
 #endif
     struct hud *hud;
+    struct capconv *capconv;
     int64_t cpu_update_time;
     int64_t cpu_draw_time;
     int64_t gpu_draw_time;
@@ -121,15 +156,35 @@ struct ngl_ctx {
     cmd_func_type cmd_func;
     void *cmd_arg;
     int cmd_ret;
+    int async_cmd_pending;
+    int async_cmd_ret;
+    int deferred_ret; /* first error without a direct caller, returned by the next draw */
+    double draw_async_time;
+    struct cmdqueue *live_changes;
 };
 
 #define NGLI_ACTION_KEEP_SCENE  0
 #define NGLI_ACTION_UNREF_SCENE 1
 
 int ngli_ctx_dispatch_cmd(struct ngl_ctx *s, cmd_func_type cmd_func, void *arg);
+
+/*
+ * Dispatch a command to the worker without waiting for its completion. Any
+ * other command (or ngli_ctx_wait_async_cmd()) waits for it first, and its
+ * result is returned by the next ngl_wait() or ngl_draw_async() call.
+ */
+int ngli_ctx_dispatch_cmd_async(struct ngl_ctx *s, cmd_func_type cmd_func, void *arg);
+void ngli_ctx_wait_async_cmd(struct ngl_ctx *s);
+
+/*
+ * Record an error which cannot be returned to its caller (node draw callbacks,
+ * queued live changes, ...): the first one is returned by the next draw.
+ */
+void ngli_ctx_defer_error(struct ngl_ctx *s, int ret);
 int ngli_ctx_configure(struct ngl_ctx *s, const struct ngl_config *config);
 int ngli_ctx_resize(struct ngl_ctx *s, int width, int height, const int *viewport);
 int ngli_ctx_set_capture_buffer(struct ngl_ctx *s, void *capture_buffer);
+int ngli_ctx_fetch_capture(struct ngl_ctx *s, int wait, double *t);
 int ngli_ctx_set_scene(struct ngl_ctx *s, struct ngl_node *node);
 int ngli_ctx_prepare_draw(struct ngl_ctx *s, double t);
 int ngli_ctx_draw(struct ngl_ctx *s, double t);
@@ -147,11 +202,18 @@ struct ngl_node {
     double visit_time;
     double last_update_time;
 
+    int is_time_dependent; /* the node or one of its children is flagged NGLI_NODE_FLAG_TIME_DEPENDENT */
+    int is_up_to_date;     /* a time invariant node has been updated and not invalidated since */
+
     int draw_count;
 
+    struct work prefetch_work; /* see NGLI_NODE_FLAG_ASYNC_PREFETCH */
+
     int refcount;
     int ctx_refcount;
 
+    struct arena *arena; /* arena the node has been carved from, if any */
+
     struct darray children;
     struct darray parents;
 
@@ -226,6 +288,7 @@ struct variable_info {
     int data_size;
     int data_type;          // any of NGLI_TYPE_*
     int dynamic;
+    uint64_t version;       // incremented every time data may have changed
 };
 
 int ngli_velocity_evaluate(struct ngl_node *node, void *dst, double t);
@@ -280,6 +343,7 @@ struct texture_priv {
 struct media_priv {
     struct sxplayer_ctx *player;
     struct sxplayer_frame *frame;
+    struct sxplayer_frame *prefetched_frame; /* decoded by prefetch(), consumed by the first update() */
     int nb_parents;
 
 #if defined(TARGET_ANDROID)
@@ -298,11 +362,27 @@ struct timerangemode_priv {
     int updated;
 };
 
+/*
+ * Append to boundaries (array of double) the times at which the time range
+ * filter node may change the activity of its child during a visit.
+ */
+int ngli_node_timerangefilter_add_boundaries(struct ngl_node *node, struct darray *boundaries);
+
 struct transform {
     struct ngl_node *child;
     NGLI_ALIGNED_MAT(matrix);
 };
 
+struct pass;
+
+struct pass *ngli_node_render_get_pass(struct ngl_node *node);
+
+/*
+ * Return the index of the child of each draw of a Group node, or NULL if the
+ * children are drawn in their order.
+ */
+const int *ngli_node_group_get_draw_order(const struct ngl_node *node);
+
 struct io_opts {
     int precision_out;
     int precision_in;
@@ -441,6 +521,31 @@ enum {
  */
 #define NGLI_NODE_FLAG_LIVECTL (1 << 0)
 
+/*
+ * The update of the node depends on the time, independently of its children.
+ * The nodes without this flag and without any time dependent child are only
+ * updated once, and then again after each invalidation or release of their
+ * branch.
+ */
+#define NGLI_NODE_FLAG_TIME_DEPENDENT (1 << 1)
+
+/*
+ * The update callback of the node only works on the CPU: it does not use the
+ * GPU context nor any state shared with other nodes than its own children.
+ * When ngl_config.parallel_update is set, the subtrees made of such nodes are
+ * updated concurrently on the thread pool of the context (see plan.h).
+ */
+#define NGLI_NODE_FLAG_CPU_UPDATE (1 << 2)
+
+/*
+ * The prefetch callback of the node does not use the GPU context and can be
+ * executed in the background: the node is then only waited for by its first
+ * update (or its release). Combined with the prefetch time of the time range
+ * filters, this moves expensive prefetches (such as starting a media player)
+ * out of the frames.
+ */
+#define NGLI_NODE_FLAG_ASYNC_PREFETCH (1 << 3)
+
 /*
  * Specifications of a node.
  *
@@ -614,15 +719,34 @@ int ngli_node_visit(struct ngl_node *node, int is_active, double t);
 int ngli_node_honor_release_prefetch(struct ngl_node *scene, double t);
 int ngli_node_update(struct ngl_node *node, double t);
 int ngli_node_update_children(struct ngl_node *node, double t);
+/*
+ * Account for the update of a node forwarding its update to its children
+ * (ngli_node_update_children()), without updating these children. Return 1 if
+ * the node is time invariant and up-to-date, in which case the update of its
+ * children can be skipped as well.
+ */
+int ngli_node_mark_updated(struct ngl_node *node, double t);
 void *ngli_node_get_data_ptr(struct ngl_node *var_node, void *data_fallback);
 int ngli_prepare_draw(struct ngl_ctx *s, double t);
 void ngli_node_draw(struct ngl_node *node);
 
+/*
+ * Attach the node graph to the context and prepare it. The pipelines of the
+ * prepared passes are left pending: they must be created with
+ * ngli_pass_create_pending_pipelines() once the plan is built.
+ */
 int ngli_node_attach_ctx(struct ngl_node *node, struct ngl_ctx *ctx);
 void ngli_node_detach_ctx(struct ngl_node *node, struct ngl_ctx *ctx);
 
+/*
+ * Apply the pending live changes of the parameters of the nodes attached to
+ * the context. Returns the first error encountered, if any.
+ */
+int ngli_node_apply_live_changes(struct ngl_ctx *ctx);
+
 int ngli_node_livectls_get(const struct ngl_node *scene, int *nb_livectlsp, struct ngl_livectl **livectlsp);
 void ngli_node_livectls_freep(struct ngl_livectl **livectlsp);
+int ngli_node_livectls_apply(int nb_livectls, const struct ngl_livectl *livectls);
 
 char *ngli_node_default_label(const char *class_name);
 int ngli_is_default_label(const char *class_name, const char *str);
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <string.h>
+
+#include "linear_alloc.h"
+#include "nodegl.h"
+#include "utils.h"
+
+void ngli_linear_alloc_init(struct linear_alloc *s, const struct linear_alloc_params *params)
+{
+    ngli_assert(params->chunk_size > 0);
+    ngli_assert(params->alignment > 0 && !(params->alignment & (params->alignment - 1)));
+
+    memset(s, 0, sizeof(*s));
+    s->params = *params;
+    ngli_darray_init(&s->chunks, sizeof(struct linear_alloc_chunk), 0);
+}
+
+static void release_chunks(struct linear_alloc *s, int nb_kept)
+{
+    const struct linear_alloc_params *params = &s->params;
+    const int nb_chunks = ngli_darray_count(&s->chunks);
+    struct linear_alloc_chunk *chunks = ngli_darray_data(&s->chunks);
+    for (int i = nb_kept; i < nb_chunks; i++)
+        params->chunk_free(params->user_arg, &chunks[i]);
+    ngli_darray_remove_range(&s->chunks, nb_kept, nb_chunks - nb_kept);
+}
+
+void ngli_linear_alloc_begin(struct linear_alloc *s)
+{
+    const int nb_chunks = ngli_darray_count(&s->chunks);
+    if (s->nb_used_chunks == nb_chunks) {
+        s->nb_idle_frames = 0;
+        s->peak_chunks = 0;
+    } else {
+        s->peak_chunks = NGLI_MAX(s->peak_chunks, s->nb_used_chunks);
+        if (++s->nb_idle_frames >= s->params.trim_delay) {
+            release_chunks(s, s->peak_chunks);
+            s->nb_idle_frames = 0;
+            s->peak_chunks = 0;
+        }
+    }
+
+    s->cur_chunk = 0;
+    s->offset = 0;
+    s->nb_used_chunks = 0;
+}
+
+static int alloc_chunk(struct linear_alloc *s, int size)
+{
+    const struct linear_alloc_params *params = &s->params;
+
+    struct linear_alloc_chunk chunk = {.size = NGLI_MAX(size, params->chunk_size)};
+    int ret = params->chunk_alloc(params->user_arg, &chunk);
+    if (ret < 0)
+        return ret;
+
+    if (!ngli_darray_push(&s->chunks, &chunk)) {
+        params->chunk_free(params->user_arg, &chunk);
+        return NGL_ERROR_MEMORY;
+    }
+
+    return 0;
+}
+
+int ngli_linear_alloc_get(struct linear_alloc *s, int size,
+                          struct linear_alloc_chunk **chunkp, int *offsetp)
+{
+    for (;;) {
+        if (s->cur_chunk == ngli_darray_count(&s->chunks)) {
+            int ret = alloc_chunk(s, size);
+            if (ret < 0)
+                return ret;
+        }
+
+        struct linear_alloc_chunk *chunk = ngli_darray_get(&s->chunks, s->cur_chunk);
+        const int offset = NGLI_ALIGN(s->offset, s->params.alignment);
+        if (offset + size <= chunk->size) {
+            s->offset = offset + size;
+            s->nb_used_chunks = s->cur_chunk + 1;
+            *chunkp = chunk;
+            *offsetp = offset;
+            return 0;
+        }
+
+        s->cur_chunk++;
+        s->offset = 0;
+    }
+}
+
+void ngli_linear_alloc_reset(struct linear_alloc *s)
+{
+    if (!s->params.chunk_free)
+        return;
+    release_chunks(s, 0);
+    ngli_darray_reset(&s->chunks);
+    memset(s, 0, sizeof(*s));
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef LINEAR_ALLOC_H
+#define LINEAR_ALLOC_H
+
+#include <stdint.h>
+
+#include "darray.h"
+
+/*
+ * Linear sub-allocator of transient memory: every allocation of a frame is
+ * packed in a list of chunks which is entirely recycled at the beginning of
+ * the next frame. The list grows on demand and shrinks back to the peak usage
+ * once the allocations fit in fewer chunks for trim_delay consecutive frames.
+ * The memory of the chunks is provided by the user callbacks.
+ */
+
+struct linear_alloc_chunk {
+    void *priv;    /* user data associated with the chunk */
+    uint8_t *data; /* host pointer to the chunk memory */
+    int size;
+};
+
+struct linear_alloc_params {
+    int chunk_size;  /* minimum size of a chunk */
+    int alignment;
+    int trim_delay;  /* number of frames before the unused chunks are released */
+    void *user_arg;
+    int (*chunk_alloc)(void *user_arg, struct linear_alloc_chunk *chunk);
+    void (*chunk_free)(void *user_arg, struct linear_alloc_chunk *chunk);
+};
+
+struct linear_alloc {
+    struct linear_alloc_params params;
+    struct darray chunks; /* array of linear_alloc_chunk */
+    int cur_chunk;
+    int offset;
+    int nb_used_chunks;   /* number of chunks used by the current frame */
+    int peak_chunks;      /* peak number of chunks used since the last full usage */
+    int nb_idle_frames;   /* number of consecutive frames not using every chunk */
+};
+
+void ngli_linear_alloc_init(struct linear_alloc *s, const struct linear_alloc_params *params);
+void ngli_linear_alloc_begin(struct linear_alloc *s);
+
+/*
+ * Reserve size bytes in the current frame. The returned chunk pointer is only
+ * valid until the next call.
+ */
+int ngli_linear_alloc_get(struct linear_alloc *s, int size,
+                          struct linear_alloc_chunk **chunkp, int *offsetp);
+
+void ngli_linear_alloc_reset(struct linear_alloc *s);
+
+#endif
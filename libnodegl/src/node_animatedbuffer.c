@@ -191,6 +191,7 @@ const struct node_class ngli_animatedbuffer##type_name##_class = {
     .priv_size = sizeof(struct animatedbuffer_priv),                               \
     .params    = animatedbuffer_params,                                            \
     .params_id = "AnimatedBuffer",                                                 \
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT,                                    \
     .file      = __FILE__,                                                         \
 };                                                                                 \
 
@@ -167,7 +167,7 @@ static void compute_uninit(struct ngl_node *node)
 static void compute_draw(struct ngl_node *node)
 {
     struct compute_priv *s = node->priv_data;
-    ngli_pass_exec(&s->pass);
+    ngli_ctx_defer_error(node->ctx, ngli_pass_exec(&s->pass));
 }
 
 const struct node_class ngli_compute_class = {
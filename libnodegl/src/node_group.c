@@ -20,23 +20,206 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include "log.h"
+#include "memory.h"
 #include "nodegl.h"
 #include "internal.h"
+#include "pass.h"
+#include "utils.h"
 
 struct group_opts {
     struct ngl_node **children;
     int nb_children;
+    int sort_draws;
+};
+
+struct group_priv {
+    int *draw_order; /* index of the child of each draw, NULL to follow the children order */
 };
 
 #define OFFSET(x) offsetof(struct group_opts, x)
 static const struct node_param group_params[] = {
     {"children", NGLI_PARAM_TYPE_NODELIST, OFFSET(children),
                  .desc=NGLI_DOCSTRING("a set of scenes")},
+    {"sort_draws", NGLI_PARAM_TYPE_BOOL, OFFSET(sort_draws), {.i32=0},
+                   .desc=NGLI_DOCSTRING("sort the draws of the consecutive `Render` children (optionally drawn "
+                                        "through transforms) by pipeline, then textures, then buffers, to "
+                                        "minimize the state changes; their draws must not depend on their order "
+                                        "(opaque, depth tested, ...)")},
     {NULL}
 };
 
+struct draw_key {
+    int index;
+    const struct pass *pass; /* NULL if the child is not a Render node */
+    const struct rnode *rnode;
+};
+
+static const struct pass *get_render_pass(struct ngl_node *node)
+{
+    while (node) {
+        switch (node->cls->id) {
+        case NGL_NODE_ROTATE:
+        case NGL_NODE_ROTATEQUAT:
+        case NGL_NODE_SCALE:
+        case NGL_NODE_SKEW:
+        case NGL_NODE_TRANSFORM:
+        case NGL_NODE_TRANSLATE: {
+            const struct transform *trf = node->priv_data;
+            node = trf->child;
+            break;
+        }
+        case NGL_NODE_RENDER:
+            return ngli_node_render_get_pass(node);
+        default:
+            return NULL;
+        }
+    }
+    return NULL;
+}
+
+static int cmp_ptr(const void *a, const void *b)
+{
+    return ((uintptr_t)a > (uintptr_t)b) - ((uintptr_t)a < (uintptr_t)b);
+}
+
+static int cmp_pipelines(const struct draw_key *ka, const struct draw_key *kb)
+{
+    const struct pass *pa = ka->pass;
+    const struct pass *pb = kb->pass;
+    int ret;
+    if ((ret = strcmp(pa->params.vert_base, pb->params.vert_base)) ||
+        (ret = strcmp(pa->params.frag_base, pb->params.frag_base)) ||
+        (ret = pa->pipeline_graphics.topology - pb->pipeline_graphics.topology) ||
+        (ret = pa->params.blending - pb->params.blending) ||
+        (ret = memcmp(&ka->rnode->graphicstate, &kb->rnode->graphicstate, sizeof(ka->rnode->graphicstate))))
+        return ret;
+    return 0;
+}
+
+static int cmp_textures(const struct pass *pa, const struct pass *pb)
+{
+    const int nb_textures = NGLI_MIN(ngli_darray_count(&pa->crafter_textures), ngli_darray_count(&pb->crafter_textures));
+    const struct pgcraft_texture *textures_a = ngli_darray_data(&pa->crafter_textures);
+    const struct pgcraft_texture *textures_b = ngli_darray_data(&pb->crafter_textures);
+    for (int i = 0; i < nb_textures; i++) {
+        const int ret = cmp_ptr(textures_a[i].image, textures_b[i].image);
+        if (ret)
+            return ret;
+    }
+    return ngli_darray_count(&pa->crafter_textures) - ngli_darray_count(&pb->crafter_textures);
+}
+
+static int cmp_buffers(const struct pass *pa, const struct pass *pb)
+{
+    const int nb_blocks = NGLI_MIN(ngli_darray_count(&pa->crafter_blocks), ngli_darray_count(&pb->crafter_blocks));
+    const struct pgcraft_block *blocks_a = ngli_darray_data(&pa->crafter_blocks);
+    const struct pgcraft_block *blocks_b = ngli_darray_data(&pb->crafter_blocks);
+    for (int i = 0; i < nb_blocks; i++) {
+        const int ret = cmp_ptr(blocks_a[i].buffer, blocks_b[i].buffer);
+        if (ret)
+            return ret;
+    }
+    int ret = ngli_darray_count(&pa->crafter_blocks) - ngli_darray_count(&pb->crafter_blocks);
+    if (ret)
+        return ret;
+
+    const int nb_attributes = NGLI_MIN(ngli_darray_count(&pa->crafter_attributes), ngli_darray_count(&pb->crafter_attributes));
+    const struct pgcraft_attribute *attributes_a = ngli_darray_data(&pa->crafter_attributes);
+    const struct pgcraft_attribute *attributes_b = ngli_darray_data(&pb->crafter_attributes);
+    for (int i = 0; i < nb_attributes; i++) {
+        ret = cmp_ptr(attributes_a[i].buffer, attributes_b[i].buffer);
+        if (ret)
+            return ret;
+    }
+    return ngli_darray_count(&pa->crafter_attributes) - ngli_darray_count(&pb->crafter_attributes);
+}
+
+/* The child index is the last criterion to keep the sort stable */
+static int cmp_draw_keys(const void *a, const void *b)
+{
+    const struct draw_key *ka = a;
+    const struct draw_key *kb = b;
+    int ret;
+    if ((ret = cmp_pipelines(ka, kb)) ||
+        (ret = cmp_textures(ka->pass, kb->pass)) ||
+        (ret = cmp_buffers(ka->pass, kb->pass)))
+        return ret;
+    return ka->index - kb->index;
+}
+
+static int count_pipeline_changes(const struct draw_key *keys, int nb_keys)
+{
+    int nb_changes = 0;
+    for (int i = 1; i < nb_keys; i++)
+        if (keys[i - 1].pass && keys[i].pass && cmp_pipelines(&keys[i - 1], &keys[i]))
+            nb_changes++;
+    return nb_changes;
+}
+
+/*
+ * Only the runs of consecutive Render children are sorted: any other node
+ * (compute, render to texture, ...) may depend on the draws preceding it.
+ */
+static int sort_draws(struct ngl_node *node)
+{
+    struct ngl_ctx *ctx = node->ctx;
+    struct group_priv *s = node->priv_data;
+    const struct group_opts *o = node->opts;
+
+    struct draw_key *keys = ngli_calloc(o->nb_children, sizeof(*keys));
+    if (!keys)
+        return NGL_ERROR_MEMORY;
+
+    const struct rnode *rnodes = ngli_darray_data(&ctx->rnode_pos->children);
+    for (int i = 0; i < o->nb_children; i++) {
+        keys[i].index = i;
+        keys[i].pass  = get_render_pass(o->children[i]);
+        keys[i].rnode = &rnodes[i];
+    }
+
+    const int nb_changes = count_pipeline_changes(keys, o->nb_children);
+
+    int start = 0;
+    while (start < o->nb_children) {
+        if (!keys[start].pass) {
+            start++;
+            continue;
+        }
+        int end = start + 1;
+        while (end < o->nb_children && keys[end].pass)
+            end++;
+        qsort(&keys[start], end - start, sizeof(*keys), cmp_draw_keys);
+        start = end;
+    }
+
+    LOG(DEBUG, "%s: %d pipeline changes between the draws of the children, %d once sorted",
+        node->label, nb_changes, count_pipeline_changes(keys, o->nb_children));
+
+    ngli_freep(&s->draw_order);
+    s->draw_order = ngli_calloc(o->nb_children, sizeof(*s->draw_order));
+    if (!s->draw_order) {
+        ngli_freep(&keys);
+        return NGL_ERROR_MEMORY;
+    }
+    for (int i = 0; i < o->nb_children; i++)
+        s->draw_order[i] = keys[i].index;
+
+    ngli_freep(&keys);
+    return 0;
+}
+
+const int *ngli_node_group_get_draw_order(const struct ngl_node *node)
+{
+    ngli_assert(node->cls->id == NGL_NODE_GROUP);
+    const struct group_priv *s = node->priv_data;
+    return s->draw_order;
+}
+
 static int group_prepare(struct ngl_node *node)
 {
     struct ngl_ctx *ctx = node->ctx;
@@ -55,6 +238,10 @@ static int group_prepare(struct ngl_node *node)
         if (ret < 0)
             goto done;
     }
+    ctx->rnode_pos = rnode_pos;
+
+    if (o->sort_draws)
+        ret = sort_draws(node);
 
 done:
     ctx->rnode_pos = rnode_pos;
@@ -64,25 +251,35 @@ done:
 static void group_draw(struct ngl_node *node)
 {
     struct ngl_ctx *ctx = node->ctx;
+    const struct group_priv *s = node->priv_data;
     const struct group_opts *o = node->opts;
 
     struct rnode *rnode_pos = ctx->rnode_pos;
     struct rnode *rnodes = ngli_darray_data(&rnode_pos->children);
     for (int i = 0; i < o->nb_children; i++) {
-        ctx->rnode_pos = &rnodes[i];
-        struct ngl_node *child = o->children[i];
+        const int index = s->draw_order ? s->draw_order[i] : i;
+        ctx->rnode_pos = &rnodes[index];
+        struct ngl_node *child = o->children[index];
         ngli_node_draw(child);
     }
     ctx->rnode_pos = rnode_pos;
 }
 
+static void group_uninit(struct ngl_node *node)
+{
+    struct group_priv *s = node->priv_data;
+    ngli_freep(&s->draw_order);
+}
+
 const struct node_class ngli_group_class = {
     .id        = NGL_NODE_GROUP,
     .name      = "Group",
     .prepare   = group_prepare,
     .update    = ngli_node_update_children,
     .draw      = group_draw,
+    .uninit    = group_uninit,
     .opts_size = sizeof(struct group_opts),
+    .priv_size = sizeof(struct group_priv),
     .params    = group_params,
     .file      = __FILE__,
 };
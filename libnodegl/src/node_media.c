@@ -272,6 +272,14 @@ static int media_prefetch(struct ngl_node *node)
 {
     struct media_priv *s = node->priv_data;
     sxplayer_start(s->player);
+
+    /*
+     * The prefetch runs in the background (see NGLI_NODE_FLAG_ASYNC_PREFETCH)
+     * so the first frame is decoded here as well. Its media time is 0 when
+     * the media is remapped from its initial seek, or when it starts along
+     * with the scene. Only its upload is left to the first update.
+     */
+    s->prefetched_frame = sxplayer_get_frame(s->player, 0);
     return 0;
 }
 
@@ -316,6 +324,16 @@ static int media_update(struct ngl_node *node, double t)
 
     TRACE("get frame from %s at t=%g", node->label, media_time);
     struct sxplayer_frame *frame = sxplayer_get_frame(s->player, media_time);
+
+    /* No frame is returned if it did not change since the prefetched one */
+    if (s->prefetched_frame) {
+        if (frame)
+            sxplayer_release_frame(s->prefetched_frame);
+        else
+            frame = s->prefetched_frame;
+        s->prefetched_frame = NULL;
+    }
+
     if (frame) {
         const char *pix_fmt_str = frame->pix_fmt >= 0 &&
                                   frame->pix_fmt < NGLI_ARRAY_NB(pix_fmt_names) ? pix_fmt_names[frame->pix_fmt]
@@ -343,6 +361,8 @@ static void media_release(struct ngl_node *node)
     struct media_priv *s = node->priv_data;
     sxplayer_release_frame(s->frame);
     s->frame = NULL;
+    sxplayer_release_frame(s->prefetched_frame);
+    s->prefetched_frame = NULL;
     sxplayer_stop(s->player);
 }
 
@@ -374,5 +394,7 @@ const struct node_class ngli_media_class = {
     .opts_size = sizeof(struct media_opts),
     .priv_size = sizeof(struct media_priv),
     .params    = media_params,
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT |
+                 NGLI_NODE_FLAG_ASYNC_PREFETCH,
     .file      = __FILE__,
 };
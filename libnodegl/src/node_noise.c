@@ -147,6 +147,8 @@ const struct node_class ngli_noise##type##_class = {                        \
     .priv_size = sizeof(struct noise_priv),                                 \
     .params    = noise_params,                                              \
     .params_id = "Noise",                                                   \
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT |                            \
+                 NGLI_NODE_FLAG_CPU_UPDATE,                                 \
     .file      = __FILE__,                                                  \
 };
 
@@ -216,7 +216,14 @@ static void render_uninit(struct ngl_node *node)
 static void render_draw(struct ngl_node *node)
 {
     struct render_priv *s = node->priv_data;
-    ngli_pass_exec(&s->pass);
+    ngli_ctx_defer_error(node->ctx, ngli_pass_exec(&s->pass));
+}
+
+struct pass *ngli_node_render_get_pass(struct ngl_node *node)
+{
+    ngli_assert(node->cls->id == NGL_NODE_RENDER);
+    struct render_priv *s = node->priv_data;
+    return &s->pass;
 }
 
 const struct node_class ngli_render_class = {
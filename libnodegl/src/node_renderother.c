@@ -91,7 +91,7 @@ struct render_common_opts {
 
 struct render_common {
     uint32_t helpers;
-    void (*draw)(struct render_common *s, struct pipeline_compat *pl_compat);
+    int (*draw)(struct render_common *s, struct pipeline_compat *pl_compat);
     struct filterschain *filterschain;
     char *combined_fragment;
     struct pgcraft_attribute position_attr;
@@ -347,17 +347,17 @@ static int combine_filters_code(struct render_common *s, const struct render_com
     return 0;
 }
 
-static void draw_simple(struct render_common *s, struct pipeline_compat *pl_compat)
+static int draw_simple(struct render_common *s, struct pipeline_compat *pl_compat)
 {
-    ngli_pipeline_compat_draw(pl_compat, s->nb_vertices, 1);
+    return ngli_pipeline_compat_draw(pl_compat, s->nb_vertices, 1);
 }
 
-static void draw_indexed(struct render_common *s, struct pipeline_compat *pl_compat)
+static int draw_indexed(struct render_common *s, struct pipeline_compat *pl_compat)
 {
-    ngli_pipeline_compat_draw_indexed(pl_compat,
-                                      s->geometry->indices_buffer,
-                                      s->geometry->indices_layout.format,
-                                      s->geometry->indices_layout.count, 1);
+    return ngli_pipeline_compat_draw_indexed(pl_compat,
+                                             s->geometry->indices_buffer,
+                                             s->geometry->indices_layout.format,
+                                             s->geometry->indices_layout.count, 1);
 }
 
 static int init(struct ngl_node *node,
@@ -815,7 +815,7 @@ static void renderother_draw(struct ngl_node *node, struct render_common *s, con
         ctx->render_pass_started = 1;
     }
 
-    s->draw(s, desc->pipeline_compat);
+    ngli_ctx_defer_error(ctx, s->draw(s, desc->pipeline_compat));
 }
 
 static void renderother_uninit(struct ngl_node *node, struct render_common *s)
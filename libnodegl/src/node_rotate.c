@@ -117,5 +117,6 @@ const struct node_class ngli_rotate_class = {
     .opts_size = sizeof(struct rotate_opts),
     .priv_size = sizeof(struct rotate_priv),
     .params    = rotate_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
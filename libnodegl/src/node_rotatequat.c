@@ -106,5 +106,6 @@ const struct node_class ngli_rotatequat_class = {
     .opts_size = sizeof(struct rotatequat_opts),
     .priv_size = sizeof(struct rotatequat_priv),
     .params    = rotatequat_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
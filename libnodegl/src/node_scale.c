@@ -106,5 +106,6 @@ const struct node_class ngli_scale_class = {
     .opts_size = sizeof(struct scale_opts),
     .priv_size = sizeof(struct scale_priv),
     .params    = scale_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
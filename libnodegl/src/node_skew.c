@@ -120,5 +120,6 @@ const struct node_class ngli_skew_class = {
     .opts_size = sizeof(struct skew_opts),
     .priv_size = sizeof(struct skew_priv),
     .params    = skew_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
@@ -216,6 +216,8 @@ const struct node_class ngli_streamed##class_suffix##_class = {             \
     .opts_size = sizeof(struct streamed_opts),                              \
     .priv_size = sizeof(struct streamed_priv),                              \
     .params    = streamed##class_suffix##_params,                           \
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT |                            \
+                 NGLI_NODE_FLAG_CPU_UPDATE,                                 \
     .file      = __FILE__,                                                  \
 };                                                                          \
 
@@ -722,7 +722,11 @@ static void text_draw(struct ngl_node *node)
     ngli_pipeline_compat_update_uniform(bg_desc->pipeline_compat, bg_desc->projection_matrix_index, projection_matrix);
     ngli_pipeline_compat_update_uniform(bg_desc->pipeline_compat, bg_desc->color_index, o->bg_color);
     ngli_pipeline_compat_update_uniform(bg_desc->pipeline_compat, bg_desc->opacity_index, &o->bg_opacity);
-    ngli_pipeline_compat_draw(bg_desc->pipeline_compat, 4, 1);
+    int ret = ngli_pipeline_compat_draw(bg_desc->pipeline_compat, 4, 1);
+    if (ret < 0) {
+        ngli_ctx_defer_error(ctx, ret);
+        return;
+    }
 
     if (s->nb_indices) {
         struct pipeline_subdesc *fg_desc = &desc->fg;
@@ -730,7 +734,8 @@ static void text_draw(struct ngl_node *node)
         ngli_pipeline_compat_update_uniform(fg_desc->pipeline_compat, fg_desc->projection_matrix_index, projection_matrix);
         ngli_pipeline_compat_update_uniform(fg_desc->pipeline_compat, fg_desc->color_index, o->fg_color);
         ngli_pipeline_compat_update_uniform(fg_desc->pipeline_compat, fg_desc->opacity_index, &o->fg_opacity);
-        ngli_pipeline_compat_draw_indexed(fg_desc->pipeline_compat, s->indices, NGLI_FORMAT_R16_UNORM, s->nb_indices, 1);
+        ret = ngli_pipeline_compat_draw_indexed(fg_desc->pipeline_compat, s->indices, NGLI_FORMAT_R16_UNORM, s->nb_indices, 1);
+        ngli_ctx_defer_error(ctx, ret);
     }
 }
 
@@ -56,5 +56,7 @@ const struct node_class ngli_time_class = {
     .init      = time_init,
     .update    = time_update,
     .priv_size = sizeof(struct time_priv),
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT |
+                 NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
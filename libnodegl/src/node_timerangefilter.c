@@ -195,6 +195,27 @@ static int timerangefilter_visit(struct ngl_node *node, int is_active, double t)
     return ngli_node_visit(child, is_active, t);
 }
 
+int ngli_node_timerangefilter_add_boundaries(struct ngl_node *node, struct darray *boundaries)
+{
+    const struct timerangefilter_opts *o = node->opts;
+
+    for (int i = 0; i < o->nb_ranges; i++) {
+        const struct timerangemode_opts *rr = o->ranges[i]->opts;
+        if (!ngli_darray_push(boundaries, &rr->start_time))
+            return NGL_ERROR_MEMORY;
+
+        /* See the activity anticipation of the noop ranges in timerangefilter_visit() */
+        if (i > 0 && o->ranges[i - 1]->cls->id == NGL_NODE_TIMERANGEMODENOOP) {
+            const double prefetch_start = rr->start_time - o->prefetch_time;
+            const double idle_start = rr->start_time - o->max_idle_time;
+            if (!ngli_darray_push(boundaries, &prefetch_start) ||
+                !ngli_darray_push(boundaries, &idle_start))
+                return NGL_ERROR_MEMORY;
+        }
+    }
+    return 0;
+}
+
 static int timerangefilter_update(struct ngl_node *node, double t)
 {
     struct timerangefilter_priv *s = node->priv_data;
@@ -247,5 +268,6 @@ const struct node_class ngli_timerangefilter_class = {
     .opts_size = sizeof(struct timerangefilter_opts),
     .priv_size = sizeof(struct timerangefilter_priv),
     .params    = timerangefilter_params,
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT,
     .file      = __FILE__,
 };
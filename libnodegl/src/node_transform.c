@@ -81,5 +81,6 @@ const struct node_class ngli_transform_class = {
     .opts_size = sizeof(struct transform_opts),
     .priv_size = sizeof(struct transform_priv),
     .params    = transform_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
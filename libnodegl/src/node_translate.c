@@ -96,5 +96,6 @@ const struct node_class ngli_translate_class = {
     .opts_size = sizeof(struct translate_opts),
     .priv_size = sizeof(struct translate_priv),
     .params    = translate_params,
+    .flags     = NGLI_NODE_FLAG_CPU_UPDATE,
     .file      = __FILE__,
 };
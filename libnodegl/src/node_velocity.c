@@ -206,6 +206,8 @@ const struct node_class ngli_velocity##type##_class = {
     .opts_size = sizeof(struct velocity_opts),                                  \
     .priv_size = sizeof(struct velocity_priv),                                  \
     .params    = velocity##type##_params,                                       \
+    .flags     = NGLI_NODE_FLAG_TIME_DEPENDENT |                                \
+                 NGLI_NODE_FLAG_CPU_UPDATE,                                     \
     .file      = __FILE__,                                                      \
 };
 
@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "hmap.h"
 #include "log.h"
 #include "nodegl.h"
@@ -38,7 +39,8 @@ enum {
     STATE_INIT_FAILED   = -1,
     STATE_UNINITIALIZED = 0, /* post uninit(), default */
     STATE_INITIALIZED   = 1, /* post init() or release() */
-    STATE_READY         = 2, /* post prefetch() */
+    STATE_PREFETCHING   = 2, /* prefetch() queued in the background */
+    STATE_READY         = 3, /* post prefetch() */
 };
 
 /* We depend on the monotonically incrementing by 1 property of these fields */
@@ -63,16 +65,19 @@ static void *aligned_allocz(size_t size)
     return ptr;
 }
 
-static struct ngl_node *node_create(const struct node_class *cls)
+static struct ngl_node *node_create(const struct node_class *cls, struct arena *arena)
 {
     struct ngl_node *node;
     const size_t node_size = NGLI_ALIGN(sizeof(*node), NGLI_ALIGN_VAL);
     const size_t opts_size = NGLI_ALIGN(cls->opts_size, NGLI_ALIGN_VAL);
     const size_t priv_size = NGLI_ALIGN(cls->priv_size, NGLI_ALIGN_VAL);
+    const size_t size = node_size + opts_size + priv_size;
 
-    node = aligned_allocz(node_size + opts_size + priv_size);
+    node = arena ? ngli_arena_alloc(arena, size) : aligned_allocz(size);
     if (!node)
         return NULL;
+    if (arena)
+        node->arena = ngli_arena_ref(arena);
     node->opts = ((uint8_t *)node) + node_size;
     node->priv_data = ((uint8_t *)node->opts) + opts_size;
 
@@ -130,7 +135,7 @@ static const struct node_class *get_node_class(int type)
     return NULL;
 }
 
-struct ngl_node *ngl_node_create(int type)
+static struct ngl_node *create_node(int type, struct arena *arena)
 {
     const struct node_class *cls = get_node_class(type);
     if (!cls) {
@@ -138,7 +143,7 @@ struct ngl_node *ngl_node_create(int type)
         return NULL;
     }
 
-    struct ngl_node *node = node_create(cls);
+    struct ngl_node *node = node_create(cls, arena);
     if (!node)
         return NULL;
 
@@ -159,8 +164,66 @@ struct ngl_node *ngl_node_create(int type)
     return node;
 }
 
+struct ngl_node *ngl_node_create(int type)
+{
+    return create_node(type, NULL);
+}
+
+struct ngl_scene_arena {
+    struct arena *arena;
+};
+
+#define SCENE_ARENA_BLOCK_SIZE (256 * 1024)
+
+struct ngl_scene_arena *ngl_scene_arena_create(void)
+{
+    struct ngl_scene_arena *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    s->arena = ngli_arena_create();
+    if (!s->arena || ngli_arena_init(s->arena, SCENE_ARENA_BLOCK_SIZE) < 0) {
+        ngl_scene_arena_freep(&s);
+        return NULL;
+    }
+    return s;
+}
+
+struct ngl_node *ngl_scene_arena_create_node(struct ngl_scene_arena *s, int type)
+{
+    return create_node(type, s->arena);
+}
+
+void ngl_scene_arena_freep(struct ngl_scene_arena **sp)
+{
+    struct ngl_scene_arena *s = *sp;
+    if (!s)
+        return;
+    ngli_arena_unrefp(&s->arena);
+    ngli_freep(sp);
+}
+
+/*
+ * The time invariant ancestors of a node must be updated again when the node
+ * is released or invalidated since they skip the update of their children
+ * while up-to-date.
+ */
+static void node_clear_up_to_date(struct ngl_node *node)
+{
+    node->is_up_to_date = 0;
+    struct ngl_node **parents = ngli_darray_data(&node->parents);
+    for (int i = 0; i < ngli_darray_count(&node->parents); i++) {
+        struct ngl_node *parent = parents[i];
+        if (parent->is_up_to_date)
+            node_clear_up_to_date(parent);
+    }
+}
+
+static int node_wait_prefetch(struct ngl_node *node);
+
 static void node_release(struct ngl_node *node)
 {
+    if (node->state == STATE_PREFETCHING)
+        node_wait_prefetch(node);
     if (node->state != STATE_READY)
         return;
 
@@ -171,6 +234,7 @@ static void node_release(struct ngl_node *node)
     }
     node->state = STATE_INITIALIZED;
     node->last_update_time = -1.;
+    node_clear_up_to_date(node);
 }
 
 static void node_uninit(struct ngl_node *node)
@@ -308,6 +372,13 @@ static int node_init(struct ngl_node *node)
         return ret;
     }
 
+    /* The children are initialized first, so their time dependency is known */
+    node->is_time_dependent = !!(node->cls->flags & NGLI_NODE_FLAG_TIME_DEPENDENT);
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++)
+        node->is_time_dependent |= children[i]->is_time_dependent;
+    node->is_up_to_date = 0;
+
     if (node->cls->prefetch)
         node->state = STATE_INITIALIZED;
     else
@@ -572,10 +643,12 @@ int ngli_node_attach_ctx(struct ngl_node *node, struct ngl_ctx *ctx)
         return ret;
 
     ret = ngli_node_prepare(node);
-    if (ret < 0)
+    if (ret < 0) {
+        ngli_darray_clear(&ctx->pending_passes);
         return ret;
+    }
 
-    return ret;
+    return 0;
 }
 
 void ngli_node_detach_ctx(struct ngl_node *node, struct ngl_ctx *ctx)
@@ -674,21 +747,54 @@ int ngli_node_visit(struct ngl_node *node, int is_active, double t)
     return 0;
 }
 
+static void node_prefetch_failed(struct ngl_node *node, int ret)
+{
+    LOG(ERROR, "prefetching node %s failed: %s", node->label, NGLI_RET_STR(ret));
+    node->visit_time = -1.;
+    if (node->cls->release) {
+        LOG(VERBOSE, "RELEASE %s @ %p", node->label, node);
+        node->cls->release(node);
+    }
+}
+
+static int prefetch_work(void *user_arg)
+{
+    struct ngl_node *node = user_arg;
+    TRACE("PREFETCH %s @ %p in the background", node->label, node);
+    return node->cls->prefetch(node);
+}
+
+static int node_wait_prefetch(struct ngl_node *node)
+{
+    ngli_assert(node->state == STATE_PREFETCHING);
+    int ret = ngli_workqueue_wait(node->ctx->prefetch_queue, &node->prefetch_work);
+    if (ret < 0) {
+        node_prefetch_failed(node, ret);
+        node->state = STATE_INITIALIZED;
+        return ret;
+    }
+    node->state = STATE_READY;
+    return 0;
+}
+
 static int node_prefetch(struct ngl_node *node)
 {
-    if (node->state == STATE_READY)
+    if (node->state == STATE_READY || node->state == STATE_PREFETCHING)
+        return 0;
+
+    if (node->cls->prefetch && (node->cls->flags & NGLI_NODE_FLAG_ASYNC_PREFETCH)) {
+        int ret = ngli_workqueue_push(node->ctx->prefetch_queue, &node->prefetch_work, prefetch_work, node);
+        if (ret < 0)
+            return ret;
+        node->state = STATE_PREFETCHING;
         return 0;
+    }
 
     if (node->cls->prefetch) {
         TRACE("PREFETCH %s @ %p", node->label, node);
         int ret = node->cls->prefetch(node);
         if (ret < 0) {
-            LOG(ERROR, "prefetching node %s failed: %s", node->label, NGLI_RET_STR(ret));
-            node->visit_time = -1.;
-            if (node->cls->release) {
-                LOG(VERBOSE, "RELEASE %s @ %p", node->label, node);
-                node->cls->release(node);
-            }
+            node_prefetch_failed(node, ret);
             return ret;
         }
     }
@@ -699,12 +805,22 @@ static int node_prefetch(struct ngl_node *node)
 
 int ngli_node_honor_release_prefetch(struct ngl_node *scene, double t)
 {
-    /* Build a new list of activity checks nodes */
-    struct darray *nodes_array = &scene->ctx->activitycheck_nodes;
-    ngli_darray_clear(nodes_array);
-    int ret = ngli_node_visit(scene, 1, t);
-    if (ret < 0)
-        return ret;
+    struct ngl_ctx *ctx = scene->ctx;
+    struct darray *nodes_array = &ctx->activitycheck_nodes;
+
+    /*
+     * Build a new list of activity checks nodes, unless the activity of the
+     * nodes can not have changed since the previous visit, in which case its
+     * list is reused as is.
+     */
+    if (ngli_plan_needs_visit(&ctx->plan, t)) {
+        ngli_darray_clear(nodes_array);
+        int ret = ngli_node_visit(scene, 1, t);
+        if (ret < 0) {
+            ngli_plan_invalidate_activity(&ctx->plan);
+            return ret;
+        }
+    }
 
     struct ngl_node **nodes = ngli_darray_data(nodes_array);
 
@@ -720,24 +836,49 @@ int ngli_node_honor_release_prefetch(struct ngl_node *scene, double t)
         struct ngl_node *node = nodes[i];
         if (node->is_active) {
             int ret = node_prefetch(node);
-            if (ret < 0)
+            if (ret < 0) {
+                ngli_plan_invalidate_activity(&ctx->plan);
                 return ret;
+            }
         }
     }
 
     return 0;
 }
 
+/*
+ * The variables are only written by their update and their live changes: bump
+ * their version so that their users can skip uploading unchanged data.
+ */
+static void bump_variable_version(struct ngl_node *node)
+{
+    if (node->cls->category != NGLI_NODE_CATEGORY_VARIABLE)
+        return;
+    struct variable_info *var = node->priv_data;
+    var->version++;
+}
+
 int ngli_node_update(struct ngl_node *node, double t)
 {
+    if (node->state == STATE_PREFETCHING) {
+        int ret = node_wait_prefetch(node);
+        if (ret < 0)
+            return ret;
+    }
     ngli_assert(node->state == STATE_READY);
     if (node->cls->update) {
         if (node->last_update_time != t) {
-            TRACE("UPDATE %s @ %p with t=%g", node->label, node, t);
-            int ret = node->cls->update(node, t);
-            if (ret < 0) {
-                LOG(ERROR, "updating node %s failed: %s", node->label, NGLI_RET_STR(ret));
-                return ret;
+            if (node->is_up_to_date) {
+                TRACE("%s is time invariant and up-to-date, skip it", node->label);
+            } else {
+                TRACE("UPDATE %s @ %p with t=%g", node->label, node, t);
+                int ret = node->cls->update(node, t);
+                if (ret < 0) {
+                    LOG(ERROR, "updating node %s failed: %s", node->label, NGLI_RET_STR(ret));
+                    return ret;
+                }
+                node->is_up_to_date = !node->is_time_dependent;
+                bump_variable_version(node);
             }
             node->last_update_time = t;
             node->draw_count = 0;
@@ -749,6 +890,19 @@ int ngli_node_update(struct ngl_node *node, double t)
     return 0;
 }
 
+int ngli_node_mark_updated(struct ngl_node *node, double t)
+{
+    ngli_assert(node->state == STATE_READY);
+    ngli_assert(node->cls->update == ngli_node_update_children);
+    if (node->last_update_time == t)
+        return 0;
+    const int skip_children = node->is_up_to_date;
+    node->last_update_time = t;
+    node->draw_count = 0;
+    node->is_up_to_date = !node->is_time_dependent;
+    return skip_children;
+}
+
 int ngli_node_update_children(struct ngl_node *node, double t)
 {
     struct ngl_node **children = ngli_darray_data(&node->children);
@@ -794,6 +948,8 @@ const struct node_param *ngli_node_param_find(const struct ngl_node *node, const
     return par;
 }
 
+static void flush_live_changes(struct ngl_ctx *ctx);
+
 static int param_add(struct ngl_node *node, const char *key, int nb_elems, void *elems)
 {
     int ret = 0;
@@ -808,14 +964,22 @@ static int param_add(struct ngl_node *node, const char *key, int nb_elems, void
         return NGL_ERROR_INVALID_USAGE;
     }
 
+    if (node->ctx)
+        flush_live_changes(node->ctx);
+
     ret = ngli_params_add(base_ptr, par, nb_elems, elems);
     if (ret < 0) {
         LOG(ERROR, "unable to add elements to %s.%s", node->label, key);
         return ret;
     }
 
-    if (node->ctx && par->update_func)
+    if (node->ctx && par->update_func) {
         ret = par->update_func(node);
+        bump_variable_version(node);
+    }
+
+    if (node->ctx)
+        ngli_plan_invalidate_activity(&node->ctx->plan);
 
     return ret;
 }
@@ -832,9 +996,24 @@ int ngl_node_param_add_f64s(struct ngl_node *node, const char *key,
     return param_add(node, key, nb_f64s, f64s);
 }
 
-static int node_invalidate_branch(struct ngl_node *node)
+/*
+ * If invalidated is not NULL, it records the nodes already invalidated by the
+ * current pass (together with all their ancestors), which are then skipped.
+ */
+static int node_invalidate_branch(struct hmap *invalidated, struct ngl_node *node)
 {
+    if (invalidated) {
+        char key[32];
+        snprintf(key, sizeof(key), "%p", (void *)node);
+        if (ngli_hmap_get(invalidated, key))
+            return 0;
+        int ret = ngli_hmap_set(invalidated, key, node);
+        if (ret < 0)
+            return ret;
+    }
+
     node->last_update_time = -1;
+    node->is_up_to_date = 0;
     if (node->cls->invalidate) {
         int ret = node->cls->invalidate(node);
         if (ret < 0)
@@ -842,7 +1021,7 @@ static int node_invalidate_branch(struct ngl_node *node)
     }
     struct ngl_node **parents = ngli_darray_data(&node->parents);
     for (int i = 0; i < ngli_darray_count(&node->parents); i++) {
-        int ret = node_invalidate_branch(parents[i]);
+        int ret = node_invalidate_branch(invalidated, parents[i]);
         if (ret < 0)
             return ret;
     }
@@ -871,7 +1050,12 @@ static int node_param_is_value_allowed(struct ngl_node *node, const char *key,
     return 0;
 }
 
-static int node_param_update(struct ngl_node *node, const struct node_param *par)
+/*
+ * If changed is not NULL, the node is recorded in it to be invalidated later
+ * along with the other changed nodes, instead of being invalidated right away.
+ */
+static int node_param_update(struct ngl_node *node, const struct node_param *par,
+                             struct darray *changed)
 {
     if (!node->ctx)
         return 0;
@@ -880,28 +1064,300 @@ static int node_param_update(struct ngl_node *node, const struct node_param *par
         int ret = par->update_func(node);
         if (ret < 0)
             return ret;
+        bump_variable_version(node);
     }
 
-    return node_invalidate_branch(node);
+    /* The node may filter the activity of its children (user switch, ...) */
+    if (node->cls->visit)
+        ngli_plan_invalidate_activity(&node->ctx->plan);
+
+    if (changed && ngli_darray_push(changed, &node))
+        return 0;
+
+    return node_invalidate_branch(NULL, node);
 }
 
-#define FORWARD_TO_PARAM(type, ...)                                     \
+static int apply_live_change(const struct live_change *change, struct darray *changed)
+{
+    const struct node_param *par = change->par;
+    uint8_t *dst = change->dst;
+    const int *i = change->value.i;
+    const unsigned *u = change->value.u;
+    const float *f = change->value.f;
+
+    int ret;
+    switch (par->type) {
+    case NGLI_PARAM_TYPE_BOOL:     ret = ngli_params_set_bool(dst, par, i[0]);                  break;
+    case NGLI_PARAM_TYPE_I32:      ret = ngli_params_set_i32(dst, par, i[0]);                   break;
+    case NGLI_PARAM_TYPE_IVEC2:    ret = ngli_params_set_ivec2(dst, par, i);                    break;
+    case NGLI_PARAM_TYPE_IVEC3:    ret = ngli_params_set_ivec3(dst, par, i);                    break;
+    case NGLI_PARAM_TYPE_IVEC4:    ret = ngli_params_set_ivec4(dst, par, i);                    break;
+    case NGLI_PARAM_TYPE_U32:      ret = ngli_params_set_u32(dst, par, u[0]);                   break;
+    case NGLI_PARAM_TYPE_UVEC2:    ret = ngli_params_set_uvec2(dst, par, u);                    break;
+    case NGLI_PARAM_TYPE_UVEC3:    ret = ngli_params_set_uvec3(dst, par, u);                    break;
+    case NGLI_PARAM_TYPE_UVEC4:    ret = ngli_params_set_uvec4(dst, par, u);                    break;
+    case NGLI_PARAM_TYPE_F32:      ret = ngli_params_set_f32(dst, par, f[0]);                   break;
+    case NGLI_PARAM_TYPE_VEC2:     ret = ngli_params_set_vec2(dst, par, f);                     break;
+    case NGLI_PARAM_TYPE_VEC3:     ret = ngli_params_set_vec3(dst, par, f);                     break;
+    case NGLI_PARAM_TYPE_VEC4:     ret = ngli_params_set_vec4(dst, par, f);                     break;
+    case NGLI_PARAM_TYPE_MAT4:     ret = ngli_params_set_mat4(dst, par, f);                     break;
+    case NGLI_PARAM_TYPE_F64:      ret = ngli_params_set_f64(dst, par, change->value.d);        break;
+    case NGLI_PARAM_TYPE_RATIONAL: ret = ngli_params_set_rational(dst, par, i[0], i[1]);        break;
+    case NGLI_PARAM_TYPE_STR:
+        ret = ngli_params_set_str(dst, par, change->value.s);
+        ngli_free(change->value.s);
+        break;
+    default:
+        ngli_assert(0);
+    }
+    if (ret < 0)
+        return ret;
+
+    return node_param_update(change->node, par, changed);
+}
+
+static int is_same_live_change(const void *queued_cmd, const void *cmd)
+{
+    const struct live_change *a = queued_cmd;
+    const struct live_change *b = cmd;
+    return a->node == b->node && a->par == b->par;
+}
+
+static int queue_param_change(struct ngl_node *node, const struct node_param *par, uint8_t *base_ptr,
+                              const struct live_change *change)
+{
+    const char *key = par->key;
+    uint8_t *dst = base_ptr + par->offset;
+    int ret = node_param_is_value_allowed(node, key, dst, par);
+    if (ret < 0)
+        return ret;
+
+    const int type = par->type;
+    struct live_change queued = *change;
+    queued.node = node;
+    queued.par = par;
+    queued.dst = dst;
+    if (type == NGLI_PARAM_TYPE_STR && change->value.s) {
+        queued.value.s = ngli_strdup(change->value.s);
+        if (!queued.value.s)
+            return NGL_ERROR_MEMORY;
+    }
+
+    /* A pending change of the same parameter is superseded by this one */
+    struct live_change old;
+    ret = ngli_cmdqueue_replace_or_push(node->ctx->live_changes, &queued, is_same_live_change, &old);
+    if (ret == 1) {
+        if (type == NGLI_PARAM_TYPE_STR)
+            ngli_free(old.value.s);
+        return 0;
+    }
+
+    /*
+     * The queue is full of changes to distinct parameters: fall back on the
+     * synchronous path, after the pending changes to preserve their order.
+     */
+    if (ret == NGL_ERROR_LIMIT_EXCEEDED) {
+        LOG(DEBUG, "live changes queue is full, applying %s.%s synchronously", node->label, key);
+        flush_live_changes(node->ctx);
+        return apply_live_change(&queued, NULL);
+    }
+
+    return ret;
+}
+
+static int queue_live_change(const struct ngl_param_handle *handle, int type, const struct live_change *change)
+{
+    struct ngl_node *node = handle->node;
+    const struct node_param *par = handle->par;
+    if (par->type != type) {
+        LOG(ERROR, "invalid type for live change of %s.%s", node->label, par->key);
+        return NGL_ERROR_INVALID_ARG;
+    }
+
+    return queue_param_change(node, par, handle->base_ptr, change);
+}
+
+int ngli_node_apply_live_changes(struct ngl_ctx *ctx)
+{
+    struct live_change change;
+    if (!ngli_cmdqueue_pop(ctx->live_changes, &change))
+        return 0;
+
+    /*
+     * The callers of ngl_node_param_set_*() already got their return value,
+     * so a failing change is dropped and the remaining ones are still
+     * applied. The first error is returned to be reported by the next draw.
+     */
+    int first_ret = 0;
+    struct darray changed;
+    ngli_darray_init(&changed, sizeof(struct ngl_node *), 0);
+    do {
+        int ret = apply_live_change(&change, &changed);
+        if (ret < 0) {
+            LOG(ERROR, "live change of %s.%s failed and has been dropped: %s",
+                change.node->label, change.par->key, NGLI_RET_STR(ret));
+            if (first_ret >= 0)
+                first_ret = ret;
+        }
+    } while (ngli_cmdqueue_pop(ctx->live_changes, &change));
+
+    /*
+     * Once every change is applied, the changed nodes are invalidated in a
+     * single pass where their shared ancestors are only visited once. Without
+     * this index, each changed node walks up its whole branch.
+     */
+    struct hmap *invalidated = ngli_hmap_create();
+    if (!invalidated)
+        LOG(WARNING, "unable to allocate the invalidation index, falling back on per node invalidations");
+
+    struct ngl_node **nodes = ngli_darray_data(&changed);
+    for (int i = 0; i < ngli_darray_count(&changed); i++) {
+        int ret = node_invalidate_branch(invalidated, nodes[i]);
+        if (ret < 0) {
+            LOG(ERROR, "invalidation of %s failed: %s", nodes[i]->label, NGLI_RET_STR(ret));
+            if (first_ret >= 0)
+                first_ret = ret;
+        }
+    }
+
+    ngli_hmap_freep(&invalidated);
+    ngli_darray_reset(&changed);
+    return first_ret;
+}
+
+/*
+ * Apply the pending live changes before a synchronous change, once the scene
+ * is not used by an asynchronous draw anymore
+ */
+static void flush_live_changes(struct ngl_ctx *ctx)
+{
+    ngli_ctx_wait_async_cmd(ctx);
+    ngli_ctx_defer_error(ctx, ngli_node_apply_live_changes(ctx));
+}
+
+/* The value parameter points to livectl.val, see NGLI_NODE_FLAG_LIVECTL */
+static const struct node_param *get_livectl_param(const struct ngl_node *node)
+{
+    const size_t val_offset = node->cls->livectl_offset + offsetof(struct livectl, val);
+    const struct node_param *par = node->cls->params;
+    for (; par && par->key; par++)
+        if (par->offset == val_offset && (par->flags & NGLI_PARAM_FLAG_ALLOW_LIVE_CHANGE))
+            return par;
+    return NULL;
+}
+
+int ngli_node_livectls_apply(int nb_livectls, const struct ngl_livectl *livectls)
+{
+    for (int i = 0; i < nb_livectls; i++) {
+        const struct ngl_livectl *ctl = &livectls[i];
+        struct ngl_node *node = ctl->node;
+
+        const struct node_param *par = NULL;
+        if (node && (node->cls->flags & NGLI_NODE_FLAG_LIVECTL))
+            par = get_livectl_param(node);
+        if (!par) {
+            LOG(ERROR, "live control %d is not associated with a live control node", i);
+            return NGL_ERROR_INVALID_ARG;
+        }
+
+        struct live_change change = {.node = node, .par = par};
+        if (par->type == NGLI_PARAM_TYPE_STR)
+            change.value.s = ctl->val.s;
+        else
+            memcpy(&change.value, &ctl->val, NGLI_MIN(sizeof(change.value), sizeof(ctl->val)));
+
+        /*
+         * All the changes of the nodes attached to a context are queued
+         * together, so they are applied by the same draw with a single
+         * invalidation pass.
+         */
+        uint8_t *base_ptr = node->opts;
+        int ret;
+        if (node->ctx) {
+            ret = queue_param_change(node, par, base_ptr, &change);
+        } else {
+            change.dst = base_ptr + par->offset;
+            if (par->type == NGLI_PARAM_TYPE_STR)
+                ret = ngli_params_set_str(change.dst, par, change.value.s);
+            else
+                ret = apply_live_change(&change, NULL);
+        }
+        if (ret < 0) {
+            LOG(ERROR, "unable to apply live control %s", node->label);
+            return ret;
+        }
+    }
+    return 0;
+}
+
+int ngl_node_param_get_handle(struct ngl_node *node, const char *key, struct ngl_param_handle *handle)
+{
+    uint8_t *base_ptr;
+    const struct node_param *par = ngli_node_param_find(node, key, &base_ptr);
+    if (!par)
+        return NGL_ERROR_NOT_FOUND;
+
+    *handle = (struct ngl_param_handle){
+        .node     = node,
+        .par      = par,
+        .base_ptr = base_ptr,
+    };
+    return 0;
+}
+
+/*
+ * The live changes of the nodes attached to a context are only queued, and
+ * applied by the next update of the scene (or when the scene is detached)
+ */
+#define QUEUE_LIVE_CHANGE(type, field, src, size)                       \
+    if (handle->node->ctx) {                                            \
+        struct live_change change;                                      \
+        memcpy(&change.value.field, src, size);                         \
+        return queue_live_change(handle, NGLI_PARAM_TYPE_##type, &change); \
+    }
+
+#define SET_PARAM(type, ...)                                            \
     int ret;                                                            \
+    uint8_t *dst = base_ptr + par->offset;                              \
+    if ((ret = node_param_is_value_allowed(node, par->key, dst, par)) < 0) \
+        return ret;                                                     \
+    if (node->ctx)                                                      \
+        flush_live_changes(node->ctx);                                  \
+    if ((ret = ngli_params_set_##type(dst, par, __VA_ARGS__)) < 0 ||    \
+        (ret = node_param_update(node, par, NULL)) < 0)                 \
+        return ret;                                                     \
+    return 0
+
+#define FORWARD_TO_PARAM(type, ...)                                     \
     uint8_t *base_ptr;                                                  \
     const struct node_param *par =                                      \
         ngli_node_param_find(node, key, &base_ptr);                     \
     if (!par)                                                           \
         return NGL_ERROR_NOT_FOUND;                                     \
-    uint8_t *dst = base_ptr + par->offset;                              \
-    if ((ret = node_param_is_value_allowed(node, key, dst, par)) < 0 || \
-        (ret = ngli_params_set_##type(dst, par, __VA_ARGS__)) < 0 ||    \
-        (ret = node_param_update(node, par)) < 0)                       \
+    SET_PARAM(type, __VA_ARGS__)
+
+#define FORWARD_TO_HANDLE_PARAM(type, ...)                              \
+    struct ngl_node *node = handle->node;                               \
+    const struct node_param *par = handle->par;                         \
+    uint8_t *base_ptr = handle->base_ptr;                               \
+    SET_PARAM(type, __VA_ARGS__)
+
+#define FORWARD_TO_HANDLE(type, ...)                                    \
+    struct ngl_param_handle handle;                                     \
+    int ret = ngl_node_param_get_handle(node, key, &handle);            \
+    if (ret < 0)                                                        \
         return ret;                                                     \
-    return 0
+    return ngl_node_param_set_##type##_h(&handle, __VA_ARGS__)
 
 int ngl_node_param_set_bool(struct ngl_node *node, const char *key, int value)
 {
-    FORWARD_TO_PARAM(bool, value);
+    FORWARD_TO_HANDLE(bool, value);
+}
+
+int ngl_node_param_set_bool_h(const struct ngl_param_handle *handle, int value)
+{
+    QUEUE_LIVE_CHANGE(BOOL, i, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(bool, value);
 }
 
 int ngl_node_param_set_data(struct ngl_node *node, const char *key, int size, const void *data)
@@ -911,12 +1367,24 @@ int ngl_node_param_set_data(struct ngl_node *node, const char *key, int size, co
 
 int ngl_node_param_set_f32(struct ngl_node *node, const char *key, float value)
 {
-    FORWARD_TO_PARAM(f32, value);
+    FORWARD_TO_HANDLE(f32, value);
+}
+
+int ngl_node_param_set_f32_h(const struct ngl_param_handle *handle, float value)
+{
+    QUEUE_LIVE_CHANGE(F32, f, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(f32, value);
 }
 
 int ngl_node_param_set_f64(struct ngl_node *node, const char *key, double value)
 {
-    FORWARD_TO_PARAM(f64, value);
+    FORWARD_TO_HANDLE(f64, value);
+}
+
+int ngl_node_param_set_f64_h(const struct ngl_param_handle *handle, double value)
+{
+    QUEUE_LIVE_CHANGE(F64, d, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(f64, value);
 }
 
 int ngl_node_param_set_flags(struct ngl_node *node, const char *key, const char *value)
@@ -926,27 +1394,57 @@ int ngl_node_param_set_flags(struct ngl_node *node, const char *key, const char
 
 int ngl_node_param_set_i32(struct ngl_node *node, const char *key, int value)
 {
-    FORWARD_TO_PARAM(i32, value);
+    FORWARD_TO_HANDLE(i32, value);
+}
+
+int ngl_node_param_set_i32_h(const struct ngl_param_handle *handle, int value)
+{
+    QUEUE_LIVE_CHANGE(I32, i, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(i32, value);
 }
 
 int ngl_node_param_set_ivec2(struct ngl_node *node, const char *key, const int *value)
 {
-    FORWARD_TO_PARAM(ivec2, value);
+    FORWARD_TO_HANDLE(ivec2, value);
+}
+
+int ngl_node_param_set_ivec2_h(const struct ngl_param_handle *handle, const int *value)
+{
+    QUEUE_LIVE_CHANGE(IVEC2, i, value, 2 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(ivec2, value);
 }
 
 int ngl_node_param_set_ivec3(struct ngl_node *node, const char *key, const int *value)
 {
-    FORWARD_TO_PARAM(ivec3, value);
+    FORWARD_TO_HANDLE(ivec3, value);
+}
+
+int ngl_node_param_set_ivec3_h(const struct ngl_param_handle *handle, const int *value)
+{
+    QUEUE_LIVE_CHANGE(IVEC3, i, value, 3 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(ivec3, value);
 }
 
 int ngl_node_param_set_ivec4(struct ngl_node *node, const char *key, const int *value)
 {
-    FORWARD_TO_PARAM(ivec4, value);
+    FORWARD_TO_HANDLE(ivec4, value);
+}
+
+int ngl_node_param_set_ivec4_h(const struct ngl_param_handle *handle, const int *value)
+{
+    QUEUE_LIVE_CHANGE(IVEC4, i, value, 4 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(ivec4, value);
 }
 
 int ngl_node_param_set_mat4(struct ngl_node *node, const char *key, const float *value)
 {
-    FORWARD_TO_PARAM(mat4, value);
+    FORWARD_TO_HANDLE(mat4, value);
+}
+
+int ngl_node_param_set_mat4_h(const struct ngl_param_handle *handle, const float *value)
+{
+    QUEUE_LIVE_CHANGE(MAT4, f, value, 16 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(mat4, value);
 }
 
 int ngl_node_param_set_node(struct ngl_node *node, const char *key, struct ngl_node *value)
@@ -960,7 +1458,14 @@ int ngl_node_param_set_node(struct ngl_node *node, const char *key, struct ngl_n
 
 int ngl_node_param_set_rational(struct ngl_node *node, const char *key, int num, int den)
 {
-    FORWARD_TO_PARAM(rational, num, den);
+    FORWARD_TO_HANDLE(rational, num, den);
+}
+
+int ngl_node_param_set_rational_h(const struct ngl_param_handle *handle, int num, int den)
+{
+    const int rational[] = {num, den};
+    QUEUE_LIVE_CHANGE(RATIONAL, i, rational, sizeof(rational));
+    FORWARD_TO_HANDLE_PARAM(rational, num, den);
 }
 
 int ngl_node_param_set_select(struct ngl_node *node, const char *key, const char *value)
@@ -970,42 +1475,90 @@ int ngl_node_param_set_select(struct ngl_node *node, const char *key, const char
 
 int ngl_node_param_set_str(struct ngl_node *node, const char *key, const char *value)
 {
-    FORWARD_TO_PARAM(str, value);
+    FORWARD_TO_HANDLE(str, value);
+}
+
+int ngl_node_param_set_str_h(const struct ngl_param_handle *handle, const char *value)
+{
+    QUEUE_LIVE_CHANGE(STR, s, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(str, value);
 }
 
 int ngl_node_param_set_u32(struct ngl_node *node, const char *key, const unsigned value)
 {
-    FORWARD_TO_PARAM(u32, value);
+    FORWARD_TO_HANDLE(u32, value);
+}
+
+int ngl_node_param_set_u32_h(const struct ngl_param_handle *handle, const unsigned value)
+{
+    QUEUE_LIVE_CHANGE(U32, u, &value, sizeof(value));
+    FORWARD_TO_HANDLE_PARAM(u32, value);
 }
 
 int ngl_node_param_set_uvec2(struct ngl_node *node, const char *key, const unsigned *value)
 {
-    FORWARD_TO_PARAM(uvec2, value);
+    FORWARD_TO_HANDLE(uvec2, value);
+}
+
+int ngl_node_param_set_uvec2_h(const struct ngl_param_handle *handle, const unsigned *value)
+{
+    QUEUE_LIVE_CHANGE(UVEC2, u, value, 2 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(uvec2, value);
 }
 
 int ngl_node_param_set_uvec3(struct ngl_node *node, const char *key, const unsigned *value)
 {
-    FORWARD_TO_PARAM(uvec3, value);
+    FORWARD_TO_HANDLE(uvec3, value);
+}
+
+int ngl_node_param_set_uvec3_h(const struct ngl_param_handle *handle, const unsigned *value)
+{
+    QUEUE_LIVE_CHANGE(UVEC3, u, value, 3 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(uvec3, value);
 }
 
 int ngl_node_param_set_uvec4(struct ngl_node *node, const char *key, const unsigned *value)
 {
-    FORWARD_TO_PARAM(uvec4, value);
+    FORWARD_TO_HANDLE(uvec4, value);
+}
+
+int ngl_node_param_set_uvec4_h(const struct ngl_param_handle *handle, const unsigned *value)
+{
+    QUEUE_LIVE_CHANGE(UVEC4, u, value, 4 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(uvec4, value);
 }
 
 int ngl_node_param_set_vec2(struct ngl_node *node, const char *key, const float *value)
 {
-    FORWARD_TO_PARAM(vec2, value);
+    FORWARD_TO_HANDLE(vec2, value);
+}
+
+int ngl_node_param_set_vec2_h(const struct ngl_param_handle *handle, const float *value)
+{
+    QUEUE_LIVE_CHANGE(VEC2, f, value, 2 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(vec2, value);
 }
 
 int ngl_node_param_set_vec3(struct ngl_node *node, const char *key, const float *value)
 {
-    FORWARD_TO_PARAM(vec3, value);
+    FORWARD_TO_HANDLE(vec3, value);
+}
+
+int ngl_node_param_set_vec3_h(const struct ngl_param_handle *handle, const float *value)
+{
+    QUEUE_LIVE_CHANGE(VEC3, f, value, 3 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(vec3, value);
 }
 
 int ngl_node_param_set_vec4(struct ngl_node *node, const char *key, const float *value)
 {
-    FORWARD_TO_PARAM(vec4, value);
+    FORWARD_TO_HANDLE(vec4, value);
+}
+
+int ngl_node_param_set_vec4_h(const struct ngl_param_handle *handle, const float *value)
+{
+    QUEUE_LIVE_CHANGE(VEC4, f, value, 4 * sizeof(*value));
+    FORWARD_TO_HANDLE_PARAM(vec4, value);
 }
 
 int ngl_node_param_set_dict(struct ngl_node *node, const char *key, const char *name, struct ngl_node *value)
@@ -1031,7 +1584,13 @@ void ngl_node_unrefp(struct ngl_node **nodep)
         ngli_assert(!node->ctx);
         ngli_params_free((uint8_t *)node, ngli_base_node_params);
         ngli_params_free(node->opts, node->cls->params);
-        ngli_free_aligned(node);
+        if (node->arena) {
+            /* The memory of the node is only reclaimed with the whole arena */
+            struct arena *arena = node->arena;
+            ngli_arena_unrefp(&arena);
+        } else {
+            ngli_free_aligned(node);
+        }
     }
     *nodep = NULL;
 }
@@ -43,6 +43,7 @@
 #include "pipeline_compat.h"
 #include "program.h"
 #include "texture.h"
+#include "threadpool.h"
 #include "topology.h"
 #include "type.h"
 #include "utils.h"
@@ -50,23 +51,44 @@
 struct uniform_map {
     int index;
     const void *data;
+    const uint64_t *version;   /* NULL if the changes of the data are not tracked */
+    uint64_t uploaded_version; /* UINT64_MAX until the first upload */
 };
 
 struct pipeline_desc {
     struct pgcraft *crafter;
     struct pipeline_compat *pipeline_compat;
+    int pending;
+    struct pipeline_graphics pipeline_graphics;
     int modelview_matrix_index;
     int projection_matrix_index;
     int normal_matrix_index;
     int resolution_index;
     struct darray uniforms_map;
+
+    /* Last values of the builtin uniforms sent to the pipeline */
+    int builtins_uploaded;
+    float modelview_matrix[4*4];
+    float projection_matrix[4*4];
+    float resolution[2];
 };
 
+static int register_crafter_uniform(struct pass *s, const struct pgcraft_uniform *crafter_uniform,
+                                    const uint64_t *version)
+{
+    if (!ngli_darray_push(&s->crafter_uniforms, crafter_uniform) ||
+        !ngli_darray_push(&s->crafter_uniforms_versions, &version))
+        return NGL_ERROR_MEMORY;
+    return 0;
+}
+
 static int register_uniform(struct pass *s, const char *name, struct ngl_node *uniform, int stage)
 {
     struct pgcraft_uniform crafter_uniform = {.stage = stage};
     snprintf(crafter_uniform.name, sizeof(crafter_uniform.name), "%s", name);
 
+    const uint64_t *version = NULL;
+
     if (uniform->cls->category == NGLI_NODE_CATEGORY_BUFFER) {
         struct buffer_info *buffer_info = uniform->priv_data;
         crafter_uniform.type  = buffer_info->layout.type;
@@ -76,6 +98,7 @@ static int register_uniform(struct pass *s, const char *name, struct ngl_node *u
         struct variable_info *variable_info = uniform->priv_data;
         crafter_uniform.type  = variable_info->data_type;
         crafter_uniform.data  = variable_info->data;
+        version = &variable_info->version;
     } else {
         ngli_assert(0);
     }
@@ -89,25 +112,22 @@ static int register_uniform(struct pass *s, const char *name, struct ngl_node *u
         }
     }
 
-    if (!ngli_darray_push(&s->crafter_uniforms, &crafter_uniform))
-        return NGL_ERROR_MEMORY;
-
-    return 0;
+    return register_crafter_uniform(s, &crafter_uniform, version);
 }
 
 static int register_builtin_uniforms(struct pass *s)
 {
     struct pgcraft_uniform crafter_uniforms[] = {
-        {.name = "ngl_modelview_matrix",  .type = NGLI_TYPE_MAT4, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL},
-        {.name = "ngl_projection_matrix", .type = NGLI_TYPE_MAT4, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL},
-        {.name = "ngl_normal_matrix",     .type = NGLI_TYPE_MAT3, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL},
-        {.name = "ngl_resolution",        .type = NGLI_TYPE_VEC2, .stage=NGLI_PROGRAM_SHADER_FRAG, .data = NULL},
+        {.name = "ngl_modelview_matrix",  .type = NGLI_TYPE_MAT4, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL, .push_constant = 1},
+        {.name = "ngl_projection_matrix", .type = NGLI_TYPE_MAT4, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL, .push_constant = 1},
+        {.name = "ngl_normal_matrix",     .type = NGLI_TYPE_MAT3, .stage=NGLI_PROGRAM_SHADER_VERT, .data = NULL, .push_constant = 1},
+        {.name = "ngl_resolution",        .type = NGLI_TYPE_VEC2, .stage=NGLI_PROGRAM_SHADER_FRAG, .data = NULL, .push_constant = 1},
     };
 
     for (int i = 0; i < NGLI_ARRAY_NB(crafter_uniforms); i++) {
-        struct pgcraft_uniform *crafter_uniform = &crafter_uniforms[i];
-        if (!ngli_darray_push(&s->crafter_uniforms, crafter_uniform))
-            return NGL_ERROR_MEMORY;
+        int ret = register_crafter_uniform(s, &crafter_uniforms[i], NULL);
+        if (ret < 0)
+            return ret;
     }
 
     return 0;
@@ -440,11 +460,13 @@ static int pass_compute_init(struct pass *s)
     return 0;
 }
 
-static int build_uniforms_map(struct pipeline_desc *desc, struct darray *crafter_uniforms)
+static int build_uniforms_map(struct pass *s, struct pipeline_desc *desc)
 {
     ngli_darray_init(&desc->uniforms_map, sizeof(struct uniform_map), 0);
 
-    struct pgcraft_uniform *uniforms = ngli_darray_data(crafter_uniforms);
+    const struct darray *crafter_uniforms = &s->crafter_uniforms;
+    const struct pgcraft_uniform *uniforms = ngli_darray_data(crafter_uniforms);
+    const uint64_t **versions = ngli_darray_data(&s->crafter_uniforms_versions);
     for (int i = 0; i < ngli_darray_count(crafter_uniforms); i++) {
         const struct pgcraft_uniform *uniform = &uniforms[i];
         const int index = ngli_pgcraft_get_uniform_index(desc->crafter, uniform->name, uniform->stage);
@@ -459,7 +481,12 @@ static int build_uniforms_map(struct pipeline_desc *desc, struct darray *crafter
         if (!uniform->data)
             continue;
 
-        const struct uniform_map map = {.index=index, .data=uniform->data};
+        const struct uniform_map map = {
+            .index            = index,
+            .data             = uniform->data,
+            .version          = versions[i],
+            .uploaded_version = UINT64_MAX,
+        };
         if (!ngli_darray_push(&desc->uniforms_map, &map))
             return NGL_ERROR_MEMORY;
     }
@@ -467,10 +494,32 @@ static int build_uniforms_map(struct pipeline_desc *desc, struct darray *crafter
     return 0;
 }
 
+static struct pgcraft_params get_crafter_params(const struct pass *s)
+{
+    const struct pgcraft_params crafter_params = {
+        .program_label     = s->params.program_label,
+        .vert_base         = s->params.vert_base,
+        .frag_base         = s->params.frag_base,
+        .comp_base         = s->params.comp_base,
+        .uniforms          = ngli_darray_data(&s->crafter_uniforms),
+        .nb_uniforms       = ngli_darray_count(&s->crafter_uniforms),
+        .textures          = ngli_darray_data(&s->crafter_textures),
+        .nb_textures       = ngli_darray_count(&s->crafter_textures),
+        .attributes        = ngli_darray_data(&s->crafter_attributes),
+        .nb_attributes     = ngli_darray_count(&s->crafter_attributes),
+        .blocks            = ngli_darray_data(&s->crafter_blocks),
+        .nb_blocks         = ngli_darray_count(&s->crafter_blocks),
+        .vert_out_vars     = s->params.vert_out_vars,
+        .nb_vert_out_vars  = s->params.nb_vert_out_vars,
+        .nb_frag_output    = s->params.nb_frag_output,
+        .workgroup_size    = {NGLI_ARG_VEC3(s->params.workgroup_size)},
+    };
+    return crafter_params;
+}
+
 int ngli_pass_prepare(struct pass *s)
 {
     struct ngl_ctx *ctx = s->ctx;
-    struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
     struct rnode *rnode = ctx->rnode_pos;
 
     const int format = rnode->rendertarget_desc.depth_stencil.format;
@@ -492,37 +541,31 @@ int ngli_pass_prepare(struct pass *s)
     if (ret < 0)
         return ret;
 
-    const struct pgcraft_params crafter_params = {
-        .program_label     = s->params.program_label,
-        .vert_base         = s->params.vert_base,
-        .frag_base         = s->params.frag_base,
-        .comp_base         = s->params.comp_base,
-        .uniforms          = ngli_darray_data(&s->crafter_uniforms),
-        .nb_uniforms       = ngli_darray_count(&s->crafter_uniforms),
-        .textures          = ngli_darray_data(&s->crafter_textures),
-        .nb_textures       = ngli_darray_count(&s->crafter_textures),
-        .attributes        = ngli_darray_data(&s->crafter_attributes),
-        .nb_attributes     = ngli_darray_count(&s->crafter_attributes),
-        .blocks            = ngli_darray_data(&s->crafter_blocks),
-        .nb_blocks         = ngli_darray_count(&s->crafter_blocks),
-        .vert_out_vars     = s->params.vert_out_vars,
-        .nb_vert_out_vars  = s->params.nb_vert_out_vars,
-        .nb_frag_output    = s->params.nb_frag_output,
-        .workgroup_size    = {NGLI_ARG_VEC3(s->params.workgroup_size)},
-    };
-
     struct pipeline_desc *desc = ngli_darray_push(&s->pipeline_descs, NULL);
     if (!desc)
         return NGL_ERROR_MEMORY;
     ctx->rnode_pos->id = ngli_darray_count(&s->pipeline_descs) - 1;
 
     memset(desc, 0, sizeof(*desc));
+    desc->pipeline_graphics = pipeline_graphics;
 
     desc->crafter = ngli_pgcraft_create(ctx);
     if (!desc->crafter)
         return NGL_ERROR_MEMORY;
 
-    ret = ngli_pgcraft_craft(desc->crafter, &crafter_params);
+    if (!ngli_darray_push(&ctx->pending_passes, &s))
+        return NGL_ERROR_MEMORY;
+    desc->pending = 1;
+
+    return 0;
+}
+
+static int create_pipeline(struct pass *s, struct pipeline_desc *desc)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
+
+    int ret = ngli_pgcraft_finalize(desc->crafter);
     if (ret < 0)
         return ret;
 
@@ -532,7 +575,7 @@ int ngli_pass_prepare(struct pass *s)
 
     const struct pipeline_params pipeline_params = {
         .type     = s->pipeline_type,
-        .graphics = pipeline_graphics,
+        .graphics = desc->pipeline_graphics,
         .program  = ngli_pgcraft_get_program(desc->crafter),
         .layout   = ngli_pgcraft_get_pipeline_layout(desc->crafter),
     };
@@ -549,7 +592,7 @@ int ngli_pass_prepare(struct pass *s)
     if (ret < 0)
         return ret;
 
-    ret = build_uniforms_map(desc, &s->crafter_uniforms);
+    ret = build_uniforms_map(s, desc);
     if (ret < 0)
         return ret;
 
@@ -561,6 +604,102 @@ int ngli_pass_prepare(struct pass *s)
     return 0;
 }
 
+void ngli_pass_cancel_pending_pipeline(struct pass *s, int id)
+{
+    struct pipeline_desc *desc = ngli_darray_get(&s->pipeline_descs, id);
+    ngli_assert(desc->pending);
+    desc->pending = 0;
+    ngli_pgcraft_freep(&desc->crafter);
+}
+
+struct pending_pipeline {
+    struct pass *pass;
+    struct pipeline_desc *desc;
+    struct pgcraft_params crafter_params;
+};
+
+static int craft_shaders_job(void *user_arg, int index)
+{
+    struct pending_pipeline *pipelines = user_arg;
+    struct pending_pipeline *pipeline = &pipelines[index];
+    int ret = ngli_pgcraft_craft_shaders(pipeline->desc->crafter, &pipeline->crafter_params);
+    if (ret < 0)
+        LOG(ERROR, "could not craft shaders of pass %s", pipeline->pass->params.label);
+    return ret;
+}
+
+static int collect_pending_pipelines(struct ngl_ctx *ctx, struct darray *pipelines)
+{
+    struct pass **passes = ngli_darray_data(&ctx->pending_passes);
+    for (int i = 0; i < ngli_darray_count(&ctx->pending_passes); i++) {
+        struct pass *s = passes[i];
+        const struct pgcraft_params crafter_params = get_crafter_params(s);
+        struct pipeline_desc *descs = ngli_darray_data(&s->pipeline_descs);
+        for (int j = 0; j < ngli_darray_count(&s->pipeline_descs); j++) {
+            struct pipeline_desc *desc = &descs[j];
+            if (!desc->pending)
+                continue;
+            desc->pending = 0;
+
+            const struct pending_pipeline pipeline = {
+                .pass           = s,
+                .desc           = desc,
+                .crafter_params = crafter_params,
+            };
+            if (!ngli_darray_push(pipelines, &pipeline))
+                return NGL_ERROR_MEMORY;
+        }
+    }
+    return 0;
+}
+
+int ngli_pass_create_pending_pipelines(struct ngl_ctx *ctx)
+{
+    struct darray pipelines_array;
+    ngli_darray_init(&pipelines_array, sizeof(struct pending_pipeline), 0);
+
+    int ret = collect_pending_pipelines(ctx, &pipelines_array);
+    ngli_darray_clear(&ctx->pending_passes);
+    if (ret < 0)
+        goto end;
+
+    struct pending_pipeline *pipelines = ngli_darray_data(&pipelines_array);
+    const int nb_pipelines = ngli_darray_count(&pipelines_array);
+
+    /* The shaders generation only depends on the pass parameters */
+    ret = ngli_threadpool_execute(ctx->threadpool, craft_shaders_job, pipelines, nb_pipelines);
+    if (ret < 0)
+        goto end;
+
+    /*
+     * The programs missing from the cache are all compiled at once (and
+     * concurrently when the backend allows it) when the batch ends.
+     */
+    ngli_pgcache_begin_batch(&ctx->pgcache);
+    for (int i = 0; i < nb_pipelines; i++) {
+        ret = ngli_pgcraft_request_program(pipelines[i].desc->crafter, &pipelines[i].crafter_params);
+        if (ret < 0) {
+            ngli_pgcache_cancel_batch(&ctx->pgcache);
+            goto end;
+        }
+    }
+    ret = ngli_pgcache_end_batch(&ctx->pgcache, ctx->threadpool);
+    if (ret < 0)
+        goto end;
+
+    for (int i = 0; i < nb_pipelines; i++) {
+        ret = create_pipeline(pipelines[i].pass, pipelines[i].desc);
+        if (ret < 0) {
+            LOG(ERROR, "could not create pipeline of pass %s", pipelines[i].pass->params.label);
+            goto end;
+        }
+    }
+
+end:
+    ngli_darray_reset(&pipelines_array);
+    return ret;
+}
+
 int ngli_pass_init(struct pass *s, struct ngl_ctx *ctx, const struct pass_params *params)
 {
     s->ctx = ctx;
@@ -569,6 +708,7 @@ int ngli_pass_init(struct pass *s, struct ngl_ctx *ctx, const struct pass_params
     ngli_darray_init(&s->crafter_attributes, sizeof(struct pgcraft_attribute), 0);
     ngli_darray_init(&s->crafter_textures, sizeof(struct pgcraft_texture), 0);
     ngli_darray_init(&s->crafter_uniforms, sizeof(struct pgcraft_uniform), 0);
+    ngli_darray_init(&s->crafter_uniforms_versions, sizeof(const uint64_t *), 0);
     ngli_darray_init(&s->crafter_blocks, sizeof(struct pgcraft_block), 0);
 
     ngli_darray_init(&s->pipeline_descs, sizeof(struct pipeline_desc), 0);
@@ -603,11 +743,29 @@ void ngli_pass_uninit(struct pass *s)
     ngli_darray_reset(&s->crafter_attributes);
     ngli_darray_reset(&s->crafter_textures);
     ngli_darray_reset(&s->crafter_uniforms);
+    ngli_darray_reset(&s->crafter_uniforms_versions);
     ngli_darray_reset(&s->crafter_blocks);
 
     memset(s, 0, sizeof(*s));
 }
 
+/*
+ * Send a builtin uniform to the pipeline unless it is unchanged since the
+ * previous execution. Return whether the value has changed.
+ */
+static int update_builtin_uniform(struct pass *s, struct pipeline_desc *desc, int index,
+                                  float *last_value, const float *value, size_t size)
+{
+    if (desc->builtins_uploaded && !memcmp(last_value, value, size)) {
+        if (index >= 0)
+            s->ctx->gpu_ctx->nb_elided_uniform_uploads++;
+        return 0;
+    }
+    memcpy(last_value, value, size);
+    ngli_pipeline_compat_update_uniform(desc->pipeline_compat, index, value);
+    return 1;
+}
+
 int ngli_pass_exec(struct pass *s)
 {
     struct ngl_ctx *ctx = s->ctx;
@@ -619,26 +777,45 @@ int ngli_pass_exec(struct pass *s)
     const float *modelview_matrix = ngli_darray_tail(&ctx->modelview_matrix_stack);
     const float *projection_matrix = ngli_darray_tail(&ctx->projection_matrix_stack);
 
-    ngli_pipeline_compat_update_uniform(pipeline_compat, desc->modelview_matrix_index, modelview_matrix);
-    ngli_pipeline_compat_update_uniform(pipeline_compat, desc->projection_matrix_index, projection_matrix);
+    const int modelview_changed = update_builtin_uniform(s, desc, desc->modelview_matrix_index,
+                                                         desc->modelview_matrix, modelview_matrix,
+                                                         sizeof(desc->modelview_matrix));
+    update_builtin_uniform(s, desc, desc->projection_matrix_index,
+                           desc->projection_matrix, projection_matrix,
+                           sizeof(desc->projection_matrix));
 
     int viewport[4] = {0};
     ngli_gpu_ctx_get_viewport(ctx->gpu_ctx, viewport);
 
     const float resolution[2] = {viewport[2], viewport[3]};
-    ngli_pipeline_compat_update_uniform(pipeline_compat, desc->resolution_index, resolution);
+    update_builtin_uniform(s, desc, desc->resolution_index,
+                           desc->resolution, resolution, sizeof(desc->resolution));
 
     if (desc->normal_matrix_index >= 0) {
-        float normal_matrix[3*3];
-        ngli_mat3_from_mat4(normal_matrix, modelview_matrix);
-        ngli_mat3_inverse(normal_matrix, normal_matrix);
-        ngli_mat3_transpose(normal_matrix, normal_matrix);
-        ngli_pipeline_compat_update_uniform(pipeline_compat, desc->normal_matrix_index, normal_matrix);
+        if (modelview_changed) {
+            float normal_matrix[3*3];
+            ngli_mat3_from_mat4(normal_matrix, modelview_matrix);
+            ngli_mat3_inverse(normal_matrix, normal_matrix);
+            ngli_mat3_transpose(normal_matrix, normal_matrix);
+            ngli_pipeline_compat_update_uniform(pipeline_compat, desc->normal_matrix_index, normal_matrix);
+        } else {
+            ctx->gpu_ctx->nb_elided_uniform_uploads++;
+        }
+    }
+    desc->builtins_uploaded = 1;
+
+    struct uniform_map *map = ngli_darray_data(&desc->uniforms_map);
+    for (int i = 0; i < ngli_darray_count(&desc->uniforms_map); i++) {
+        struct uniform_map *uniform_map = &map[i];
+        if (uniform_map->version) {
+            if (*uniform_map->version == uniform_map->uploaded_version) {
+                ctx->gpu_ctx->nb_elided_uniform_uploads++;
+                continue;
+            }
+            uniform_map->uploaded_version = *uniform_map->version;
+        }
+        ngli_pipeline_compat_update_uniform(pipeline_compat, uniform_map->index, uniform_map->data);
     }
-
-    const struct uniform_map *map = ngli_darray_data(&desc->uniforms_map);
-    for (int i = 0; i < ngli_darray_count(&desc->uniforms_map); i++)
-        ngli_pipeline_compat_update_uniform(pipeline_compat, map[i].index, map[i].data);
 
     const struct darray *texture_infos_array = ngli_pgcraft_get_texture_infos(desc->crafter);
     const struct pgcraft_texture_info *texture_infos = ngli_darray_data(texture_infos_array);
@@ -652,11 +829,14 @@ int ngli_pass_exec(struct pass *s)
             ctx->render_pass_started = 1;
         }
 
+        if (ctx->hud)
+            ngli_hud_register_draw(ctx->hud, ngli_pgcraft_get_program(desc->crafter),
+                                   &desc->pipeline_graphics.state);
+
         if (s->indices)
-            ngli_pipeline_compat_draw_indexed(pipeline_compat, s->indices, s->indices_layout->format,
-                                              s->indices_layout->count, s->nb_instances);
-        else
-            ngli_pipeline_compat_draw(pipeline_compat, s->nb_vertices, s->nb_instances);
+            return ngli_pipeline_compat_draw_indexed(pipeline_compat, s->indices, s->indices_layout->format,
+                                                     s->indices_layout->count, s->nb_instances);
+        return ngli_pipeline_compat_draw(pipeline_compat, s->nb_vertices, s->nb_instances);
     } else {
         if (ctx->render_pass_started) {
             struct gpu_ctx *gpu_ctx = ctx->gpu_ctx;
@@ -665,8 +845,6 @@ int ngli_pass_exec(struct pass *s)
             ctx->current_rendertarget = ctx->available_rendertargets[1];
         }
 
-        ngli_pipeline_compat_dispatch(pipeline_compat, NGLI_ARG_VEC3(params->workgroup_count));
+        return ngli_pipeline_compat_dispatch(pipeline_compat, NGLI_ARG_VEC3(params->workgroup_count));
     }
-
-    return 0;
 }
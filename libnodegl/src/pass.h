@@ -73,13 +73,27 @@ struct pass {
     struct pipeline_graphics pipeline_graphics;
     struct darray crafter_attributes;
     struct darray crafter_uniforms;
+    struct darray crafter_uniforms_versions; // const uint64_t pointer per crafter uniform, NULL if untracked
     struct darray crafter_textures;
     struct darray crafter_blocks;
     struct darray pipeline_descs;
 };
 
 int ngli_pass_init(struct pass *s, struct ngl_ctx *ctx, const struct pass_params *params);
+
+/*
+ * Only register the pipeline required by the current render node: the
+ * pipelines of all the prepared passes are then crafted and compiled at once
+ * with ngli_pass_create_pending_pipelines().
+ */
 int ngli_pass_prepare(struct pass *s);
+int ngli_pass_create_pending_pipelines(struct ngl_ctx *ctx);
+
+/*
+ * Cancel the pending pipeline registered for the render node with the given
+ * id: its draws are taken over by a batch, so it is never created.
+ */
+void ngli_pass_cancel_pending_pipeline(struct pass *s, int id);
 void ngli_pass_uninit(struct pass *s);
 void ngli_pass_update_texture_uniforms(struct pipeline *pipeline, const struct pgcraft_texture_info *info);
 int ngli_pass_exec(struct pass *s);
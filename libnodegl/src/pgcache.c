@@ -47,9 +47,46 @@ int ngli_pgcache_init(struct pgcache *s, struct gpu_ctx *gpu_ctx)
         return NGL_ERROR_MEMORY;
     ngli_hmap_set_free(s->graphics_cache, reset_cached_frag_map, s);
     ngli_hmap_set_free(s->compute_cache, reset_cached_program, s);
+    ngli_darray_init(&s->batch_programs, sizeof(struct program *), 0);
+    ngli_darray_init(&s->batch_params, sizeof(struct program_params), 0);
     return 0;
 }
 
+static void reset_batch_params(struct program_params *params)
+{
+    ngli_freep(&params->label);
+    ngli_freep(&params->vertex);
+    ngli_freep(&params->fragment);
+    ngli_freep(&params->compute);
+}
+
+static int queue_batch_program(struct pgcache *s, struct program *program, const struct program_params *params)
+{
+    /* The sources are copied since they are generally released by the caller */
+    struct program_params params_copy = {0};
+    if ((params->label    && !(params_copy.label    = ngli_strdup(params->label)))    ||
+        (params->vertex   && !(params_copy.vertex   = ngli_strdup(params->vertex)))   ||
+        (params->fragment && !(params_copy.fragment = ngli_strdup(params->fragment))) ||
+        (params->compute  && !(params_copy.compute  = ngli_strdup(params->compute)))  ||
+        !ngli_darray_push(&s->batch_params, &params_copy)) {
+        reset_batch_params(&params_copy);
+        return NGL_ERROR_MEMORY;
+    }
+
+    if (!ngli_darray_push(&s->batch_programs, &program)) {
+        reset_batch_params(ngli_darray_pop(&s->batch_params));
+        return NGL_ERROR_MEMORY;
+    }
+
+    return 0;
+}
+
+static void unqueue_batch_program(struct pgcache *s)
+{
+    reset_batch_params(ngli_darray_pop(&s->batch_params));
+    ngli_darray_pop(&s->batch_programs);
+}
+
 static int query_cache(struct pgcache *s, struct program **dstp,
                        struct hmap *cache, const char *cache_key,
                        const struct program_params *params)
@@ -70,7 +107,8 @@ static int query_cache(struct pgcache *s, struct program **dstp,
     if (!new_program)
         return NGL_ERROR_MEMORY;
 
-    int ret = ngli_program_init(new_program, params);
+    int ret = s->batching ? queue_batch_program(s, new_program, params)
+                          : ngli_program_init(new_program, params);
     if (ret < 0) {
         ngli_program_freep(&new_program);
         return ret;
@@ -78,6 +116,8 @@ static int query_cache(struct pgcache *s, struct program **dstp,
 
     ret = ngli_hmap_set(cache, cache_key, new_program);
     if (ret < 0) {
+        if (s->batching)
+            unqueue_batch_program(s);
         ngli_program_freep(&new_program);
         return ret;
     }
@@ -115,10 +155,68 @@ int ngli_pgcache_get_compute_program(struct pgcache *s, struct program **dstp, c
     return query_cache(s, dstp, s->compute_cache, params->compute, params);
 }
 
+void ngli_pgcache_begin_batch(struct pgcache *s)
+{
+    ngli_assert(!s->batching);
+    s->batching = 1;
+}
+
+static void remove_program(struct pgcache *s, const struct program_params *params)
+{
+    if (params->compute) {
+        ngli_hmap_set(s->compute_cache, params->compute, NULL);
+        return;
+    }
+
+    struct hmap *frag_map = ngli_hmap_get(s->graphics_cache, params->vertex);
+    if (frag_map)
+        ngli_hmap_set(frag_map, params->fragment, NULL);
+}
+
+static void clear_batch(struct pgcache *s)
+{
+    struct program_params *params = ngli_darray_data(&s->batch_params);
+    for (int i = 0; i < ngli_darray_count(&s->batch_params); i++)
+        reset_batch_params(&params[i]);
+    ngli_darray_clear(&s->batch_params);
+    ngli_darray_clear(&s->batch_programs);
+    s->batching = 0;
+}
+
+void ngli_pgcache_cancel_batch(struct pgcache *s)
+{
+    ngli_assert(s->batching);
+
+    const struct program_params *params = ngli_darray_data(&s->batch_params);
+    for (int i = 0; i < ngli_darray_count(&s->batch_params); i++)
+        remove_program(s, &params[i]);
+
+    clear_batch(s);
+}
+
+int ngli_pgcache_end_batch(struct pgcache *s, struct threadpool *threadpool)
+{
+    ngli_assert(s->batching);
+
+    int ret = ngli_program_init_batch(ngli_darray_data(&s->batch_programs),
+                                      ngli_darray_data(&s->batch_params),
+                                      ngli_darray_count(&s->batch_programs), threadpool);
+    if (ret < 0) {
+        ngli_pgcache_cancel_batch(s);
+        return ret;
+    }
+
+    clear_batch(s);
+    return 0;
+}
+
 void ngli_pgcache_reset(struct pgcache *s)
 {
     if (!s->gpu_ctx)
         return;
+    clear_batch(s);
+    ngli_darray_reset(&s->batch_programs);
+    ngli_darray_reset(&s->batch_params);
     ngli_hmap_freep(&s->compute_cache);
     ngli_hmap_freep(&s->graphics_cache);
     memset(s, 0, sizeof(*s));
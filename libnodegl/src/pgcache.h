@@ -22,18 +22,35 @@
 #ifndef PGCACHE_H
 #define PGCACHE_H
 
+#include "darray.h"
 #include "hmap.h"
 #include "program.h"
 
+struct threadpool;
+
 struct pgcache {
     struct gpu_ctx *gpu_ctx;
     struct hmap *graphics_cache;
     struct hmap *compute_cache;
+    int batching;
+    struct darray batch_programs; /* array of program pointers */
+    struct darray batch_params;   /* array of program_params */
 };
 
 int ngli_pgcache_init(struct pgcache *s, struct gpu_ctx *ctx);
 int ngli_pgcache_get_graphics_program(struct pgcache *s, struct program **dstp, const struct program_params *params);
 int ngli_pgcache_get_compute_program(struct pgcache *s, struct program **dstp, const struct program_params *params);
+
+/*
+ * Between ngli_pgcache_begin_batch() and ngli_pgcache_end_batch(), the
+ * programs missing from the cache are returned uninitialized: they are all
+ * initialized at once (and possibly concurrently) by ngli_pgcache_end_batch().
+ * If it fails, the programs of the batch are removed from the cache.
+ */
+void ngli_pgcache_begin_batch(struct pgcache *s);
+int ngli_pgcache_end_batch(struct pgcache *s, struct threadpool *threadpool);
+void ngli_pgcache_cancel_batch(struct pgcache *s);
+
 void ngli_pgcache_reset(struct pgcache *s);
 
 #endif
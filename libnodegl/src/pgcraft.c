@@ -200,6 +200,7 @@ static const int type_flags_map[NGLI_TYPE_NB] = {
     [NGLI_TYPE_IMAGE_3D]                    = TYPE_FLAG_HAS_PRECISION|TYPE_FLAG_IS_SAMPLER_OR_IMAGE,
     [NGLI_TYPE_IMAGE_2D_ARRAY]              = TYPE_FLAG_HAS_PRECISION|TYPE_FLAG_IS_SAMPLER_OR_IMAGE,
     [NGLI_TYPE_UNIFORM_BUFFER]              = 0,
+    [NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC]      = 0,
     [NGLI_TYPE_STORAGE_BUFFER]              = 0,
 };
 
@@ -261,12 +262,39 @@ static int inject_block_uniform(struct pgcraft *s, struct bstr *b,
     return ngli_block_add_field(block, uniform->name, uniform->type, uniform->count);
 }
 
+static int inject_batched_uniform(struct pgcraft *s, struct bstr *b,
+                                  const struct pgcraft_uniform *uniform)
+{
+    /* Set per instance by the main() wrapper, see inject_batch_main() */
+    const char *type = get_glsl_type(uniform->type);
+    const char *precision = get_precision_qualifier(s, uniform->type, uniform->precision, "highp");
+    ngli_bstr_printf(b, "%s %s %s;\n", precision, type, uniform->name);
+    return 0;
+}
+
+static int get_push_constant_index(const struct pgcraft *s, const char *name)
+{
+    const struct darray *fields_array = &s->compat_info.push_constants.fields;
+    const struct block_field *fields = ngli_darray_data(fields_array);
+    for (int i = 0; i < ngli_darray_count(fields_array); i++)
+        if (!strcmp(fields[i].name, name))
+            return i;
+    return -1;
+}
+
 static int inject_uniform(struct pgcraft *s, struct bstr *b,
                           const struct pgcraft_uniform *uniform)
 {
+    if (uniform->batched)
+        return inject_batched_uniform(s, b, uniform);
+
     struct pgcraft_compat_info *compat_info = &s->compat_info;
-    if (compat_info->use_ublocks)
+    if (compat_info->use_ublocks) {
+        /* Declared by inject_push_constants() */
+        if (uniform->push_constant && get_push_constant_index(s, uniform->name) >= 0)
+            return 0;
         return inject_block_uniform(s, b, uniform, uniform->stage);
+    }
 
     struct pipeline_uniform_desc pl_uniform_desc = {
         .type  = uniform->type,
@@ -539,8 +567,8 @@ static int inject_block(struct pgcraft *s, struct bstr *b,
                         const struct pgcraft_block *named_block)
 {
     const struct block *block = named_block->block;
-    const int binding_type = named_block->type == NGLI_TYPE_UNIFORM_BUFFER
-                           ? NGLI_BINDING_TYPE_UBO : NGLI_BINDING_TYPE_SSBO;
+    const int binding_type = named_block->type == NGLI_TYPE_STORAGE_BUFFER
+                           ? NGLI_BINDING_TYPE_SSBO : NGLI_BINDING_TYPE_UBO;
     struct pipeline_buffer_desc pl_buffer_desc = {
         .type    = named_block->type,
         .binding = request_next_binding(s, named_block->stage, binding_type),
@@ -676,7 +704,7 @@ static int inject_ublock(struct pgcraft *s, struct bstr *b, int stage)
     struct pgcraft_block pgcraft_block = {
         /* instance name is empty to make field accesses identical to uniform accesses */
         .instance_name = "",
-        .type          = NGLI_TYPE_UNIFORM_BUFFER,
+        .type          = NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC,
         .stage         = stage,
         .block         = block,
         .buffer        = NULL,
@@ -691,6 +719,69 @@ static int inject_ublock(struct pgcraft *s, struct bstr *b, int stage)
     return 0;
 }
 
+/*
+ * Pack the uniforms hinted as push constants into the push constants block, in
+ * their order of declaration, as long as the block fits in the limit of the
+ * backend. The block must be known before crafting any stage since all of them
+ * declare it identically.
+ */
+static int setup_push_constants(struct pgcraft *s, const struct pgcraft_params *params)
+{
+    struct pgcraft_compat_info *compat_info = &s->compat_info;
+    if (!compat_info->use_ublocks)
+        return 0;
+
+    const struct gpu_limits *limits = &s->ctx->gpu_ctx->limits;
+    struct block *block = &compat_info->push_constants;
+    for (int i = 0; i < params->nb_uniforms; i++) {
+        const struct pgcraft_uniform *uniform = &params->uniforms[i];
+        if (!uniform->push_constant || uniform->batched || uniform->count)
+            continue;
+
+        const int prev_size = block->size;
+        int ret = ngli_block_add_field(block, uniform->name, uniform->type, 0);
+        if (ret < 0)
+            return ret;
+
+        /* Keep the uniform in the uniform block of its stage */
+        if (block->size > limits->max_push_constants_size) {
+            ngli_darray_pop(&block->fields);
+            block->size = prev_size;
+            continue;
+        }
+
+        struct pipeline_uniform_desc pl_uniform_desc = {
+            .type  = uniform->type,
+            .count = 1,
+        };
+        snprintf(pl_uniform_desc.name, sizeof(pl_uniform_desc.name), "%s", uniform->name);
+
+        if (!ngli_darray_push(&s->pipeline_info.desc.uniforms, &pl_uniform_desc))
+            return NGL_ERROR_MEMORY;
+        if (!ngli_darray_push(&s->pipeline_info.data.uniforms, &uniform->data))
+            return NGL_ERROR_MEMORY;
+    }
+
+    return 0;
+}
+
+static int inject_push_constants(struct pgcraft *s, struct bstr *b)
+{
+    const struct block *block = &s->compat_info.push_constants;
+    if (!block->size)
+        return 0;
+
+    ngli_bstr_print(b, "layout(push_constant) uniform ngl_push_constants {\n");
+    const struct block_field *fields = ngli_darray_data(&block->fields);
+    for (int i = 0; i < ngli_darray_count(&block->fields); i++) {
+        const struct block_field *fi = &fields[i];
+        ngli_bstr_printf(b, "    layout(offset=%d) %s %s;\n", fi->offset, get_glsl_type(fi->type), fi->name);
+    }
+    ngli_bstr_print(b, "};\n");
+
+    return 0;
+}
+
 static int params_have_ssbos(struct pgcraft *s, const struct pgcraft_params *params, int stage)
 {
     for (int i = 0; i < params->nb_blocks; i++) {
@@ -1061,28 +1152,107 @@ static int inject_iovars(struct pgcraft *s, struct bstr *b, int stage)
     return 0;
 }
 
+static int has_batched_uniforms(const struct pgcraft_params *params, int stage)
+{
+    for (int i = 0; i < params->nb_uniforms; i++) {
+        const struct pgcraft_uniform *uniform = &params->uniforms[i];
+        if (uniform->batched && uniform->stage == stage)
+            return 1;
+    }
+    return 0;
+}
+
+/*
+ * The fragment stage batched uniforms are forwarded from their vertex
+ * attributes through flat varyings, located after the user ones.
+ */
+static int inject_batch_iovars(struct pgcraft *s, struct bstr *b,
+                               const struct pgcraft_params *params, int stage)
+{
+    static const char *qualifiers[2] = {
+        [NGLI_PROGRAM_SHADER_VERT] = "out",
+        [NGLI_PROGRAM_SHADER_FRAG] = "in",
+    };
+
+    int location = 0;
+    const struct pgcraft_iovar *iovars = ngli_darray_data(&s->vert_out_vars);
+    for (int i = 0; i < ngli_darray_count(&s->vert_out_vars); i++)
+        location += get_location_count(iovars[i].type);
+
+    for (int i = 0; i < params->nb_uniforms; i++) {
+        const struct pgcraft_uniform *uniform = &params->uniforms[i];
+        if (!uniform->batched || uniform->stage != NGLI_PROGRAM_SHADER_FRAG)
+            continue;
+        if (s->has_in_out_layout_qualifiers)
+            ngli_bstr_printf(b, "layout(location=%d) ", location);
+        const char *type = get_glsl_type(uniform->type);
+        const char *precision = get_precision_qualifier(s, uniform->type, uniform->precision, "highp");
+        ngli_bstr_printf(b, "flat %s %s %s ngl_batch_io_%s;\n", qualifiers[stage], precision, type, uniform->name);
+        location += get_location_count(uniform->type);
+    }
+    return 0;
+}
+
+/*
+ * The user main() is renamed with a define preceding the user code: the
+ * actual main() sets the batched uniforms of the stage before calling it.
+ */
+static void inject_batch_main(struct pgcraft *s, struct bstr *b,
+                              const struct pgcraft_params *params, int stage)
+{
+    ngli_bstr_print(b, "\n#undef main\n"
+                       "void main()\n"
+                       "{\n");
+    for (int i = 0; i < params->nb_uniforms; i++) {
+        const struct pgcraft_uniform *uniform = &params->uniforms[i];
+        if (!uniform->batched)
+            continue;
+        const char *name = uniform->name;
+        if (stage == NGLI_PROGRAM_SHADER_VERT && uniform->stage == NGLI_PROGRAM_SHADER_VERT)
+            ngli_bstr_printf(b, "    %s = ngl_batch_vert_%s;\n", name, name);
+        else if (stage == NGLI_PROGRAM_SHADER_VERT && uniform->stage == NGLI_PROGRAM_SHADER_FRAG)
+            ngli_bstr_printf(b, "    ngl_batch_io_%s = ngl_batch_frag_%s;\n", name, name);
+        else if (stage == NGLI_PROGRAM_SHADER_FRAG && uniform->stage == NGLI_PROGRAM_SHADER_FRAG)
+            ngli_bstr_printf(b, "    %s = ngl_batch_io_%s;\n", name, name);
+    }
+    ngli_bstr_print(b, "    ngl_batch_main();\n"
+                       "}\n");
+}
+
 static int craft_vert(struct pgcraft *s, const struct pgcraft_params *params)
 {
     struct bstr *b = s->shaders[NGLI_PROGRAM_SHADER_VERT];
 
     set_glsl_header(s, b, params, NGLI_PROGRAM_SHADER_VERT);
 
+    /* The instances of a batched draw are the merged draws, not user instances */
+    const int batched = has_batched_uniforms(params, NGLI_PROGRAM_SHADER_VERT) ||
+                        has_batched_uniforms(params, NGLI_PROGRAM_SHADER_FRAG);
     ngli_bstr_printf(b, "#define ngl_out_pos gl_Position\n"
                         "#define ngl_vertex_index %s\n"
                         "#define ngl_instance_index %s\n",
-                        s->sym_vertex_index, s->sym_instance_index);
+                        s->sym_vertex_index, batched ? "0" : s->sym_instance_index);
 
     int ret;
     if ((ret = inject_iovars(s, b, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
+        (ret = inject_batch_iovars(s, b, params, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
         (ret = inject_uniforms(s, b, params, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
         (ret = inject_texture_infos(s, params, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
         (ret = inject_blocks(s, b, params, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
         (ret = inject_attributes(s, b, params)) < 0 ||
-        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_VERT)) < 0)
+        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
+        (ret = inject_push_constants(s, b)) < 0)
         return ret;
 
+    if (batched)
+        ngli_bstr_print(b, "#define main ngl_batch_main\n");
     ngli_bstr_print(b, params->vert_base);
-    return samplers_preproc(s, params, b);
+    ret = samplers_preproc(s, params, b);
+    if (ret < 0)
+        return ret;
+    if (batched)
+        inject_batch_main(s, b, params, NGLI_PROGRAM_SHADER_VERT);
+    return 0;
 }
 
 static int craft_frag(struct pgcraft *s, const struct pgcraft_params *params)
@@ -1123,16 +1293,27 @@ static int craft_frag(struct pgcraft *s, const struct pgcraft_params *params)
         ngli_bstr_print(b, "#define ngl_out_color gl_FragColor\n");
     }
 
+    const int batched = has_batched_uniforms(params, NGLI_PROGRAM_SHADER_FRAG);
+
     int ret;
     if ((ret = inject_iovars(s, b, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
+        (ret = inject_batch_iovars(s, b, params, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
         (ret = inject_uniforms(s, b, params, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
         (ret = inject_texture_infos(s, params, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
         (ret = inject_blocks(s, b, params, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
-        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_FRAG)) < 0)
+        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
+        (ret = inject_push_constants(s, b)) < 0)
         return ret;
 
+    if (batched)
+        ngli_bstr_print(b, "#define main ngl_batch_main\n");
     ngli_bstr_print(b, params->frag_base);
-    return samplers_preproc(s, params, b);
+    ret = samplers_preproc(s, params, b);
+    if (ret < 0)
+        return ret;
+    if (batched)
+        inject_batch_main(s, b, params, NGLI_PROGRAM_SHADER_FRAG);
+    return 0;
 }
 
 static int craft_comp(struct pgcraft *s, const struct pgcraft_params *params)
@@ -1149,7 +1330,8 @@ static int craft_comp(struct pgcraft *s, const struct pgcraft_params *params)
     if ((ret = inject_uniforms(s, b, params, NGLI_PROGRAM_SHADER_COMP)) < 0 ||
         (ret = inject_texture_infos(s, params, NGLI_PROGRAM_SHADER_COMP)) < 0 ||
         (ret = inject_blocks(s, b, params, NGLI_PROGRAM_SHADER_COMP)) < 0 ||
-        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_COMP)) < 0)
+        (ret = inject_ublock(s, b, NGLI_PROGRAM_SHADER_COMP)) < 0 ||
+        (ret = inject_push_constants(s, b)) < 0)
         return ret;
 
     ngli_bstr_print(b, params->comp_base);
@@ -1431,6 +1613,7 @@ struct pgcraft *ngli_pgcraft_create(struct ngl_ctx *ctx)
             ngli_block_init(&compat_info->ublocks[i], NGLI_BLOCK_LAYOUT_STD140);
             compat_info->ubindings[i] = -1;
         }
+        ngli_block_init(&compat_info->push_constants, NGLI_BLOCK_LAYOUT_STD430);
     }
 
     ngli_darray_init(&s->pipeline_info.desc.uniforms,   sizeof(struct pipeline_uniform_desc),   0);
@@ -1466,28 +1649,30 @@ static int alloc_shader(struct pgcraft *s, int stage)
     return 0;
 }
 
-static int get_program_compute(struct pgcraft *s, const struct pgcraft_params *params)
+static int craft_shaders_compute(struct pgcraft *s, const struct pgcraft_params *params)
 {
     int ret;
 
     if ((ret = alloc_shader(s, NGLI_PROGRAM_SHADER_COMP)) < 0 ||
         (ret = prepare_texture_infos(s, params, 0)) < 0 ||
+        (ret = setup_push_constants(s, params)) < 0 ||
         (ret = craft_comp(s, params)) < 0)
         return ret;
 
-    const struct program_params program_params = {
-        .label   = params->program_label,
-        .compute = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_COMP]),
-    };
-    ret = ngli_pgcache_get_compute_program(&s->ctx->pgcache, &s->program, &program_params);
-    ngli_bstr_freep(&s->shaders[NGLI_PROGRAM_SHADER_COMP]);
-    return ret;
+    return 0;
 }
 
-static int get_program_graphics(struct pgcraft *s, const struct pgcraft_params *params)
+static int craft_shaders_graphics(struct pgcraft *s, const struct pgcraft_params *params)
 {
     int ret;
 
+    if (!ngli_pgcraft_supports_batching(s) &&
+        (has_batched_uniforms(params, NGLI_PROGRAM_SHADER_VERT) ||
+         has_batched_uniforms(params, NGLI_PROGRAM_SHADER_FRAG))) {
+        LOG(ERROR, "batched uniforms are not supported by this GLSL version");
+        return NGL_ERROR_UNSUPPORTED;
+    }
+
     ngli_darray_init(&s->vert_out_vars, sizeof(struct pgcraft_iovar), 0);
     for (int i = 0; i < params->nb_vert_out_vars; i++) {
         struct pgcraft_iovar *iovar = ngli_darray_push(&s->vert_out_vars, &params->vert_out_vars[i]);
@@ -1498,29 +1683,48 @@ static int get_program_graphics(struct pgcraft *s, const struct pgcraft_params *
     if ((ret = alloc_shader(s, NGLI_PROGRAM_SHADER_VERT)) < 0 ||
         (ret = alloc_shader(s, NGLI_PROGRAM_SHADER_FRAG)) < 0 ||
         (ret = prepare_texture_infos(s, params, 1)) < 0 ||
+        (ret = setup_push_constants(s, params)) < 0 ||
         (ret = craft_vert(s, params)) < 0 ||
         (ret = craft_frag(s, params)) < 0)
         return ret;
 
-    const struct program_params program_params = {
-        .label    = params->program_label,
-        .vertex   = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_VERT]),
-        .fragment = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_FRAG]),
-    };
-    ret = ngli_pgcache_get_graphics_program(&s->ctx->pgcache, &s->program, &program_params);
-    ngli_bstr_freep(&s->shaders[NGLI_PROGRAM_SHADER_VERT]);
-    ngli_bstr_freep(&s->shaders[NGLI_PROGRAM_SHADER_FRAG]);
-    return ret;
+    return 0;
 }
 
-int ngli_pgcraft_craft(struct pgcraft *s, const struct pgcraft_params *params)
+int ngli_pgcraft_craft_shaders(struct pgcraft *s, const struct pgcraft_params *params)
 {
-    int ret = params->comp_base ? get_program_compute(s, params)
-                                : get_program_graphics(s, params);
-    if (ret < 0)
-        return ret;
+    return params->comp_base ? craft_shaders_compute(s, params)
+                             : craft_shaders_graphics(s, params);
+}
+
+int ngli_pgcraft_request_program(struct pgcraft *s, const struct pgcraft_params *params)
+{
+    struct pgcache *pgcache = &s->ctx->pgcache;
+
+    int ret;
+    if (params->comp_base) {
+        const struct program_params program_params = {
+            .label   = params->program_label,
+            .compute = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_COMP]),
+        };
+        ret = ngli_pgcache_get_compute_program(pgcache, &s->program, &program_params);
+    } else {
+        const struct program_params program_params = {
+            .label    = params->program_label,
+            .vertex   = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_VERT]),
+            .fragment = ngli_bstr_strptr(s->shaders[NGLI_PROGRAM_SHADER_FRAG]),
+        };
+        ret = ngli_pgcache_get_graphics_program(pgcache, &s->program, &program_params);
+    }
 
-    ret = probe_pipeline_elems(s);
+    for (int i = 0; i < NGLI_ARRAY_NB(s->shaders); i++)
+        ngli_bstr_freep(&s->shaders[i]);
+    return ret;
+}
+
+int ngli_pgcraft_finalize(struct pgcraft *s)
+{
+    int ret = probe_pipeline_elems(s);
     if (ret < 0)
         return ret;
 
@@ -1542,13 +1746,44 @@ int ngli_pgcraft_craft(struct pgcraft *s, const struct pgcraft_params *params)
     return 0;
 }
 
+int ngli_pgcraft_craft(struct pgcraft *s, const struct pgcraft_params *params)
+{
+    int ret;
+    if ((ret = ngli_pgcraft_craft_shaders(s, params)) < 0 ||
+        (ret = ngli_pgcraft_request_program(s, params)) < 0 ||
+        (ret = ngli_pgcraft_finalize(s)) < 0)
+        return ret;
+    return 0;
+}
+
+int ngli_pgcraft_supports_batching(const struct pgcraft *s)
+{
+    /* Flat varyings are required to forward the fragment batched uniforms */
+    return s->has_in_out_qualifiers;
+}
+
+int ngli_pgcraft_get_batch_attribute_name(char *dst, size_t size, const struct pgcraft_uniform *uniform)
+{
+    ngli_assert(uniform->stage == NGLI_PROGRAM_SHADER_VERT || uniform->stage == NGLI_PROGRAM_SHADER_FRAG);
+    const int len = snprintf(dst, size, "ngl_batch_%s_%s", ublock_names[uniform->stage], uniform->name);
+    if (len >= size) {
+        LOG(ERROR, "uniform name \"%s\" is too long to be batched", uniform->name);
+        return NGL_ERROR_MEMORY;
+    }
+    return 0;
+}
+
 int ngli_pgcraft_get_uniform_index(const struct pgcraft *s, const char *name, int stage)
 {
     const struct pgcraft_compat_info *compat_info = &s->compat_info;
-    if (compat_info->use_ublocks)
+    if (compat_info->use_ublocks) {
+        /* The only pipeline uniforms are the push constants */
+        const int index = get_uniform_index(s, name);
+        if (index >= 0)
+            return NGLI_PGCRAFT_PUSH_CONSTANTS_STAGE << 16 | index;
         return get_ublock_index(s, name, stage);
-    else
-        return get_uniform_index(s, name);
+    }
+    return get_uniform_index(s, name);
 }
 
 const struct darray *ngli_pgcraft_get_texture_infos(const struct pgcraft *s)
@@ -1609,6 +1844,7 @@ void ngli_pgcraft_freep(struct pgcraft **sp)
     for (int i = 0; i < NGLI_ARRAY_NB(compat_info->ublocks); i++) {
         ngli_block_reset(&compat_info->ublocks[i]);
     }
+    ngli_block_reset(&compat_info->push_constants);
 
     for (int i = 0; i < NGLI_ARRAY_NB(s->shaders); i++)
         ngli_bstr_freep(&s->shaders[i]);
@@ -22,6 +22,8 @@
 #ifndef PGCRAFT_H
 #define PGCRAFT_H
 
+#include <stddef.h>
+
 #include "block.h"
 #include "bstr.h"
 #include "buffer.h"
@@ -39,6 +41,20 @@ struct pgcraft_uniform { // also buffers (for arrays)
     int count;
     int precision;
     const void *data;
+    /*
+     * Graphics only: the value of a batched uniform is set per instance from
+     * the vertex attribute named by ngli_pgcraft_get_batch_attribute_name(),
+     * which must be part of the attributes. The shaders still access it as a
+     * global variable of the same name.
+     */
+    int batched;
+    /*
+     * Hint for the non-array uniforms updated before every draw: when the
+     * uniforms are packed into uniform blocks and the push constants block of
+     * the backend is large enough, the uniform is pushed along with the draw
+     * commands instead. Ignored for the batched uniforms.
+     */
+    int push_constant;
 };
 
 enum pgcraft_shader_tex_type {
@@ -169,8 +185,20 @@ struct pgcraft_compat_info {
     int use_ublocks;
     struct block ublocks[NGLI_PROGRAM_SHADER_NB];
     int ubindings[NGLI_PROGRAM_SHADER_NB];
+    /*
+     * Uniforms shared by all the stages through the push constants, they are
+     * also the uniforms of the pipeline layout, in the same order.
+     */
+    struct block push_constants;
 };
 
+/*
+ * Stage encoded in the uniform indexes of the push constants, see
+ * ngli_pgcraft_get_uniform_index(). The rest of the index is the index of the
+ * uniform in the pipeline layout.
+ */
+#define NGLI_PGCRAFT_PUSH_CONSTANTS_STAGE NGLI_PROGRAM_SHADER_NB
+
 struct pgcraft_params {
     const char *program_label;
     const char *vert_base;
@@ -198,6 +226,21 @@ struct pgcraft;
 
 struct pgcraft *ngli_pgcraft_create(struct ngl_ctx *ctx);
 int ngli_pgcraft_craft(struct pgcraft *s, const struct pgcraft_params *params);
+
+/*
+ * ngli_pgcraft_craft() split in its 3 steps, for callers preparing many
+ * programs at once:
+ * - ngli_pgcraft_craft_shaders() only generates the shader sources; it does
+ *   not rely on the GPU context and crafters can run it concurrently
+ * - ngli_pgcraft_request_program() gets the program from the program cache,
+ *   which might only be initialized later if the cache is in batch mode
+ * - ngli_pgcraft_finalize() introspects the initialized program
+ */
+int ngli_pgcraft_craft_shaders(struct pgcraft *s, const struct pgcraft_params *params);
+int ngli_pgcraft_request_program(struct pgcraft *s, const struct pgcraft_params *params);
+int ngli_pgcraft_finalize(struct pgcraft *s);
+int ngli_pgcraft_supports_batching(const struct pgcraft *s);
+int ngli_pgcraft_get_batch_attribute_name(char *dst, size_t size, const struct pgcraft_uniform *uniform);
 int ngli_pgcraft_get_uniform_index(const struct pgcraft *s, const char *name, int stage);
 const struct darray *ngli_pgcraft_get_texture_infos(const struct pgcraft *s);
 const struct pgcraft_compat_info *ngli_pgcraft_get_compat_info(const struct pgcraft *s);
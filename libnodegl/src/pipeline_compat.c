@@ -19,18 +19,31 @@
  * under the License.
  */
 
+#include <string.h>
+
 #include "darray.h"
+#include "gpu_ctx.h"
+#include "log.h"
 #include "memory.h"
 #include "nodegl.h"
 #include "pipeline_compat.h"
 #include "type.h"
 
+/*
+ * When the uniforms are packed into uniform blocks, their values are kept in
+ * host memory and copied at each draw into memory sub-allocated from the
+ * per-frame uniform ring of the context, bound with a dynamic offset. This
+ * allows a pipeline to be drawn several times per frame with different values,
+ * and the frames in flight to never overwrite the values read by the previous
+ * ones. The uniforms mapped to push constants are directly forwarded to the
+ * pipeline which records them with the draw commands.
+ */
 struct pipeline_compat {
     struct gpu_ctx *gpu_ctx;
     struct pipeline *pipeline;
     const struct pgcraft_compat_info *compat_info;
-    struct buffer *ubuffers[NGLI_PROGRAM_SHADER_NB];
-    uint8_t *mapped_datas[NGLI_PROGRAM_SHADER_NB];
+    uint8_t *ublock_datas[NGLI_PROGRAM_SHADER_NB];
+    int ublock_indexes[NGLI_PROGRAM_SHADER_NB];
 };
 
 struct pipeline_compat *ngli_pipeline_compat_create(struct gpu_ctx *gpu_ctx)
@@ -46,7 +59,7 @@ static int get_pipeline_ubo_index(const struct pipeline_params *params, int bind
 {
     const struct pipeline_layout *layout = &params->layout;
     for (int i = 0; i < layout->nb_buffers; i++) {
-        if (layout->buffers_desc[i].type == NGLI_TYPE_UNIFORM_BUFFER &&
+        if (layout->buffers_desc[i].type == NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC &&
             layout->buffers_desc[i].stage == stage &&
             layout->buffers_desc[i].binding == binding) {
             return i;
@@ -55,40 +68,59 @@ static int get_pipeline_ubo_index(const struct pipeline_params *params, int bind
     return -1;
 }
 
-static int init_blocks_buffers(struct pipeline_compat *s, const struct pipeline_compat_params *params)
+static int init_blocks_datas(struct pipeline_compat *s, const struct pipeline_compat_params *params)
 {
-    struct gpu_ctx *gpu_ctx = s->gpu_ctx;
-
     for (int i = 0; i < NGLI_PROGRAM_SHADER_NB; i++) {
         const struct block *block = &s->compat_info->ublocks[i];
         if (!block->size)
             continue;
 
-        struct buffer *buffer = ngli_buffer_create(gpu_ctx);
-        if (!buffer)
+        s->ublock_datas[i] = ngli_calloc(1, block->size);
+        if (!s->ublock_datas[i])
             return NGL_ERROR_MEMORY;
-        s->ubuffers[i] = buffer;
 
-        int ret = ngli_buffer_init(buffer,
-                                   block->size,
-                                   NGLI_BUFFER_USAGE_DYNAMIC_BIT |
-                                   NGLI_BUFFER_USAGE_UNIFORM_BUFFER_BIT |
-                                   NGLI_BUFFER_USAGE_MAP_WRITE);
+        const struct pipeline_params *pipeline_params = params->params;
+        s->ublock_indexes[i] = get_pipeline_ubo_index(pipeline_params, s->compat_info->ubindings[i], i);
+    }
+
+    return 0;
+}
+
+static int upload_blocks_datas(struct pipeline_compat *s)
+{
+    if (!s->compat_info->use_ublocks)
+        return 0;
+
+    for (int i = 0; i < NGLI_PROGRAM_SHADER_NB; i++) {
+        const struct block *block = &s->compat_info->ublocks[i];
+        if (!block->size)
+            continue;
+
+        struct buffer *buffer;
+        int offset;
+        void *data;
+        int ret = ngli_gpu_ctx_get_uniform_memory(s->gpu_ctx, block->size, &buffer, &offset, &data);
         if (ret < 0)
             return ret;
 
-        ret = ngli_buffer_map(buffer, buffer->size, 0, (void **)&s->mapped_datas[i]);
+        memcpy(data, s->ublock_datas[i], block->size);
+
+        ret = ngli_pipeline_update_buffer(s->pipeline, s->ublock_indexes[i], buffer, offset, block->size);
         if (ret < 0)
             return ret;
-
-        const struct pipeline_params *pipeline_params = params->params;
-        const int index = get_pipeline_ubo_index(pipeline_params, s->compat_info->ubindings[i], i);
-        ngli_pipeline_update_buffer(s->pipeline, index, buffer, 0, buffer->size);
     }
 
     return 0;
 }
 
+static int prepare_exec(struct pipeline_compat *s)
+{
+    int ret = upload_blocks_datas(s);
+    if (ret < 0)
+        LOG(ERROR, "could not upload uniform blocks, skipping pipeline execution");
+    return ret;
+}
+
 int ngli_pipeline_compat_init(struct pipeline_compat *s, const struct pipeline_compat_params *params)
 {
     struct gpu_ctx *gpu_ctx = s->gpu_ctx;
@@ -107,7 +139,7 @@ int ngli_pipeline_compat_init(struct pipeline_compat *s, const struct pipeline_c
 
     s->compat_info = params->compat_info;
     if (s->compat_info->use_ublocks) {
-        ret = init_blocks_buffers(s, params);
+        ret = init_blocks_datas(s, params);
         if (ret < 0)
             return ret;
     }
@@ -130,11 +162,14 @@ int ngli_pipeline_compat_update_uniform(struct pipeline_compat *s, int index, co
 
     const int stage = index >> 16;
     const int field_index = index & 0xffff;
+    if (stage == NGLI_PGCRAFT_PUSH_CONSTANTS_STAGE)
+        return ngli_pipeline_update_uniform(s->pipeline, field_index, value);
+
     const struct block *block = &s->compat_info->ublocks[stage];
     const struct block_field *fields = ngli_darray_data(&block->fields);
     const struct block_field *field = &fields[field_index];
     if (value) {
-        uint8_t *dst = s->mapped_datas[stage] + field->offset;
+        uint8_t *dst = s->ublock_datas[stage] + field->offset;
         ngli_block_field_copy(field, dst, value);
     }
 
@@ -214,19 +249,31 @@ int ngli_pipeline_compat_update_buffer(struct pipeline_compat *s, int index, con
     return ngli_pipeline_update_buffer(s->pipeline, index, buffer, offset, size);
 }
 
-void ngli_pipeline_compat_draw(struct pipeline_compat *s, int nb_vertices, int nb_instances)
+int ngli_pipeline_compat_draw(struct pipeline_compat *s, int nb_vertices, int nb_instances)
 {
+    int ret = prepare_exec(s);
+    if (ret < 0)
+        return ret;
     ngli_pipeline_draw(s->pipeline, nb_vertices, nb_instances);
+    return 0;
 }
 
-void ngli_pipeline_compat_draw_indexed(struct pipeline_compat *s, const struct buffer *indices, int indices_format, int nb_indices, int nb_instances)
+int ngli_pipeline_compat_draw_indexed(struct pipeline_compat *s, const struct buffer *indices, int indices_format, int nb_indices, int nb_instances)
 {
+    int ret = prepare_exec(s);
+    if (ret < 0)
+        return ret;
     ngli_pipeline_draw_indexed(s->pipeline, indices, indices_format, nb_indices, nb_instances);
+    return 0;
 }
 
-void ngli_pipeline_compat_dispatch(struct pipeline_compat *s, int nb_group_x, int nb_group_y, int nb_group_z)
+int ngli_pipeline_compat_dispatch(struct pipeline_compat *s, int nb_group_x, int nb_group_y, int nb_group_z)
 {
+    int ret = prepare_exec(s);
+    if (ret < 0)
+        return ret;
     ngli_pipeline_dispatch(s->pipeline, nb_group_x, nb_group_y, nb_group_z);
+    return 0;
 }
 
 void ngli_pipeline_compat_freep(struct pipeline_compat **sp)
@@ -235,13 +282,7 @@ void ngli_pipeline_compat_freep(struct pipeline_compat **sp)
     if (!s)
         return;
     ngli_pipeline_freep(&s->pipeline);
-    if (s->compat_info && s->compat_info->use_ublocks) {
-        for (int i = 0; i < NGLI_PROGRAM_SHADER_NB; i++) {
-            if (s->ubuffers[i]) {
-                ngli_buffer_unmap(s->ubuffers[i]);
-                ngli_buffer_freep(&s->ubuffers[i]);
-            }
-        }
-    }
+    for (int i = 0; i < NGLI_PROGRAM_SHADER_NB; i++)
+        ngli_freep(&s->ublock_datas[i]);
     ngli_freep(sp);
 }
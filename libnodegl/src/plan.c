@@ -0,0 +1,545 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "gpu_ctx.h"
+#include "hmap.h"
+#include "internal.h"
+#include "log.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "plan.h"
+#include "rnode.h"
+#include "threadpool.h"
+
+void ngli_plan_init(struct plan *s)
+{
+    memset(s, 0, sizeof(*s));
+    ngli_darray_init(&s->update_ops, sizeof(struct plan_update_op), 0);
+    ngli_darray_init(&s->draw_ops, sizeof(struct plan_draw_op), 0);
+    ngli_darray_init(&s->cpu_nodes, sizeof(struct ngl_node *), 0);
+    ngli_darray_init(&s->batches, sizeof(struct batch *), 0);
+    ngli_darray_init(&s->activity_boundaries, sizeof(double), 0);
+    s->activity_interval = -1;
+}
+
+static int build_update_ops(struct plan *s, struct hmap *visited, struct ngl_node *node)
+{
+    /*
+     * A node reached a second time would be skipped by the recursive update
+     * since it has already been updated for the current time.
+     */
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)node);
+    if (ngli_hmap_get(visited, key))
+        return 0;
+    int ret = ngli_hmap_set(visited, key, node);
+    if (ret < 0)
+        return ret;
+
+    if (!node->cls->update)
+        return 0;
+
+    const int forward = node->cls->update == ngli_node_update_children;
+    const struct plan_update_op op = {.node = node, .forward = forward};
+    if (!ngli_darray_push(&s->update_ops, &op))
+        return NGL_ERROR_MEMORY;
+
+    if (!forward)
+        return 0;
+
+    const int op_index = ngli_darray_count(&s->update_ops) - 1;
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+        ret = build_update_ops(s, visited, children[i]);
+        if (ret < 0)
+            return ret;
+    }
+
+    struct plan_update_op *ops = ngli_darray_data(&s->update_ops);
+    ops[op_index].nb_sub_ops = ngli_darray_count(&s->update_ops) - op_index - 1;
+
+    return 0;
+}
+
+static int is_cpu_update(const struct ngl_node *node)
+{
+    const struct node_class *cls = node->cls;
+    return !cls->update ||
+           cls->update == ngli_node_update_children ||
+           (cls->flags & NGLI_NODE_FLAG_CPU_UPDATE);
+}
+
+/* Returns 1 if the whole subtree of the node can be updated on a worker thread */
+static int check_cpu_subtree(struct hmap *checked, struct ngl_node *node)
+{
+    static const int results[] = {0, 1};
+
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)node);
+    const int *result = ngli_hmap_get(checked, key);
+    if (result)
+        return *result;
+
+    int cpu_only = is_cpu_update(node);
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+        int ret = check_cpu_subtree(checked, children[i]);
+        if (ret < 0)
+            return ret;
+        cpu_only &= ret;
+    }
+
+    int ret = ngli_hmap_set(checked, key, (void *)&results[cpu_only]);
+    if (ret < 0)
+        return ret;
+    return cpu_only;
+}
+
+static int collect_cpu_nodes(struct plan *s, struct hmap *checked, struct hmap *visited,
+                             struct ngl_node *node)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)node);
+    if (ngli_hmap_get(visited, key))
+        return 0;
+    int ret = ngli_hmap_set(visited, key, node);
+    if (ret < 0)
+        return ret;
+
+    ret = check_cpu_subtree(checked, node);
+    if (ret < 0)
+        return ret;
+    if (ret && (node->cls->flags & NGLI_NODE_FLAG_CPU_UPDATE)) {
+        if (!ngli_darray_push(&s->cpu_nodes, &node))
+            return NGL_ERROR_MEMORY;
+        return 0;
+    }
+
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+        ret = collect_cpu_nodes(s, checked, visited, children[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+/*
+ * Two subtrees sharing a node can not be updated concurrently: they are
+ * discarded (set to NULL) and left to the regular update.
+ */
+static int discard_shared_cpu_nodes(struct hmap *owners, struct ngl_node **owner, struct ngl_node *node)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)node);
+    struct ngl_node **prev_owner = ngli_hmap_get(owners, key);
+    if (prev_owner) {
+        if (prev_owner != owner) {
+            *prev_owner = NULL;
+            *owner = NULL;
+        }
+        return 0;
+    }
+    int ret = ngli_hmap_set(owners, key, owner);
+    if (ret < 0)
+        return ret;
+
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+        ret = discard_shared_cpu_nodes(owners, owner, children[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int build_cpu_nodes(struct plan *s, struct ngl_node *scene)
+{
+    int ret = 0;
+    struct hmap *checked = ngli_hmap_create();
+    struct hmap *visited = ngli_hmap_create();
+    struct hmap *owners = ngli_hmap_create();
+    if (!checked || !visited || !owners) {
+        ret = NGL_ERROR_MEMORY;
+        goto end;
+    }
+
+    ret = collect_cpu_nodes(s, checked, visited, scene);
+    if (ret < 0)
+        goto end;
+
+    struct ngl_node **nodes = ngli_darray_data(&s->cpu_nodes);
+    const int nb_nodes = ngli_darray_count(&s->cpu_nodes);
+    for (int i = 0; i < nb_nodes; i++) {
+        ret = discard_shared_cpu_nodes(owners, &nodes[i], nodes[i]);
+        if (ret < 0)
+            goto end;
+    }
+
+    int nb_kept = 0;
+    for (int i = 0; i < nb_nodes; i++)
+        if (nodes[i])
+            nodes[nb_kept++] = nodes[i];
+
+    /* Not worth waking up the thread pool */
+    if (nb_kept < 2)
+        nb_kept = 0;
+
+    if (nb_kept < nb_nodes)
+        ngli_darray_remove_range(&s->cpu_nodes, nb_kept, nb_nodes - nb_kept);
+
+end:
+    ngli_hmap_freep(&owners);
+    ngli_hmap_freep(&visited);
+    ngli_hmap_freep(&checked);
+    return ret;
+}
+
+static int collect_activity_boundaries(struct plan *s, struct hmap *visited, struct ngl_node *node)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%p", (void *)node);
+    if (ngli_hmap_get(visited, key))
+        return 0;
+    int ret = ngli_hmap_set(visited, key, node);
+    if (ret < 0)
+        return ret;
+
+    if (node->cls->id == NGL_NODE_TIMERANGEFILTER) {
+        ret = ngli_node_timerangefilter_add_boundaries(node, &s->activity_boundaries);
+        if (ret < 0)
+            return ret;
+    }
+
+    struct ngl_node **children = ngli_darray_data(&node->children);
+    for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+        ret = collect_activity_boundaries(s, visited, children[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
+static int cmp_time(const void *a, const void *b)
+{
+    const double ta = *(const double *)a;
+    const double tb = *(const double *)b;
+    return (ta > tb) - (ta < tb);
+}
+
+static int build_activity_boundaries(struct plan *s, struct ngl_node *scene)
+{
+    struct hmap *visited = ngli_hmap_create();
+    if (!visited)
+        return NGL_ERROR_MEMORY;
+    int ret = collect_activity_boundaries(s, visited, scene);
+    ngli_hmap_freep(&visited);
+    if (ret < 0)
+        return ret;
+
+    double *boundaries = ngli_darray_data(&s->activity_boundaries);
+    const int nb_boundaries = ngli_darray_count(&s->activity_boundaries);
+    if (!nb_boundaries)
+        return 0;
+    qsort(boundaries, nb_boundaries, sizeof(*boundaries), cmp_time);
+
+    int nb_unique = 1;
+    for (int i = 1; i < nb_boundaries; i++)
+        if (boundaries[i] != boundaries[nb_unique - 1])
+            boundaries[nb_unique++] = boundaries[i];
+    ngli_darray_remove_range(&s->activity_boundaries, nb_unique, nb_boundaries - nb_unique);
+
+    return 0;
+}
+
+static int build_draw_ops(struct plan *s, struct ngl_node *node, struct rnode *rnode)
+{
+    if (node->cls->id == NGL_NODE_GROUP) {
+        /* Mirror group_draw(): one rnode per child, created by group_prepare() */
+        struct rnode *rnodes = ngli_darray_data(&rnode->children);
+        struct ngl_node **children = ngli_darray_data(&node->children);
+        const int *draw_order = ngli_node_group_get_draw_order(node);
+        ngli_assert(ngli_darray_count(&rnode->children) == ngli_darray_count(&node->children));
+        for (int i = 0; i < ngli_darray_count(&node->children); i++) {
+            const int index = draw_order ? draw_order[i] : i;
+            int ret = build_draw_ops(s, children[index], &rnodes[index]);
+            if (ret < 0)
+                return ret;
+        }
+        return 0;
+    }
+
+    if (!node->cls->draw)
+        return 0;
+
+    const struct plan_draw_op op = {.node = node, .rnode = rnode};
+    if (!ngli_darray_push(&s->draw_ops, &op))
+        return NGL_ERROR_MEMORY;
+
+    return 0;
+}
+
+static int create_batch(struct plan *s, int op_index, int nb_ops)
+{
+    struct plan_draw_op *ops = ngli_darray_data(&s->draw_ops);
+
+    struct batch_item *items = ngli_calloc(nb_ops, sizeof(*items));
+    if (!items)
+        return NGL_ERROR_MEMORY;
+    for (int i = 0; i < nb_ops; i++) {
+        items[i].node  = ops[op_index + i].node;
+        items[i].rnode = ops[op_index + i].rnode;
+    }
+
+    struct batch *batch = ngli_batch_create(s->ctx);
+    if (!batch) {
+        ngli_freep(&items);
+        return NGL_ERROR_MEMORY;
+    }
+
+    int ret = ngli_batch_init(batch, items, nb_ops);
+    ngli_freep(&items);
+    if (ret < 0) {
+        ngli_batch_freep(&batch);
+        if (ret == NGL_ERROR_MEMORY)
+            return ret;
+        /* Batching is only an optimization */
+        LOG(DEBUG, "could not batch the draws of %s and the %d following nodes",
+            ops[op_index].node->label, nb_ops - 1);
+        return 0;
+    }
+
+    if (!ngli_darray_push(&s->batches, &batch)) {
+        ngli_batch_freep(&batch);
+        return NGL_ERROR_MEMORY;
+    }
+
+    ops[op_index].batch = batch;
+    ops[op_index].nb_batched_ops = nb_ops;
+    return 0;
+}
+
+static int build_batches(struct plan *s)
+{
+    struct gpu_ctx *gpu_ctx = s->ctx->gpu_ctx;
+    if (!(gpu_ctx->features & NGLI_FEATURE_INSTANCED_DRAW))
+        return 0;
+
+    const struct plan_draw_op *ops = ngli_darray_data(&s->draw_ops);
+    const int nb_ops = ngli_darray_count(&s->draw_ops);
+    int i = 0;
+    while (i < nb_ops) {
+        const struct batch_item ref = {.node = ops[i].node, .rnode = ops[i].rnode};
+        int nb_batched_ops = 1;
+        if (ngli_batch_get_render(ref.node)) {
+            while (i + nb_batched_ops < nb_ops) {
+                const struct plan_draw_op *op = &ops[i + nb_batched_ops];
+                const struct batch_item item = {.node = op->node, .rnode = op->rnode};
+                if (!ngli_batch_check_items(&ref, &item))
+                    break;
+                nb_batched_ops++;
+            }
+        }
+
+        if (nb_batched_ops > 1) {
+            int ret = create_batch(s, i, nb_batched_ops);
+            if (ret < 0)
+                return ret;
+        }
+        i += nb_batched_ops;
+    }
+    return 0;
+}
+
+static void reset_batches(struct plan *s)
+{
+    struct batch **batches = ngli_darray_data(&s->batches);
+    for (int i = 0; i < ngli_darray_count(&s->batches); i++)
+        ngli_batch_freep(&batches[i]);
+    ngli_darray_clear(&s->batches);
+}
+
+int ngli_plan_build(struct plan *s, struct ngl_ctx *ctx, struct ngl_node *scene)
+{
+    reset_batches(s);
+    ngli_darray_clear(&s->update_ops);
+    ngli_darray_clear(&s->draw_ops);
+    ngli_darray_clear(&s->cpu_nodes);
+    ngli_darray_clear(&s->activity_boundaries);
+    s->activity_interval = -1;
+    s->ctx = ctx;
+
+    struct hmap *visited = ngli_hmap_create();
+    if (!visited)
+        return NGL_ERROR_MEMORY;
+
+    int ret;
+    if ((ret = build_update_ops(s, visited, scene)) < 0 ||
+        (ctx->config.parallel_update && (ret = build_cpu_nodes(s, scene)) < 0) ||
+        (ret = build_draw_ops(s, scene, &ctx->rnode)) < 0 ||
+        (ret = build_batches(s)) < 0 ||
+        (ret = build_activity_boundaries(s, scene)) < 0) {
+        reset_batches(s);
+        ngli_darray_clear(&s->update_ops);
+        ngli_darray_clear(&s->draw_ops);
+        ngli_darray_clear(&s->cpu_nodes);
+        ngli_darray_clear(&s->activity_boundaries);
+        ngli_hmap_freep(&visited);
+        return ret;
+    }
+
+    ngli_hmap_freep(&visited);
+
+    LOG(DEBUG, "execution plan of %s: %d update ops, %d draw ops, %d batches, %d parallel CPU updates, "
+        "%d activity boundaries",
+        scene->label, ngli_darray_count(&s->update_ops), ngli_darray_count(&s->draw_ops),
+        ngli_darray_count(&s->batches), ngli_darray_count(&s->cpu_nodes),
+        ngli_darray_count(&s->activity_boundaries));
+
+    return 0;
+}
+
+static int update_cpu_node(void *user_arg, int index)
+{
+    struct plan *s = user_arg;
+    struct ngl_node **nodes = ngli_darray_data(&s->cpu_nodes);
+    struct ngl_node *node = nodes[index];
+    const double t = s->cpu_update_time;
+
+    /* Inactive nodes may have been released and are not updated anyway */
+    if (!node->is_active)
+        return 0;
+
+    return ngli_node_update(node, t);
+}
+
+int ngli_plan_update(struct plan *s, double t)
+{
+    const int nb_cpu_nodes = ngli_darray_count(&s->cpu_nodes);
+    if (nb_cpu_nodes) {
+        s->cpu_update_time = t;
+        int ret = ngli_threadpool_execute(s->ctx->threadpool, update_cpu_node, s, nb_cpu_nodes);
+        if (ret < 0)
+            return ret;
+    }
+
+    const struct plan_update_op *ops = ngli_darray_data(&s->update_ops);
+    for (int i = 0; i < ngli_darray_count(&s->update_ops); i++) {
+        const struct plan_update_op *op = &ops[i];
+        struct ngl_node *node = op->node;
+
+        if (op->forward) {
+            /* The whole subtree of an up-to-date time invariant node is skipped */
+            if (ngli_node_mark_updated(node, t))
+                i += op->nb_sub_ops;
+            continue;
+        }
+
+        int ret = ngli_node_update(node, t);
+        if (ret < 0) {
+            /*
+             * The containers have been marked up-to-date before their
+             * children were updated, so they must not skip them next time.
+             */
+            for (int j = 0; j < i; j++)
+                if (ops[j].forward)
+                    ops[j].node->is_up_to_date = 0;
+            return ret;
+        }
+    }
+
+    struct batch **batches = ngli_darray_data(&s->batches);
+    for (int i = 0; i < ngli_darray_count(&s->batches); i++) {
+        int ret = ngli_batch_update(batches[i]);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
+void ngli_plan_draw(struct plan *s)
+{
+    struct ngl_ctx *ctx = s->ctx;
+    struct rnode *rnode_pos = ctx->rnode_pos;
+
+    const struct plan_draw_op *ops = ngli_darray_data(&s->draw_ops);
+    for (int i = 0; i < ngli_darray_count(&s->draw_ops); i++) {
+        const struct plan_draw_op *op = &ops[i];
+        if (op->batch) {
+            ngli_ctx_defer_error(ctx, ngli_batch_draw(op->batch));
+            i += op->nb_batched_ops - 1;
+            continue;
+        }
+        ctx->rnode_pos = op->rnode;
+        ngli_node_draw(op->node);
+    }
+
+    ctx->rnode_pos = rnode_pos;
+}
+
+/* Number of boundaries lower or equal to t */
+static int get_activity_interval(const struct plan *s, double t)
+{
+    const double *boundaries = ngli_darray_data(&s->activity_boundaries);
+    int lo = 0;
+    int hi = ngli_darray_count(&s->activity_boundaries);
+    while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (boundaries[mid] <= t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+int ngli_plan_needs_visit(struct plan *s, double t)
+{
+    const int interval = get_activity_interval(s, t);
+    const int needs_visit = s->activity_interval < 0 ||
+                            s->activity_interval != interval ||
+                            t < s->activity_time;
+    s->activity_interval = interval;
+    s->activity_time = t;
+    return needs_visit;
+}
+
+void ngli_plan_invalidate_activity(struct plan *s)
+{
+    s->activity_interval = -1;
+}
+
+void ngli_plan_reset(struct plan *s)
+{
+    reset_batches(s);
+    ngli_darray_reset(&s->batches);
+    ngli_darray_reset(&s->update_ops);
+    ngli_darray_reset(&s->draw_ops);
+    ngli_darray_reset(&s->cpu_nodes);
+    ngli_darray_reset(&s->activity_boundaries);
+    memset(s, 0, sizeof(*s));
+}
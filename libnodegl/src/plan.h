@@ -0,0 +1,102 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef PLAN_H
+#define PLAN_H
+
+#include "darray.h"
+
+struct ngl_node;
+struct ngl_ctx;
+struct rnode;
+struct batch;
+
+/*
+ * Linear execution plan of a prepared scene, replacing the recursive
+ * update and draw traversals of its top levels.
+ *
+ * The container nodes (the nodes which only forward the update to their
+ * children, and the groups which only select the rnode of each child during
+ * the draw) are flattened: their children are inlined in the plan, in the
+ * order the recursion would have reached them. Every other node is kept as a
+ * single operation executing its own subtree, since it may filter it (time
+ * ranges, user switches, ...), remap its time, or wrap its draw (transforms,
+ * render targets, ...).
+ *
+ * The graph of a scene can not be modified once attached to a context, so the
+ * plan only needs to be built when the scene is set.
+ *
+ * With ngl_config.parallel_update, the largest subtrees only made of nodes
+ * flagged with NGLI_NODE_FLAG_CPU_UPDATE (and not sharing any node between
+ * each others) are collected as well: the active ones are updated concurrently
+ * on the thread pool of the context before the update operations, which then
+ * consider them already up-to-date for the current time.
+ *
+ * The plan also indexes the times at which the activity of the nodes may change
+ * (the boundaries of the time range filters): the scene only needs to be
+ * visited again to release and prefetch its nodes when the time crosses one of
+ * them or goes backward, or when a live change may affect it.
+ *
+ * When the GPU supports instanced draws, the consecutive draw operations of
+ * compatible Render nodes (see batch.h) are merged into batches, updated after
+ * the update operations and drawn with a single draw call.
+ */
+
+struct plan_update_op {
+    struct ngl_node *node;
+    int forward;    /* container node, its children are the next operations */
+    int nb_sub_ops; /* number of operations following a container for its children */
+};
+
+struct plan_draw_op {
+    struct ngl_node *node;
+    struct rnode *rnode;
+    struct batch *batch; /* draws this operation and the following ones of the batch at once */
+    int nb_batched_ops;
+};
+
+struct plan {
+    struct ngl_ctx *ctx;
+    struct darray update_ops; /* plan_update_op */
+    struct darray draw_ops;   /* plan_draw_op */
+    struct darray cpu_nodes;  /* ngl_node pointer, roots of the parallel CPU updates */
+    struct darray batches;    /* batch pointer */
+    double cpu_update_time;   /* time of the running parallel CPU update */
+    struct darray activity_boundaries; /* double, sorted and unique */
+    int activity_interval;    /* boundaries interval of the last visit, -1 to force a new visit */
+    double activity_time;     /* time of the last activity check */
+};
+
+void ngli_plan_init(struct plan *s);
+int ngli_plan_build(struct plan *s, struct ngl_ctx *ctx, struct ngl_node *scene);
+int ngli_plan_update(struct plan *s, double t);
+void ngli_plan_draw(struct plan *s);
+
+/*
+ * Return whether the scene must be visited to check the activity of its nodes
+ * at time t, and record t as the time of the last check.
+ */
+int ngli_plan_needs_visit(struct plan *s, double t);
+void ngli_plan_invalidate_activity(struct plan *s);
+
+void ngli_plan_reset(struct plan *s);
+
+#endif
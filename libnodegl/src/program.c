@@ -32,6 +32,24 @@ int ngli_program_init(struct program *s, const struct program_params *params)
     return s->gpu_ctx->cls->program_init(s, params);
 }
 
+int ngli_program_init_batch(struct program **programs, const struct program_params *params,
+                            int nb_programs, struct threadpool *threadpool)
+{
+    if (!nb_programs)
+        return 0;
+
+    const struct gpu_ctx_class *cls = programs[0]->gpu_ctx->cls;
+    if (cls->program_init_batch)
+        return cls->program_init_batch(programs, params, nb_programs, threadpool);
+
+    for (int i = 0; i < nb_programs; i++) {
+        int ret = cls->program_init(programs[i], &params[i]);
+        if (ret < 0)
+            return ret;
+    }
+    return 0;
+}
+
 void ngli_program_freep(struct program **sp)
 {
     if (!*sp)
@@ -25,6 +25,7 @@
 #include "hmap.h"
 
 struct gpu_ctx;
+struct threadpool;
 
 #define MAX_ID_LEN 128
 
@@ -56,6 +57,15 @@ struct program {
 
 struct program *ngli_program_create(struct gpu_ctx *gpu_ctx);
 int ngli_program_init(struct program *s, const struct program_params *params);
+
+/*
+ * Initialize nb_programs programs at once (programs[i] with params[i]), which
+ * allows the backend to compile them concurrently. The first error is
+ * returned, in which case the state of every program is undefined and they
+ * must all be freed.
+ */
+int ngli_program_init_batch(struct program **programs, const struct program_params *params,
+                            int nb_programs, struct threadpool *threadpool);
 void ngli_program_freep(struct program **sp);
 
 #endif
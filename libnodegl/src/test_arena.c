@@ -0,0 +1,66 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "utils.h"
+
+#define NB_CHUNKS 10000
+
+int main(void)
+{
+    struct arena *arena = ngli_arena_create();
+    ngli_assert(arena);
+    int ret = ngli_arena_init(arena, 4096);
+    ngli_assert(ret == 0);
+
+    uint8_t *chunks[NB_CHUNKS];
+    for (int i = 0; i < NB_CHUNKS; i++) {
+        /* Include chunks larger than the blocks */
+        const size_t size = i % 1000 == 0 ? 10000 : 1 + i % 100;
+        chunks[i] = ngli_arena_alloc(arena, size);
+        ngli_assert(chunks[i]);
+        ngli_assert(((uintptr_t)chunks[i] & (NGLI_ALIGN_VAL - 1)) == 0);
+        for (size_t j = 0; j < size; j++) {
+            ngli_assert(chunks[i][j] == 0);
+            chunks[i][j] = (uint8_t)i;
+        }
+    }
+
+    /* The chunks must not overlap */
+    for (int i = 0; i < NB_CHUNKS; i++) {
+        const size_t size = i % 1000 == 0 ? 10000 : 1 + i % 100;
+        for (size_t j = 0; j < size; j++)
+            ngli_assert(chunks[i][j] == (uint8_t)i);
+    }
+
+    struct arena *ref = ngli_arena_ref(arena);
+    ngli_arena_unrefp(&arena);
+    ngli_assert(!arena);
+    ngli_assert(ngli_arena_alloc(ref, 16));
+    ngli_arena_unrefp(&ref);
+    ngli_assert(!ref);
+
+    printf("arena checks passed\n");
+    return 0;
+}
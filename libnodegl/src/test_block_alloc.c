@@ -0,0 +1,154 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "block_alloc.h"
+#include "nodegl.h"
+#include "utils.h"
+
+#define BLOCK_SIZE 1024
+#define NB_POOLS   2
+
+struct heap {
+    int nb_blocks;
+    int fail;
+};
+
+static int block_create(void *user_arg, int pool, uint64_t size, void **memoryp, uint8_t **mapped_datap)
+{
+    struct heap *heap = user_arg;
+    if (heap->fail)
+        return NGL_ERROR_MEMORY;
+    uint8_t *data = malloc(size);
+    if (!data)
+        return NGL_ERROR_MEMORY;
+    heap->nb_blocks++;
+    *memoryp = data;
+    /* Only the blocks of the first pool are mapped */
+    *mapped_datap = pool == 0 ? data : NULL;
+    return 0;
+}
+
+static void block_destroy(void *user_arg, void *memory, uint8_t *mapped_data)
+{
+    struct heap *heap = user_arg;
+    free(memory);
+    heap->nb_blocks--;
+}
+
+static void check_stats(const struct block_alloc *s, uint64_t used, uint64_t reserved,
+                        int nb_allocations, int nb_device_allocations)
+{
+    const struct block_alloc_stats *stats = &s->stats;
+    ngli_assert(stats->used == used);
+    ngli_assert(stats->reserved == reserved);
+    ngli_assert(stats->nb_allocations == nb_allocations);
+    ngli_assert(stats->nb_device_allocations == nb_device_allocations);
+}
+
+int main(void)
+{
+    struct heap heap = {0};
+    const struct block_alloc_params params = {
+        .nb_pools      = NB_POOLS,
+        .block_size    = BLOCK_SIZE,
+        .user_arg      = &heap,
+        .block_create  = block_create,
+        .block_destroy = block_destroy,
+    };
+    struct block_alloc s;
+    int ret = ngli_block_alloc_init(&s, &params);
+    ngli_assert(ret == 0);
+    check_stats(&s, 0, 0, 0, 0);
+
+    /* Small allocations are packed in the same block with their alignment */
+    struct block_alloc_allocation a, b, c;
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, 100, 1, 0, &a) == 0);
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, 100, 64, 0, &b) == 0);
+    ngli_assert(a.offset == 0 && b.offset == 128);
+    ngli_assert(a.memory == b.memory);
+    ngli_assert(a.mapped_data && b.mapped_data == a.mapped_data + 128);
+    check_stats(&s, 200, BLOCK_SIZE, 2, 1);
+
+    /* Pools never share blocks */
+    ngli_assert(ngli_block_alloc_alloc(&s, 1, 100, 1, 0, &c) == 0);
+    ngli_assert(c.memory != a.memory && !c.mapped_data);
+    check_stats(&s, 300, 2 * BLOCK_SIZE, 3, 2);
+    ngli_block_alloc_free(&s, &c);
+    ngli_assert(!c.block);
+
+    /* Large and explicitly dedicated allocations get their own block */
+    struct block_alloc_allocation large, dedicated;
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, BLOCK_SIZE, 1, 0, &large) == 0);
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, 10, 1, 1, &dedicated) == 0);
+    ngli_assert(large.offset == 0 && dedicated.offset == 0);
+    check_stats(&s, 200 + BLOCK_SIZE + 10, 3 * BLOCK_SIZE + 10, 4, 4);
+    ngli_block_alloc_free(&s, &large);
+    ngli_block_alloc_free(&s, &dedicated);
+    check_stats(&s, 200, 2 * BLOCK_SIZE, 2, 2);
+
+    /* Released ranges are merged and reused (first fit) */
+    ngli_block_alloc_free(&s, &a);
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, 128, 1, 0, &a) == 0);
+    ngli_assert(a.offset == 0);
+    check_stats(&s, 228, 2 * BLOCK_SIZE, 2, 2);
+
+    /* A new block is created when the existing ones are full */
+    struct block_alloc_allocation d, e;
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, BLOCK_SIZE / 2, 1, 0, &d) == 0);
+    ngli_assert(d.memory == a.memory && d.offset == 228);
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, BLOCK_SIZE / 2, 1, 0, &e) == 0);
+    ngli_assert(e.memory != a.memory && e.offset == 0);
+    check_stats(&s, 228 + BLOCK_SIZE, 3 * BLOCK_SIZE, 4, 3);
+
+    /* One empty block is kept per pool, the others are released */
+    ngli_block_alloc_free(&s, &e);
+    check_stats(&s, 228 + BLOCK_SIZE / 2, 3 * BLOCK_SIZE, 3, 3);
+    ngli_block_alloc_free(&s, &a);
+    ngli_block_alloc_free(&s, &b);
+    ngli_block_alloc_free(&s, &d);
+    check_stats(&s, 0, 2 * BLOCK_SIZE, 0, 2);
+    ngli_assert(heap.nb_blocks == 2);
+
+    /* The kept block is reused without any new block creation */
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, 64, 1, 0, &a) == 0);
+    ngli_assert(ngli_block_alloc_alloc(&s, 1, 64, 1, 0, &c) == 0);
+    check_stats(&s, 128, 2 * BLOCK_SIZE, 2, 2);
+    ngli_assert(heap.nb_blocks == 2);
+
+    /* Block creation failures are forwarded and do not alter the statistics */
+    heap.fail = 1;
+    ngli_assert(ngli_block_alloc_alloc(&s, 0, BLOCK_SIZE, 1, 0, &d) == NGL_ERROR_MEMORY);
+    ngli_assert(!d.block);
+    check_stats(&s, 128, 2 * BLOCK_SIZE, 2, 2);
+    heap.fail = 0;
+
+    ngli_block_alloc_free(&s, &a);
+    ngli_block_alloc_free(&s, &c);
+    ngli_block_alloc_reset(&s);
+    ngli_assert(heap.nb_blocks == 0);
+
+    printf("block allocator checks passed\n");
+    return 0;
+}
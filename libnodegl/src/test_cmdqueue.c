@@ -0,0 +1,138 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+
+#include "cmdqueue.h"
+#include "nodegl.h"
+#include "pthread_compat.h"
+#include "utils.h"
+
+#define NB_PRODUCERS 4
+#define NB_CMDS      10000
+#define CAPACITY     64
+
+struct cmd {
+    int producer;
+    int index;
+};
+
+static int is_same_producer(const void *queued_cmd, const void *cmd)
+{
+    const struct cmd *a = queued_cmd;
+    const struct cmd *b = cmd;
+    return a->producer == b->producer;
+}
+
+struct producer {
+    struct cmdqueue *queue;
+    int id;
+};
+
+static void *producer_thread(void *arg)
+{
+    struct producer *producer = arg;
+    for (int i = 0; i < NB_CMDS; i++) {
+        const struct cmd cmd = {.producer = producer->id, .index = i};
+        while (ngli_cmdqueue_push(producer->queue, &cmd) == NGL_ERROR_LIMIT_EXCEEDED)
+            ;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    struct cmdqueue *queue = ngli_cmdqueue_create();
+    ngli_assert(queue);
+    int ret = ngli_cmdqueue_init(queue, sizeof(struct cmd), CAPACITY);
+    ngli_assert(ret == 0);
+
+    /* Single thread: FIFO order and capacity */
+    struct cmd cmd;
+    ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 0);
+    for (int i = 0; i < CAPACITY; i++) {
+        cmd = (struct cmd){.index = i};
+        ngli_assert(ngli_cmdqueue_push(queue, &cmd) == 0);
+    }
+    ngli_assert(ngli_cmdqueue_push(queue, &cmd) == NGL_ERROR_LIMIT_EXCEEDED);
+    for (int i = 0; i < CAPACITY; i++) {
+        ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 1);
+        ngli_assert(cmd.index == i);
+    }
+    ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 0);
+
+    /* Replaced commands keep their position in the queue */
+    struct cmd old_cmd;
+    for (int i = 0; i < 3; i++) {
+        cmd = (struct cmd){.producer = i, .index = 0};
+        ngli_assert(ngli_cmdqueue_replace_or_push(queue, &cmd, is_same_producer, &old_cmd) == 0);
+    }
+    cmd = (struct cmd){.producer = 1, .index = 1};
+    ngli_assert(ngli_cmdqueue_replace_or_push(queue, &cmd, is_same_producer, &old_cmd) == 1);
+    ngli_assert(old_cmd.producer == 1 && old_cmd.index == 0);
+    for (int i = 0; i < 3; i++) {
+        ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 1);
+        ngli_assert(cmd.producer == i && cmd.index == (i == 1));
+    }
+    ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 0);
+
+    /* A full queue still accepts replacements */
+    for (int i = 0; i < CAPACITY; i++) {
+        cmd = (struct cmd){.producer = i, .index = 0};
+        ngli_assert(ngli_cmdqueue_replace_or_push(queue, &cmd, is_same_producer, &old_cmd) == 0);
+    }
+    cmd = (struct cmd){.producer = CAPACITY, .index = 0};
+    ngli_assert(ngli_cmdqueue_replace_or_push(queue, &cmd, is_same_producer, &old_cmd) == NGL_ERROR_LIMIT_EXCEEDED);
+    cmd = (struct cmd){.producer = 0, .index = 1};
+    ngli_assert(ngli_cmdqueue_replace_or_push(queue, &cmd, is_same_producer, &old_cmd) == 1);
+    while (ngli_cmdqueue_pop(queue, &cmd))
+        ;
+
+    /* Multiple producers: every command is received once, in order per producer */
+    pthread_t threads[NB_PRODUCERS];
+    struct producer producers[NB_PRODUCERS];
+    for (int i = 0; i < NB_PRODUCERS; i++) {
+        producers[i] = (struct producer){.queue = queue, .id = i};
+        ret = pthread_create(&threads[i], NULL, producer_thread, &producers[i]);
+        ngli_assert(ret == 0);
+    }
+
+    int next_index[NB_PRODUCERS] = {0};
+    int nb_received = 0;
+    while (nb_received < NB_PRODUCERS * NB_CMDS) {
+        if (!ngli_cmdqueue_pop(queue, &cmd))
+            continue;
+        ngli_assert(cmd.producer >= 0 && cmd.producer < NB_PRODUCERS);
+        ngli_assert(cmd.index == next_index[cmd.producer]);
+        next_index[cmd.producer]++;
+        nb_received++;
+    }
+
+    for (int i = 0; i < NB_PRODUCERS; i++)
+        pthread_join(threads[i], NULL);
+    ngli_assert(ngli_cmdqueue_pop(queue, &cmd) == 0);
+
+    ngli_cmdqueue_freep(&queue);
+    ngli_assert(!queue);
+
+    printf("command queue checks passed\n");
+    return 0;
+}
@@ -24,6 +24,7 @@
 
 #include "image.h"
 #include "colorconv.h"
+#include "math_utils.h"
 
 static const struct {
     int val;
@@ -97,6 +98,70 @@ static int compare_matrices(const float *a, const float *b)
     return fail ? -fail : 0;
 }
 
+static void mat4_mul(float *dst, const float *a, const float *b)
+{
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            float v = 0.f;
+            for (int k = 0; k < 4; k++)
+                v += a[k * 4 + j] * b[i * 4 + k];
+            dst[i * 4 + j] = v;
+        }
+    }
+}
+
+/*
+ * The YCbCr to RGB matrix works on 8-bit normalized samples: limited range
+ * 10-bit samples are exactly 4 times their 8-bit counterparts so the scale
+ * only has to account for the different normalization factor.
+ */
+static int check_roundtrip(const struct color_info *cinfo, int depth)
+{
+    static const float identity[] = NGLI_MAT4_IDENTITY;
+    const float scale = ((1 << depth) - 1) / (255.f * (1 << (depth - 8)));
+    float rgb2yuv[4 * 4], yuv2rgb[4 * 4], mat[4 * 4];
+    if (ngli_colorconv_get_rgb_to_ycbcr_color_matrix(rgb2yuv, cinfo, depth) < 0 ||
+        ngli_colorconv_get_ycbcr_to_rgb_color_matrix(yuv2rgb, cinfo, scale) < 0)
+        return -1;
+    mat4_mul(mat, yuv2rgb, rgb2yuv);
+    return compare_matrices(mat, identity);
+}
+
+static int check_codes(const struct color_info *cinfo, int depth)
+{
+    const int video_range = cinfo->range != SXPLAYER_COL_RNG_FULL;
+    const float max_val = (1 << depth) - 1;
+    const float depth_scale = 1 << (depth - 8);
+    const float uv_mid = 1 << (depth - 1);
+    const struct {
+        float rgba[4];
+        float codes[3];
+    } refs[] = {
+        {{0.f, 0.f, 0.f, 1.f}, {video_range ?  16.f * depth_scale : 0.f,     uv_mid, uv_mid}},
+        {{1.f, 1.f, 1.f, 1.f}, {video_range ? 235.f * depth_scale : max_val, uv_mid, uv_mid}},
+    };
+
+    float mat[4 * 4];
+    if (ngli_colorconv_get_rgb_to_ycbcr_color_matrix(mat, cinfo, depth) < 0)
+        return -1;
+
+    int fail = 0;
+    for (int i = 0; i < NGLI_ARRAY_NB(refs); i++) {
+        for (int c = 0; c < 3; c++) {
+            float v = 0.f;
+            for (int k = 0; k < 4; k++)
+                v += mat[k * 4 + c] * refs[i].rgba[k];
+            const float code = v * max_val;
+            if (fabs(code - refs[i].codes[c]) > 1e-3) {
+                printf("%d-bit code %d of color #%d: got %g, expected %g\n",
+                       depth, c, i, code, refs[i].codes[c]);
+                fail++;
+            }
+        }
+    }
+    return fail ? -fail : 0;
+}
+
 int main(void)
 {
     int fail = 0;
@@ -114,6 +179,19 @@ int main(void)
                 printf(">>>> DIFF IS TOO HIGH <<<<\n\n");
                 fail++;
             }
+            if (check_roundtrip(&cinfo, 8) < 0) {
+                printf(">>>> ROUNDTRIP DIFF IS TOO HIGH <<<<\n\n");
+                fail++;
+            }
+            /* Full range 10-bit samples are not a multiple of the 8-bit ones */
+            if (cinfo.range != SXPLAYER_COL_RNG_FULL && check_roundtrip(&cinfo, 10) < 0) {
+                printf(">>>> 10-BIT ROUNDTRIP DIFF IS TOO HIGH <<<<\n\n");
+                fail++;
+            }
+            if (check_codes(&cinfo, 8) < 0 || check_codes(&cinfo, 10) < 0) {
+                printf(">>>> REFERENCE CODES MISMATCH <<<<\n\n");
+                fail++;
+            }
         }
     }
     return fail;
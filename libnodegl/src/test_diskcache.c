@@ -0,0 +1,276 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "diskcache.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "utils.h"
+
+#define ENTRY_SIZE 1000
+#define NB_ENTRIES 32
+#define NB_LRU_ENTRIES 8
+
+static char *make_tmp_dir(void)
+{
+#ifdef _WIN32
+    char base[MAX_PATH + 1];
+    if (!GetTempPathA(sizeof(base), base))
+        return NULL;
+    char *path = ngli_asprintf("%sngl-test-diskcache-%d", base, _getpid());
+    if (path && _mkdir(path) < 0)
+        ngli_freep(&path);
+    return path;
+#else
+    const char *base = getenv("TMPDIR");
+    char *path = ngli_asprintf("%s/ngl-test-diskcache-XXXXXX", base ? base : "/tmp");
+    if (path && !mkdtemp(path))
+        ngli_freep(&path);
+    return path;
+#endif
+}
+
+static int remove_dir(const char *path)
+{
+#ifdef _WIN32
+    return _rmdir(path);
+#else
+    return rmdir(path);
+#endif
+}
+
+static void make_key(struct diskcache_key *key, const char *domain, int i)
+{
+    ngli_diskcache_key_init(key, domain);
+    ngli_diskcache_key_update_int(key, i);
+}
+
+static char *get_entry_filename(const char *dir, const char *domain, int i)
+{
+    struct diskcache_key key;
+    make_key(&key, domain, i);
+    return ngli_asprintf("%s/%016" PRIx64 "%016" PRIx64 ".bin", dir, key.h[0], key.h[1]);
+}
+
+static int has_entry(const char *dir, const char *domain, int i)
+{
+    char *filename = get_entry_filename(dir, domain, i);
+    ngli_assert(filename);
+    FILE *fp = fopen(filename, "rb");
+    ngli_freep(&filename);
+    if (!fp)
+        return 0;
+    fclose(fp);
+    return 1;
+}
+
+static void remove_entries(const char *dir, const char *domain, int nb_entries)
+{
+    for (int i = 0; i < nb_entries; i++) {
+        char *filename = get_entry_filename(dir, domain, i);
+        ngli_assert(filename);
+        remove(filename);
+        ngli_freep(&filename);
+    }
+}
+
+static void fill_data(uint8_t *data, int i)
+{
+    for (int j = 0; j < ENTRY_SIZE; j++)
+        data[j] = (uint8_t)(i * 7 + j);
+}
+
+static void corrupt_entry(const char *dir, const char *domain, int i, long offset, int whence, int c)
+{
+    char *filename = get_entry_filename(dir, domain, i);
+    ngli_assert(filename);
+    FILE *fp = fopen(filename, "r+b");
+    ngli_assert(fp);
+    fseek(fp, offset, whence);
+    fputc(c, fp);
+    fclose(fp);
+    ngli_freep(&filename);
+}
+
+static void check_lru(const char *dir)
+{
+    /* Room for NB_LRU_ENTRIES entries and their (small) headers */
+    const int64_t max_size = NB_LRU_ENTRIES * (ENTRY_SIZE + 64);
+
+    struct diskcache *cache = ngli_diskcache_create();
+    ngli_assert(cache);
+    int ret = ngli_diskcache_init(cache, dir, max_size);
+    ngli_assert(ret == 0);
+
+    uint8_t ref[ENTRY_SIZE] = {0};
+    for (int i = 0; i < NB_LRU_ENTRIES; i++) {
+        struct diskcache_key key;
+        make_key(&key, "lru", i);
+        ret = ngli_diskcache_put(cache, &key, ref, sizeof(ref));
+        ngli_assert(ret == 0);
+    }
+
+    /*
+     * Accessing the oldest entry makes it the most recently used one, even
+     * if every entry has been written within the resolution of the file
+     * system clock
+     */
+    struct diskcache_key key;
+    make_key(&key, "lru", 0);
+    void *data;
+    size_t size;
+    ret = ngli_diskcache_get(cache, &key, &data, &size);
+    ngli_assert(ret == 0);
+    ngli_free(data);
+
+    make_key(&key, "lru", NB_LRU_ENTRIES);
+    ret = ngli_diskcache_put(cache, &key, ref, sizeof(ref));
+    ngli_assert(ret == 0);
+
+    ngli_assert(has_entry(dir, "lru", 0));
+    ngli_assert(!has_entry(dir, "lru", 1));
+    ngli_assert(has_entry(dir, "lru", NB_LRU_ENTRIES));
+
+    ngli_diskcache_freep(&cache);
+    remove_entries(dir, "lru", NB_LRU_ENTRIES + 1);
+}
+
+int main(void)
+{
+    char *dir = make_tmp_dir();
+    ngli_assert(dir);
+
+    /* Keys are sensitive to the domain and to every update */
+    struct diskcache_key k0, k1;
+    ngli_diskcache_key_init(&k0, "foo");
+    ngli_diskcache_key_init(&k1, "bar");
+    ngli_assert(memcmp(&k0, &k1, sizeof(k0)));
+    ngli_diskcache_key_init(&k1, "foo");
+    ngli_assert(!memcmp(&k0, &k1, sizeof(k0)));
+    ngli_diskcache_key_update_str(&k0, "ab");
+    ngli_diskcache_key_update_str(&k1, "a");
+    ngli_assert(memcmp(&k0, &k1, sizeof(k0)));
+
+    /* Room for about half of the entries */
+    const int64_t max_size = NB_ENTRIES / 2 * ENTRY_SIZE;
+
+    struct diskcache *cache = ngli_diskcache_create();
+    ngli_assert(cache);
+    int ret = ngli_diskcache_init(cache, dir, max_size);
+    ngli_assert(ret == 0);
+
+    uint8_t ref[ENTRY_SIZE];
+    for (int i = 0; i < NB_ENTRIES; i++) {
+        struct diskcache_key key;
+        make_key(&key, "test", i);
+
+        void *data;
+        size_t size;
+        ret = ngli_diskcache_get(cache, &key, &data, &size);
+        if (ret == 0)
+            ngli_free(data);
+
+        fill_data(ref, i);
+        ret = ngli_diskcache_put(cache, &key, ref, sizeof(ref));
+        ngli_assert(ret == 0);
+
+        /* An entry is always available right after being written */
+        ret = ngli_diskcache_get(cache, &key, &data, &size);
+        ngli_assert(ret == 0);
+        ngli_assert(size == sizeof(ref));
+        ngli_assert(!memcmp(data, ref, size));
+        ngli_free(data);
+    }
+
+    /* Eviction must have kept the cache below its maximum size */
+    int nb_hits = 0;
+    for (int i = 0; i < NB_ENTRIES; i++) {
+        struct diskcache_key key;
+        make_key(&key, "test", i);
+
+        void *data;
+        size_t size;
+        ret = ngli_diskcache_get(cache, &key, &data, &size);
+        if (ret == NGL_ERROR_NOT_FOUND)
+            continue;
+        ngli_assert(ret == 0);
+        fill_data(ref, i);
+        ngli_assert(size == sizeof(ref));
+        ngli_assert(!memcmp(data, ref, size));
+        ngli_free(data);
+        nb_hits++;
+    }
+    printf("%d/%d entries still cached\n", nb_hits, NB_ENTRIES);
+    ngli_assert(nb_hits > 0 && nb_hits < NB_ENTRIES / 2);
+
+    /*
+     * Corrupted entries (altered payload, extra data, altered header) are
+     * reported as missing and removed
+     */
+    const struct {
+        long offset;
+        int whence;
+    } corruptions[] = {
+        {-1, SEEK_END},
+        { 0, SEEK_END},
+        { 8, SEEK_SET},
+    };
+    for (int i = 0; i < NGLI_ARRAY_NB(corruptions); i++) {
+        const int index = NB_ENTRIES + i;
+        struct diskcache_key key;
+        make_key(&key, "test", index);
+        fill_data(ref, index);
+        ret = ngli_diskcache_put(cache, &key, ref, sizeof(ref));
+        ngli_assert(ret == 0);
+
+        corrupt_entry(dir, "test", index, corruptions[i].offset, corruptions[i].whence, 0xff);
+
+        void *data;
+        size_t size;
+        ret = ngli_diskcache_get(cache, &key, &data, &size);
+        ngli_assert(ret == NGL_ERROR_NOT_FOUND);
+        ngli_assert(!has_entry(dir, "test", index));
+    }
+
+    ngli_diskcache_freep(&cache);
+    ngli_assert(!cache);
+
+    remove_entries(dir, "test", NB_ENTRIES + NGLI_ARRAY_NB(corruptions));
+
+    check_lru(dir);
+
+    ngli_assert(remove_dir(dir) == 0);
+    ngli_freep(&dir);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "linear_alloc.h"
+#include "nodegl.h"
+#include "utils.h"
+
+#define CHUNK_SIZE 256
+#define TRIM_DELAY 4
+
+struct heap {
+    int nb_chunks;
+    int nb_allocs;
+    int fail;
+};
+
+static int chunk_alloc(void *user_arg, struct linear_alloc_chunk *chunk)
+{
+    struct heap *heap = user_arg;
+    if (heap->fail)
+        return NGL_ERROR_MEMORY;
+    chunk->data = malloc(chunk->size);
+    if (!chunk->data)
+        return NGL_ERROR_MEMORY;
+    heap->nb_chunks++;
+    heap->nb_allocs++;
+    return 0;
+}
+
+static void chunk_free(void *user_arg, struct linear_alloc_chunk *chunk)
+{
+    struct heap *heap = user_arg;
+    free(chunk->data);
+    heap->nb_chunks--;
+}
+
+static void run_frame(struct linear_alloc *s, int nb_allocs, int size)
+{
+    ngli_linear_alloc_begin(s);
+    for (int i = 0; i < nb_allocs; i++) {
+        struct linear_alloc_chunk *chunk;
+        int offset;
+        int ret = ngli_linear_alloc_get(s, size, &chunk, &offset);
+        ngli_assert(ret == 0);
+        ngli_assert(offset % 16 == 0);
+        ngli_assert(offset + size <= chunk->size);
+        memset(chunk->data + offset, 0xff, size);
+    }
+}
+
+int main(void)
+{
+    struct heap heap = {0};
+    const struct linear_alloc_params params = {
+        .chunk_size  = CHUNK_SIZE,
+        .alignment   = 16,
+        .trim_delay  = TRIM_DELAY,
+        .user_arg    = &heap,
+        .chunk_alloc = chunk_alloc,
+        .chunk_free  = chunk_free,
+    };
+    struct linear_alloc s;
+    ngli_linear_alloc_init(&s, &params);
+
+    /* Allocations are packed with the requested alignment */
+    ngli_linear_alloc_begin(&s);
+    struct linear_alloc_chunk *chunk;
+    int offset;
+    ngli_assert(ngli_linear_alloc_get(&s, 10, &chunk, &offset) == 0 && offset == 0);
+    ngli_assert(ngli_linear_alloc_get(&s, 10, &chunk, &offset) == 0 && offset == 16);
+    ngli_assert(heap.nb_chunks == 1);
+
+    /* Growth: a chunk is appended when the current one is full */
+    run_frame(&s, 8, 64);
+    ngli_assert(heap.nb_chunks == 2);
+
+    /* Reuse: the same workload does not allocate any new chunk */
+    const int nb_allocs = heap.nb_allocs;
+    for (int i = 0; i < TRIM_DELAY * 2; i++)
+        run_frame(&s, 8, 64);
+    ngli_assert(heap.nb_allocs == nb_allocs);
+    ngli_assert(heap.nb_chunks == 2);
+
+    /* Oversized allocations get a chunk large enough to hold them */
+    ngli_linear_alloc_begin(&s);
+    ngli_assert(ngli_linear_alloc_get(&s, CHUNK_SIZE * 3, &chunk, &offset) == 0);
+    ngli_assert(chunk->size == CHUNK_SIZE * 3 && offset == 0);
+    ngli_assert(heap.nb_chunks == 3);
+    run_frame(&s, 1, CHUNK_SIZE * 4);
+    ngli_assert(heap.nb_chunks == 4);
+
+    /*
+     * Trim: the chunks which have not been used for TRIM_DELAY frames are
+     * released at the beginning of the next one
+     */
+    for (int i = 0; i < TRIM_DELAY; i++)
+        run_frame(&s, 1, 64);
+    ngli_assert(heap.nb_chunks == 4);
+    run_frame(&s, 1, 64);
+    ngli_assert(heap.nb_chunks == 1);
+
+    /* A frame using every chunk restarts the idle period */
+    run_frame(&s, 8, 64);
+    ngli_assert(heap.nb_chunks == 2);
+    for (int i = 0; i < TRIM_DELAY - 1; i++)
+        run_frame(&s, 1, 64);
+    run_frame(&s, 8, 64);
+    for (int i = 0; i < TRIM_DELAY - 1; i++)
+        run_frame(&s, 1, 64);
+    ngli_assert(heap.nb_chunks == 2);
+
+    /* The chunks are trimmed to the peak usage of the idle period */
+    run_frame(&s, 8, 64);
+    run_frame(&s, 16, 64);
+    ngli_assert(heap.nb_chunks == 4);
+    for (int i = 0; i < TRIM_DELAY; i++)
+        run_frame(&s, i == 1 ? 8 : 1, 64);
+    ngli_assert(heap.nb_chunks == 4);
+    run_frame(&s, 1, 64);
+    ngli_assert(heap.nb_chunks == 2);
+
+    /* Chunk allocation failures are forwarded */
+    heap.fail = 1;
+    ngli_linear_alloc_begin(&s);
+    ngli_assert(ngli_linear_alloc_get(&s, 64, &chunk, &offset) == 0);
+    ngli_assert(ngli_linear_alloc_get(&s, CHUNK_SIZE * 2, &chunk, &offset) == NGL_ERROR_MEMORY);
+    heap.fail = 0;
+
+    ngli_linear_alloc_reset(&s);
+    ngli_assert(heap.nb_chunks == 0);
+
+    printf("linear allocator checks passed\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "nodegl.h"
+#include "threadpool.h"
+#include "utils.h"
+
+#define NB_JOBS 1000
+
+static int square_job(void *user_arg, int index)
+{
+    int *results = user_arg;
+    results[index] = index * index;
+    return 0;
+}
+
+static int failing_job(void *user_arg, int index)
+{
+    return index == NB_JOBS / 2 ? NGL_ERROR_GENERIC : 0;
+}
+
+static void check_pool(struct threadpool *pool)
+{
+    int results[NB_JOBS];
+
+    for (int run = 0; run < 10; run++) {
+        memset(results, 0xff, sizeof(results));
+        int ret = ngli_threadpool_execute(pool, square_job, results, NB_JOBS);
+        ngli_assert(ret == 0);
+        for (int i = 0; i < NB_JOBS; i++)
+            ngli_assert(results[i] == i * i);
+    }
+
+    int ret = ngli_threadpool_execute(pool, failing_job, NULL, NB_JOBS);
+    ngli_assert(ret == NGL_ERROR_GENERIC);
+
+    /* The pool must still be usable after a failure */
+    ret = ngli_threadpool_execute(pool, square_job, results, NB_JOBS);
+    ngli_assert(ret == 0);
+
+    ret = ngli_threadpool_execute(pool, square_job, results, 0);
+    ngli_assert(ret == 0);
+}
+
+int main(void)
+{
+    /* Without a pool, the jobs are executed sequentially */
+    check_pool(NULL);
+
+    static const int nb_threads[] = {0, 1, 3, 8};
+    for (int i = 0; i < NGLI_ARRAY_NB(nb_threads); i++) {
+        struct threadpool *pool = ngli_threadpool_create();
+        ngli_assert(pool);
+        int ret = ngli_threadpool_init(pool, nb_threads[i]);
+        ngli_assert(ret == 0);
+        check_pool(pool);
+        ngli_threadpool_freep(&pool);
+        ngli_assert(!pool);
+    }
+
+    printf("thread pool checks passed\n");
+    return 0;
+}
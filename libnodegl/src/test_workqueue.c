@@ -0,0 +1,85 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdio.h>
+
+#include "nodegl.h"
+#include "utils.h"
+#include "workqueue.h"
+
+#define NB_WORKS 100
+
+struct work_ctx {
+    int index;
+    int result;
+};
+
+static int square_work(void *user_arg)
+{
+    struct work_ctx *ctx = user_arg;
+    ctx->result = ctx->index * ctx->index;
+    return ctx->index == NB_WORKS / 2 ? NGL_ERROR_GENERIC : 0;
+}
+
+static void check_queue(struct workqueue *queue)
+{
+    struct work works[NB_WORKS] = {0};
+    struct work_ctx ctxs[NB_WORKS] = {0};
+
+    for (int run = 0; run < 10; run++) {
+        for (int i = 0; i < NB_WORKS; i++) {
+            ctxs[i] = (struct work_ctx){.index = i, .result = -1};
+            int ret = ngli_workqueue_push(queue, &works[i], square_work, &ctxs[i]);
+            ngli_assert(ret == 0);
+        }
+
+        /* Wait in reverse order so that some works are taken out of the queue */
+        for (int i = NB_WORKS - 1; i >= 0; i--) {
+            int ret = ngli_workqueue_wait(queue, &works[i]);
+            ngli_assert(ret == (i == NB_WORKS / 2 ? NGL_ERROR_GENERIC : 0));
+            ngli_assert(ctxs[i].result == i * i);
+        }
+    }
+}
+
+int main(void)
+{
+    /* Without a queue, the works are executed immediately */
+    check_queue(NULL);
+
+    struct workqueue *queue = ngli_workqueue_create();
+    ngli_assert(queue);
+    int ret = ngli_workqueue_init(queue);
+    ngli_assert(ret == 0);
+    check_queue(queue);
+
+    /* Works still queued are executed before the queue is destroyed */
+    struct work work = {0};
+    struct work_ctx ctx = {.index = 3, .result = -1};
+    ret = ngli_workqueue_push(queue, &work, square_work, &ctx);
+    ngli_assert(ret == 0);
+    ngli_workqueue_freep(&queue);
+    ngli_assert(!queue);
+    ngli_assert(ctx.result == 9);
+
+    printf("work queue checks passed\n");
+    return 0;
+}
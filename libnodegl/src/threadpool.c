@@ -0,0 +1,198 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "log.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "pthread_compat.h"
+#include "threadpool.h"
+#include "utils.h"
+
+struct threadpool {
+    pthread_t *threads;
+    int nb_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond_job;
+    pthread_cond_t cond_done;
+    int initialized;
+    int quit;
+
+    /* Current batch, protected by the lock */
+    threadpool_job_func_type job_func;
+    void *user_arg;
+    int nb_jobs;
+    int next_job;
+    int nb_done;
+    int ret;
+};
+
+static int get_nb_cpus(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    const long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return nb_cpus > 0 ? (int)nb_cpus : 1;
+#endif
+}
+
+/* Must be called with the lock held */
+static void run_jobs(struct threadpool *s)
+{
+    while (s->next_job < s->nb_jobs) {
+        const int index = s->next_job++;
+        const threadpool_job_func_type job_func = s->job_func;
+        void *user_arg = s->user_arg;
+        const int skip = s->ret < 0;
+
+        pthread_mutex_unlock(&s->lock);
+        const int ret = skip ? 0 : job_func(user_arg, index);
+        pthread_mutex_lock(&s->lock);
+
+        if (ret < 0 && s->ret >= 0)
+            s->ret = ret;
+        if (++s->nb_done == s->nb_jobs)
+            pthread_cond_signal(&s->cond_done);
+    }
+}
+
+static void *worker_thread(void *arg)
+{
+    struct threadpool *s = arg;
+
+    ngli_thread_set_name("ngl-pool");
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->quit && s->next_job >= s->nb_jobs)
+            pthread_cond_wait(&s->cond_job, &s->lock);
+        if (s->quit)
+            break;
+        run_jobs(s);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return NULL;
+}
+
+struct threadpool *ngli_threadpool_create(void)
+{
+    struct threadpool *s = ngli_calloc(1, sizeof(*s));
+    return s;
+}
+
+int ngli_threadpool_init(struct threadpool *s, int nb_threads)
+{
+    if (!nb_threads)
+        nb_threads = get_nb_cpus() - 1;
+    if (nb_threads <= 0)
+        return 0;
+
+    s->threads = ngli_calloc(nb_threads, sizeof(*s->threads));
+    if (!s->threads)
+        return NGL_ERROR_MEMORY;
+
+    if (pthread_mutex_init(&s->lock, NULL) ||
+        pthread_cond_init(&s->cond_job, NULL) ||
+        pthread_cond_init(&s->cond_done, NULL)) {
+        pthread_cond_destroy(&s->cond_job);
+        pthread_cond_destroy(&s->cond_done);
+        pthread_mutex_destroy(&s->lock);
+        return NGL_ERROR_EXTERNAL;
+    }
+    s->initialized = 1;
+
+    for (int i = 0; i < nb_threads; i++) {
+        if (pthread_create(&s->threads[i], NULL, worker_thread, s)) {
+            LOG(WARNING, "could only spawn %d/%d pool threads", i, nb_threads);
+            break;
+        }
+        s->nb_threads++;
+    }
+
+    return 0;
+}
+
+int ngli_threadpool_execute(struct threadpool *s, threadpool_job_func_type job_func, void *user_arg, int nb_jobs)
+{
+    if (!s || !s->nb_threads || nb_jobs <= 1) {
+        for (int i = 0; i < nb_jobs; i++) {
+            int ret = job_func(user_arg, i);
+            if (ret < 0)
+                return ret;
+        }
+        return 0;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    ngli_assert(s->next_job >= s->nb_jobs);
+    s->job_func = job_func;
+    s->user_arg = user_arg;
+    s->nb_jobs  = nb_jobs;
+    s->next_job = 0;
+    s->nb_done  = 0;
+    s->ret      = 0;
+    pthread_cond_broadcast(&s->cond_job);
+
+    run_jobs(s);
+    while (s->nb_done < s->nb_jobs)
+        pthread_cond_wait(&s->cond_done, &s->lock);
+
+    const int ret = s->ret;
+    s->job_func = NULL;
+    s->user_arg = NULL;
+    s->nb_jobs  = 0;
+    s->next_job = 0;
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+void ngli_threadpool_freep(struct threadpool **sp)
+{
+    struct threadpool *s = *sp;
+    if (!s)
+        return;
+
+    if (s->initialized) {
+        pthread_mutex_lock(&s->lock);
+        s->quit = 1;
+        pthread_cond_broadcast(&s->cond_job);
+        pthread_mutex_unlock(&s->lock);
+
+        for (int i = 0; i < s->nb_threads; i++)
+            pthread_join(s->threads[i], NULL);
+
+        pthread_cond_destroy(&s->cond_job);
+        pthread_cond_destroy(&s->cond_done);
+        pthread_mutex_destroy(&s->lock);
+    }
+
+    ngli_freep(&s->threads);
+    ngli_freep(sp);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+/*
+ * Fixed set of worker threads executing batches of independent jobs. The
+ * thread submitting a batch takes part in its execution and only returns once
+ * every job of the batch is done.
+ */
+
+typedef int (*threadpool_job_func_type)(void *user_arg, int index);
+
+struct threadpool;
+
+struct threadpool *ngli_threadpool_create(void);
+
+/*
+ * Spawn nb_threads worker threads, or one less than the number of online CPUs
+ * if nb_threads is 0.
+ */
+int ngli_threadpool_init(struct threadpool *s, int nb_threads);
+
+/*
+ * Call job_func(user_arg, i) for every i in [0,nb_jobs) and wait for their
+ * completion. The return value is the first error raised by a job (jobs
+ * starting after a failure are skipped), or 0. A NULL pool executes the jobs
+ * sequentially in the calling thread.
+ */
+int ngli_threadpool_execute(struct threadpool *s, threadpool_job_func_type job_func, void *user_arg, int nb_jobs);
+
+void ngli_threadpool_freep(struct threadpool **sp);
+
+#endif
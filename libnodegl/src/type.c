@@ -48,6 +48,7 @@ static const char * const type_map[NGLI_TYPE_NB] = {
     [NGLI_TYPE_IMAGE_3D]                    = "image3D",
     [NGLI_TYPE_IMAGE_2D_ARRAY]              = "image2DArray",
     [NGLI_TYPE_UNIFORM_BUFFER]              = "uniform",
+    [NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC]      = "uniform",
     [NGLI_TYPE_STORAGE_BUFFER]              = "buffer",
 };
 
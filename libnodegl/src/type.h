@@ -49,6 +49,7 @@ enum {
     NGLI_TYPE_IMAGE_2D_ARRAY,
     NGLI_TYPE_IMAGE_3D,
     NGLI_TYPE_UNIFORM_BUFFER,
+    NGLI_TYPE_UNIFORM_BUFFER_DYNAMIC,
     NGLI_TYPE_STORAGE_BUFFER,
     NGLI_TYPE_NB
 };
@@ -264,6 +264,14 @@ int ngli_config_copy(struct ngl_config *dst, const struct ngl_config *src)
             return NGL_ERROR_MEMORY;
     }
 
+    if (src->cache_dir) {
+        tmp.cache_dir = ngli_strdup(src->cache_dir);
+        if (!tmp.cache_dir) {
+            ngli_freep(&tmp.hud_export_filename);
+            return NGL_ERROR_MEMORY;
+        }
+    }
+
     if (src->backend_config) {
         if (src->backend == NGL_BACKEND_OPENGL ||
             src->backend == NGL_BACKEND_OPENGLES) {
@@ -271,10 +279,12 @@ int ngli_config_copy(struct ngl_config *dst, const struct ngl_config *src)
             tmp.backend_config = ngli_memdup(src->backend_config, size);
             if (!tmp.backend_config) {
                 ngli_freep(&tmp.hud_export_filename);
+                ngli_freep(&tmp.cache_dir);
                 return NGL_ERROR_MEMORY;
             }
         } else {
             ngli_freep(&tmp.hud_export_filename);
+            ngli_freep(&tmp.cache_dir);
             LOG(ERROR, "backend_config %p is not supported by backend %d",
                 src->backend_config, src->backend);
             return NGL_ERROR_UNSUPPORTED;
@@ -290,5 +300,6 @@ void ngli_config_reset(struct ngl_config *config)
 {
     ngli_freep(&config->backend_config);
     ngli_freep(&config->hud_export_filename);
+    ngli_freep(&config->cache_dir);
     memset(config, 0, sizeof(*config));
 }
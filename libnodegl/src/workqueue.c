@@ -0,0 +1,180 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "darray.h"
+#include "memory.h"
+#include "nodegl.h"
+#include "pthread_compat.h"
+#include "utils.h"
+#include "workqueue.h"
+
+enum {
+    WORK_STATE_IDLE,
+    WORK_STATE_QUEUED,
+    WORK_STATE_RUNNING,
+};
+
+struct workqueue {
+    pthread_t thread;
+    int thread_started;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond_work;
+    pthread_cond_t cond_done;
+    int initialized;
+    int quit;
+
+    struct darray works; /* struct work pointers, protected by the lock */
+};
+
+static void *worker_thread(void *arg)
+{
+    struct workqueue *s = arg;
+
+    ngli_thread_set_name("ngl-workqueue");
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (!s->quit && !ngli_darray_count(&s->works))
+            pthread_cond_wait(&s->cond_work, &s->lock);
+        if (!ngli_darray_count(&s->works))
+            break;
+
+        struct work **works = ngli_darray_data(&s->works);
+        struct work *work = works[0];
+        ngli_darray_remove(&s->works, 0);
+        work->state = WORK_STATE_RUNNING;
+
+        pthread_mutex_unlock(&s->lock);
+        const int ret = work->func(work->user_arg);
+        pthread_mutex_lock(&s->lock);
+
+        work->ret = ret;
+        work->state = WORK_STATE_IDLE;
+        pthread_cond_broadcast(&s->cond_done);
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    return NULL;
+}
+
+struct workqueue *ngli_workqueue_create(void)
+{
+    struct workqueue *s = ngli_calloc(1, sizeof(*s));
+    if (!s)
+        return NULL;
+    ngli_darray_init(&s->works, sizeof(struct work *), 0);
+    return s;
+}
+
+int ngli_workqueue_init(struct workqueue *s)
+{
+    if (pthread_mutex_init(&s->lock, NULL) ||
+        pthread_cond_init(&s->cond_work, NULL) ||
+        pthread_cond_init(&s->cond_done, NULL)) {
+        pthread_cond_destroy(&s->cond_work);
+        pthread_cond_destroy(&s->cond_done);
+        pthread_mutex_destroy(&s->lock);
+        return NGL_ERROR_EXTERNAL;
+    }
+    s->initialized = 1;
+
+    if (pthread_create(&s->thread, NULL, worker_thread, s))
+        return NGL_ERROR_EXTERNAL;
+    s->thread_started = 1;
+
+    return 0;
+}
+
+int ngli_workqueue_push(struct workqueue *s, struct work *work, workqueue_func_type func, void *user_arg)
+{
+    ngli_assert(work->state == WORK_STATE_IDLE);
+    work->func = func;
+    work->user_arg = user_arg;
+
+    if (!s) {
+        work->ret = func(user_arg);
+        return 0;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    if (!ngli_darray_push(&s->works, &work)) {
+        pthread_mutex_unlock(&s->lock);
+        return NGL_ERROR_MEMORY;
+    }
+    work->state = WORK_STATE_QUEUED;
+    pthread_cond_signal(&s->cond_work);
+    pthread_mutex_unlock(&s->lock);
+
+    return 0;
+}
+
+int ngli_workqueue_wait(struct workqueue *s, struct work *work)
+{
+    if (!s)
+        return work->ret;
+
+    pthread_mutex_lock(&s->lock);
+    if (work->state == WORK_STATE_QUEUED) {
+        /* Not started yet: execute it now rather than waiting for the others */
+        struct work **works = ngli_darray_data(&s->works);
+        for (int i = 0; i < ngli_darray_count(&s->works); i++) {
+            if (works[i] == work) {
+                ngli_darray_remove(&s->works, i);
+                break;
+            }
+        }
+        work->state = WORK_STATE_IDLE;
+        pthread_mutex_unlock(&s->lock);
+        work->ret = work->func(work->user_arg);
+        return work->ret;
+    }
+    while (work->state == WORK_STATE_RUNNING)
+        pthread_cond_wait(&s->cond_done, &s->lock);
+    const int ret = work->ret;
+    pthread_mutex_unlock(&s->lock);
+
+    return ret;
+}
+
+void ngli_workqueue_freep(struct workqueue **sp)
+{
+    struct workqueue *s = *sp;
+    if (!s)
+        return;
+
+    if (s->initialized) {
+        pthread_mutex_lock(&s->lock);
+        s->quit = 1;
+        pthread_cond_signal(&s->cond_work);
+        pthread_mutex_unlock(&s->lock);
+
+        if (s->thread_started)
+            pthread_join(s->thread, NULL);
+
+        pthread_cond_destroy(&s->cond_work);
+        pthread_cond_destroy(&s->cond_done);
+        pthread_mutex_destroy(&s->lock);
+    }
+
+    ngli_darray_reset(&s->works);
+    ngli_freep(sp);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2022 GoPro Inc.
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+/*
+ * Background thread executing queued works in order. A work is owned by the
+ * caller and must be waited for (ngli_workqueue_wait()) before being queued
+ * again or destroyed. Waiting for a work which has not been started yet
+ * removes it from the queue and executes it in the calling thread instead.
+ */
+
+typedef int (*workqueue_func_type)(void *user_arg);
+
+struct work {
+    workqueue_func_type func;
+    void *user_arg;
+    int state;
+    int ret;
+};
+
+struct workqueue;
+
+struct workqueue *ngli_workqueue_create(void);
+int ngli_workqueue_init(struct workqueue *s);
+
+/*
+ * Queue the execution of func(user_arg). With a NULL queue, the function is
+ * executed immediately and its result is returned by ngli_workqueue_wait().
+ */
+int ngli_workqueue_push(struct workqueue *s, struct work *work, workqueue_func_type func, void *user_arg);
+
+/*
+ * Wait for the completion of a queued work and return its result.
+ */
+int ngli_workqueue_wait(struct workqueue *s, struct work *work);
+
+/*
+ * Wait for every queued work before destroying the queue.
+ */
+void ngli_workqueue_freep(struct workqueue **sp);
+
+#endif
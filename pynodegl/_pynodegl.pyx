@@ -39,6 +39,13 @@ cdef extern from "nodegl.h":
     cdef struct ngl_node
 
     ngl_node *ngl_node_create(int type)
+
+    cdef struct ngl_scene_arena
+
+    ngl_scene_arena *ngl_scene_arena_create()
+    ngl_node *ngl_scene_arena_create_node(ngl_scene_arena *arena, int type)
+    void ngl_scene_arena_freep(ngl_scene_arena **arenap)
+
     ngl_node *ngl_node_ref(ngl_node *node)
     void ngl_node_unrefp(ngl_node **nodep)
     int ngl_node_param_add_nodes(ngl_node *node, const char *key, int nb_nodes, ngl_node **nodes)
@@ -65,6 +72,28 @@ cdef extern from "nodegl.h":
     int ngl_node_param_set_vec2(ngl_node *node, const char *key, const float *value)
     int ngl_node_param_set_vec3(ngl_node *node, const char *key, const float *value)
     int ngl_node_param_set_vec4(ngl_node *node, const char *key, const float *value)
+
+    cdef struct ngl_param_handle:
+        pass
+
+    int ngl_node_param_get_handle(ngl_node *node, const char *key, ngl_param_handle *handle)
+    int ngl_node_param_set_bool_h(const ngl_param_handle *handle, int value)
+    int ngl_node_param_set_f32_h(const ngl_param_handle *handle, float value)
+    int ngl_node_param_set_f64_h(const ngl_param_handle *handle, double value)
+    int ngl_node_param_set_i32_h(const ngl_param_handle *handle, int value)
+    int ngl_node_param_set_ivec2_h(const ngl_param_handle *handle, const int *value)
+    int ngl_node_param_set_ivec3_h(const ngl_param_handle *handle, const int *value)
+    int ngl_node_param_set_ivec4_h(const ngl_param_handle *handle, const int *value)
+    int ngl_node_param_set_mat4_h(const ngl_param_handle *handle, const float *value)
+    int ngl_node_param_set_rational_h(const ngl_param_handle *handle, int num, int den)
+    int ngl_node_param_set_str_h(const ngl_param_handle *handle, const char *value)
+    int ngl_node_param_set_u32_h(const ngl_param_handle *handle, const unsigned value)
+    int ngl_node_param_set_uvec2_h(const ngl_param_handle *handle, const unsigned *value)
+    int ngl_node_param_set_uvec3_h(const ngl_param_handle *handle, const unsigned *value)
+    int ngl_node_param_set_uvec4_h(const ngl_param_handle *handle, const unsigned *value)
+    int ngl_node_param_set_vec2_h(const ngl_param_handle *handle, const float *value)
+    int ngl_node_param_set_vec3_h(const ngl_param_handle *handle, const float *value)
+    int ngl_node_param_set_vec4_h(const ngl_param_handle *handle, const float *value)
     char *ngl_node_dot(const ngl_node *node)
     char *ngl_node_serialize(const ngl_node *node)
     ngl_node *ngl_node_deserialize(const char *s)
@@ -84,6 +113,20 @@ cdef extern from "nodegl.h":
     cdef int NGL_BACKEND_OPENGLES
     cdef int NGL_BACKEND_VULKAN
 
+    cdef int NGL_CAPTURE_BUFFER_TYPE_CPU
+    cdef int NGL_CAPTURE_BUFFER_TYPE_COREVIDEO
+    cdef int NGL_CAPTURE_BUFFER_TYPE_CPU_NV12
+    cdef int NGL_CAPTURE_BUFFER_TYPE_CPU_I420
+    cdef int NGL_CAPTURE_BUFFER_TYPE_CPU_P010
+
+    cdef int NGL_CAPTURE_COLORSPACE_AUTO
+    cdef int NGL_CAPTURE_COLORSPACE_BT601
+    cdef int NGL_CAPTURE_COLORSPACE_BT709
+    cdef int NGL_CAPTURE_COLORSPACE_BT2020
+
+    cdef int NGL_CAPTURE_COLOR_RANGE_LIMITED
+    cdef int NGL_CAPTURE_COLOR_RANGE_FULL
+
     cdef int NGL_CAP_BLOCK
     cdef int NGL_CAP_COMPUTE
     cdef int NGL_CAP_DEPTH_STENCIL_RESOLVE
@@ -143,11 +186,17 @@ cdef extern from "nodegl.h":
         float clear_color[4]
         void *capture_buffer
         int capture_buffer_type
+        int capture_colorspace
+        int capture_color_range
+        int capture_async_depth
         int hud
         int hud_measure_window
         int hud_refresh_rate[2]
         const char *hud_export_filename
         int hud_scale
+        const char *cache_dir
+        int cache_max_size
+        int parallel_update
 
     cdef union ngl_livectl_data:
         float f[4]
@@ -171,11 +220,15 @@ cdef extern from "nodegl.h":
     int ngl_configure(ngl_ctx *s, ngl_config *config)
     int ngl_resize(ngl_ctx *s, int width, int height, const int *viewport)
     int ngl_set_capture_buffer(ngl_ctx *s, void *capture_buffer)
+    int ngl_fetch_capture(ngl_ctx *s, int wait, double *t) nogil
     int ngl_set_scene(ngl_ctx *s, ngl_node *scene)
     int ngl_draw(ngl_ctx *s, double t) nogil
+    int ngl_draw_async(ngl_ctx *s, double t) nogil
+    int ngl_wait(ngl_ctx *s) nogil
     char *ngl_dot(ngl_ctx *s, double t) nogil
     int ngl_livectls_get(ngl_node *scene, int *nb_livectlsp, ngl_livectl **livectlsp)
     void ngl_livectls_freep(ngl_livectl **livectlsp)
+    int ngl_livectls_apply(int nb_livectls, const ngl_livectl *livectls)
     void ngl_freep(ngl_ctx **ss)
 
     int ngl_easing_evaluate(const char *name, const double *args, int nb_args,
@@ -200,6 +253,20 @@ BACKEND_OPENGL    = NGL_BACKEND_OPENGL
 BACKEND_OPENGLES  = NGL_BACKEND_OPENGLES
 BACKEND_VULKAN    = NGL_BACKEND_VULKAN
 
+CAPTURE_BUFFER_TYPE_CPU       = NGL_CAPTURE_BUFFER_TYPE_CPU
+CAPTURE_BUFFER_TYPE_COREVIDEO = NGL_CAPTURE_BUFFER_TYPE_COREVIDEO
+CAPTURE_BUFFER_TYPE_CPU_NV12  = NGL_CAPTURE_BUFFER_TYPE_CPU_NV12
+CAPTURE_BUFFER_TYPE_CPU_I420  = NGL_CAPTURE_BUFFER_TYPE_CPU_I420
+CAPTURE_BUFFER_TYPE_CPU_P010  = NGL_CAPTURE_BUFFER_TYPE_CPU_P010
+
+CAPTURE_COLORSPACE_AUTO   = NGL_CAPTURE_COLORSPACE_AUTO
+CAPTURE_COLORSPACE_BT601  = NGL_CAPTURE_COLORSPACE_BT601
+CAPTURE_COLORSPACE_BT709  = NGL_CAPTURE_COLORSPACE_BT709
+CAPTURE_COLORSPACE_BT2020 = NGL_CAPTURE_COLORSPACE_BT2020
+
+CAPTURE_COLOR_RANGE_LIMITED = NGL_CAPTURE_COLOR_RANGE_LIMITED
+CAPTURE_COLOR_RANGE_FULL    = NGL_CAPTURE_COLOR_RANGE_FULL
+
 CAP_BLOCK                          = NGL_CAP_BLOCK
 CAP_COMPUTE                        = NGL_CAP_COMPUTE
 CAP_DEPTH_STENCIL_RESOLVE          = NGL_CAP_DEPTH_STENCIL_RESOLVE
@@ -244,6 +311,75 @@ def log_set_min_level(int level):
     ngl_log_set_min_level(level)
 
 
+cdef class _ParamHandle:
+    cdef ngl_param_handle handle
+    cdef object node  # keeps the node alive as long as the handle
+
+    def __cinit__(self, node):
+        self.node = node
+
+    def set_bool(self, bint value):
+        return ngl_node_param_set_bool_h(&self.handle, value)
+
+    def set_f32(self, float value):
+        return ngl_node_param_set_f32_h(&self.handle, value)
+
+    def set_f64(self, double value):
+        return ngl_node_param_set_f64_h(&self.handle, value)
+
+    def set_i32(self, int value):
+        return ngl_node_param_set_i32_h(&self.handle, value)
+
+    def set_ivec2(self, value):
+        cdef int[2] ivec = value
+        return ngl_node_param_set_ivec2_h(&self.handle, ivec)
+
+    def set_ivec3(self, value):
+        cdef int[3] ivec = value
+        return ngl_node_param_set_ivec3_h(&self.handle, ivec)
+
+    def set_ivec4(self, value):
+        cdef int[4] ivec = value
+        return ngl_node_param_set_ivec4_h(&self.handle, ivec)
+
+    def set_mat4(self, value):
+        cdef float[16] mat = value
+        return ngl_node_param_set_mat4_h(&self.handle, mat)
+
+    def set_rational(self, int num, int den):
+        return ngl_node_param_set_rational_h(&self.handle, num, den)
+
+    def set_str(self, const char *value):
+        return ngl_node_param_set_str_h(&self.handle, value)
+
+    def set_u32(self, const unsigned value):
+        return ngl_node_param_set_u32_h(&self.handle, value)
+
+    def set_uvec2(self, value):
+        cdef unsigned[2] uvec = value
+        return ngl_node_param_set_uvec2_h(&self.handle, uvec)
+
+    def set_uvec3(self, value):
+        cdef unsigned[3] uvec = value
+        return ngl_node_param_set_uvec3_h(&self.handle, uvec)
+
+    def set_uvec4(self, value):
+        cdef unsigned[4] uvec = value
+        return ngl_node_param_set_uvec4_h(&self.handle, uvec)
+
+    def set_vec2(self, value):
+        cdef float[2] vec = value
+        return ngl_node_param_set_vec2_h(&self.handle, vec)
+
+    def set_vec3(self, value):
+        cdef float[3] vec = value
+        return ngl_node_param_set_vec3_h(&self.handle, vec)
+
+    def set_vec4(self, value):
+        cdef float[4] vec = value
+        return ngl_node_param_set_vec4_h(&self.handle, vec)
+
+
 cdef class _Node:
     cdef ngl_node *ctx
 
@@ -348,6 +484,12 @@ cdef class _Node:
         cdef float[4] vec = value
         return ngl_node_param_set_vec4(self.ctx, key, vec)
 
+    def param_handle(self, const char *key):
+        cdef _ParamHandle handle = _ParamHandle(self)
+        if ngl_node_param_get_handle(self.ctx, key, &handle.handle) < 0:
+            raise KeyError(key)
+        return handle
+
     def _param_add_nodes(self, const char *key, int nb_nodes, nodes):
         nodes_c = <ngl_node **>calloc(nb_nodes, sizeof(ngl_node *))
         if nodes_c is NULL:
@@ -546,6 +688,71 @@ def get_livectls(_Node scene):
     return livectl_dict
 
 
+def apply_livectls(livectl_dict):
+    cdef int nb_livectls = len(livectl_dict)
+    if not nb_livectls:
+        return
+    cdef ngl_livectl *livectls = <ngl_livectl *>calloc(nb_livectls, sizeof(ngl_livectl))
+    if livectls is NULL:
+        raise MemoryError()
+
+    cdef _Node py_node
+    cdef ngl_livectl *livectl
+    cdef bytes py_str
+    strings = []  # the encoded strings must outlive ngl_livectls_apply()
+    for i, py_data in enumerate(livectl_dict.values()):
+        py_node = py_data['node']
+        livectl = &livectls[i]
+        livectl.node = py_node.ctx
+        py_cls, data_type = LIVECTL_INFO[py_node.type_id]
+        data_count = _TYPES_COUNT[data_type]
+        val = py_data['val']
+        if data_type[0] in 'fiu' and data_count == 1:
+            val = [val]
+        if data_type[0] in 'fvm':
+            for j in range(data_count):
+                livectl.val.f[j] = val[j]
+        elif data_type[0] == 'i':
+            for j in range(data_count):
+                livectl.val.i[j] = val[j]
+        elif data_type[0] == 'u':
+            for j in range(data_count):
+                livectl.val.u[j] = val[j]
+        elif data_type == 'bool':
+            livectl.val.i[0] = 1 if val else 0
+        elif data_type == 'str':
+            py_str = val.encode('utf-8')
+            strings.append(py_str)
+            livectl.val.s = py_str
+
+    cdef int ret = ngl_livectls_apply(nb_livectls, livectls)
+    free(livectls)
+    if ret < 0:
+        raise Exception('Error applying live controls')
+
+
+cdef class SceneArena:
+    cdef ngl_scene_arena *ctx
+
+    def __cinit__(self):
+        self.ctx = ngl_scene_arena_create()
+        if self.ctx is NULL:
+            raise MemoryError()
+
+    def create_node(self, node_cls, *args, **kwargs):
+        cdef ngl_node *node = ngl_scene_arena_create_node(self.ctx, node_cls.type_id)
+        if node is NULL:
+            raise MemoryError()
+        try:
+            return node_cls(*args, ctx=<uintptr_t>node, **kwargs)
+        finally:
+            # The Python node holds its own reference
+            ngl_node_unrefp(&node)
+
+    def __dealloc__(self):
+        ngl_scene_arena_freep(&self.ctx)
+
+
 cdef class ConfigGL:
     cdef ngl_config_gl config
 
@@ -594,6 +801,10 @@ cdef class Context:
         capture_buffer = kwargs.get('capture_buffer')
         if capture_buffer is not None:
             config.capture_buffer = <uint8_t *>capture_buffer
+        config.capture_buffer_type = kwargs.get('capture_buffer_type', CAPTURE_BUFFER_TYPE_CPU)
+        config.capture_colorspace = kwargs.get('capture_colorspace', CAPTURE_COLORSPACE_AUTO)
+        config.capture_color_range = kwargs.get('capture_color_range', CAPTURE_COLOR_RANGE_LIMITED)
+        config.capture_async_depth = kwargs.get('capture_async_depth', 0)
         config.hud = kwargs.get('hud', 0)
         config.hud_measure_window = kwargs.get('hud_measure_window', 0)
         hud_refresh_rate = kwargs.get('hud_refresh_rate', (0, 0))
@@ -603,6 +814,11 @@ cdef class Context:
         if hud_export_filename is not None:
             config.hud_export_filename = hud_export_filename
         config.hud_scale = kwargs.get('hud_scale', 0)
+        cache_dir = kwargs.get('cache_dir')
+        if cache_dir is not None:
+            config.cache_dir = cache_dir
+        config.cache_max_size = kwargs.get('cache_max_size', 0)
+        config.parallel_update = kwargs.get('parallel_update', False)
 
     def configure(self, **kwargs):
         self.capture_buffer = kwargs.get('capture_buffer')
@@ -625,6 +841,13 @@ cdef class Context:
             ptr = <uint8_t *>self.capture_buffer
         return ngl_set_capture_buffer(self.ctx, ptr)
 
+    def fetch_capture(self, wait=False):
+        cdef int c_wait = wait
+        cdef double t = 0
+        with nogil:
+            ret = ngl_fetch_capture(self.ctx, c_wait, &t)
+        return ret, t
+
     def set_scene(self, _Node scene):
         return ngl_set_scene(self.ctx, NULL if scene is None else scene.ctx)
 
@@ -639,6 +862,16 @@ cdef class Context:
             ret = ngl_draw(self.ctx, t)
         return ret
 
+    def draw_async(self, double t):
+        with nogil:
+            ret = ngl_draw_async(self.ctx, t)
+        return ret
+
+    def wait(self):
+        with nogil:
+            ret = ngl_wait(self.ctx)
+        return ret
+
     def dot(self, double t):
         cdef char *s
         with nogil:
@@ -37,6 +37,7 @@ import _pynodegl as _ngl
 from _pynodegl import _Node
 
 # fmt: off
+apply_livectls    = _ngl.apply_livectls
 ConfigGL          = _ngl.ConfigGL
 Context           = _ngl.Context
 easing_derivate   = _ngl.easing_derivate
@@ -46,6 +47,7 @@ get_backends      = _ngl.get_backends
 get_livectls      = _ngl.get_livectls
 log_set_min_level = _ngl.log_set_min_level
 probe_backends    = _ngl.probe_backends
+SceneArena        = _ngl.SceneArena
 
 PLATFORM_AUTO    = _ngl.PLATFORM_AUTO
 PLATFORM_XLIB    = _ngl.PLATFORM_XLIB
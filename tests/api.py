@@ -122,6 +122,169 @@ def api_capture_buffer(width=16, height=16):
     del ctx
 
 
+def _get_async_capture_ctx(width, height, depth):
+    capture_buffer = bytearray(width * height * 4)
+    ctx = ngl.Context()
+    ret = ctx.configure(
+        offscreen=1,
+        width=width,
+        height=height,
+        backend=_backend,
+        capture_buffer=capture_buffer,
+        capture_async_depth=depth,
+    )
+    assert ret == 0
+    assert ctx.set_scene(_get_scene()) == 0
+    return ctx, capture_buffer
+
+
+def api_capture_async_order(width=16, height=16, depth=3):
+    import zlib
+
+    ctx, capture_buffer = _get_async_capture_ctx(width, height, depth)
+    times = [i / 4.0 for i in range(depth)]
+    for t in times:
+        assert ctx.draw(t) == 0
+    for t in times:
+        capture_buffer[:] = bytes(len(capture_buffer))
+        ret, fetched_t = ctx.fetch_capture(wait=True)
+        assert ret == 1
+        assert fetched_t == t
+        assert zlib.crc32(capture_buffer) == 0xB4BD32FA
+    assert ctx.fetch_capture(wait=True) == (0, 0)
+    del ctx
+
+
+def api_capture_async_queue_full(width=16, height=16, depth=2):
+    ctx, _ = _get_async_capture_ctx(width, height, depth)
+    for i in range(depth):
+        assert ctx.draw(i) == 0
+    assert ctx.draw(depth) < 0
+
+    # Fetching the oldest capture frees one slot for the next frame
+    ret, t = ctx.fetch_capture(wait=True)
+    assert (ret, t) == (1, 0)
+    assert ctx.draw(depth) == 0
+    assert ctx.draw(depth + 1) < 0
+
+    for i in range(1, depth + 1):
+        ret, t = ctx.fetch_capture(wait=True)
+        assert (ret, t) == (1, i)
+    assert ctx.fetch_capture(wait=True)[0] == 0
+    del ctx
+
+
+def api_capture_async_resize(width=16, height=16, depth=2):
+    import zlib
+
+    ctx, _ = _get_async_capture_ctx(width, height, depth)
+    assert ctx.draw(0) == 0
+
+    # Offscreen contexts can not be resized: the pending capture must survive
+    # the failed attempt
+    assert ctx.resize(width * 2, height * 2) != 0
+    ret, t = ctx.fetch_capture(wait=True)
+    assert (ret, t) == (1, 0)
+
+    # Reconfiguring with a new size drops the pending captures and the
+    # following ones use the new dimensions
+    assert ctx.draw(1) == 0
+    width, height = width * 2, height * 2
+    capture_buffer = bytearray(width * height * 4)
+    ret = ctx.configure(
+        offscreen=1,
+        width=width,
+        height=height,
+        backend=_backend,
+        capture_buffer=capture_buffer,
+        capture_async_depth=depth,
+    )
+    assert ret == 0
+    assert ctx.fetch_capture(wait=True)[0] == 0
+    assert ctx.draw(2) == 0
+    ret, t = ctx.fetch_capture(wait=True)
+    assert (ret, t) == (1, 2)
+    async_crc = zlib.crc32(capture_buffer)
+    del ctx
+
+    ctx = ngl.Context()
+    capture_buffer = bytearray(width * height * 4)
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+    assert ret == 0
+    assert ctx.set_scene(_get_scene()) == 0
+    assert ctx.draw(2) == 0
+    assert zlib.crc32(capture_buffer) == async_crc
+    del ctx
+
+
+def api_capture_async_poll(width=16, height=16, depth=3):
+    import zlib
+
+    ctx, capture_buffer = _get_async_capture_ctx(width, height, depth)
+    for i in range(depth):
+        assert ctx.draw(i) == 0
+
+    # Without waiting, the captures are returned in order as soon as they are
+    # available
+    fetched = []
+    while len(fetched) < depth:
+        ret, t = ctx.fetch_capture(wait=False)
+        assert ret >= 0
+        if ret:
+            assert zlib.crc32(capture_buffer) == 0xB4BD32FA
+            fetched.append(t)
+    assert fetched == list(range(depth))
+    assert ctx.fetch_capture(wait=False)[0] == 0
+    del ctx
+
+
+def api_capture_async_invalid(width=16, height=16):
+    ctx = ngl.Context()
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_async_depth=-1)
+    assert ret < 0
+
+    # Fetching requires an asynchronous context with a capture buffer
+    capture_buffer = bytearray(width * height * 4)
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+    assert ret == 0
+    assert ctx.fetch_capture(wait=True)[0] < 0
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_async_depth=2)
+    assert ret == 0
+    assert ctx.fetch_capture(wait=True)[0] < 0
+    del ctx
+
+
+def api_capture_yuv(width=16, height=16):
+    # A fullscreen white frame converted on the GPU to limited range YUV
+    scene = ngl.RenderColor(color=(1, 1, 1), geometry=ngl.Quad((-1, -1, 0), (2, 0, 0), (0, 2, 0)))
+    nb_pixels = width * height
+    specs = (
+        (ngl.CAPTURE_BUFFER_TYPE_CPU_NV12, nb_pixels * 3 // 2, bytes([235]) * nb_pixels, bytes([128]) * (nb_pixels // 2)),
+        (ngl.CAPTURE_BUFFER_TYPE_CPU_I420, nb_pixels * 3 // 2, bytes([235]) * nb_pixels, bytes([128]) * (nb_pixels // 2)),
+        # 10-bit samples are stored in the 10 most significant bits of
+        # little-endian 16-bit words: 940 << 6 and 512 << 6
+        (ngl.CAPTURE_BUFFER_TYPE_CPU_P010, nb_pixels * 3, bytes([0x00, 0xEB]) * nb_pixels, bytes([0x00, 0x80]) * nb_pixels),
+    )
+    for buffer_type, size, luma, chroma in specs:
+        capture_buffer = bytearray(size)
+        ctx = ngl.Context()
+        ret = ctx.configure(
+            offscreen=1,
+            width=width,
+            height=height,
+            backend=_backend,
+            capture_buffer=capture_buffer,
+            capture_buffer_type=buffer_type,
+            capture_color_range=ngl.CAPTURE_COLOR_RANGE_LIMITED,
+        )
+        assert ret == 0
+        assert ctx.set_scene(scene) == 0
+        assert ctx.draw(0) == 0
+        assert capture_buffer[: len(luma)] == luma
+        assert capture_buffer[len(luma) :] == chroma
+        del ctx
+
+
 def api_ctx_ownership():
     ctx = ngl.Context()
     ctx2 = ngl.Context()
@@ -185,6 +348,55 @@ def api_hud(width=234, height=123):
     del ctx
 
 
+def _get_interleaved_pipelines_scene(sort_draws):
+    children = []
+    for i in range(4):
+        quad = ngl.Quad(corner=(-1 + i * 0.5, -1, 0), width=(0.5, 0, 0), height=(0, 2, 0))
+        render = ngl.RenderGradient(geometry=quad) if i % 2 else ngl.RenderColor(geometry=quad)
+        children.append(render)
+    return ngl.Group(children=children, sort_draws=sort_draws)
+
+
+def _get_pipeline_switches(sort_draws, width, height):
+    import csv
+    import tempfile
+    import zlib
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        export_filename = os.path.join(tmpdir, "hud.csv")
+        capture_buffer = bytearray(width * height * 4)
+        ctx = ngl.Context()
+        ret = ctx.configure(
+            offscreen=1,
+            width=width,
+            height=height,
+            backend=_backend,
+            capture_buffer=capture_buffer,
+            hud=1,
+            hud_export_filename=export_filename,
+        )
+        assert ret == 0
+        assert ctx.set_scene(_get_interleaved_pipelines_scene(sort_draws)) == 0
+        for i in range(3):
+            assert ctx.draw(i) == 0
+        del ctx
+
+        with open(export_filename, newline="") as f:
+            rows = list(csv.DictReader(f))
+        assert len(rows) == 3
+        return [int(row["PipeSwitch"]) for row in rows], zlib.crc32(capture_buffer)
+
+
+# The RenderColor and RenderGradient draws alternate: sorting them must group
+# them by pipeline without altering the (non overlapping) output
+def api_hud_pipeline_switches(width=32, height=32):
+    unsorted_switches, unsorted_crc = _get_pipeline_switches(False, width, height)
+    sorted_switches, sorted_crc = _get_pipeline_switches(True, width, height)
+    assert unsorted_switches == [4] * 3
+    assert sorted_switches == [2] * 3
+    assert sorted_crc == unsorted_crc
+
+
 def api_text_live_change(width=320, height=240):
     import zlib
 
@@ -320,6 +532,68 @@ def api_livectls():
             assert math.isclose(value, expected_value, rel_tol=1e-6)
 
 
+def api_live_changes_queue():
+    # More live changed nodes than the capacity of the live changes queue
+    nb_nodes = 1100
+    nodes = [ngl.UniformFloat(live_id=f"f{i}") for i in range(nb_nodes)]
+    scene = ngl.Group(children=nodes)
+
+    ctx = ngl.Context()
+    ret = ctx.configure(offscreen=1, width=16, height=16, backend=_backend)
+    assert ret == 0
+    assert ctx.set_scene(scene) == 0
+    assert ctx.draw(0) == 0
+
+    # Repeated changes of the same parameter replace each other in the queue
+    for i in range(nb_nodes * 2):
+        assert nodes[0].set_value(i) == 0
+    assert ctx.draw(1) == 0
+
+    # Changes beyond the capacity of the queue are applied synchronously
+    expected_values = [i * 0.5 for i in range(nb_nodes)]
+    for node, value in zip(nodes, expected_values):
+        assert node.set_value(value) == 0
+    assert ctx.draw(2) == 0
+
+    assert ctx.set_scene(None) == 0
+    livectls = ngl.get_livectls(scene)
+    for i, expected_value in enumerate(expected_values):
+        value = livectls[f"f{i}"]["val"]
+        assert math.isclose(value, expected_value, rel_tol=1e-6), (i, value, expected_value)
+
+
+def api_scene_arena(width=16, height=16):
+    import zlib
+
+    ctx = ngl.Context()
+    capture_buffer = bytearray(width * height * 4)
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+    assert ret == 0
+
+    def get_scene(create_node):
+        geometry = create_node(ngl.Quad, corner=(-1, -1, 0), width=(1, 0, 0), height=(0, 2, 0))
+        renders = [
+            create_node(ngl.RenderColor, color=(1, 0.5, 0), geometry=geometry),
+            create_node(ngl.Translate, create_node(ngl.RenderColor, color=(0, 0.5, 1), geometry=geometry), vector=(1, 0, 0)),
+        ]
+        return create_node(ngl.Group, children=renders)
+
+    assert ctx.set_scene(get_scene(lambda node_cls, *args, **kwargs: node_cls(*args, **kwargs))) == 0
+    assert ctx.draw(0) == 0
+    ref_crc = zlib.crc32(capture_buffer)
+
+    # The arena outlives the user reference as long as its nodes are alive
+    arena = ngl.SceneArena()
+    scene = get_scene(arena.create_node)
+    del arena
+    assert ctx.set_scene(scene) == 0
+    assert ctx.draw(0) == 0
+    assert zlib.crc32(capture_buffer) == ref_crc
+
+    assert ctx.set_scene(None) == 0
+    del scene
+
+
 def api_reset_scene(width=320, height=240):
     ctx = ngl.Context()
     ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend)
@@ -428,3 +702,353 @@ def api_trf_seek_keep_alive(width=320, height=240):
     assert ctx.draw(end) == 0
     assert ctx.draw(start) == 0
     assert ctx.draw(end) == 0
+
+
+def _get_capture_crcs(scene, times, width, height, **config):
+    import zlib
+
+    capture_buffer = bytearray(width * height * 4)
+    ctx = ngl.Context()
+    ret = ctx.configure(
+        offscreen=1,
+        width=width,
+        height=height,
+        backend=_backend,
+        capture_buffer=capture_buffer,
+        **config,
+    )
+    assert ret == 0
+    assert ctx.set_scene(scene) == 0
+    crcs = []
+    for t in times:
+        assert ctx.draw(t) == 0
+        crcs.append(zlib.crc32(capture_buffer))
+    del ctx
+    return crcs
+
+
+def _get_static_subtree_scene(value):
+    # A time invariant CPU subtree feeding the color of a transformed render
+    uniform = ngl.UniformFloat(value)
+    color = ngl.EvalVec3(expr0="v", expr1="0.5", expr2="1-v", resources=dict(v=uniform))
+    quad = ngl.Quad(corner=(-1, -1, 0), width=(1, 0, 0), height=(0, 2, 0))
+    render = ngl.Translate(ngl.RenderColor(color=color, geometry=quad), vector=(0.5, 0, 0))
+    return ngl.Group(children=(render,)), uniform
+
+
+def api_static_subtree(width=16, height=16):
+    import zlib
+
+    ref_crc = _get_capture_crcs(_get_static_subtree_scene(0.25)[0], [0], width, height)[0]
+    changed_crc = _get_capture_crcs(_get_static_subtree_scene(0.75)[0], [0], width, height)[0]
+    assert ref_crc != changed_crc
+
+    # The skipped updates of the up-to-date subtree must not alter its output,
+    # whatever the time sequence
+    scene, uniform = _get_static_subtree_scene(0.25)
+    times = [0, 1, 0.5, 3, 3, 2]
+    assert _get_capture_crcs(scene, times, width, height) == [ref_crc] * len(times)
+
+    # A live change of a node of the subtree must update its ancestors again
+    capture_buffer = bytearray(width * height * 4)
+    ctx = ngl.Context()
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+    assert ret == 0
+    assert ctx.set_scene(scene) == 0
+    for t in range(3):
+        assert ctx.draw(t) == 0
+        assert zlib.crc32(capture_buffer) == ref_crc
+    assert uniform.set_value(0.75) == 0
+    for t in range(3, 6):
+        assert ctx.draw(t) == 0
+        assert zlib.crc32(capture_buffer) == changed_crc
+    del ctx
+
+
+def _get_animated_under_static_scene():
+    static_quad = ngl.Quad(corner=(-1, -1, 0), width=(1, 0, 0), height=(0, 2, 0))
+    animated_quad = ngl.Quad(corner=(0, -1, 0), width=(1, 0, 0), height=(0, 2, 0))
+    animkf = [
+        ngl.AnimKeyFrameVec3(0, (1, 0, 0)),
+        ngl.AnimKeyFrameVec3(1, (0, 0, 1)),
+    ]
+    animated = ngl.RenderColor(color=ngl.AnimatedVec3(animkf), geometry=animated_quad)
+    static = ngl.Translate(ngl.RenderColor(color=(0, 1, 0), geometry=static_quad), vector=(0, 0, 0))
+    return ngl.Group(children=(ngl.Group(children=(static, animated)),))
+
+
+def api_static_group_animated_child(width=16, height=16):
+    # The animated render must still be updated while its time invariant
+    # sibling is skipped
+    times = [0, 0.5, 1, 0.25]
+    ref_crcs = [_get_capture_crcs(_get_animated_under_static_scene(), [t], width, height)[0] for t in times]
+    assert len(set(ref_crcs)) == len(times)
+    assert _get_capture_crcs(_get_animated_under_static_scene(), times, width, height) == ref_crcs
+
+
+def _get_parallel_update_scene():
+    # The animated value is shared between 2 CPU subtrees, which are thus not
+    # updated in parallel, unlike the animated transforms
+    shared = ngl.AnimatedFloat([ngl.AnimKeyFrameFloat(0, 0), ngl.AnimKeyFrameFloat(1, 1)])
+    children = []
+    for i, (expr0, expr1) in enumerate((("v", "1-v"), ("1-v", "v"))):
+        color = ngl.EvalVec3(expr0=expr0, expr1=expr1, expr2="0.5", resources=dict(v=shared))
+        quad = ngl.Quad(corner=(-0.5, -0.5, 0), width=(0.5, 0, 0), height=(0, 0.5, 0))
+        render = ngl.RenderColor(color=color, geometry=quad)
+        angle = ngl.AnimatedFloat([ngl.AnimKeyFrameFloat(0, 0), ngl.AnimKeyFrameFloat(1, 90 * (i + 1))])
+        vector = ngl.AnimatedVec3([ngl.AnimKeyFrameVec3(0, (0, 0, 0)), ngl.AnimKeyFrameVec3(1, (i - 0.5, 0.25, 0))])
+        children.append(ngl.Translate(ngl.Rotate(render, angle=angle), vector=vector))
+    return ngl.Group(children=children)
+
+
+def api_parallel_update(width=32, height=32):
+    times = [0, 0.25, 1, 0.5, 0.75]
+    crcs = _get_capture_crcs(_get_parallel_update_scene(), times, width, height)
+    assert len(set(crcs)) == len(times)
+    parallel_crcs = _get_capture_crcs(_get_parallel_update_scene(), times, width, height, parallel_update=1)
+    assert parallel_crcs == crcs
+
+
+def _get_animated_color_scene():
+    animkf = [
+        ngl.AnimKeyFrameVec3(0, (1, 0, 0)),
+        ngl.AnimKeyFrameVec3(4, (0, 0, 1)),
+    ]
+    return ngl.RenderColor(color=ngl.AnimatedVec3(animkf), geometry=ngl.Quad())
+
+
+def api_draw_async(width=16, height=16):
+    import zlib
+
+    times = list(range(5))
+    ref_crcs = _get_capture_crcs(_get_animated_color_scene(), times, width, height)
+
+    capture_buffer = bytearray(width * height * 4)
+    ctx = ngl.Context()
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+    assert ret == 0
+    assert ctx.set_scene(_get_animated_color_scene()) == 0
+
+    # The capture is only complete once the asynchronous draw is waited for
+    for t in times:
+        assert ctx.draw_async(t) == 0
+        assert ctx.wait() == 0
+        assert zlib.crc32(capture_buffer) == ref_crcs[t]
+
+    # A synchronous draw waits for the pending asynchronous one before drawing
+    # its own frame
+    for t in times:
+        if t % 2:
+            assert ctx.draw(t) == 0
+        else:
+            assert ctx.draw_async(t) == 0
+            assert ctx.wait() == 0
+        assert zlib.crc32(capture_buffer) == ref_crcs[t]
+    assert ctx.draw_async(0) == 0
+    assert ctx.draw(1) == 0
+    assert zlib.crc32(capture_buffer) == ref_crcs[1]
+    assert ctx.wait() == 0
+    del ctx
+
+
+def api_draw_async_error(width=16, height=16, depth=2):
+    ctx, _ = _get_async_capture_ctx(width, height, depth)
+    for i in range(depth):
+        assert ctx.draw_async(i) == 0
+
+    # The capture queue is full: the failure of the asynchronous draw is
+    # reported by the next call, which does not draw
+    assert ctx.draw_async(depth) == 0
+    assert ctx.draw_async(depth + 1) < 0
+    assert ctx.wait() == 0
+
+    # Fetching the oldest capture frees one slot for the next frame
+    ret, t = ctx.fetch_capture(wait=True)
+    assert (ret, t) == (1, 0)
+    assert ctx.draw_async(depth) == 0
+    assert ctx.wait() == 0
+
+    # The failure is reported by ngl_wait() as well
+    assert ctx.draw_async(depth + 1) == 0
+    assert ctx.wait() < 0
+    assert ctx.wait() == 0
+
+    for i in range(1, depth + 1):
+        ret, t = ctx.fetch_capture(wait=True)
+        assert (ret, t) == (1, i)
+    assert ctx.fetch_capture(wait=True)[0] == 0
+    del ctx
+
+
+def api_param_handle(width=16, height=16):
+    import zlib
+
+    def get_scene():
+        return ngl.RenderColor(color=(1, 0, 0), geometry=ngl.Quad())
+
+    # The same values set by name and through a handle, on detached and then
+    # attached nodes
+    values = [(0, 1, 0), (0.25, 0.5, 1)]
+    crcs = []
+    for use_handle in (False, True):
+        capture_buffer = bytearray(width * height * 4)
+        ctx = ngl.Context()
+        ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend, capture_buffer=capture_buffer)
+        assert ret == 0
+        render = get_scene()
+        handle = render.param_handle("color")
+        for i, value in enumerate(values):
+            if use_handle:
+                assert handle.set_vec3(value) == 0
+            else:
+                assert render.set_color(*value) == 0
+            if i == 0:
+                assert ctx.set_scene(render) == 0
+            assert ctx.draw(i) == 0
+            crcs.append(zlib.crc32(capture_buffer))
+        del ctx
+    assert crcs[: len(values)] == crcs[len(values) :]
+    assert crcs[0] != crcs[1]
+
+    # The values set through a handle are the ones read back from the node
+    uniform = ngl.UniformFloat(live_id="f")
+    handle = uniform.param_handle("value")
+    assert handle.set_f32(0.5) == 0
+    assert math.isclose(ngl.get_livectls(uniform)["f"]["val"], 0.5)
+
+    # A value of the wrong type is rejected, whether the node is attached or
+    # not
+    assert handle.set_vec3((1, 2, 3)) < 0
+    ctx = ngl.Context()
+    ret = ctx.configure(offscreen=1, width=width, height=height, backend=_backend)
+    assert ret == 0
+    assert ctx.set_scene(ngl.Group(children=(uniform,))) == 0
+    assert handle.set_vec3((1, 2, 3)) < 0
+    assert handle.set_f32(0.75) == 0
+    assert ctx.draw(0) == 0
+    assert ctx.set_scene(None) == 0
+    assert math.isclose(ngl.get_livectls(uniform)["f"]["val"], 0.75)
+
+    # Unknown parameters have no handle
+    try:
+        uniform.param_handle("unknown")
+    except KeyError:
+        pass
+    else:
+        assert False
+    del ctx
+
+
+def _get_time_ranges_scene():
+    # The first 2 filters share their boundaries, and the last one repeats one
+    # of them in its own ranges
+    range_specs = (
+        (("noop", 0), ("cont", 1), ("noop", 2), ("cont", 3)),
+        (("noop", 0), ("cont", 1), ("noop", 2), ("cont", 3)),
+        (("noop", 0), ("noop", 2), ("cont", 2), ("noop", 3)),
+    )
+    range_classes = dict(noop=ngl.TimeRangeModeNoop, cont=ngl.TimeRangeModeCont)
+    colors = ((1, 0, 0), (0, 1, 0), (0, 0, 1))
+    children = []
+    for i, (specs, color) in enumerate(zip(range_specs, colors)):
+        quad = ngl.Quad(corner=(-1 + i * 2 / 3, -1, 0), width=(2 / 3, 0, 0), height=(0, 2, 0))
+        render = ngl.RenderColor(color=color, geometry=quad)
+        ranges = [range_classes[mode](start) for mode, start in specs]
+        children.append(ngl.TimeRangeFilter(render, ranges=ranges))
+    return ngl.Group(children=children)
+
+
+def api_time_ranges_boundaries(width=18, height=18):
+    # Times on, just before and just after each boundary (including the
+    # prefetch and idle times), in a random order
+    eps = 1 / 1024
+    times = [t + d for t in range(-3, 5) for d in (-eps, 0, eps)]
+    random.Random(0).shuffle(times)
+
+    # A new context visits the scene for its first draw
+    ref_crcs = [_get_capture_crcs(_get_time_ranges_scene(), [t], width, height)[0] for t in times]
+    assert len(set(ref_crcs)) > 1
+    assert _get_capture_crcs(_get_time_ranges_scene(), times, width, height) == ref_crcs
+
+    # Draw the same times again, each one twice in a row
+    times = [t for t in times for _ in range(2)]
+    ref_crcs = [crc for crc in ref_crcs for _ in range(2)]
+    assert _get_capture_crcs(_get_time_ranges_scene(), times, width, height) == ref_crcs
+
+
+def _get_shared_program_scene(get_color):
+    vert = (
+        "void main() { ngl_out_pos = ngl_projection_matrix * ngl_modelview_matrix * vec4(ngl_position, 1.0); }"
+    )
+    frag = "void main() { ngl_out_color = vec4(color, 1.0); }"
+    program = ngl.Program(vertex=vert, fragment=frag)
+    children = []
+    for i in range(2):
+        # Distinct geometries prevent the renders from being batched
+        quad = ngl.Quad(corner=(-1 + i, -1, 0), width=(1, 0, 0), height=(0, 2, 0))
+        render = ngl.Render(quad, program)
+        render.update_frag_resources(color=get_color(i))
+        children.append(render)
+    return ngl.Group(children=children)
+
+
+def _get_uniform_skips(scene, nb_frames, width, height):
+    import csv
+    import tempfile
+
+    colors = []
+    with tempfile.TemporaryDirectory() as tmpdir:
+        export_filename = os.path.join(tmpdir, "hud.csv")
+        capture_buffer = bytearray(width * height * 4)
+        ctx = ngl.Context()
+        ret = ctx.configure(
+            offscreen=1,
+            width=width,
+            height=height,
+            backend=_backend,
+            capture_buffer=capture_buffer,
+            hud=1,
+            hud_export_filename=export_filename,
+        )
+        assert ret == 0
+        assert ctx.set_scene(scene) == 0
+        for i in range(nb_frames):
+            assert ctx.draw(i) == 0
+            row = height // 2 * width
+            left = (row + width // 4) * 4
+            right = (row + width * 3 // 4) * 4
+            colors.append((bytes(capture_buffer[left : left + 4]), bytes(capture_buffer[right : right + 4])))
+        del ctx
+
+        with open(export_filename, newline="") as f:
+            rows = list(csv.DictReader(f))
+        assert len(rows) == nb_frames
+        return [int(row["UniSkip"]) for row in rows], colors
+
+
+# The 2 renders share their program: each of them must upload its own values
+# again when it draws after the other one, even if they did not change
+def api_hud_uniform_skips(width=32, height=32, nb_frames=4):
+    red, green = bytes([0xFF, 0, 0, 0xFF]), bytes([0, 0xFF, 0, 0xFF])
+
+    def get_uniform_color(i):
+        return ngl.UniformVec3(value=((1, 0, 0), (0, 1, 0))[i])
+
+    skips, colors = _get_uniform_skips(_get_shared_program_scene(get_uniform_color), nb_frames, width, height)
+    assert colors == [(red, green)] * nb_frames
+    assert all(skip > 0 for skip in skips[1:])
+
+    # The value of a time invariant evaluation is not updated, and thus not
+    # uploaded again, unlike the one depending on the time
+    def get_eval_color(i):
+        return ngl.EvalVec3(expr0="1-v", expr1="v", expr2="0", resources=dict(v=ngl.UniformFloat(i)))
+
+    def get_time_eval_color(i):
+        return ngl.EvalVec3(expr0="1-v", expr1="v", expr2="0*t", resources=dict(v=ngl.UniformFloat(i), t=ngl.Time()))
+
+    eval_skips, eval_colors = _get_uniform_skips(_get_shared_program_scene(get_eval_color), nb_frames, width, height)
+    time_skips, time_colors = _get_uniform_skips(
+        _get_shared_program_scene(get_time_eval_color), nb_frames, width, height
+    )
+    assert eval_colors == time_colors == colors
+    assert all(skip > time_skip for skip, time_skip in zip(eval_skips[1:], time_skips[1:]))
@@ -0,0 +1,121 @@
+#
+# Copyright 2022 GoPro Inc.
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+import textwrap
+
+from pynodegl_utils.misc import SceneCfg, scene
+from pynodegl_utils.tests.cmp_cuepoints import test_cuepoints
+
+import pynodegl as ngl
+
+# Offsets of the bottom-left quadrant quad to each quadrant of the viewport
+_QUADRANTS = dict(
+    bl=(0, 0, 0),
+    br=(1, 0, 0),
+    tr=(1, 1, 0),
+    tl=(0, 1, 0),
+)
+
+_QUADRANT_COLORS = dict(
+    bl=(1, 0, 0),
+    br=(0, 1, 0),
+    tr=(0, 0, 1),
+    tl=(1, 1, 1),
+)
+
+# Center of each quadrant, and inner corner of each quadrant (overlapped by the
+# center quad)
+_OUTER_POINTS = dict(bl=(-0.75, -0.75), br=(0.75, -0.75), tr=(0.75, 0.75), tl=(-0.75, 0.75))
+_INNER_POINTS = dict(bl_in=(-0.25, -0.25), br_in=(0.25, -0.25), tr_in=(0.25, 0.25), tl_in=(-0.25, 0.25))
+
+
+def _get_quadrant_geometry():
+    return ngl.Quad(corner=(-1, -1, 0), width=(1, 0, 0), height=(0, 1, 0))
+
+
+def _get_quadrant_renders(geometry, names):
+    return [
+        ngl.Translate(ngl.RenderColor(_QUADRANT_COLORS[name], geometry=geometry), vector=_QUADRANTS[name])
+        for name in names
+    ]
+
+
+@test_cuepoints(points=_OUTER_POINTS, tolerance=1)
+@scene()
+def batch_transforms_colors(cfg: SceneCfg):
+    """Consecutive compatible renders with distinct transforms and colors, drawn in a single batch"""
+    cfg.aspect_ratio = (1, 1)
+    geometry = _get_quadrant_geometry()
+    return ngl.Group(children=_get_quadrant_renders(geometry, _QUADRANTS.keys()))
+
+
+@test_cuepoints(points=dict(**_OUTER_POINTS, **_INNER_POINTS), tolerance=1)
+@scene()
+def batch_broken_run(cfg: SceneCfg):
+    """
+    A render with another geometry in the middle of a run splits it in 2
+    batches: it must be drawn above the first one and below the second one
+    """
+    cfg.aspect_ratio = (1, 1)
+    geometry = _get_quadrant_geometry()
+    center_geometry = ngl.Quad(corner=(-0.5, -0.5, 0), width=(1, 0, 0), height=(0, 1, 0))
+    center = ngl.RenderColor((1, 1, 0), geometry=center_geometry)
+    renders = (
+        _get_quadrant_renders(geometry, ("bl", "br"))
+        + [center]
+        + _get_quadrant_renders(geometry, ("tr", "tl"))
+    )
+    return ngl.Group(children=renders)
+
+
+@test_cuepoints(points=_OUTER_POINTS, tolerance=1)
+@scene()
+def batch_fallback(cfg: SceneCfg):
+    """
+    Compatible renders with too many distinct matrices to fit in the vertex
+    attributes of a batch: they must be drawn separately
+    """
+    cfg.aspect_ratio = (1, 1)
+    vert = textwrap.dedent(
+        """\
+        void main()
+        {
+            ngl_out_pos = ngl_projection_matrix * ngl_modelview_matrix * m0 * m1 * m2 * m3 * vec4(ngl_position, 1.0);
+        }
+        """
+    )
+    frag = textwrap.dedent(
+        """\
+        void main()
+        {
+            ngl_out_color = color;
+        }
+        """
+    )
+    program = ngl.Program(vertex=vert, fragment=frag)
+    geometry = _get_quadrant_geometry()
+    renders = []
+    for name, vector in _QUADRANTS.items():
+        render = ngl.Render(geometry, program)
+        render.update_vert_resources(**{f"m{i}": ngl.UniformMat4() for i in range(4)})
+        render.update_frag_resources(color=ngl.UniformVec4(value=_QUADRANT_COLORS[name] + (1,)))
+        renders.append(ngl.Translate(render, vector=vector))
+    return ngl.Group(children=renders)
@@ -315,6 +315,65 @@ def data_mat_iovars(cfg: SceneCfg):
     return render
 
 
+_BUILTINS_POINTS = dict(bl=(-0.5, -0.5), br=(0.5, -0.5), tl=(-0.5, 0.5), tr=(0.5, 0.5))
+
+
+def _get_builtins_scene(cfg: SceneCfg, batched):
+    """
+    Each color channel depends on one of the builtin uniforms, which are hinted
+    as push constants. Together, they exceed the 128 bytes guaranteed for the
+    push constants, so some of them fall back on the uniform block with such
+    a limit. When batched, the modelview and normal matrices are per instance
+    attributes, so the remaining builtins always fit.
+    """
+    cfg.aspect_ratio = (1, 1)
+    vert = textwrap.dedent(
+        """\
+        void main()
+        {
+            vec4 position = ngl_modelview_matrix * vec4(ngl_position, 1.0);
+            ngl_out_pos = ngl_projection_matrix * position;
+            var_position = position.xy;
+            var_normal = ngl_normal_matrix * vec3(0.0, 0.0, 1.0);
+        }
+        """
+    )
+    frag = textwrap.dedent(
+        """\
+        void main()
+        {
+            float blue = step(2.0, var_normal.z) * step(1.0, ngl_resolution.x);
+            ngl_out_color = vec4(step(0.0, var_position.x), step(0.0, var_position.y), blue, 1.0);
+        }
+        """
+    )
+    program = ngl.Program(vertex=vert, fragment=frag)
+    program.update_vert_out_vars(var_position=ngl.IOVec2(), var_normal=ngl.IOVec3())
+
+    # The scale of the z axis by 0.25 scales the normals by 4
+    factors = (2, 2, 0.25)
+    if not batched:
+        geometry = ngl.Quad(corner=(-0.5, -0.5, 0), width=(1, 0, 0), height=(0, 1, 0))
+        return ngl.Scale(ngl.Render(geometry, program), factors=factors)
+
+    geometry = ngl.Quad(corner=(-0.5, -0.5, 0), width=(0.5, 0, 0), height=(0, 1, 0))
+    left = ngl.Scale(ngl.Render(geometry, program), factors=factors)
+    right = ngl.Scale(ngl.Translate(ngl.Render(geometry, program), vector=(0.5, 0, 0)), factors=factors)
+    return ngl.Group(children=(left, right))
+
+
+@test_cuepoints(points=_BUILTINS_POINTS, tolerance=1)
+@scene()
+def data_builtins_push_constants(cfg: SceneCfg):
+    return _get_builtins_scene(cfg, batched=False)
+
+
+@test_cuepoints(points=_BUILTINS_POINTS, tolerance=1)
+@scene()
+def data_builtins_push_constants_batched(cfg: SceneCfg):
+    return _get_builtins_scene(cfg, batched=True)
+
+
 @test_fingerprint(nb_keyframes=10, tolerance=1)
 @scene()
 def data_noise_time(cfg: SceneCfg):
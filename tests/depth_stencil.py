@@ -20,6 +20,7 @@
 #
 
 from pynodegl_utils.misc import scene
+from pynodegl_utils.tests.cmp_cuepoints import test_cuepoints
 from pynodegl_utils.tests.cmp_fingerprint import test_fingerprint
 from pynodegl_utils.toolbox.colors import COLORS
 
@@ -63,6 +64,40 @@ def depth_stencil_depth(_):
     return group
 
 
+def _get_interleaved_pipelines_scene(sort_draws):
+    # Each quad starts one column further right and is closer than the
+    # previous ones, so every column shows a different quad whatever the draw
+    # order. The pipelines alternate between RenderColor and RenderGradient.
+    colors = (COLORS.red, COLORS.green, COLORS.blue, COLORS.white)
+    children = []
+    for i, color in enumerate(colors):
+        depth = 0.8 - i * 0.2
+        quad = ngl.Quad(corner=(-1 + i * 0.5, -1, depth), width=(2 - i * 0.5, 0, 0), height=(0, 2, 0))
+        if i % 2:
+            render = ngl.RenderGradient(color0=color, color1=color, geometry=quad)
+        else:
+            render = ngl.RenderColor(color, geometry=quad)
+        children.append(render)
+    group = ngl.Group(children=children, sort_draws=sort_draws)
+    return ngl.GraphicConfig(group, depth_test=True, depth_func="less")
+
+
+_INTERLEAVED_PIPELINES_POINTS = dict(c0=(-0.75, 0), c1=(-0.25, 0), c2=(0.25, 0), c3=(0.75, 0))
+
+
+@test_cuepoints(points=_INTERLEAVED_PIPELINES_POINTS, tolerance=1)
+@scene()
+def depth_stencil_sort_draws(_):
+    return _get_interleaved_pipelines_scene(sort_draws=True)
+
+
+# Reference for depth_stencil_sort_draws: both must produce the same output
+@test_cuepoints(points=_INTERLEAVED_PIPELINES_POINTS, tolerance=1)
+@scene()
+def depth_stencil_sort_draws_unsorted(_):
+    return _get_interleaved_pipelines_scene(sort_draws=False)
+
+
 @test_fingerprint(width=16, height=16, nb_keyframes=2, tolerance=1)
 @scene()
 def depth_stencil_stencil(_):